@@ -0,0 +1,581 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Arithmetic expansion, "$((EXPRESSION))". The expression is evaluated within the shell by a
+*	recursive descent evaluator with 64-bit integers and C operator precedence, so a counter or an offset no
+*	longer costs a fork of expr or bc
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "variables.h"
+#include "arithmetic.h"
+
+// the length of the longest variable name an expression can refer to
+#define MAX_NAME_LENGTH 255
+
+/*
+* A struct representing the state of the evaluation of an expression
+*/
+struct evaluator {
+	char* position;  // the next character of the expression to be read
+	char* end;  // the address just past the last character of the expression
+	bool evaluate;  // false within an operand skipped by "&&", "||" or "?:", which stores nothing and cannot fail
+	char* error;  // the first error found, or NULL
+	char* errorAt;  // the address of the character a syntax error was found at, or NULL for other errors
+	char message[MAX_NAME_LENGTH + 32];  // the text of an error naming a variable
+};
+
+/*
+* A struct representing a binary operator, which is not recognized when one of the characters in excluded
+* follows it - so that "<" is not taken for the start of "<<" or "<=", nor "+" for "+="
+*/
+struct binaryOperator {
+	char* text;  // the operator
+	char* excluded;  // the characters that cannot follow it
+	int level;  // the precedence of the operator, higher binding tighter
+};
+
+// the binary operators other than "**", two character operators first so that "<<" is not taken for "<" - every
+// one of them is left associative
+static struct binaryOperator binaryOperators[] = {
+	{ "||", "", 0 }, { "&&", "", 1 }, { "==", "", 5 }, { "!=", "", 5 }, { "<=", "", 6 }, { ">=", "", 6 },
+	{ "<<", "=", 7 }, { ">>", "=", 7 }, { "|", "=", 2 }, { "^", "=", 3 }, { "&", "=", 4 }, { "<", "", 6 },
+	{ ">", "", 6 }, { "+", "=", 8 }, { "-", "=", 8 }, { "*", "*=", 9 }, { "/", "=", 9 }, { "%", "=", 9 },
+	{ NULL, NULL, 0 }
+};
+
+// the assignment operators, longest first so that "<<=" is not taken for "<"
+static char* assignmentOperators[] = { "<<=", ">>=", "+=", "-=", "*=", "/=", "%=", "&=", "^=", "|=", "=", NULL };
+
+static long long evaluateComma(struct evaluator* evaluator);
+static long long evaluateAssignment(struct evaluator* evaluator);
+
+/*
+* Records error as the error of the evaluation, unless an earlier one was found, and stops it. A syntax error
+* records the address it was found at
+*/
+static long long fail(struct evaluator* evaluator, char* error, bool syntax) {
+	if (!evaluator->error) {
+		evaluator->error = error;
+		evaluator->errorAt = syntax ? evaluator->position : NULL;
+	}
+	evaluator->position = evaluator->end;
+	return 0;
+}
+
+/*
+* Skips the whitespace before the next token of the expression
+*/
+static void skipSpace(struct evaluator* evaluator) {
+	while (evaluator->position < evaluator->end && (*evaluator->position == ' ' || *evaluator->position == '\t' ||
+		*evaluator->position == '\n' || *evaluator->position == '\r')) {
+		evaluator->position++;
+	}
+}
+
+/*
+* Reads the operator text if it is the next token of the expression and none of the characters in excluded
+* follows it. Returns true if the operator was read
+*/
+static bool acceptOperator(struct evaluator* evaluator, char* text, char* excluded) {
+	// declare and initialize a variable used to store the length of the operator matched so far
+	size_t length = 0;
+
+	// every token is tried against many operators, so this avoids calling into the C library until one matches
+	skipSpace(evaluator);
+	for (; text[length]; length++) {
+		if (evaluator->position + length == evaluator->end || evaluator->position[length] != text[length]) {
+			return false;
+		}
+	}
+	if (evaluator->position + length < evaluator->end && evaluator->position[length] &&
+		strchr(excluded, evaluator->position[length])) {
+		return false;
+	}
+
+	evaluator->position += length;
+	return true;
+}
+
+/*
+* Reads the variable name that is the next token of the expression into name. Returns false, reading nothing,
+* if the next token is not a name
+*/
+static bool readName(struct evaluator* evaluator, char* name) {
+	int length = 0;
+
+	skipSpace(evaluator);
+	while (evaluator->position + length < evaluator->end && length < MAX_NAME_LENGTH &&
+		isValidVariableName(evaluator->position, length + 1)) {
+		length++;
+	}
+	if (length == 0) {
+		return false;
+	}
+
+	memcpy(name, evaluator->position, length);
+	name[length] = '\0';
+	evaluator->position += length;
+	return true;
+}
+
+/*
+* Converts text, the value of a variable or a reference, into a number stored in value - a blank text is 0.
+* Returns false if text is not a number
+*/
+static bool parseNumber(char* text, long long* value) {
+	char* end;
+
+	while (isspace((unsigned char)*text)) {
+		text++;
+	}
+	if (*text == '\0') {
+		*value = 0;
+		return true;
+	}
+
+	// a leading 0x makes the number hexadecimal and a leading 0 octal, and a number too large wraps around
+	bool negative = *text == '-';
+	text += (*text == '-' || *text == '+');
+	if (!isdigit((unsigned char)*text)) {
+		return false;
+	}
+	unsigned long long magnitude = strtoull(text, &end, 0);
+	while (isspace((unsigned char)*end)) {
+		end++;
+	}
+	if (*end != '\0') {
+		return false;
+	}
+
+	*value = (long long)(negative ? 0 - magnitude : magnitude);
+	return true;
+}
+
+/*
+* Returns the value of the variable called name - an unset or empty variable is 0
+*/
+static long long getValue(struct evaluator* evaluator, char* name) {
+	char* text = getVariable(name);
+	long long value;
+
+	if (text && !parseNumber(text, &value)) {
+		snprintf(evaluator->message, sizeof(evaluator->message), "%s: not a number", name);
+		return fail(evaluator, evaluator->message, false);
+	}
+
+	return text ? value : 0;
+}
+
+/*
+* Writes value in decimal into buffer, which must hold at least 21 characters, and returns buffer. Every
+* expansion and assignment formats a number, which snprintf takes several times longer to do
+*/
+static char* formatNumber(long long value, char* buffer) {
+	// declare and initialize variables used to build the digits backwards from the end of a scratch buffer
+	char digits[24];
+	int position = sizeof(digits);
+	unsigned long long magnitude = value < 0 ? 0 - (unsigned long long)value : (unsigned long long)value;
+
+	digits[--position] = '\0';
+	do {
+		digits[--position] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while (magnitude);
+	if (value < 0) {
+		digits[--position] = '-';
+	}
+
+	memcpy(buffer, digits + position, sizeof(digits) - position);
+	return buffer;
+}
+
+/*
+* Stores value into the variable called name, unless the operand being evaluated is skipped
+*/
+static void setValue(struct evaluator* evaluator, char* name, long long value) {
+	char text[32];
+
+	if (evaluator->evaluate && !evaluator->error) {
+		setVariable(name, formatNumber(value, text));
+	}
+}
+
+/*
+* Returns the result of applying the binary operator text to left and right. Integer overflow wraps around
+*/
+static long long applyOperator(struct evaluator* evaluator, char* text, long long left, long long right) {
+	unsigned long long leftBits = left, rightBits = right;
+
+	switch (text[0]) {
+		case '+': return (long long)(leftBits + rightBits);
+		case '-': return (long long)(leftBits - rightBits);
+		case '*': return (long long)(leftBits * rightBits);
+		case '^': return left ^ right;
+		case '=': return left == right;
+		case '!': return left != right;
+		case '|': return text[1] ? (left || right) : (left | right);
+		case '&': return text[1] ? (left && right) : (left & right);
+		case '<':
+			if (text[1] == '<') {
+				return (long long)(leftBits << (right & 63));
+			}
+			return text[1] == '=' ? left <= right : left < right;
+		case '>':
+			if (text[1] == '>') {
+				return left >> (right & 63);
+			}
+			return text[1] == '=' ? left >= right : left > right;
+		case '/':
+		case '%':
+			// a skipped operand is never divided, so it cannot divide by zero
+			if (!evaluator->evaluate) {
+				return 0;
+			}
+			if (right == 0) {
+				return fail(evaluator, "division by zero", false);
+			}
+			// the one quotient that does not fit wraps around like the other operators
+			if (right == -1) {
+				return text[0] == '/' ? (long long)(0 - leftBits) : 0;
+			}
+			return text[0] == '/' ? left / right : left % right;
+		default:
+			return 0;
+	}
+}
+
+/*
+* Evaluates a primary expression - a number, a variable with an optional "++" or "--" after it, a '$'
+* reference or a parenthesized expression
+*/
+static long long evaluatePrimary(struct evaluator* evaluator) {
+	char name[MAX_NAME_LENGTH + 1];
+	long long value = 0;
+
+	skipSpace(evaluator);
+	if (evaluator->position == evaluator->end) {
+		return fail(evaluator, "operand expected", true);
+	}
+
+	// a parenthesized expression
+	if (acceptOperator(evaluator, "(", "")) {
+		value = evaluateComma(evaluator);
+		if (!acceptOperator(evaluator, ")", "")) {
+			return fail(evaluator, "missing ')'", true);
+		}
+		return value;
+	}
+
+	// a number, which cannot run into a name
+	if (isdigit((unsigned char)*evaluator->position)) {
+		char* end;
+		value = (long long)strtoull(evaluator->position, &end, 0);
+		if (end < evaluator->end && (isalnum((unsigned char)*end) || *end == '_')) {
+			evaluator->position = end;
+			return fail(evaluator, "invalid number", true);
+		}
+		evaluator->position = end;
+		return value;
+	}
+
+	// a reference such as "$NAME", "${NAME}", "$1" or a nested "$((EXPRESSION))" - the expression holds no
+	// quotes, so the reference cannot run past its end
+	if (*evaluator->position == '$') {
+		char pidString[32] = "";
+		char* referenceEnd;
+		if (evaluator->position[1] == '$') {
+			snprintf(pidString, sizeof(pidString), "%d", getpid());
+		}
+		char* text = expandReference(evaluator->position, &referenceEnd, pidString);
+		if (referenceEnd == evaluator->position + 1 || referenceEnd > evaluator->end) {
+			return fail(evaluator, "invalid reference", true);
+		}
+		if (!parseNumber(text, &value)) {
+			return fail(evaluator, "reference is not a number", true);
+		}
+		evaluator->position = referenceEnd;
+		return value;
+	}
+
+	// a variable, which "++" or "--" after it increments or decrements once its value is taken
+	if (readName(evaluator, name)) {
+		value = getValue(evaluator, name);
+		if (acceptOperator(evaluator, "++", "")) {
+			setValue(evaluator, name, (long long)((unsigned long long)value + 1));
+		}
+		else if (acceptOperator(evaluator, "--", "")) {
+			setValue(evaluator, name, (long long)((unsigned long long)value - 1));
+		}
+		return value;
+	}
+
+	return fail(evaluator, "operand expected", true);
+}
+
+/*
+* Evaluates a unary expression - "++" or "--" before a variable, or '+', '-', '!' or '~' before an operand
+*/
+static long long evaluateUnary(struct evaluator* evaluator) {
+	char name[MAX_NAME_LENGTH + 1];
+
+	if (acceptOperator(evaluator, "++", "") || acceptOperator(evaluator, "--", "")) {
+		bool increment = evaluator->position[-1] == '+';
+		if (!readName(evaluator, name)) {
+			return fail(evaluator, "variable expected", true);
+		}
+		long long value = (long long)((unsigned long long)getValue(evaluator, name) + (increment ? 1 : -1));
+		setValue(evaluator, name, value);
+		return value;
+	}
+	if (acceptOperator(evaluator, "+", "")) {
+		return evaluateUnary(evaluator);
+	}
+	if (acceptOperator(evaluator, "-", "")) {
+		return (long long)(0 - (unsigned long long)evaluateUnary(evaluator));
+	}
+	if (acceptOperator(evaluator, "!", "=")) {
+		return !evaluateUnary(evaluator);
+	}
+	if (acceptOperator(evaluator, "~", "")) {
+		return ~evaluateUnary(evaluator);
+	}
+
+	return evaluatePrimary(evaluator);
+}
+
+/*
+* Evaluates a power, "base ** exponent", which binds tighter than any other binary operator and is right
+* associative
+*/
+static long long evaluatePower(struct evaluator* evaluator) {
+	long long base = evaluateUnary(evaluator);
+
+	if (!acceptOperator(evaluator, "**", "=")) {
+		return base;
+	}
+
+	long long exponent = evaluatePower(evaluator);
+	if (exponent < 0) {
+		return evaluator->evaluate ? fail(evaluator, "exponent less than 0", false) : 0;
+	}
+
+	// square and multiply, wrapping around on overflow
+	unsigned long long result = 1, factor = base;
+	for (; exponent; exponent >>= 1) {
+		if (exponent & 1) {
+			result *= factor;
+		}
+		factor *= factor;
+	}
+	return (long long)result;
+}
+
+/*
+* Returns the binary operator other than "**" that is the next token of the expression, without reading it, or
+* NULL if the next token is not one
+*/
+static struct binaryOperator* peekBinaryOperator(struct evaluator* evaluator) {
+	skipSpace(evaluator);
+	if (evaluator->position == evaluator->end) {
+		return NULL;
+	}
+
+	// the operators are few, so comparing the first character rules out nearly all of them
+	for (struct binaryOperator* operator = binaryOperators; operator->text; operator++) {
+		if (operator->text[0] != evaluator->position[0]) {
+			continue;
+		}
+		size_t length = operator->text[1] ? 2 : 1;
+		if ((length == 2 && (evaluator->position + 1 == evaluator->end || evaluator->position[1] != operator->text[1])) ||
+			(evaluator->position + length < evaluator->end && strchr(operator->excluded, evaluator->position[length]) &&
+			evaluator->position[length])) {
+			continue;
+		}
+		return operator;
+	}
+
+	return NULL;
+}
+
+/*
+* Evaluates the binary operators of precedence level and above by precedence climbing, so that each operand
+* looks up the operator after it once. The right operand of "&&" and "||" is only evaluated when it decides
+* the result
+*/
+static long long evaluateBinary(struct evaluator* evaluator, int level) {
+	long long left = evaluatePower(evaluator);
+
+	while (!evaluator->error) {
+		// stop at an operator that binds looser than this level, which a caller applies
+		struct binaryOperator* operator = peekBinaryOperator(evaluator);
+		if (!operator || operator->level < level) {
+			break;
+		}
+		evaluator->position += strlen(operator->text);
+
+		bool evaluate = evaluator->evaluate;
+		if (strcmp(operator->text, "&&") == 0 || strcmp(operator->text, "||") == 0) {
+			evaluator->evaluate = evaluate && (operator->text[0] == '&' ? left != 0 : left == 0);
+		}
+		long long right = evaluateBinary(evaluator, operator->level + 1);
+		evaluator->evaluate = evaluate;
+		left = applyOperator(evaluator, operator->text, left, right);
+	}
+
+	return left;
+}
+
+/*
+* Evaluates a conditional expression, "condition ? value : value", of which only the chosen value is evaluated
+*/
+static long long evaluateConditional(struct evaluator* evaluator) {
+	long long condition = evaluateBinary(evaluator, 0);
+
+	if (!acceptOperator(evaluator, "?", "")) {
+		return condition;
+	}
+
+	bool evaluate = evaluator->evaluate;
+	evaluator->evaluate = evaluate && condition;
+	long long whenTrue = evaluateComma(evaluator);
+	if (!acceptOperator(evaluator, ":", "")) {
+		return fail(evaluator, "':' expected", true);
+	}
+	evaluator->evaluate = evaluate && !condition;
+	long long whenFalse = evaluateConditional(evaluator);
+	evaluator->evaluate = evaluate;
+
+	return condition ? whenTrue : whenFalse;
+}
+
+/*
+* Evaluates an assignment, "NAME = value" or "NAME op= value", which is right associative, or a conditional
+* expression
+*/
+static long long evaluateAssignment(struct evaluator* evaluator) {
+	char name[MAX_NAME_LENGTH + 1];
+	char* start = evaluator->position;
+
+	if (readName(evaluator, name)) {
+		for (int index = 0; assignmentOperators[index]; index++) {
+			if (acceptOperator(evaluator, assignmentOperators[index], "=")) {
+				char* text = assignmentOperators[index];
+				long long value = evaluateAssignment(evaluator);
+				// "NAME op= value" applies op to the current value, "=" just stores value
+				if (text[1]) {
+					char operator[3] = { text[0], text[1] == '=' ? '\0' : text[1], '\0' };
+					value = applyOperator(evaluator, operator, getValue(evaluator, name), value);
+				}
+				setValue(evaluator, name, value);
+				return value;
+			}
+		}
+		// not an assignment - read the name again as an operand
+		evaluator->position = start;
+	}
+
+	return evaluateConditional(evaluator);
+}
+
+/*
+* Evaluates a list of expressions separated by ',', the value of which is that of the last one
+*/
+static long long evaluateComma(struct evaluator* evaluator) {
+	long long value = evaluateAssignment(evaluator);
+
+	while (acceptOperator(evaluator, ",", "")) {
+		value = evaluateAssignment(evaluator);
+	}
+
+	return value;
+}
+
+/*
+* Returns the address of the first character following the "))" that closes the arithmetic expansion starting
+* with the "$((" at the address in dollar, or NULL if it is never closed
+*/
+char* findArithmeticEnd(char* dollar) {
+	// declare and initialize a variable used to store the number of parentheses opened within the expression
+	int depth = 0;
+
+	for (char* current = dollar + 3; *current; current++) {
+		if (*current == '(') {
+			depth++;
+		}
+		else if (*current == ')' && depth > 0) {
+			depth--;
+		}
+		else if (*current == ')') {
+			return current[1] == ')' ? current + 2 : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* Expands the arithmetic expansion starting with the "$((" at the address in dollar into the value of its
+* expression, storing the address of the first character following it in referenceEnd. Returns the value in a
+* buffer overwritten by the next expansion, an empty string after displaying an error message if the expression
+* is invalid, or NULL if the expansion is never closed
+*/
+char* expandArithmetic(char* dollar, char** referenceEnd) {
+	// declare a buffer large enough to hold the value of the expression
+	static char valueString[32];
+	// declare a variable used to store the value of the expression
+	long long value;
+
+	*referenceEnd = findArithmeticEnd(dollar);
+	if (!*referenceEnd) {
+		return NULL;
+	}
+
+	// the expression lies between "$((" and "))"
+	if (!evaluateArithmetic(dollar + 3, *referenceEnd - 2 - (dollar + 3), &value)) {
+		return "";
+	}
+	return formatNumber(value, valueString);
+}
+
+/*
+* Evaluates the length characters of expression with 64-bit integers and C operator precedence, storing the value
+* in result. Variables are referenced by name or with '$', and "=", "+=" and the other assignment operators, "++"
+* and "--" store into them. Returns false after displaying an error message if expression is invalid or divides
+* by zero
+*/
+bool evaluateArithmetic(char* expression, size_t length, long long* result) {
+	// declare and initialize the state of the evaluation
+	struct evaluator evaluator = { expression, expression + length, true, NULL, NULL, "" };
+
+	// an empty expression is 0
+	skipSpace(&evaluator);
+	*result = evaluator.position == evaluator.end ? 0 : evaluateComma(&evaluator);
+
+	// everything in the expression must have been read
+	skipSpace(&evaluator);
+	if (!evaluator.error && evaluator.position != evaluator.end) {
+		fail(&evaluator, "syntax error", true);
+	}
+
+	if (evaluator.error) {
+		if (evaluator.errorAt && evaluator.errorAt < expression + length) {
+			printf("$((%.*s)): %s near \"%.*s\"\n", (int)length, expression, evaluator.error,
+				(int)(expression + length - evaluator.errorAt), evaluator.errorAt);
+		}
+		else {
+			printf("$((%.*s)): %s\n", (int)length, expression, evaluator.error);
+		}
+		fflush(stdout);
+		return false;
+	}
+
+	return true;
+}
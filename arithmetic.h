@@ -0,0 +1,29 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for arithmetic expansion, "$((EXPRESSION))", which is evaluated within the shell by a
+*	recursive descent evaluator instead of forking expr or bc
+*/
+
+/*
+* Returns the address of the first character following the "))" that closes the arithmetic expansion starting
+* with the "$((" at the address in dollar, or NULL if it is never closed
+*/
+char* findArithmeticEnd(char* dollar);
+
+/*
+* Expands the arithmetic expansion starting with the "$((" at the address in dollar into the value of its
+* expression, storing the address of the first character following it in referenceEnd. Returns the value in a
+* buffer overwritten by the next expansion, an empty string after displaying an error message if the expression
+* is invalid, or NULL if the expansion is never closed
+*/
+char* expandArithmetic(char* dollar, char** referenceEnd);
+
+/*
+* Evaluates the length characters of expression with 64-bit integers and C operator precedence, storing the value
+* in result. Variables are referenced by name or with '$', and "=", "+=" and the other assignment operators, "++"
+* and "--" store into them. Returns false after displaying an error message if expression is invalid or divides
+* by zero
+*/
+bool evaluateArithmetic(char* expression, size_t length, long long* result);
@@ -0,0 +1,381 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Brace expansion. A word is parsed once into a tree of generators - text, ranges, lists and
+*	products of them - that produce its words one at a time. A range only stores where it starts, its step and
+*	how many values it has, so "{1..1000000}" takes as little memory as "{1..2}"
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "braces.h"
+
+static struct braceGenerator* parseBraces(char* text, size_t length);
+
+/*
+* Returns a newly allocated, zeroed generator of kind
+*/
+static struct braceGenerator* newGenerator(int kind) {
+	struct braceGenerator* generator = (struct braceGenerator*)calloc(1, sizeof(struct braceGenerator));
+
+	generator->kind = kind;
+	return generator;
+}
+
+/*
+* Returns the index just past the quoted text or escape starting at text[index], which is a quote or a
+* backslash, or length if it runs to the end of text
+*/
+static size_t skipQuoted(char* text, size_t index, size_t length) {
+	char quote = text[index];
+
+	if (quote == '\\') {
+		return index + 2 < length ? index + 2 : length;
+	}
+	for (index++; index < length && text[index] != quote; index++) {
+		// within double quotes a backslash escapes the next character
+		if (quote == '"' && text[index] == '\\') {
+			index++;
+		}
+	}
+
+	return index < length ? index + 1 : length;
+}
+
+/*
+* Returns the index of the '}' matching the '{' at text[open], or length if there is none. The number of ','
+* outside of nested braces is stored in commas
+*/
+static size_t findClosingBrace(char* text, size_t open, size_t length, int* commas) {
+	int depth = 0;
+
+	*commas = 0;
+	for (size_t index = open + 1; index < length;) {
+		char character = text[index];
+		if (character == '\\' || character == '\'' || character == '"') {
+			index = skipQuoted(text, index, length);
+			continue;
+		}
+		if (character == '{') {
+			depth++;
+		}
+		else if (character == '}' && depth == 0) {
+			return index;
+		}
+		else if (character == '}') {
+			depth--;
+		}
+		else if (character == ',' && depth == 0) {
+			(*commas)++;
+		}
+		index++;
+	}
+
+	return length;
+}
+
+/*
+* Parses the optionally signed decimal number at *text, advancing *text past it. Returns false if there is none
+* or it does not fit into a long long
+*/
+static bool parseRangeNumber(char** text, char* end, long long* value) {
+	char* start = *text;
+
+	if (*text < end && (**text == '-' || **text == '+')) {
+		(*text)++;
+	}
+	if (*text == end || !isdigit((unsigned char)**text)) {
+		return false;
+	}
+	while (*text < end && isdigit((unsigned char)**text)) {
+		(*text)++;
+	}
+
+	errno = 0;
+	*value = strtoll(start, NULL, 10);
+	return errno != ERANGE;
+}
+
+/*
+* Returns true if the number at text of length characters starts with a zero that is not the whole number,
+* which pads every number of its range with zeros
+*/
+static bool isPadded(char* text, size_t length) {
+	if (length > 0 && (*text == '-' || *text == '+')) {
+		text++;
+		length--;
+	}
+
+	return length > 1 && *text == '0';
+}
+
+/*
+* Returns a range generator for the length characters of text - "START..END" or "START..END..STEP" where START
+* and END are both numbers or both single characters - or NULL if text is not a range
+*/
+static struct braceGenerator* parseRange(char* text, size_t length) {
+	char* end = text + length;
+	char* position = text;
+	long long first, last, step = 1;
+	bool characters = false;
+	int width = 0;
+
+	// the start and end of the range, which must be of the same kind
+	if (length >= 4 && !isdigit((unsigned char)text[0]) && text[0] != '-' && text[0] != '+' && text[1] == '.' && text[2] == '.' &&
+		!isdigit((unsigned char)text[3]) && (length == 4 || text[4] == '.')) {
+		characters = true;
+		first = (unsigned char)text[0];
+		last = (unsigned char)text[3];
+		position = text + 4;
+	}
+	else {
+		char* firstText = position;
+		if (!parseRangeNumber(&position, end, &first) || end - position < 2 || strncmp(position, "..", 2) != 0) {
+			return NULL;
+		}
+		size_t firstLength = position - firstText;
+		position += 2;
+		char* lastText = position;
+		if (!parseRangeNumber(&position, end, &last)) {
+			return NULL;
+		}
+		size_t lastLength = position - lastText;
+
+		// a leading zero on either end pads every number to the width of the wider end
+		if (isPadded(firstText, firstLength) || isPadded(lastText, lastLength)) {
+			width = firstLength > lastLength ? firstLength : lastLength;
+		}
+	}
+
+	// the step, whose sign is ignored as the range always runs from its start to its end
+	if (position < end) {
+		if (end - position < 3 || strncmp(position, "..", 2) != 0) {
+			return NULL;
+		}
+		position += 2;
+		if (!parseRangeNumber(&position, end, &step) || position != end) {
+			return NULL;
+		}
+		step = step < 0 ? -step : step;
+		step = step ? step : 1;
+	}
+
+	struct braceGenerator* generator = newGenerator(BRACE_RANGE);
+	unsigned long long distance = first <= last ? (unsigned long long)last - first : (unsigned long long)first - last;
+	generator->start = first;
+	generator->step = first <= last ? step : -step;
+	generator->count = distance / step + 1;
+	generator->width = width;
+	generator->characters = characters;
+	return generator;
+}
+
+/*
+* Returns a list generator for the length characters of text, the alternatives between a pair of braces
+* separated by the ',' outside of nested braces
+*/
+static struct braceGenerator* parseList(char* text, size_t length, int commas) {
+	struct braceGenerator* generator = newGenerator(BRACE_LIST);
+	size_t start = 0;
+	int depth = 0;
+
+	generator->alternatives = (struct braceGenerator**)malloc((commas + 1) * sizeof(struct braceGenerator*));
+	for (size_t index = 0; index <= length;) {
+		if (index < length && (text[index] == '\\' || text[index] == '\'' || text[index] == '"')) {
+			index = skipQuoted(text, index, length);
+			continue;
+		}
+
+		// each alternative may hold brace expressions of its own
+		if (index == length || (text[index] == ',' && depth == 0)) {
+			generator->alternatives[generator->numAlternatives++] = parseBraces(text + start, index - start);
+			start = index + 1;
+		}
+		else if (text[index] == '{') {
+			depth++;
+		}
+		else if (text[index] == '}') {
+			depth--;
+		}
+		index++;
+	}
+
+	return generator;
+}
+
+/*
+* Returns a generator of the words the length characters of text stand for - a product of the text before its
+* first brace expression, the expression and a generator of the text after it, or the text itself if it holds
+* no brace expression
+*/
+static struct braceGenerator* parseBraces(char* text, size_t length) {
+	for (size_t open = 0; open < length;) {
+		// quoted and escaped braces are only characters
+		if (text[open] == '\\' || text[open] == '\'' || text[open] == '"') {
+			open = skipQuoted(text, open, length);
+			continue;
+		}
+		// and so is the brace of a variable reference
+		if (text[open] != '{' || (open > 0 && text[open - 1] == '$')) {
+			open++;
+			continue;
+		}
+
+		// a pair of braces is only a brace expression if it holds a list or a range
+		int commas;
+		size_t close = findClosingBrace(text, open, length, &commas);
+		if (close == length) {
+			break;
+		}
+		struct braceGenerator* group = commas ? parseList(text + open + 1, close - open - 1, commas) :
+			parseRange(text + open + 1, close - open - 1);
+		if (!group) {
+			open++;
+			continue;
+		}
+
+		struct braceGenerator* generator = newGenerator(BRACE_PRODUCT);
+		generator->prefix = strndup(text, open);
+		generator->group = group;
+		generator->suffix = parseBraces(text + close + 1, length - close - 1);
+		return generator;
+	}
+
+	struct braceGenerator* generator = newGenerator(BRACE_TEXT);
+	generator->text = strndup(text, length);
+	return generator;
+}
+
+/*
+* Starts generator over from its first word
+*/
+static void resetBraces(struct braceGenerator* generator) {
+	generator->done = false;
+	generator->index = 0;
+	generator->groupWord = NULL;
+	for (int index = 0; index < generator->numAlternatives; index++) {
+		resetBraces(generator->alternatives[index]);
+	}
+	if (generator->group) {
+		resetBraces(generator->group);
+	}
+}
+
+/*
+* Stores the text of each part in the buffer of generator and returns the buffer
+*/
+static char* produceWord(struct braceGenerator* generator, char* first, char* second, char* third) {
+	size_t length = strlen(first) + strlen(second) + strlen(third) + 1;
+
+	if (length > generator->capacity) {
+		generator->capacity = length * 2;
+		generator->buffer = (char*)realloc(generator->buffer, generator->capacity);
+	}
+	strcpy(generator->buffer, first);
+	strcat(generator->buffer, second);
+	strcat(generator->buffer, third);
+	return generator->buffer;
+}
+
+/*
+* Returns a generator of the words word stands for, or NULL if word holds no brace expression - an unquoted
+* '{' and its matching '}' holding a ',' outside of any nested braces or a range. The words produced still hold
+* the quotes, escapes and variable references of word, which are expanded like those of any other word
+*/
+struct braceGenerator* startBraces(char* word) {
+	// most words hold no brace at all
+	if (!strchr(word, '{')) {
+		return NULL;
+	}
+
+	struct braceGenerator* generator = parseBraces(word, strlen(word));
+	if (generator->kind == BRACE_TEXT) {
+		freeBraces(generator);
+		return NULL;
+	}
+
+	return generator;
+}
+
+/*
+* Returns the next word produced by generator, which is overwritten by the following call, or NULL once every
+* word has been produced
+*/
+char* nextBrace(struct braceGenerator* generator) {
+	switch (generator->kind) {
+		case BRACE_TEXT:
+			if (generator->done) {
+				return NULL;
+			}
+			generator->done = true;
+			return generator->text;
+
+		case BRACE_RANGE: {
+			if (generator->index == generator->count) {
+				return NULL;
+			}
+			// the value wraps around rather than overflowing for a range near the ends of a long long
+			long long value = (long long)((unsigned long long)generator->start + generator->index++ * (unsigned long long)generator->step);
+			char text[32];
+			if (generator->characters) {
+				snprintf(text, sizeof(text), "%c", (char)value);
+			}
+			else {
+				snprintf(text, sizeof(text), "%0*lld", generator->width, value);
+			}
+			return produceWord(generator, text, "", "");
+		}
+
+		case BRACE_LIST:
+			// produce every word of each alternative in turn
+			while (generator->index < (unsigned long long)generator->numAlternatives) {
+				char* word = nextBrace(generator->alternatives[generator->index]);
+				if (word) {
+					return word;
+				}
+				generator->index++;
+			}
+			return NULL;
+
+		default:
+			// every word of the expression is combined with every word of the text after it
+			while (true) {
+				if (!generator->groupWord) {
+					generator->groupWord = nextBrace(generator->group);
+					if (!generator->groupWord) {
+						return NULL;
+					}
+					resetBraces(generator->suffix);
+				}
+				char* suffixWord = nextBrace(generator->suffix);
+				if (suffixWord) {
+					return produceWord(generator, generator->prefix, generator->groupWord, suffixWord);
+				}
+				generator->groupWord = NULL;
+			}
+	}
+}
+
+/*
+* Releases all memory allocated for generator
+*/
+void freeBraces(struct braceGenerator* generator) {
+	if (!generator) {
+		return;
+	}
+
+	for (int index = 0; index < generator->numAlternatives; index++) {
+		freeBraces(generator->alternatives[index]);
+	}
+	free(generator->alternatives);
+	freeBraces(generator->group);
+	freeBraces(generator->suffix);
+	free(generator->prefix);
+	free(generator->text);
+	free(generator->buffer);
+	free(generator);
+}
@@ -0,0 +1,65 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for brace expansion - "{a,b,c}" lists and "{1..100000}", "{01..10..2}" or "{a..z}"
+*	ranges - which is done by generators that produce one word at a time, so that a huge range never has to be
+*	held in memory at once
+*/
+
+// the kinds of brace generators
+#define BRACE_TEXT 0  // text without a brace expression, generated once
+#define BRACE_RANGE 1  // a numeric or character range
+#define BRACE_LIST 2  // a list of alternatives, each a generator of its own
+#define BRACE_PRODUCT 3  // text before a brace expression, the expression and the generator of the text after it
+
+/*
+* A struct representing a brace generator, which produces the words a word holding brace expressions stands for
+* in order - "x{a,b}{1..2}" produces xa1, xa2, xb1 and xb2
+*/
+struct braceGenerator {
+	int kind;  // BRACE_TEXT, BRACE_RANGE, BRACE_LIST or BRACE_PRODUCT
+	char* text;  // the text of a BRACE_TEXT generator
+	char* buffer;  // the word produced last
+	size_t capacity;  // the size of buffer
+	bool done;  // true once a BRACE_TEXT generator has produced its text
+	long long start;  // the first value of a range
+	long long step;  // the difference between successive values of a range, negative for a decreasing range
+	unsigned long long count;  // the number of values of a range
+	unsigned long long index;  // the index of the next value of a range, or of the current alternative of a list
+	int width;  // the width numbers of a range are padded to with zeros, 0 for no padding
+	bool characters;  // true if a range is of characters rather than numbers
+	struct braceGenerator** alternatives;  // the alternatives of a list
+	int numAlternatives;  // the number of alternatives of a list
+	char* prefix;  // the text before the brace expression of a product
+	struct braceGenerator* group;  // the brace expression of a product
+	char* groupWord;  // the word the brace expression of a product produced last, NULL before the first
+	struct braceGenerator* suffix;  // the generator of the text after the brace expression of a product
+};
+
+/*
+* A struct representing an item of a chunked command holding a brace expression, whose words are produced as the
+* batches of the command are filled rather than when the command is parsed
+*/
+struct braceItem {
+	char* arg;  // the element of argv holding the item, still unexpanded
+	struct braceGenerator* generator;  // the generator of the words of the item
+};
+
+/*
+* Returns a generator of the words word stands for, or NULL if word holds no brace expression - an unquoted
+* '{' and its matching '}' holding a ',' outside of any nested braces or a range. The words produced still hold
+* the quotes, escapes and variable references of word, which are expanded like those of any other word
+*/
+struct braceGenerator* startBraces(char* word);
+
+/*
+* Returns the next word produced by generator, which is overwritten by the following call, or NULL once every
+* word has been produced
+*/
+char* nextBrace(struct braceGenerator* generator);
+
+/*
+* Releases all memory allocated for generator
+*/
+void freeBraces(struct braceGenerator* generator);
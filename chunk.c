@@ -0,0 +1,352 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Accounting for the size limit the kernel places on the arguments and environment of a program,
+*	and the chunk built-in command, which runs a command whose argument list is too long as a series of
+*	batches that each fit the limit
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <glob.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "functions.h"
+#include "braces.h"
+#include "chunk.h"
+
+/*
+* A struct representing the position reached in the items of a chunked command while its batches are filled. An
+* item holding a brace expression is expanded a word at a time, and a word that is a pattern a path at a time
+*/
+struct itemCursor {
+	struct command* command;  // the chunked command
+	char* item;  // the next item to place in a batch, NULL once every item has been placed
+	int next;  // the index in argv of the item after the one being expanded
+	int nextBraceItem;  // the index in braceItems of the next item holding a brace expression
+	struct braceGenerator* generator;  // the generator of the item being expanded, NULL if there is none
+	glob_t matches;  // the paths matched by the word being expanded
+	size_t nextMatch;  // the index in matches of the next path, valid while matching is true
+	bool matching;  // true while the paths of matches are being placed
+};
+
+/*
+* Returns the number of bytes the kernel counts against its limit for the provided NULL terminated array of
+* strings - each string with its null character plus the pointer to it
+*/
+size_t argumentSize(char** strings) {
+	size_t size = 0;
+
+	for (int index = 0; strings[index]; index++) {
+		size += strlen(strings[index]) + 1 + sizeof(char*);
+	}
+
+	return size;
+}
+
+/*
+* Returns the number of strings in the provided NULL terminated array of strings
+*/
+static int countStrings(char** strings) {
+	int count = 0;
+
+	while (strings[count]) {
+		count++;
+	}
+
+	return count;
+}
+
+/*
+* Returns the number of bytes of arguments and environment a program may be executed with
+*/
+size_t argumentLimit(void) {
+	// the limit follows the stack size limit, which does not change while the shell runs
+	static size_t limit = 0;
+
+	if (limit == 0) {
+		long argMax = sysconf(_SC_ARG_MAX);
+		limit = (argMax > ARGUMENT_HEADROOM ? argMax : 131072) - ARGUMENT_HEADROOM;
+	}
+
+	return limit;
+}
+
+/*
+* Parses the arguments of the built-in "chunk" command - chunk [-P JOBS] command [args...] [::: items...] -
+* and strips them from the argv array so that the remaining command can be executed normally with the items
+* split into batches that each fit the kernel's limit. Without ":::" every argument is an item. JOBS batches
+* run at once, 0 meaning one per CPU. Returns false after displaying an error message if the arguments are
+* invalid
+*/
+bool applyChunk(struct command* command) {
+	// declare and initialize a variable used to maintain the index of the argument being parsed
+	int index = 1;
+	// declare and initialize a variable used to store the number of batches run at once
+	long jobs = 1;
+
+	// "-P JOBS" sets how many batches run at once
+	if (command->argv[index] && strcmp(command->argv[index], "-P") == 0 && command->argv[index + 1]) {
+		char* end;
+		jobs = strtol(command->argv[index + 1], &end, 10);
+		if (*end != '\0' || end == command->argv[index + 1] || jobs < 0) {
+			printf("chunk: %s: invalid number of jobs\n", command->argv[index + 1]);
+			fflush(stdout);
+			return false;
+		}
+		index += 2;
+	}
+
+	// a command to run is required, and it cannot be the separator
+	if (!command->argv[index] || strcmp(command->argv[index], CHUNK_SEPARATOR) == 0) {
+		printf("usage: chunk [-P JOBS] command [args...] [" CHUNK_SEPARATOR " items...]\n");
+		fflush(stdout);
+		return false;
+	}
+
+	// strip the arguments that belonged to the chunk command itself
+	removeLeadingArgs(command, index);
+
+	// a function is given all of its items at once, so any brace expressions among them are expanded now
+	if (findFunction(command->pathName)) {
+		expandBraceItems(command);
+	}
+
+	// the items start after the separator, which is removed, or right after the command without one
+	command->chunkStart = 1;
+	for (index = 1; command->argv[index]; index++) {
+		if (strcmp(command->argv[index], CHUNK_SEPARATOR) == 0) {
+			free(command->argv[index]);
+			memmove(command->argv + index, command->argv + index + 1, (countStrings(command->argv + index + 1) + 1) * sizeof(char*));
+			command->chunkStart = index;
+			break;
+		}
+	}
+
+	// JOBS of 0 runs one batch per CPU
+	if (jobs == 0) {
+		jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	command->chunkJobs = jobs > 0 ? jobs : 1;
+
+	return true;
+}
+
+/*
+* Checks that the arguments of a command that is not chunked fit the kernel's limit together with environment.
+* Returns true if they do, otherwise false after displaying how far over the limit they are
+*/
+bool checkArgumentSize(struct command* command, char** environment) {
+	// NAME=value assignments prefixing the command are added to its environment
+	size_t size = argumentSize(command->argv) + argumentSize(command->assignments) + argumentSize(environment) + 2 * sizeof(char*);
+
+	// the total of the arguments and the environment is limited
+	if (size > argumentLimit()) {
+		printf("%s: argument list too long (%zu bytes of arguments and environment, the limit is %zu) - use chunk to run it in batches\n",
+			command->pathName, size, argumentLimit());
+		fflush(stdout);
+		return false;
+	}
+
+	// and so is each argument on its own
+	for (int index = 0; command->argv[index]; index++) {
+		size_t length = strlen(command->argv[index]) + 1;
+		if (length > MAX_ARGUMENT_LENGTH) {
+			printf("%s: argument %d too long (%zu bytes, the limit is %d)\n", command->pathName, index, length, MAX_ARGUMENT_LENGTH);
+			fflush(stdout);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+* Moves cursor to the next item of its command, which is newly allocated and stored in cursor->item, or NULL once
+* every item has been placed. Items holding brace expressions or patterns are expanded here, in the child
+* running the batches, one word or path at a time
+*/
+static void advanceItem(struct itemCursor* cursor) {
+	struct command* command = cursor->command;
+
+	while (true) {
+		// the paths matched by a word of a brace expression
+		if (cursor->matching) {
+			if (cursor->nextMatch < cursor->matches.gl_pathc) {
+				cursor->item = strdup(cursor->matches.gl_pathv[cursor->nextMatch++]);
+				return;
+			}
+			globfree(&cursor->matches);
+			cursor->matching = false;
+		}
+
+		// the words of a brace expression, each expanded like a word of its own
+		if (cursor->generator) {
+			char* word = nextBrace(cursor->generator);
+			if (word && isPattern(word)) {
+				char* pattern = expandWord(word, true);
+				cursor->matching = glob(pattern, 0, NULL, &cursor->matches) == 0;
+				cursor->nextMatch = 0;
+				free(pattern);
+				if (cursor->matching) {
+					continue;
+				}
+			}
+			if (word) {
+				cursor->item = expandWord(word, false);
+				return;
+			}
+			cursor->generator = NULL;
+		}
+
+		// the next item of argv, which was expanded when the command was parsed unless it holds a brace expression
+		char* arg = command->argv[cursor->next];
+		if (!arg) {
+			cursor->item = NULL;
+			return;
+		}
+		cursor->next++;
+		if (cursor->nextBraceItem < command->numBraceItems && arg == command->braceItems[cursor->nextBraceItem].arg) {
+			cursor->generator = command->braceItems[cursor->nextBraceItem++].generator;
+			continue;
+		}
+		cursor->item = strdup(arg);
+		return;
+	}
+}
+
+/*
+* Places as many items as fit the kernel's limit into batch after the arguments before the items, starting with
+* cursor->item, and returns how many were placed. batch, whose room for items is in capacity, is grown as needed.
+* fixedSize is the number of bytes every batch uses before any item is added. An item that does not fit even on
+* its own is skipped, setting exitStatus to 1 if it is still 0
+*/
+static int fillBatch(struct itemCursor* cursor, char*** batch, int* capacity, size_t fixedSize, int* exitStatus) {
+	// declare and initialize a variable used to store the index in batch of the first item
+	int start = cursor->command->chunkStart;
+	// declare and initialize a variable used to store the bytes the batch uses so far
+	size_t size = fixedSize;
+	// declare and initialize a variable used to store the number of items placed
+	int count = 0;
+
+	while (cursor->item) {
+		size_t itemSize = strlen(cursor->item) + 1 + sizeof(char*);
+
+		// an item that does not fit even on its own is skipped
+		if (fixedSize + itemSize > argumentLimit() || itemSize - sizeof(char*) > MAX_ARGUMENT_LENGTH) {
+			printf("%s: argument too long for any batch (%zu bytes)\n", cursor->command->pathName, strlen(cursor->item) + 1);
+			fflush(stdout);
+			*exitStatus = *exitStatus ? *exitStatus : 1;
+			free(cursor->item);
+			advanceItem(cursor);
+			continue;
+		}
+		if (size + itemSize > argumentLimit()) {
+			break;
+		}
+
+		if (count == *capacity) {
+			*capacity *= 2;
+			*batch = (char**)realloc(*batch, (start + *capacity + 1) * sizeof(char*));
+		}
+		(*batch)[start + count++] = cursor->item;
+		size += itemSize;
+		advanceItem(cursor);
+	}
+
+	(*batch)[start + count] = NULL;
+	return count;
+}
+
+/*
+* Executes a chunked command, whose program is at executable, as a series of batches each holding as many items
+* as fit the kernel's limit, running up to command->chunkJobs batches at once. Called in a forked child of the
+* shell, which exits with status 0 if every batch succeeded, otherwise with the status of the first batch that
+* failed. Items are expanded as the batches are filled, so only the batches running are ever held in memory. If
+* all of the items fit in a single batch, they replace the argv array and nothing is executed
+*/
+void executeChunks(struct command* command, char* executable, char** environment) {
+	// declare and initialize the bytes every batch uses before any item is added - the arguments before the
+	// items, the environment and the two NULL pointers ending argv and the environment
+	size_t fixedSize = argumentSize(environment) + 2 * sizeof(char*);
+	// declare and initialize the position reached in the items
+	struct itemCursor cursor = { command, NULL, command->chunkStart, 0, NULL };
+	// declare and initialize a variable used to store the number of items a batch has room for
+	int capacity = 1024;
+	// declare and initialize a variable used to store the number of batches running
+	int running = 0;
+	// declare and initialize a variable used to store the exit status of the chunked command
+	int exitStatus = 0;
+	// declare a variable used to store the status of each batch
+	int batchStatus;
+
+	for (int index = 0; index < command->chunkStart; index++) {
+		fixedSize += strlen(command->argv[index]) + 1 + sizeof(char*);
+	}
+
+	// every batch starts with the arguments before the items
+	char** batch = (char**)malloc((command->chunkStart + capacity + 1) * sizeof(char*));
+	memcpy(batch, command->argv, command->chunkStart * sizeof(char*));
+	advanceItem(&cursor);
+	int count = fillBatch(&cursor, &batch, &capacity, fixedSize, &exitStatus);
+
+	// if everything fits in a single batch, the command is executed as usual
+	if (!cursor.item && exitStatus == 0) {
+		for (int index = command->chunkStart; command->argv[index]; index++) {
+			free(command->argv[index]);
+		}
+		free(command->argv);
+		command->argv = batch;
+		return;
+	}
+
+	while (count > 0 || running > 0) {
+		// start batches until chunkJobs are running or every item has been placed
+		if (count > 0 && running < command->chunkJobs) {
+			// For the following code structure, reference citation F
+			pid_t spawnPid = fork();
+			if (spawnPid == -1) {
+				perror("fork failed");
+				exitStatus = exitStatus ? exitStatus : 1;
+				break;
+			}
+			else if (spawnPid == 0) {
+				execve(executable, batch, environment);
+				printf("%s: %s\n", command->pathName, strerror(errno));
+				fflush(stdout);
+				_exit(1);
+			}
+			running++;
+
+			// the items of a running batch are no longer needed here
+			for (int index = 0; index < count; index++) {
+				free(batch[command->chunkStart + index]);
+			}
+			count = fillBatch(&cursor, &batch, &capacity, fixedSize, &exitStatus);
+			continue;
+		}
+
+		// wait for a batch to finish, keeping the status of the first one that failed
+		if (wait(&batchStatus) > 0) {
+			running--;
+			if (exitStatus == 0 && !(WIFEXITED(batchStatus) && WEXITSTATUS(batchStatus) == 0)) {
+				exitStatus = WIFEXITED(batchStatus) ? WEXITSTATUS(batchStatus) : 128 + WTERMSIG(batchStatus);
+			}
+		}
+		else {
+			break;
+		}
+	}
+
+	// _exit leaves the offset of a shared standard input alone, which exit would rewind to what stdio has read
+	free(batch);
+	fflush(stdout);
+	_exit(exitStatus);
+}
@@ -0,0 +1,52 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the size limit the kernel places on the arguments and environment of a program
+*	and the chunk built-in command, which splits an argument list that is too long into batches
+*/
+
+// the number of bytes kept free below the kernel's limit, as xargs does, so that a batch still fits after
+// the kernel adds its own bookkeeping
+#define ARGUMENT_HEADROOM 2048
+
+// the largest single argument or environment string the kernel accepts (MAX_ARG_STRLEN on Linux)
+#define MAX_ARGUMENT_LENGTH (32 * 4096)
+
+// the word separating the arguments passed to every batch from those split across batches
+#define CHUNK_SEPARATOR ":::"
+
+/*
+* Returns the number of bytes the kernel counts against its limit for the provided NULL terminated array of
+* strings - each string with its null character plus the pointer to it
+*/
+size_t argumentSize(char** strings);
+
+/*
+* Returns the number of bytes of arguments and environment a program may be executed with
+*/
+size_t argumentLimit(void);
+
+/*
+* Parses the arguments of the built-in "chunk" command - chunk [-P JOBS] command [args...] [::: items...] -
+* and strips them from the argv array so that the remaining command can be executed normally with the items
+* split into batches that each fit the kernel's limit. Without ":::" every argument is an item. JOBS batches
+* run at once, 0 meaning one per CPU. Returns false after displaying an error message if the arguments are
+* invalid
+*/
+bool applyChunk(struct command* command);
+
+/*
+* Checks that the arguments of a command that is not chunked fit the kernel's limit together with environment.
+* Returns true if they do, otherwise false after displaying how far over the limit they are
+*/
+bool checkArgumentSize(struct command* command, char** environment);
+
+/*
+* Executes a chunked command, whose program is at executable, as a series of batches each holding as many items
+* as fit the kernel's limit, running up to command->chunkJobs batches at once. Called in a forked child of the
+* shell, which exits with status 0 if every batch succeeded, otherwise with the status of the first batch that
+* failed. Items are expanded as the batches are filled, so only the batches running are ever held in memory. If
+* all of the items fit in a single batch, they replace the argv array and nothing is executed
+*/
+void executeChunks(struct command* command, char* executable, char** environment);
@@ -4,25 +4,67 @@
 * Title: Smallsh
 * Description: Functions associated with command excecution and termination
 */
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdio_ext.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
 #include <limits.h>
 #include <signal.h>
+#include <sched.h>
+#include <sys/resource.h>
 #include <errno.h>
+#include <sys/syscall.h>
 #include "dynamicArray.h"
 #include "parser.h"
 #include "signals.h"
 #include "memory.h"
+#include "variables.h"
+#include "events.h"
+#include "timeout.h"
+#include "zygote.h"
+#include "fanout.h"
+#include "jobs.h"
+#include "prompt.h"
+#include "functions.h"
+#include "chunk.h"
+#include "substitution.h"
+#include "placement.h"
+#include "joblog.h"
+#include "memo.h"
+#include "metrics.h"
+#include "lineReader.h"
+#include "onchange.h"
+
+// the names of the built-in commands, which are executed within the shell itself or change how the rest of the
+// command line is executed
+static char* builtinCommands[] = { "alias", "cd", "chunk", "exit", "export", "jobs", "joblog", "memo", "onchange", "read",
+	"status", "timeout", "ulimit", "unalias", "unset", "wait", NULL };
 
 /*
 * Prints the exit or termination status of a process based on the value in exitStatus
 */
 void status(int exitStatus) {
+	// if TIMED_OUT_FLAG is set, then the process was signalled because its timeout expired
+	if (exitStatus & TIMED_OUT_FLAG) {
+		printf("timed out, ");
+	}
+	// if a limit flag is set, then the process was stopped by the resource limit placed on it
+	if (exitStatus & CPU_LIMIT_FLAG) {
+		printf("CPU time limit reached, ");
+	}
+	if (exitStatus & FILE_LIMIT_FLAG) {
+		printf("file size limit reached, ");
+	}
+	if (exitStatus & MEMORY_LIMIT_FLAG) {
+		printf("memory limit reached, ");
+	}
+
 	// if WIFEXITED returns true, then the process was terminated normally
 	if (WIFEXITED(exitStatus)) {
 		// get and print the exit status via WEXITSTATUS 
@@ -38,30 +80,48 @@ void status(int exitStatus) {
 }
 
 /*
-* Changes the current working directory based on a user specified path
+* Changes the current working directory based on a user specified path. Returns false if the directory could not be
+* changed
 */
-void changeDirectory(struct command* command) {
+bool changeDirectory(struct command* command) {
 	// declare a character array of size PATH_MAX (reference citation H)
 	char currentWorkingDir[PATH_MAX];
-	// get the directory specified in the HOME environment variable and store it in a variable named home
-	char* home = getenv("HOME");
+	// get the directory specified in the HOME shell variable, which may have been changed or unset since smallsh
+	// started, and store it in a variable named home
+	char* home = getVariable("HOME");
 
 	// argv[1] is NULL then the user only entered "cd"
 	if (!command->argv[1]) {
-		// change to the directory specified in the HOME environment variable
+		// the working directory shown by the prompt has to be looked up again
+		invalidatePrompt(PROMPT_CWD);
+
+		// there is nowhere to go if HOME is unset or empty
+		if (!home || home[0] == '\0') {
+			// display an error message to the user
+			printf("cd: HOME not set\n");
+			// flush stdout
+			fflush(stdout);
+			return false;
+		}
+
+		// change to the directory specified in the HOME shell variable
 		if (chdir(home) == -1) {
 			// in the even that chdir fails to go home, display an error message to the user
-			printf("%s: Unable to go to home directory");
+			printf("%s: Unable to go to home directory\n", home);
 			// flush stdout
 			fflush(stdout);
+			return false;
 		}
-		return;  // exit the function
+		return true;  // exit the function
 	}
 
 	// get the current working directory and store in the currentWorkingDir variable
 	getcwd(currentWorkingDir, PATH_MAX);
-	// if home is detected in the path specified by the user then the user is specifying an absolute path
-	if (strncmp(command->argv[1], home, strlen(home)) == 0) {
+	// the working directory shown by the prompt has to be looked up again
+	invalidatePrompt(PROMPT_CWD);
+
+	// if the path specified by the user starts with '/' or home then the user is specifying an absolute path
+	if (command->argv[1][0] == '/' || (home && home[0] != '\0' && strncmp(command->argv[1], home, strlen(home)) == 0)) {
 		// since the path specified by the user is absolute, use chdir to change to the directory specified
 		// by the absolute path
 		if (chdir(command->argv[1]) == -1) {
@@ -70,6 +130,7 @@ void changeDirectory(struct command* command) {
 			printf("%s: No such file or directory\n", command->argv[1]);
 			// flush stdout
 			fflush(stdout);
+			return false;
 		}
 	}
 	// if home is not detected in the path specified by the user then the user is specifying a relative path
@@ -93,11 +154,16 @@ void changeDirectory(struct command* command) {
 			printf("%s: No such file or directory\n", command->argv[1]);
 			// flush stdout
 			fflush(stdout);
+			// free the memory allocated for path
+			free(path);
+			return false;
 		}
 
 		// free the memory allocated for path
 		free(path);
 	}
+
+	return true;
 }
 
 /*
@@ -117,8 +183,9 @@ void redirectInput(struct command* command, int* savedIn, bool* restoreIn, struc
 
 	// if command->inputRedirect is true then the user specified that they want the input redirected
 	if (command->inputRedirect) {
-		// get the file descriptor associated with where the input is being redirected from
-		targetInFD = open(command->newInput, O_RDONLY);
+		// get the file descriptor associated with where the input is being redirected from - the memory file holding
+		// the body of a here-document or here-string if there is one
+		targetInFD = command->inputFD != -1 ? dup(command->inputFD) : open(command->newInput, O_RDONLY);
 	}
 	// if command->inputRedirect wasn't true, then this function was called because the command being executed was flagged as a background
 	// command
@@ -150,6 +217,8 @@ void redirectInput(struct command* command, int* savedIn, bool* restoreIn, struc
 		// exit with status 1
 		exit(1);
 	}
+	// whatever the shell had read ahead of its old input is not part of the new one
+	__fpurge(stdin);
 }
 
 /*
@@ -167,8 +236,13 @@ void redirectOutput(struct command* command, int* savedOut, bool* restoreOut, st
 	// command execution
 	*restoreOut = true;
 
+	// if command->outputFD is set then the executor has already set up where the output goes, e.g. the pipe of
+	// an output fan-out
+	if (command->outputFD != -1) {
+		targetOutFD = command->outputFD;
+	}
 	// if command->outputRedirect is true then the user specified that they want the output redirected
-	if (command->outputRedirect) {
+	else if (command->outputRedirect) {
 		// get the file descriptor associated with where the output is being redirected to
 		targetOutFD = open(command->newOutput, O_WRONLY | O_CREAT | O_TRUNC, 0640);
 	}
@@ -234,70 +308,341 @@ void restoreIOStreams(bool restoreIn, int savedIn, bool restoreOut, int savedOut
 	}
 }
 
+/*
+* Displays the completion message of the background process at index in the backgroundPids array, whose wait status
+* is childStatus and resource usage is usage, and removes it from the backgroundPids array and the job table. Returns
+* the status of the process, noting whether its deadline expired
+*/
+int collectBackgroundProcess(struct dynamicArray* backgroundPids, int index, int childStatus, struct rusage* usage) {
+	// declare and initialize a variable used to hold the pid of the completed background process
+	pid_t backgroundPid = backgroundPids->staticArray[index];
+
+	// display message with the pid of the process that has completed
+	printf("background pid %d is done: ", backgroundPid);
+	// flush stdout
+	fflush(stdout);
+
+	// display the exit status or the terminating signal of the process that terminated, noting whether
+	// its deadline expired or a resource limit stopped it
+	childStatus |= finishDeadline(backgroundPid) | finishLimits(backgroundPid, childStatus, usage);
+	status(childStatus);
+	// a job that did not succeed shows the last lines of its captured output, if any
+	displayJobLogTail(backgroundPid, childStatus);
+
+	// delete the pid of the completed background process from the backgroundPids array and the job table
+	delete(backgroundPids, index);
+	removeJob(backgroundPid);
+
+	return childStatus;
+}
+
 /*
 * Terminates any background processes that have completed
 */
 void terminateBackgroundProcesses(struct dynamicArray* backgroundPids) {
-	// declare a variable used to hold a process id
-	pid_t backgroundPid;
 	// declare a variable used to hold the status of a background process
 	int backgroundPidStatus;
+	// declare a variable used to hold the resources used by a background process
+	struct rusage backgroundPidUsage;
 
 	// iterate over each background pid in the backgroundPids array
 	for (int index = 0; index < backgroundPids->size; index++) {
 		// use waitpid function and WNOHANG option to invoke a non-blocking wait on the background pid associated with the
 		// background pid at staticArray[index] - if waitpid returns a non-zero value, then the background process has 
 		// completed
-		if ((backgroundPid = waitpid(backgroundPids->staticArray[index], &backgroundPidStatus, WNOHANG)) != 0) {
-			// display message with the pid of the process that has completed
-			printf("background pid %d is done: ", backgroundPids->staticArray[index]);
-			// flush stdout
-			fflush(stdout);
+		if (wait4(backgroundPids->staticArray[index], &backgroundPidStatus, WNOHANG, &backgroundPidUsage) != 0) {
+			// report the completed process and revisit this index since the next pid has shifted into it
+			collectBackgroundProcess(backgroundPids, index, backgroundPidStatus, &backgroundPidUsage);
+			index--;
+		}
+	}
 
-			// display the exit status or the terminating signal of the process that terminated
-			status(backgroundPidStatus);
+	// reap the substituted commands of background commands that have terminated
+	reapSubstitutions();
 
-			// delete the pid of the completed background process from the backgroundPids array
-			delete(backgroundPids, index);
+	// publish the number of background processes still running and the CPU time of those reaped
+	updateJobMetrics(backgroundPids->size, 0);
+}
+
+/*
+* Waits for the foreground child process spawnPid to terminate and returns its wait status. While waiting,
+* the event loop keeps servicing the timers and other file descriptors of running processes
+*/
+int waitForForegroundProcess(pid_t spawnPid) {
+	// declare a variable used to store the exit or termination status of the child process
+	int childStatus;
+	// declare a variable used to store the resources used by the child process
+	struct rusage usage;
+	// get a pidfd for the child so the event loop can wait on it alongside everything else
+	int pidFD = syscall(SYS_pidfd_open, spawnPid, 0);
+
+	// if a pidfd is available, let the event loop run until the child terminates
+	if (pidFD != -1) {
+		waitForEvents(pidFD);
+		close(pidFD);
+	}
+
+	// reap the child - this only blocks if a pidfd was not available
+	wait4(spawnPid, &childStatus, 0, &usage);
+
+	// note whether the deadline of the child expired or a resource limit stopped it before it terminated
+	return childStatus | finishDeadline(spawnPid) | finishLimits(spawnPid, childStatus, &usage);
+}
+
+/*
+* Searches each directory listed in the PATH shell variable for an executable file called name and
+* returns the full path to the first one found. If name contains a '/' it is used as is. The returned
+* memory segment must be freed by the caller. NULL is returned if no executable could be found
+*/
+char* findExecutable(char* name) {
+	// declare and initialize a variable to hold the value of the PATH variable
+	char* path = getVariable("PATH");
+	// declare and initialize a variable used to walk the directories listed in path
+	char* directory = NULL;
+	// declare and initialize a variable that will hold each candidate file
+	char* candidate = NULL;
+
+	// a name containing a '/' is a path in its own right and is not searched for
+	if (strchr(name, '/')) {
+		candidate = (char*)malloc((strlen(name) + 1) * sizeof(char));
+		strcpy(candidate, name);
+		return candidate;
+	}
+
+	// fall back to the same default search path execvp uses when PATH is unset
+	if (!path) {
+		path = "/bin:/usr/bin";
+	}
+
+	// try each ':' separated directory in turn
+	directory = path;
+	while (true) {
+		// find the end of the current directory - an empty entry means the current working directory
+		char* separator = strchr(directory, ':');
+		int length = separator ? separator - directory : strlen(directory);
+
+		// build the candidate path "directory/name"
+		candidate = (char*)malloc((length + strlen(name) + 3) * sizeof(char));
+		if (length == 0) {
+			sprintf(candidate, "./%s", name);
 		}
+		else {
+			sprintf(candidate, "%.*s/%s", length, directory, name);
+		}
+
+		// if the candidate can be executed, it is the one
+		if (access(candidate, X_OK) == 0) {
+			return candidate;
+		}
+		free(candidate);
+
+		// move on to the next directory or stop if this was the last one
+		if (!separator) {
+			break;
+		}
+		directory = separator + 1;
 	}
+
+	return NULL;
 }
 
 /*
-* First checks if the command to be executed is one of three built-in commands - status, cd, or exit - and if so, the appropriate built-in
-* command function is called to execute the built-in command. If the command to be executed is not a built-in command, then this function
-* will fork of a child process which executes the user specified shell script
+* Asks the zygote to spawn the command, opening any redirection targets in the shell and passing them along.
+* Returns the pid of the spawned process or -1 if the zygote is not running or could not spawn the command, in
+* which case the command should be forked as usual so that any error is reported the usual way
 */
-void executeCommand(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag) {
-	// declare a variable used to store the exit or termination status of a child process
-	int childStatus;
-	// declare a variable used to store the pid of a forked child process
-	pid_t spawnPid;
-	// declare and initialize a variable used to signal if stdout stream should be restored
-	bool restoreOut = false;
-	// declare and initialize a variable used to store the file descriptor of the stdout stream to be
-	// restored if restoration is necessary
-	int savedOut;
-	// declare and initialize a variable used to signal if stdin stream should be restored
-	bool restoreIn = false;
-	// declare and initialize a variable used to store the file descriptor of the stdin stream to be
-	// restored if restoration is necessary
-	int savedIn;
-	
+pid_t spawnWithZygote(struct command* command, int foregroundFlag) {
+	// declare and initialize the file descriptors that replace stdin, stdout and stderr - -1 inherits the shell's
+	int fds[3] = { -1, -1, -1 };
+	// declare and initialize a variable used to store the pid of the spawned process
+	pid_t spawnPid = -1;
+	// declare and initialize a variable used to hold the path of the program to execute
+	char* executable = NULL;
+
+	// without a zygote the command is forked - as it is while a function call has redirected the standard streams
+	// of the shell, since the zygote does not share them
+	if (!zygoteRunning() || functionStreamsRedirected()) {
+		return -1;
+	}
+
+	// use the PATH variable to find the program - if it cannot be found let the forked child report the error
+	executable = findExecutable(command->pathName);
+	if (!executable) {
+		return -1;
+	}
+
+	// open the input redirection target, or "/dev/null" for a background process - a here-document or
+	// here-string is already open
+	if (command->inputFD != -1) {
+		fds[0] = fcntl(command->inputFD, F_DUPFD_CLOEXEC, 0);
+	}
+	else if (command->inputRedirect || command->backgroundProcess) {
+		fds[0] = open(command->inputRedirect ? command->newInput : "/dev/null", O_RDONLY | O_CLOEXEC);
+	}
+	// open the output redirection target, or "/dev/null" for a background process, unless the executor has already
+	// set up where the output goes
+	if (command->outputFD != -1) {
+		fds[1] = dup(command->outputFD);
+	}
+	else if (command->outputRedirect || command->backgroundProcess) {
+		fds[1] = open(command->outputRedirect ? command->newOutput : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+	}
+	// the error output goes where the executor has set up, e.g. the pipe of a job log
+	if (command->errorFD != -1) {
+		fds[2] = dup(command->errorFD);
+	}
+
+	// if a target could not be opened, let the forked child report the error
+	if (((command->inputRedirect || command->backgroundProcess) && fds[0] == -1) ||
+		((command->outputRedirect || command->backgroundProcess) && fds[1] == -1)) {
+		spawnPid = -1;
+	}
+	// any NAME=value assignments that prefixed the command only apply to the spawned process
+	else if (command->assignments[0]) {
+		char** environment = getEnvironmentWith(command->assignments);
+		spawnPid = zygoteSpawn(executable, command->argv, environment, fds, (!command->backgroundProcess || foregroundFlag) ? ZYGOTE_FOREGROUND : 0);
+		free(environment);
+	}
+	else {
+		spawnPid = zygoteSpawn(executable, command->argv, getEnvironment(), fds, (!command->backgroundProcess || foregroundFlag) ? ZYGOTE_FOREGROUND : 0);
+	}
+
+	// the spawned process has its own copies of the redirection targets
+	for (int index = 0; index < 3; index++) {
+		if (fds[index] != -1) {
+			close(fds[index]);
+		}
+	}
+	free(executable);
+
+	return spawnPid;
+}
+
+/*
+* Returns the NULL terminated array of the names of the built-in commands, which is shared by the executor and
+* completion so that a new built-in command is only ever added in one place
+*/
+char** getBuiltinNames(void) {
+	return builtinCommands;
+}
+
+/*
+* Returns true if name is the name of a built-in command
+*/
+bool isBuiltin(char* name) {
+	for (int index = 0; builtinCommands[index]; index++) {
+		if (strcmp(name, builtinCommands[index]) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+* Checks if the command to be executed is one of the built-in commands - status, cd, export, unset, jobs, joblog, wait, alias, unalias, ulimit, read, or exit - or only holds
+* NAME=value assignments and if so, executes it within the shell itself. Returns true if the command was handled as a built-in
+* command, otherwise false
+*/
+bool executeBuiltin(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus) {
+	// if argv[0] is NULL then the user only entered NAME=value assignments - store them as shell variables
+	if (!command->argv[0]) {
+		for (int index = 0; command->assignments[index]; index++) {
+			applyAssignment(command->assignments[index], false);
+		}
+		// return user back to command prompt
+		return true;
+	}
+
 	// if "status" is found as the first element of the argv array
 	if (strcmp(command->argv[0], "status") == 0) {
 		// execute built-in "status" command
 		status(*lastStatus);
 		// return user back to command prompt
-		return;
+		return true;
 	}
 
 	// if "cd" is found as the first element of the argv array
 	if (strcmp(command->argv[0], "cd") == 0) {
-		// execute built-in "cd" command
-		changeDirectory(command);
+		// execute built-in "cd" command - a directory that cannot be changed to is reported as exit value 1 via the
+		// status built-in command
+		if (!changeDirectory(command)) {
+			*lastStatus = 1 << 8;
+		}
 		// return the user back to command prompt
-		return;
+		return true;
+	}
+
+	// if "export" is found as the first element of the argv array
+	if (strcmp(command->argv[0], "export") == 0) {
+		// execute built-in "export" command
+		exportVariables(command);
+		// return the user back to command prompt
+		return true;
+	}
+
+	// if "unset" is found as the first element of the argv array
+	if (strcmp(command->argv[0], "unset") == 0) {
+		// execute built-in "unset" command
+		unsetVariables(command);
+		// return the user back to command prompt
+		return true;
+	}
+
+	// if "jobs" is found as the first element of the argv array
+	if (strcmp(command->argv[0], "jobs") == 0) {
+		// execute built-in "jobs" command
+		listJobs(command);
+		// return the user back to command prompt
+		return true;
+	}
+
+	// if "joblog" is found as the first element of the argv array
+	if (strcmp(command->argv[0], "joblog") == 0) {
+		// execute built-in "joblog" command
+		showJobLog(command, lastStatus);
+		// return the user back to command prompt
+		return true;
+	}
+
+	// if "wait" is found as the first element of the argv array
+	if (strcmp(command->argv[0], "wait") == 0) {
+		// execute built-in "wait" command
+		waitForJobs(command, backgroundPids, lastStatus);
+		// return the user back to command prompt
+		return true;
+	}
+
+	// if "alias" is found as the first element of the argv array - definitions never get this far
+	if (strcmp(command->argv[0], "alias") == 0) {
+		// execute built-in "alias" command
+		listAliases(command);
+		// return the user back to command prompt
+		return true;
+	}
+
+	// if "unalias" is found as the first element of the argv array
+	if (strcmp(command->argv[0], "unalias") == 0) {
+		// execute built-in "unalias" command
+		removeAliases(command);
+		// return the user back to command prompt
+		return true;
+	}
+
+	// if "ulimit" is found as the first element of the argv array
+	if (strcmp(command->argv[0], "ulimit") == 0) {
+		// execute built-in "ulimit" command
+		setResourceLimits(command, lastStatus);
+		// return the user back to command prompt
+		return true;
+	}
+
+	// if "read" is found as the first element of the argv array
+	if (strcmp(command->argv[0], "read") == 0) {
+		// execute built-in "read" command
+		readVariables(command, lastStatus);
+		// return the user back to command prompt
+		return true;
 	}
 
 	// if "exit" is found as the first element of the argv array
@@ -308,72 +653,530 @@ void executeCommand(struct command* command, struct dynamicArray* backgroundPids
 		exit(0);
 	}
 
-	// For the following code structure, reference citation F
+	// the command is not a built-in command
+	return false;
+}
 
-	// fork a child process and store the return value in spawnPid variable
-	spawnPid = fork();
-	// if spawnPid is -1, then fork failed
-	if (spawnPid == -1) {
-		// display error message to the user
-		perror("fork failed");
-		// exit with status 1
-		exit(1);
+/*
+* Executes the command in the current process, which must be a freshly forked child of the shell. Input and output are
+* redirected as requested, signal dispositions are set up for a foreground or background process and the program found
+* via the PATH variable replaces the current process, or the body of a shell function is executed. This function never returns
+*/
+void executeInChild(struct command* command, struct dynamicArray* backgroundPids, int foregroundFlag) {
+	// declare and initialize a variable used to signal if stdout stream should be restored
+	bool restoreOut = false;
+	// declare and initialize a variable used to store the file descriptor of the stdout stream to be
+	// restored if restoration is necessary
+	int savedOut;
+	// declare and initialize a variable used to signal if stdin stream should be restored
+	bool restoreIn = false;
+	// declare and initialize a variable used to store the file descriptor of the stdin stream to be
+	// restored if restoration is necessary
+	int savedIn;
+
+	// the program executed here is the one the pipes of any process substitutions are passed to
+	exposeSubstitutions(command);
+
+	// place the child on the CPUs chosen for it before anything runs
+	if (!applyPlacementInChild(command)) {
+		_exit(1);
 	}
-	// if spawnPid is 0, then we are in the forked child process
-	else if (spawnPid == 0) {
-		// if inputRedirect is true or the command is flagged as being a background process
-		if (command->inputRedirect || command->backgroundProcess) {
-			// redirect input stream
-			redirectInput(command, &savedIn, &restoreIn, backgroundPids);
+
+	// if inputRedirect is true or the command is flagged as being a background process
+	if (command->inputRedirect || command->backgroundProcess) {
+		// redirect input stream
+		redirectInput(command, &savedIn, &restoreIn, backgroundPids);
+	}
+
+	// if output redirect is true, the command is flagged as being a background process or the executor has set up where
+	// the output goes
+	if (command->outputRedirect || command->backgroundProcess || command->outputFD != -1) {
+		// redirect output stream
+		redirectOutput(command, &savedOut, &restoreOut, backgroundPids);
+	}
+
+	// redirect the error output stream if the executor has set up where it goes, e.g. the pipe of a job log
+	if (command->errorFD != -1) {
+		dup2(command->errorFD, STDERR_FILENO);
+	}
+
+	// if the command to be executed is not a background process or foregroundOnlyMode is set to 1, then
+	// the command is going to be a foreground process and should terminate itself upon receiving SIGINT
+	// from the OS - restore SIGINT back to it's default
+	if (!command->backgroundProcess || foregroundFlag) {
+		signal(SIGINT, SIG_DFL);
+	}
+
+	// declare and initialize an empty sigaction struct named ignore_action
+	struct sigaction ignore_action = { 0 };
+	// populate the ignore_action struct
+	fill_ignore_action(&ignore_action);
+	// register the ignore_action struct with SIGTSTP signal because any foreground or background child
+	// processes must ignore SIGTSTP
+	sigaction(SIGTSTP, &ignore_action, NULL);
+
+	// any NAME=value assignments that prefixed the command only apply to this child - export them here so
+	// the environment of the shell itself is left untouched
+	for (int index = 0; command->assignments[index]; index++) {
+		applyAssignment(command->assignments[index], true);
+	}
+
+	// a shell function run in the background, with a deadline or with process substitutions executes its body in this child, which forks
+	// the commands of the body itself
+	struct shellFunction* function = findFunction(command->pathName);
+	if (function) {
+		int functionStatus = 0;
+		detachZygote();
+		callFunction(function, command, backgroundPids, &functionStatus, foregroundFlag);
+		// _exit leaves the offset of a shared standard input alone, which exit would rewind to what stdio has read
+		fflush(stdout);
+		_exit(WIFSIGNALED(functionStatus) ? 128 + WTERMSIG(functionStatus) : WEXITSTATUS(functionStatus));
+	}
+
+	// use the PATH variable to find the correct program and execute it with the exported variables as its
+	// environment - the environment array is only rebuilt when an exported variable has changed
+	// declare and initialize a variable used to store why the program could not be executed
+	int execError = ENOENT;
+	char* executable = findExecutable(command->pathName);
+	if (executable) {
+		// a chunked command whose items do not fit in a single batch runs its batches from here
+		if (command->chunkJobs) {
+			executeChunks(command, executable, getEnvironment());
 		}
+		execve(executable, command->argv, getEnvironment());
+		execError = errno;
+		free(executable);
+	}
+
+	// if we return, then execve failed - restore all I/O streams
+	restoreIOStreams(restoreIn, savedIn, restoreOut, savedOut);
 
-		// if output redirect is true or the command is flagged as being a background process
-		if (command->outputRedirect || command->backgroundProcess) {
-			// redirect output stream
-			redirectOutput(command, &savedOut, &restoreOut, backgroundPids);
+	// count the failure on the metrics page and display an error message to the user
+	countExecFailure();
+	printf("%s: %s\n", command->pathName, strerror(execError));
+	// flush stdout
+	fflush(stdout);
+
+	// clean up memory and terminate any open background processes before exiting
+	cleanupMemoryAndExit(command, backgroundPids);
+
+	// exit with status 1 - _exit leaves the offset of a shared standard input alone, which exit would rewind to
+	// what stdio has read
+	_exit(1);
+}
+
+/*
+* Executes a command of a pipeline in the current process, which must be a freshly forked child of the shell whose
+* input and output are already connected to the pipes of the pipeline. "@" prefixes and "chunk" are applied and a
+* built-in command is executed here, anything else is handed to executeInChild. This function never returns
+*/
+static void executePipelineCommand(struct command* command, struct dynamicArray* backgroundPids, int lastStatus, int foregroundFlag) {
+	// a command of a pipeline has only the status of the command line before it
+	int builtinStatus = lastStatus;
+
+	// a timed command gets a process group of its own - only the command reading the input of the shell may take
+	// the terminal along, since the other commands of a foreground pipeline stay behind with the shell
+	enterDeadlineGroup(command, (!command->backgroundProcess || foregroundFlag) && command->inputFD == -1);
+
+	// connect the pipes before a built-in command writes anything
+	if (command->outputFD != -1) {
+		dup2(command->outputFD, STDOUT_FILENO);
+	}
+	if (command->inputFD != -1) {
+		dup2(command->inputFD, STDIN_FILENO);
+		__fpurge(stdin);
+	}
+
+	// "chunk" only changes how this command is executed
+	if (command->argv[0] && strcmp(command->argv[0], "chunk") == 0 && !applyChunk(command)) {
+		_exit(1);
+	}
+
+	// "exit" ends only this command, leaving the background processes of the shell alone
+	if (command->argv[0] && strcmp(command->argv[0], "exit") == 0) {
+		_exit(0);
+	}
+	if (executeBuiltin(command, backgroundPids, &builtinStatus)) {
+		// _exit leaves the offset of a shared standard input alone, which exit would rewind to what stdio has read
+		fflush(stdout);
+		_exit(WIFEXITED(builtinStatus) ? WEXITSTATUS(builtinStatus) : 1);
+	}
+
+	executeInChild(command, backgroundPids, foregroundFlag);
+}
+
+/*
+* Executes a pipeline - command and the commands linked to it through pipeNext - with the output of each command
+* connected to the input of the next through a pipe, unless either is redirected elsewhere. Every command runs in
+* its own child, in the background if the last command does. The status of the last command is stored in lastStatus
+*/
+void executePipeline(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag) {
+	// declare and initialize a variable used to store the number of commands in the pipeline
+	int numCommands = 0;
+	// declare and initialize a variable used to store whether the pipeline runs in the background
+	bool background = false;
+	// declare and initialize a variable used to store the end of the pipe the next command reads from
+	int readEnd = -1;
+	// declare and initialize a variable used to store the number of commands started
+	int numStarted = 0;
+	// declare and initialize a variable used to store the index of the current command
+	int index = 0;
+	// declare a variable used to store the current command of the pipeline
+	struct command* current;
+
+	for (current = command; current; current = current->pipeNext) {
+		// process substitutions and extra output targets are set up by the executor of a single command
+		if (current->numSubstitutions || current->teeOutputs[0]) {
+			printf("%s: process substitutions and more than one output target cannot be used in a pipeline\n", current->pathName);
+			fflush(stdout);
+			*lastStatus = 1 << 8;
+			return;
+		}
+		// "@NAME=VALUE" prefixes are recorded here so that the shell knows the limits placed on each command
+		if (current->argv[0] && current->argv[0][0] == '@' && !applyPlacement(current)) {
+			*lastStatus = 1 << 8;
+			return;
 		}
+		applyLimitDefaults(current);
+		// and so are "timeout" arguments, so that the shell runs the deadline of each command
+		if (current->argv[0] && strcmp(current->argv[0], "timeout") == 0 && !applyTimeout(current)) {
+			*lastStatus = 1 << 8;
+			return;
+		}
+		// the output of a memoized command is captured by the executor of a single command
+		if (current->argv[0] && strcmp(current->argv[0], "memo") == 0) {
+			printf("memo: cannot be used in a pipeline\n");
+			fflush(stdout);
+			*lastStatus = 1 << 8;
+			return;
+		}
+		background = current->backgroundProcess && !foregroundFlag;
+		numCommands++;
+	}
 
-		// if the command to be executed is not a background process or foregroundOnlyMode is set to 1, then
-		// the command is going to be a foreground process and should terminate itself upon receiving SIGINT
-		// from the OS - restore SIGINT back to it's default
-		if (!command->backgroundProcess || foregroundFlag) {
-			signal(SIGINT, SIG_DFL);
+	// declare and initialize variables used to store the pid of every command, whether its input was connected to
+	// a pipe and whether it was a background process before it was connected
+	pid_t* pids = (pid_t*)malloc(numCommands * sizeof(pid_t));
+	bool* piped = (bool*)calloc(numCommands, sizeof(bool));
+	bool* wasBackground = (bool*)malloc(numCommands * sizeof(bool));
+
+	for (current = command; current; current = current->pipeNext, index++) {
+		wasBackground[index] = current->backgroundProcess;
+	}
+
+	for (current = command, index = 0; current; current = current->pipeNext, index++) {
+		// declare and initialize a variable used to store the pipe to the next command
+		int ends[2] = { -1, -1 };
+
+		// the command reads the previous command's output unless its input is redirected
+		if (readEnd != -1 && !current->inputRedirect) {
+			current->inputRedirect = true;
+			current->inputFD = readEnd;
+			current->newInput = (char*)malloc(strlen("pipe") + 1);
+			strcpy(current->newInput, "pipe");
+			piped[index] = true;
 		}
+		else if (readEnd != -1) {
+			close(readEnd);
+		}
+		readEnd = -1;
 
-		// declare and initialize an empty sigaction struct named ignore_action
-		struct sigaction ignore_action = { 0 };
-		// populate the ignore_action struct
-		fill_ignore_action(&ignore_action);
-		// register the ignore_action struct with SIGTSTP signal because any foreground or background child
-		// processes must ignore SIGTSTP
-		sigaction(SIGTSTP, &ignore_action, NULL);
+		// and writes into the pipe to the next command unless its output is redirected
+		if (current->pipeNext && pipe2(ends, O_CLOEXEC) == -1) {
+			perror("pipe2 failed");
+			break;
+		}
+		if (current->pipeNext && !current->outputRedirect) {
+			current->outputFD = ends[1];
+		}
 
-		// call execvp function to execute the user specified commmand by using the PATH variable to find the correct
-		// shell script to be executed
-		execvp(command->pathName, command->argv);
+		// every command runs where the pipeline runs
+		current->backgroundProcess = background;
 
-		// if we return, then execvp failed - restore all I/O streams
-		restoreIOStreams(restoreIn, savedIn, restoreOut, savedOut);
+		// For the following code structure, reference citation F
+		uint64_t spawnStart = metricsClock();
+		pids[index] = fork();
+		if (pids[index] == -1) {
+			perror("fork failed");
+			if (ends[0] != -1) {
+				close(ends[0]);
+				close(ends[1]);
+				current->outputFD = -1;
+			}
+			break;
+		}
+		else if (pids[index] == 0) {
+			executePipelineCommand(current, backgroundPids, *lastStatus, foregroundFlag);
+		}
+		countSpawn(spawnStart);
+		watchLimits(current, pids[index]);
+		startDeadline(current, pids[index], !background && current->inputFD == -1);
+		numStarted++;
 
-		// display an error message to the user
-		printf("%s: No such file or directory\n", command->pathName);
-		// flush stdout
+		// only the children use the pipes
+		if (ends[1] != -1) {
+			close(ends[1]);
+			current->outputFD = -1;
+		}
+		if (piped[index]) {
+			close(current->inputFD);
+			current->inputFD = -1;
+		}
+		readEnd = ends[0];
+	}
+	if (readEnd != -1) {
+		close(readEnd);
+	}
+
+	// the commands run in the background like any other background process, each reported once it has completed
+	if (background) {
+		for (current = command, index = 0; index < numStarted; current = current->pipeNext, index++) {
+			append(backgroundPids, pids[index]);
+			addJob(pids[index], current);
+			printf("background pid is %d\n", pids[index]);
+		}
 		fflush(stdout);
+	}
+	// otherwise wait for every command, keeping the status of the last one
+	else {
+		for (index = 0; index < numStarted; index++) {
+			*lastStatus = waitForForegroundProcess(pids[index]);
+		}
+		*lastStatus = numStarted == numCommands ? *lastStatus : 1 << 8;
 
-		// clean up memory and terminate any open background processes before exiting
-		cleanupMemoryAndExit(command, backgroundPids);
+		// if the last command was terminated by SIGINT, display the signal just like for a single command
+		if (WIFSIGNALED(*lastStatus) && WTERMSIG(*lastStatus) == 2) {
+			printf("terminated by signal %d\n", WTERMSIG(*lastStatus));
+			fflush(stdout);
+		}
+	}
+
+	// leave the commands as they were built, as those of a function body are executed again - a command that was not
+	// started may still hold the end of a pipe
+	for (current = command, index = 0; current; current = current->pipeNext, index++) {
+		current->backgroundProcess = wasBackground[index];
+		if (piped[index]) {
+			if (current->inputFD != -1) {
+				close(current->inputFD);
+				current->inputFD = -1;
+			}
+			free(current->newInput);
+			current->newInput = NULL;
+			current->inputRedirect = false;
+		}
+	}
+	free(pids);
+	free(piped);
+	free(wasBackground);
+
+	// check for any completed background processes and clean them up
+	terminateBackgroundProcesses(backgroundPids);
+}
+
+/*
+* First checks if the command to be executed is one of the built-in commands - status, cd, export, unset, jobs, wait, timeout, chunk, onchange, or exit - and if so, the appropriate
+* built-in command function is called to execute the built-in command. A call of a shell function is executed within the shell itself unless it runs
+* in the background. Otherwise this function will fork of a child process which executes the user specified shell script
+*/
+void executeCommand(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag) {
+	// declare a variable used to store the exit or termination status of a child process
+	int childStatus;
+	// declare a variable used to store the pid of a forked child process
+	pid_t spawnPid;
+	// declare and initialize a variable used to store the fan-out of the output to several targets, if any
+	struct outputFanout* fanout = NULL;
+	// declare and initialize a variable used to store the shell function the command calls, if any
+	struct shellFunction* function = NULL;
+	// declare and initialize a variable used to store the job log capturing the output of a background job, if any
+	struct jobLog* jobLog = NULL;
+	// declare and initialize a variable used to store the result of a memoized command being cached, if any
+	struct memoRun* memoRun = NULL;
+	// declare a variable used to time spawning the command for the metrics page
+	uint64_t spawnStart;
+
+	// count the command on the metrics page
+	if (command->argv[0]) {
+		countCommand();
+	}
+
+	// the commands of a pipeline each run in a child of their own
+	if (command->pipeNext) {
+		executePipeline(command, backgroundPids, lastStatus, foregroundFlag);
+		return;
+	}
+
+	// "@NAME=VALUE" prefixes place the command, e.g. on a list of CPUs
+	if (command->argv[0] && command->argv[0][0] == '@') {
+		// record the placement in the command struct and strip the prefixes from argv
+		if (!applyPlacement(command)) {
+			// a prefix was invalid - report exit value 1 via the status built-in command
+			*lastStatus = 1 << 8;
+			return;
+		}
+	}
+
+	// if "onchange" is found as the first element of the argv array
+	if (command->argv[0] && strcmp(command->argv[0], "onchange") == 0) {
+		// watch the paths and rerun the rest of the command after every burst of changes until SIGINT
+		watchAndRun(command, backgroundPids, lastStatus, foregroundFlag);
+		return;
+	}
+
+	// if "timeout" is found as the first element of the argv array
+	if (command->argv[0] && strcmp(command->argv[0], "timeout") == 0) {
+		// record the deadline in the command struct and strip the timeout arguments from argv
+		if (!applyTimeout(command)) {
+			// the arguments were invalid - report exit value 1 via the status built-in command
+			*lastStatus = 1 << 8;
+			return;
+		}
+	}
+
+	// if "chunk" is found as the first element of the argv array
+	if (command->argv[0] && strcmp(command->argv[0], "chunk") == 0) {
+		// record how the arguments are split into batches and strip the chunk arguments from argv
+		if (!applyChunk(command)) {
+			// the arguments were invalid - report exit value 1 via the status built-in command
+			*lastStatus = 1 << 8;
+			return;
+		}
+	}
+
+	// if "memo" is found as the first element of the argv array
+	if (command->argv[0] && strcmp(command->argv[0], "memo") == 0) {
+		// mark the command as memoized and strip "memo" from argv - "memo --stats" leaves nothing to execute
+		if (!applyMemo(command, lastStatus)) {
+			return;
+		}
+	}
 
+	// if the command is a built-in command, it has already been executed within the shell
+	if (executeBuiltin(command, backgroundPids, lastStatus)) {
+		return;
+	}
+
+	// shell functions are looked up before the PATH variable
+	function = findFunction(command->argv[0]);
+
+	// a program whose arguments do not fit the kernel's limit cannot be executed - unless the command is chunked,
+	// report by how much rather than leaving execve to fail in the child
+	if (!function && !command->chunkJobs && !checkArgumentSize(command, getEnvironment())) {
+		// report exit value 1 via the status built-in command
+		*lastStatus = 1 << 8;
+		return;
+	}
+
+	// a memoized program run in the foreground is replayed from the memo cache if it has been cached, otherwise its
+	// output is cached while it runs
+	if (command->memoize && !function && !command->chunkJobs && !command->teeOutputs[0] && !command->numSubstitutions &&
+		(!command->backgroundProcess || foregroundFlag) && replayMemo(command, lastStatus, &memoRun)) {
+		// check for any completed background processes and clean them up
+		terminateBackgroundProcesses(backgroundPids);
+		return;
+	}
+
+	// if the output is redirected to more than one target, fan it out through a pipe
+	if (command->teeOutputs[0]) {
+		fanout = startFanout(command);
+		if (!fanout) {
+			// a target could not be opened - report exit value 1 via the status built-in command
+			*lastStatus = 1 << 8;
+			return;
+		}
+	}
+
+	// start the commands of any process substitutions so that they run alongside the command
+	if (command->numSubstitutions && !startSubstitutions(command, backgroundPids)) {
+		if (fanout) {
+			close(command->outputFD);
+			command->outputFD = -1;
+			finishFanout(fanout);
+		}
+		// report exit value 1 via the status built-in command
+		*lastStatus = 1 << 8;
+		return;
+	}
+
+	// a function call in the foreground without a deadline is executed within the shell itself, without a fork - unless
+	// its arguments hold process substitutions, whose pipes must stay open in the programs the body executes
+	if (function && (!command->backgroundProcess || foregroundFlag) && command->timeoutMs <= 0 && !command->numSubstitutions) {
+		executeFunction(function, command, backgroundPids, lastStatus, foregroundFlag);
+		// copy whatever output is still in the fan-out pipe into its targets
+		if (fanout) {
+			close(command->outputFD);
+			command->outputFD = -1;
+			finishFanout(fanout);
+		}
+		// check for any completed background processes and clean them up
+		terminateBackgroundProcesses(backgroundPids);
+		return;
+	}
+
+	// a background job may be spread across the cores or NUMA nodes
+	spreadPlacement(command, foregroundFlag);
+	// and is given the resource limits set with ulimit
+	applyLimitDefaults(command);
+	// and have its output captured into a job log
+	jobLog = startJobLog(command, foregroundFlag);
+
+	// For the following code structure, reference citation F
+
+	// if the zygote is running, let it spawn the command so that spawning does not get slower as the shell grows -
+	// a function or a chunked command is always forked since the child executes the body or the batches, and so is a
+	// command with process substitutions, a placement or a timeout since the zygote cannot pass on their pipes, set its
+	// CPUs, limit it or move it into a process group of its own
+	spawnStart = metricsClock();
+	spawnPid = (function || command->chunkJobs || command->numSubstitutions || command->placement || command->timeoutMs > 0) ? -1 : spawnWithZygote(command, foregroundFlag);
+	// if the zygote did not spawn the command, fork a child process and store the return value in spawnPid variable
+	if (spawnPid == -1) {
+		spawnPid = fork();
+	}
+	// if spawnPid is -1, then fork failed
+	if (spawnPid == -1) {
+		// display error message to the user
+		perror("fork failed");
 		// exit with status 1
 		exit(1);
 	}
+	// if spawnPid is 0, then we are in the forked child process
+	else if (spawnPid == 0) {
+		// a timed command gets a process group of its own, which takes the terminal along in the foreground
+		enterDeadlineGroup(command, !command->backgroundProcess || foregroundFlag);
+		// redirect I/O, set up signals and execute the command - this never returns
+		executeInChild(command, backgroundPids, foregroundFlag);
+	}
 	// we are in the parent process
 	else {
+		// record how long spawning took on the metrics page
+		countSpawn(spawnStart);
+		// remember the resource limits placed on the child so that its status can tell which one stopped it
+		watchLimits(command, spawnPid);
+		// only the child writes into the fan-out pipe
+		if (fanout) {
+			close(command->outputFD);
+			command->outputFD = -1;
+		}
+		// only the child and the substituted commands use the pipes of process substitutions
+		closeSubstitutions(command);
+
 		// if the child process being executed is not a background process or if foregroundOnlyMode is set to 1,
 		// then the child process will  be executed in the foreground and the parent must wait for the child to
 		// terminate before continuing
 		if (!command->backgroundProcess || foregroundFlag) {
-			// user waitpid with the spawnPid to wait for the child process to terminate
-			spawnPid = waitpid(spawnPid, &childStatus, 0);
+			// start the deadline of the child process if it was run with a timeout
+			startDeadline(command, spawnPid, true);
+			// wait for the child process to terminate
+			childStatus = waitForForegroundProcess(spawnPid);
+			// copy whatever output is still in the fan-out pipe into its targets
+			if (fanout) {
+				finishFanout(fanout);
+			}
+			// the substituted commands are reaped along with the command
+			waitSubstitutions(command, false);
+			// write the output of a memoized command where it belongs and add it to the memo cache
+			if (memoRun) {
+				finishMemo(memoRun, command, childStatus);
+			}
 			// set the value of the address in lastStatus equal to the value in childStatus - this will be used to
 			// determine the exit status or termination signal of the child process
 			*lastStatus = childStatus;
@@ -391,6 +1194,17 @@ void executeCommand(struct command* command, struct dynamicArray* backgroundPids
 		else {
 			// append the pid of the child process to the backgroundPids array in order to check when it has completed
 			append(backgroundPids, spawnPid);
+			// add the child process to the job table so that it can be waited for, and let its job log know which
+			// job it belongs to
+			attachJobLog(jobLog, command, spawnPid, addJob(spawnPid, command));
+			// start the deadline of the child process if it was run with a timeout
+			startDeadline(command, spawnPid, false);
+			// the event loop keeps copying the output of the background process into its targets
+			if (fanout) {
+				detachFanout(fanout);
+			}
+			// the substituted commands are reaped once they terminate
+			waitSubstitutions(command, true);
 			// display a message about the pid of the child process to the user
 			printf("background pid is %d\n", spawnPid);
 			// flush stdout
@@ -11,9 +11,10 @@
 void status(int exitStatus);
 
 /*
-* Changes the current working directory based on a user specified path
+* Changes the current working directory based on a user specified path. Returns false if the directory could not be
+* changed
 */
-void changeDirectory(struct command* command);
+bool changeDirectory(struct command* command);
 
 /*
 * Redirects the input stream from stdin to the input stream specified by the user. In the event that the process being run is
@@ -32,14 +33,73 @@ void redirectOutput(struct command* command, int* savedOut, bool* restoreOut, st
 */
 void restoreIOStreams(bool restoreIn, int savedIn, bool restoreOut, int savedOut);
 
+/*
+* Displays the completion message of the background process at index in the backgroundPids array, whose wait status
+* is childStatus and resource usage is usage, and removes it from the backgroundPids array and the job table. Returns
+* the status of the process, noting whether its deadline expired
+*/
+int collectBackgroundProcess(struct dynamicArray* backgroundPids, int index, int childStatus, struct rusage* usage);
+
 /*
 * Terminates any background processes that have completed
 */
 void terminateBackgroundProcesses(struct dynamicArray* backgroundPids);
 
 /*
-* First checks if the command to be executed is one of three built-in commands - status, cd, or exit - and if so, the appropriate built-in
-* command function is called to execute the built-in command. If the command to be executed is not a built-in command, then this function
-* will fork of a child process which executes the user specified shell script
+* Waits for the foreground child process spawnPid to terminate and returns its wait status. While waiting,
+* the event loop keeps servicing the timers and other file descriptors of running processes
+*/
+int waitForForegroundProcess(pid_t spawnPid);
+
+/*
+* Searches each directory listed in the PATH shell variable for an executable file called name and
+* returns the full path to the first one found. If name contains a '/' it is used as is. The returned
+* memory segment must be freed by the caller. NULL is returned if no executable could be found
+*/
+char* findExecutable(char* name);
+
+/*
+* Asks the zygote to spawn the command, opening any redirection targets in the shell and passing them along.
+* Returns the pid of the spawned process or -1 if the zygote is not running or could not spawn the command, in
+* which case the command should be forked as usual so that any error is reported the usual way
+*/
+pid_t spawnWithZygote(struct command* command, int foregroundFlag);
+
+/*
+* Returns the NULL terminated array of the names of the built-in commands, which is shared by the executor and
+* completion so that a new built-in command is only ever added in one place
+*/
+char** getBuiltinNames(void);
+
+/*
+* Returns true if name is the name of a built-in command
+*/
+bool isBuiltin(char* name);
+
+/*
+* Checks if the command to be executed is one of the built-in commands - status, cd, export, unset, jobs, joblog, wait, alias, unalias, ulimit, read, or exit - or only holds
+* NAME=value assignments and if so, executes it within the shell itself. Returns true if the command was handled as a built-in
+* command, otherwise false
+*/
+bool executeBuiltin(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus);
+
+/*
+* Executes the command in the current process, which must be a freshly forked child of the shell. Input and output are
+* redirected as requested, signal dispositions are set up for a foreground or background process and the program found
+* via the PATH variable replaces the current process, or the body of a shell function is executed. This function never returns
+*/
+void executeInChild(struct command* command, struct dynamicArray* backgroundPids, int foregroundFlag);
+
+/*
+* Executes a pipeline - command and the commands linked to it through pipeNext - with the output of each command
+* connected to the input of the next through a pipe, unless either is redirected elsewhere. Every command runs in
+* its own child, in the background if the last command does. The status of the last command is stored in lastStatus
+*/
+void executePipeline(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag);
+
+/*
+* First checks if the command to be executed is one of the built-in commands - status, cd, export, unset, jobs, wait, timeout, chunk, onchange, or exit - and if so, the appropriate
+* built-in command function is called to execute the built-in command. A call of a shell function is executed within the shell itself unless it runs
+* in the background. Otherwise this function will fork of a child process which executes the user specified shell script
 */
 void executeCommand(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag);
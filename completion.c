@@ -0,0 +1,587 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Tab completion - command names are completed from a prefix trie of every executable on PATH,
+*	which is built by a background thread and rebuilt when PATH or one of its directories changes, and file
+*	paths are completed from a cache of sorted directory listings
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "variables.h"
+#include "commandExecution.h"
+#include "completion.h"
+
+// the search path used when PATH is not set, the same one findExecutable falls back to
+#define DEFAULT_PATH "/bin:/usr/bin"
+
+/*
+* A struct representing the state of completion. The trie member is only used by the shell itself while the
+* builder thread hands each trie it finishes over through builtTrie, which is protected by lock
+*/
+struct completionState {
+	struct executableTrie* trie;  // the trie used to complete command names
+	struct executableTrie* builtTrie;  // a trie the builder thread has finished but the shell has not picked up yet
+	bool building;  // true while a builder thread has not been joined, otherwise false
+	pthread_t builder;  // the thread building a new trie
+	pthread_mutex_t lock;  // protects builtTrie
+	struct directoryListing* directories;  // the cached directory listings, most recently used first
+	int numDirectories;  // the number of cached directory listings
+};
+
+// the single completion state used by smallsh
+static struct completionState completion = { NULL, NULL, false, 0, PTHREAD_MUTEX_INITIALIZER, NULL, 0 };
+
+/*
+* Adds name to the trie below root, keeping the children of every node sorted
+*/
+static void insertName(struct trieNode* root, char* name) {
+	struct trieNode* node = root;
+	// declare a variable used to remember every node along the name so that their name counts can be updated
+	struct trieNode* path[NAME_MAX + 1];
+	int depth = 0;
+
+	path[depth++] = root;
+	for (char* current = name; *current && depth <= NAME_MAX; current++) {
+		// find the child for the current character or the place it belongs in the sorted list of children
+		struct trieNode** link = &node->child;
+		while (*link && (unsigned char)(*link)->key < (unsigned char)*current) {
+			link = &(*link)->sibling;
+		}
+		if (!*link || (*link)->key != *current) {
+			struct trieNode* newNode = (struct trieNode*)calloc(1, sizeof(struct trieNode));
+			newNode->key = *current;
+			newNode->sibling = *link;
+			*link = newNode;
+		}
+		node = *link;
+		path[depth++] = node;
+	}
+
+	// a name found in several directories is only counted once
+	if (!node->terminal) {
+		node->terminal = true;
+		for (int index = 0; index < depth; index++) {
+			path[index]->numNames++;
+		}
+	}
+}
+
+/*
+* Releases every node below node
+*/
+static void freeNodes(struct trieNode* node) {
+	struct trieNode* child = node->child;
+
+	while (child) {
+		struct trieNode* sibling = child->sibling;
+		freeNodes(child);
+		free(child);
+		child = sibling;
+	}
+}
+
+/*
+* Releases all memory allocated for trie
+*/
+static void freeTrie(struct executableTrie* trie) {
+	if (trie) {
+		freeNodes(&trie->root);
+		free(trie->path);
+		free(trie->modifiedTimes);
+		free(trie);
+	}
+}
+
+/*
+* Returns true if the directory at path was modified at a different time than modifiedTime, or if it can no
+* longer be looked at
+*/
+static bool directoryChanged(char* path, struct timespec* modifiedTime) {
+	struct stat info;
+
+	if (stat(path, &info) == -1) {
+		return modifiedTime->tv_sec != 0 || modifiedTime->tv_nsec != 0;
+	}
+	return info.st_mtim.tv_sec != modifiedTime->tv_sec || info.st_mtim.tv_nsec != modifiedTime->tv_nsec;
+}
+
+/*
+* Builds the trie of every executable in the ':' separated directories of path along with the built-in
+* commands. Run by the builder thread, so it may not touch any state of the shell
+*/
+static void* buildTrie(void* argument) {
+	// the builder thread owns the copy of PATH it was started with
+	struct executableTrie* trie = (struct executableTrie*)calloc(1, sizeof(struct executableTrie));
+	trie->path = (char*)argument;
+
+	// count the directories so that their modification times can be recorded
+	trie->numDirectories = 1;
+	for (char* current = trie->path; *current; current++) {
+		trie->numDirectories += *current == ':';
+	}
+	trie->modifiedTimes = (struct timespec*)calloc(trie->numDirectories, sizeof(struct timespec));
+
+	// add every executable file of each directory - an empty entry means the current working directory
+	char* directory = trie->path;
+	for (int index = 0; index < trie->numDirectories; index++) {
+		char* separator = strchr(directory, ':');
+		int length = separator ? separator - directory : strlen(directory);
+		char* name = (char*)malloc((length + 2) * sizeof(char));
+		struct stat info;
+
+		strncpy(name, directory, length);
+		strcpy(name + length, length ? "" : ".");
+
+		// record the modification time before reading so a change made while reading triggers a rebuild
+		if (stat(name, &info) == 0) {
+			trie->modifiedTimes[index] = info.st_mtim;
+		}
+
+		DIR* stream = opendir(name);
+		if (stream) {
+			struct dirent* entry;
+			while ((entry = readdir(stream))) {
+				if (entry->d_name[0] != '.' && fstatat(dirfd(stream), entry->d_name, &info, 0) == 0 &&
+					S_ISREG(info.st_mode) && (info.st_mode & 0111)) {
+					insertName(&trie->root, entry->d_name);
+				}
+			}
+			closedir(stream);
+		}
+		free(name);
+
+		directory = separator ? separator + 1 : directory + length;
+	}
+
+	// the built-in commands are always available
+	char** builtinNames = getBuiltinNames();
+	for (int index = 0; builtinNames[index]; index++) {
+		insertName(&trie->root, builtinNames[index]);
+	}
+
+	// hand the trie over to the shell
+	pthread_mutex_lock(&completion.lock);
+	completion.builtTrie = trie;
+	pthread_mutex_unlock(&completion.lock);
+
+	return NULL;
+}
+
+/*
+* Installs the trie finished by the builder thread, if there is one. If block is true this waits for a
+* builder thread that is still running
+*/
+static void collectTrie(bool block) {
+	// declare a variable used to store whether the builder thread has finished
+	bool finished;
+
+	if (!completion.building) {
+		return;
+	}
+
+	pthread_mutex_lock(&completion.lock);
+	finished = completion.builtTrie != NULL;
+	pthread_mutex_unlock(&completion.lock);
+	if (!finished && !block) {
+		return;
+	}
+
+	// replace the old trie with the new one
+	pthread_join(completion.builder, NULL);
+	freeTrie(completion.trie);
+	completion.trie = completion.builtTrie;
+	completion.builtTrie = NULL;
+	completion.building = false;
+}
+
+/*
+* Returns the value of PATH that the trie should be built from
+*/
+static char* currentPath(void) {
+	char* path = getVariable("PATH");
+
+	return path ? path : DEFAULT_PATH;
+}
+
+/*
+* Returns true if the trie has to be rebuilt because PATH or one of its directories has changed
+*/
+static bool trieStale(void) {
+	char* directory;
+
+	if (!completion.trie) {
+		return true;
+	}
+	if (strcmp(completion.trie->path, currentPath()) != 0) {
+		return true;
+	}
+
+	// look at the modification time of each directory listed in PATH
+	directory = completion.trie->path;
+	for (int index = 0; index < completion.trie->numDirectories; index++) {
+		char* separator = strchr(directory, ':');
+		int length = separator ? separator - directory : strlen(directory);
+		char name[length + 2];
+
+		strncpy(name, directory, length);
+		strcpy(name + length, length ? "" : ".");
+		if (directoryChanged(name, &completion.trie->modifiedTimes[index])) {
+			return true;
+		}
+
+		directory = separator ? separator + 1 : directory + length;
+	}
+
+	return false;
+}
+
+/*
+* Starts building the trie of executable names in the background so that it is ready by the time it is
+* needed. Nothing happens if the trie is already built or being built
+*/
+void prepareCompletion(void) {
+	// pick up a trie that finished building since the last call
+	collectTrie(false);
+
+	// start building a new trie if there is none yet or the current one is out of date
+	if (!completion.building && trieStale()) {
+		char* path = currentPath();
+		char* pathCopy = (char*)malloc((strlen(path) + 1) * sizeof(char));
+
+		strcpy(pathCopy, path);
+		if (pthread_create(&completion.builder, NULL, buildTrie, pathCopy) == 0) {
+			completion.building = true;
+		}
+		else {
+			free(pathCopy);
+		}
+	}
+}
+
+/*
+* Adds a copy of the first length characters of text followed by suffix to the candidates of completions
+*/
+static void addCandidate(struct completions* completions, char* text, int length, char* suffix) {
+	// beyond the limit candidates are only counted
+	if (completions->numCandidates >= MAX_COMPLETION_CANDIDATES) {
+		completions->numCandidates++;
+		return;
+	}
+	char* candidate = (char*)malloc((length + strlen(suffix) + 1) * sizeof(char));
+
+	strncpy(candidate, text, length);
+	strcpy(candidate + length, suffix);
+
+	completions->candidates = (char**)realloc(completions->candidates, (completions->numCandidates + 1) * sizeof(char*));
+	completions->candidates[completions->numCandidates] = candidate;
+	completions->numCandidates++;
+}
+
+/*
+* Adds every name below node to the candidates of completions, stopping once MAX_COMPLETION_CANDIDATES have
+* been collected. buffer holds the characters leading to node and has room for any name
+*/
+static void collectNames(struct trieNode* node, char* buffer, int length, struct completions* completions) {
+	if (node->terminal) {
+		addCandidate(completions, buffer, length, "");
+	}
+	for (struct trieNode* child = node->child; child && completions->numCandidates < MAX_COMPLETION_CANDIDATES; child = child->sibling) {
+		buffer[length] = child->key;
+		collectNames(child, buffer, length + 1, completions);
+	}
+}
+
+/*
+* Fills completions with every command name beginning with word. The common prefix is found by following the
+* trie from the node word leads to for as long as there is only one way to go
+*/
+static void completeCommand(char* word, struct completions* completions) {
+	// declare a buffer able to hold any executable name
+	char buffer[NAME_MAX + 1];
+	// declare and initialize a variable used to store the length of word
+	int length = strlen(word);
+	// start from the root of the trie
+	struct trieNode* node = &completion.trie->root;
+
+	// names longer than any file name cannot be completed
+	if (length > NAME_MAX) {
+		return;
+	}
+
+	// walk down the trie along word - if it leaves the trie no name begins with word
+	strcpy(buffer, word);
+	for (int index = 0; index < length && node; index++) {
+		node = node->child;
+		while (node && node->key != word[index]) {
+			node = node->sibling;
+		}
+	}
+	if (!node) {
+		return;
+	}
+
+	// extend the common prefix while the trie does not branch
+	struct trieNode* prefixNode = node;
+	int prefixLength = length;
+	while (!prefixNode->terminal && prefixNode->child && !prefixNode->child->sibling && prefixLength < NAME_MAX) {
+		prefixNode = prefixNode->child;
+		buffer[prefixLength++] = prefixNode->key;
+	}
+	completions->commonPrefix = (char*)malloc((prefixLength + 1) * sizeof(char));
+	memcpy(completions->commonPrefix, buffer, prefixLength);
+	completions->commonPrefix[prefixLength] = '\0';
+
+	// collect the first names below the node word leads to, then count all of them
+	collectNames(node, buffer, length, completions);
+	completions->numCandidates = node->numNames;
+}
+
+/*
+* Releases all memory allocated for a directory listing
+*/
+static void freeListing(struct directoryListing* listing) {
+	for (int index = 0; index < listing->numEntries; index++) {
+		free(listing->names[index]);
+	}
+	free(listing->names);
+	free(listing->isDirectory);
+	free(listing->path);
+	free(listing);
+}
+
+/*
+* Used by qsort to order the names of a directory listing
+*/
+static int compareNames(const void* first, const void* second) {
+	return strcmp(*(char**)first, *(char**)second);
+}
+
+/*
+* Reads the entries of the directory at path into a new listing sorted by name. Returns NULL if the directory
+* cannot be read
+*/
+static struct directoryListing* readListing(char* path, struct timespec* modifiedTime) {
+	DIR* stream = opendir(path);
+	struct dirent* entry;
+	int capacity = 16;
+
+	if (!stream) {
+		return NULL;
+	}
+
+	// collect the name of every entry other than "." and ".."
+	struct directoryListing* listing = (struct directoryListing*)calloc(1, sizeof(struct directoryListing));
+	listing->names = (char**)malloc(capacity * sizeof(char*));
+	while ((entry = readdir(stream))) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+			continue;
+		}
+		if (listing->numEntries == capacity) {
+			capacity *= 2;
+			listing->names = (char**)realloc(listing->names, capacity * sizeof(char*));
+		}
+		listing->names[listing->numEntries] = (char*)malloc((strlen(entry->d_name) + 1) * sizeof(char));
+		strcpy(listing->names[listing->numEntries], entry->d_name);
+		listing->numEntries++;
+	}
+
+	// sort the names, then note which ones are directories, following symbolic links
+	qsort(listing->names, listing->numEntries, sizeof(char*), compareNames);
+	listing->isDirectory = (bool*)calloc(listing->numEntries + 1, sizeof(bool));
+	for (int index = 0; index < listing->numEntries; index++) {
+		struct stat info;
+		listing->isDirectory[index] = fstatat(dirfd(stream), listing->names[index], &info, 0) == 0 && S_ISDIR(info.st_mode);
+	}
+	closedir(stream);
+
+	listing->path = (char*)malloc((strlen(path) + 1) * sizeof(char));
+	strcpy(listing->path, path);
+	listing->modifiedTime = *modifiedTime;
+
+	return listing;
+}
+
+/*
+* Returns the listing of the directory at path, reading it again only if it was modified since it was cached.
+* Returns NULL if the directory cannot be read
+*/
+static struct directoryListing* getListing(char* path) {
+	struct directoryListing** link = &completion.directories;
+	struct directoryListing* listing = NULL;
+	struct stat info;
+
+	if (stat(path, &info) == -1) {
+		return NULL;
+	}
+
+	// look for a cached listing, unlinking it so it can be moved to the front
+	while (*link) {
+		if (strcmp((*link)->path, path) == 0) {
+			listing = *link;
+			*link = listing->next;
+			completion.numDirectories--;
+			break;
+		}
+		link = &(*link)->next;
+	}
+
+	// read the directory if it is not cached or has changed
+	if (listing && directoryChanged(path, &listing->modifiedTime)) {
+		freeListing(listing);
+		listing = NULL;
+	}
+	if (!listing) {
+		listing = readListing(path, &info.st_mtim);
+		if (!listing) {
+			return NULL;
+		}
+	}
+
+	// make the listing the most recently used one
+	listing->next = completion.directories;
+	completion.directories = listing;
+	completion.numDirectories++;
+
+	// drop the least recently used listing once there are too many
+	if (completion.numDirectories > MAX_CACHED_DIRECTORIES) {
+		link = &completion.directories;
+		while ((*link)->next) {
+			link = &(*link)->next;
+		}
+		freeListing(*link);
+		*link = NULL;
+		completion.numDirectories--;
+	}
+
+	return listing;
+}
+
+/*
+* Fills completions with every file path beginning with word
+*/
+static void completeFile(char* word, struct completions* completions) {
+	// split word into the directory it points into and the beginning of a name in that directory
+	char* slash = strrchr(word, '/');
+	int directoryLength = slash ? slash - word + 1 : 0;
+	char* base = word + directoryLength;
+	int baseLength = strlen(base);
+	char directory[directoryLength + 2];
+	struct directoryListing* listing;
+	int low = 0;
+	// declare a variable used to store the index of the last name that is a candidate
+	int lastIndex = 0;
+
+	memcpy(directory, word, directoryLength);
+	strcpy(directory + directoryLength, directoryLength ? "" : ".");
+	listing = getListing(directory);
+	if (!listing) {
+		return;
+	}
+
+	// find the first name that is not ordered before base
+	int high = listing->numEntries;
+	while (low < high) {
+		int middle = (low + high) / 2;
+		if (strcmp(listing->names[middle], base) < 0) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	// every name beginning with base follows it - hidden files are only offered when base starts with '.'
+	for (int index = low; index < listing->numEntries && strncmp(listing->names[index], base, baseLength) == 0; index++) {
+		if (listing->names[index][0] == '.' && base[0] != '.') {
+			continue;
+		}
+		char candidate[directoryLength + strlen(listing->names[index]) + 1];
+		strncpy(candidate, word, directoryLength);
+		strcpy(candidate + directoryLength, listing->names[index]);
+		addCandidate(completions, candidate, strlen(candidate), listing->isDirectory[index] ? "/" : "");
+		lastIndex = index;
+	}
+
+	// the common prefix is shared by the first and the last candidate since they are sorted
+	if (completions->numCandidates) {
+		char* first = completions->candidates[0];
+		char* last = listing->names[lastIndex];
+		int length = 0;
+		while (first[length] && (length < directoryLength || first[length] == last[length - directoryLength])) {
+			length++;
+		}
+		completions->commonPrefix = (char*)malloc((length + 1) * sizeof(char));
+		strncpy(completions->commonPrefix, first, length);
+		completions->commonPrefix[length] = '\0';
+	}
+}
+
+/*
+* Returns the candidates for completing word. If isCommand is true and word holds no '/', word is completed
+* from the executables on PATH and the built-in commands, otherwise from the file names in the directory
+* word points into. The returned struct must be released with freeCompletions
+*/
+struct completions* findCompletions(char* word, bool isCommand) {
+	struct completions* completions = (struct completions*)calloc(1, sizeof(struct completions));
+
+	if (isCommand && !strchr(word, '/')) {
+		// use the newest trie, waiting for it only if there is none at all yet
+		prepareCompletion();
+		collectTrie(!completion.trie);
+		if (completion.trie) {
+			completeCommand(word, completions);
+		}
+	}
+	else {
+		completeFile(word, completions);
+	}
+
+	// without candidates the common prefix is word itself
+	if (!completions->commonPrefix) {
+		completions->commonPrefix = (char*)malloc((strlen(word) + 1) * sizeof(char));
+		strcpy(completions->commonPrefix, word);
+	}
+
+	return completions;
+}
+
+/*
+* Releases all memory allocated for the completions
+*/
+void freeCompletions(struct completions* completions) {
+	for (int index = 0; index < completions->numCandidates && index < MAX_COMPLETION_CANDIDATES; index++) {
+		free(completions->candidates[index]);
+	}
+	free(completions->candidates);
+	free(completions->commonPrefix);
+	free(completions);
+}
+
+/*
+* Releases all memory allocated for completion, waiting for a trie that is being built to finish first
+*/
+void cleanupCompletion(void) {
+	collectTrie(true);
+	freeTrie(completion.trie);
+	completion.trie = NULL;
+
+	while (completion.directories) {
+		struct directoryListing* next = completion.directories->next;
+		freeListing(completion.directories);
+		completion.directories = next;
+	}
+	completion.numDirectories = 0;
+}
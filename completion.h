@@ -0,0 +1,82 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for tab completion of command names, from a prefix trie of the executables on
+*	PATH, and of file paths, from a cache of directory listings
+*/
+
+// the maximum number of directory listings kept in the directory cache
+#define MAX_CACHED_DIRECTORIES 32
+
+// the maximum number of candidates collected for a word - enough to display, while keeping completion of a
+// short word fast no matter how many names begin with it
+#define MAX_COMPLETION_CANDIDATES 100
+
+/*
+* A struct representing a node of the prefix trie of executable names. The children of a node are kept in a
+* sorted list linked through sibling so that names are always visited in alphabetical order
+*/
+struct trieNode {
+	char key;  // the character leading from the parent to this node
+	bool terminal;  // true if the characters leading to this node spell out an executable name, otherwise false
+	int numNames;  // the number of executable names that end at or below this node
+	struct trieNode* child;  // the first child of this node
+	struct trieNode* sibling;  // the next child of the parent of this node
+};
+
+/*
+* A struct representing the trie of executable names along with what it was built from, so that it can be
+* rebuilt when PATH or one of its directories changes
+*/
+struct executableTrie {
+	struct trieNode root;  // the root of the trie, holding no character
+	char* path;  // the value of PATH the trie was built from
+	int numDirectories;  // the number of directories listed in path
+	struct timespec* modifiedTimes;  // the modification time of each directory when it was read
+};
+
+/*
+* A struct representing the cached listing of a directory, sorted by name so that every entry beginning
+* with a prefix can be found with a binary search
+*/
+struct directoryListing {
+	char* path;  // the directory that was listed
+	struct timespec modifiedTime;  // the modification time of the directory when it was listed
+	int numEntries;  // the number of entries in the directory
+	char** names;  // the name of each entry
+	bool* isDirectory;  // true for each entry that is a directory, otherwise false
+	struct directoryListing* next;  // the next most recently used listing
+};
+
+/*
+* A struct representing the candidates for completing a word
+*/
+struct completions {
+	int numCandidates;  // the number of candidates found
+	char** candidates;  // the full text of the first MAX_COMPLETION_CANDIDATES candidates, with '/' appended to directories
+	char* commonPrefix;  // the longest prefix shared by every candidate
+};
+
+/*
+* Starts building the trie of executable names in the background so that it is ready by the time it is
+* needed. Nothing happens if the trie is already built or being built
+*/
+void prepareCompletion(void);
+
+/*
+* Returns the candidates for completing word. If isCommand is true and word holds no '/', word is completed
+* from the executables on PATH and the built-in commands, otherwise from the file names in the directory
+* word points into. The returned struct must be released with freeCompletions
+*/
+struct completions* findCompletions(char* word, bool isCommand);
+
+/*
+* Releases all memory allocated for the completions
+*/
+void freeCompletions(struct completions* completions);
+
+/*
+* Releases all memory allocated for completion, waiting for a trie that is being built to finish first
+*/
+void cleanupCompletion(void);
@@ -0,0 +1,153 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: An epoll based event loop that lets the shell wait on its input or a child process while still
+*	servicing timers and other file descriptors that belong to background jobs
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "events.h"
+
+// the maximum number of ready events processed per call to epoll_wait - one at a time so that a callback
+// can safely release any other handler without a stale event for it still waiting to be dispatched
+#define MAX_EVENTS 1
+
+// the epoll instance shared by every handler, created on first use
+static int epollFD = -1;
+
+// a marker placed in the epoll data of the file descriptor a caller is waiting on so that it can be told
+// apart from registered handlers
+static struct eventHandler waitTarget = { 0 };
+
+/*
+* Returns the shared epoll instance, creating it the first time it is needed
+*/
+static int getEpollFD(void) {
+	if (epollFD == -1) {
+		epollFD = epoll_create1(EPOLL_CLOEXEC);
+		if (epollFD == -1) {
+			// display an error message to the user
+			perror("epoll_create1 failed");
+			// exit with status 1
+			exit(1);
+		}
+	}
+
+	return epollFD;
+}
+
+/*
+* Starts watching the file descriptor in handler for the provided epoll events
+*/
+void registerEventHandler(struct eventHandler* handler, unsigned int events) {
+	struct epoll_event event = { 0 };
+
+	// point the epoll data back at the handler so its callback can be found
+	event.events = events;
+	event.data.ptr = handler;
+	if (epoll_ctl(getEpollFD(), EPOLL_CTL_ADD, handler->fd, &event) == -1) {
+		perror("epoll_ctl failed");
+	}
+}
+
+/*
+* Changes the epoll events the file descriptor in handler is being watched for - an events value of 0 pauses
+* the handler without removing it
+*/
+void modifyEventHandler(struct eventHandler* handler, unsigned int events) {
+	struct epoll_event event = { 0 };
+
+	event.events = events;
+	event.data.ptr = handler;
+	epoll_ctl(getEpollFD(), EPOLL_CTL_MOD, handler->fd, &event);
+}
+
+/*
+* Stops watching the file descriptor in handler
+*/
+void unregisterEventHandler(struct eventHandler* handler) {
+	epoll_ctl(getEpollFD(), EPOLL_CTL_DEL, handler->fd, NULL);
+}
+
+/*
+* Blocks until fd is readable, dispatching the callback of every registered handler that becomes ready in
+* the meantime. If fd cannot be watched (e.g. it is a regular file) this function returns immediately
+*/
+void waitForEvents(int fd) {
+	waitForEventsTimeout(fd, -1);
+}
+
+/*
+* Blocks until fd is readable or timeoutMs milliseconds pass, dispatching the callback of every registered
+* handler that becomes ready in the meantime. A negative timeoutMs waits forever and an fd of -1 returns
+* after the first batch of handler callbacks. Returns true if fd became readable, otherwise false
+*/
+bool waitForEventsTimeout(int fd, int timeoutMs) {
+	// declare a buffer to receive ready events
+	struct epoll_event events[MAX_EVENTS];
+	// declare and initialize a variable used to signal that fd is ready
+	bool ready = false;
+	// declare and initialize a variable used to signal that at least one handler was dispatched
+	bool dispatched = false;
+
+	// add the file descriptor being waited on to the epoll instance - epoll refuses regular files which are
+	// always readable, so in that case there is nothing to wait for
+	if (fd != -1) {
+		struct epoll_event event = { 0 };
+		event.events = EPOLLIN;
+		event.data.ptr = &waitTarget;
+		if (epoll_ctl(getEpollFD(), EPOLL_CTL_ADD, fd, &event) == -1) {
+			return true;
+		}
+	}
+
+	// keep dispatching handlers until fd is ready
+	while (!ready && !(fd == -1 && dispatched)) {
+		int numEvents = epoll_wait(getEpollFD(), events, MAX_EVENTS, timeoutMs);
+
+		// a signal handler (e.g. SIGTSTP) interrupting the wait is not an error
+		if (numEvents == -1 && errno == EINTR) {
+			continue;
+		}
+		// if the timeout expired or epoll failed, stop waiting
+		if (numEvents <= 0) {
+			break;
+		}
+
+		// dispatch each ready handler or note that fd is ready
+		for (int index = 0; index < numEvents; index++) {
+			struct eventHandler* handler = (struct eventHandler*)events[index].data.ptr;
+			if (handler == &waitTarget) {
+				ready = true;
+			}
+			else {
+				handler->callback(handler, events[index].events);
+				dispatched = true;
+			}
+		}
+	}
+
+	// stop watching the file descriptor that was waited on
+	if (fd != -1) {
+		epoll_ctl(getEpollFD(), EPOLL_CTL_DEL, fd, NULL);
+	}
+
+	return ready;
+}
+
+/*
+* Forgets the epoll instance along with every handler registered with it. Called in a forked child of the shell
+* that runs the event loop itself, which would otherwise share the instance - and dispatch the handlers - of the
+* shell
+*/
+void resetEventLoop(void) {
+	if (epollFD != -1) {
+		close(epollFD);
+		epollFD = -1;
+	}
+}
@@ -0,0 +1,52 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the event loop used to wait on several file descriptors at once
+*/
+
+/*
+* A struct representing a file descriptor being watched by the event loop. When the file descriptor becomes
+* ready the callback is invoked with the handler itself and the ready events
+*/
+struct eventHandler {
+	int fd;  // the file descriptor being watched
+	void (*callback)(struct eventHandler* handler, unsigned int events);  // invoked when fd becomes ready
+	void* data;  // any data the owner of the handler needs inside of the callback
+};
+
+/*
+* Starts watching the file descriptor in handler for the provided epoll events
+*/
+void registerEventHandler(struct eventHandler* handler, unsigned int events);
+
+/*
+* Changes the epoll events the file descriptor in handler is being watched for - an events value of 0 pauses
+* the handler without removing it
+*/
+void modifyEventHandler(struct eventHandler* handler, unsigned int events);
+
+/*
+* Stops watching the file descriptor in handler
+*/
+void unregisterEventHandler(struct eventHandler* handler);
+
+/*
+* Blocks until fd is readable, dispatching the callback of every registered handler that becomes ready in
+* the meantime. If fd cannot be watched (e.g. it is a regular file) this function returns immediately
+*/
+void waitForEvents(int fd);
+
+/*
+* Blocks until fd is readable or timeoutMs milliseconds pass, dispatching the callback of every registered
+* handler that becomes ready in the meantime. A negative timeoutMs waits forever and an fd of -1 returns
+* after the first batch of handler callbacks. Returns true if fd became readable, otherwise false
+*/
+bool waitForEventsTimeout(int fd, int timeoutMs);
+
+/*
+* Forgets the epoll instance along with every handler registered with it. Called in a forked child of the shell
+* that runs the event loop itself, which would otherwise share the instance - and dispatch the handlers - of the
+* shell
+*/
+void resetEventLoop(void);
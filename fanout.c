@@ -0,0 +1,197 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Output fan-out - copies the output of a command into several targets (e.g. "cmd > a.log > b.log")
+*	by duplicating its pipe with tee(2) and moving the data into each target with splice(2)
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include "parser.h"
+#include "events.h"
+#include "fanout.h"
+
+// the size requested for every pipe used by a fan-out - larger pipes mean fewer tee and splice calls
+#define FANOUT_PIPE_SIZE (1024 * 1024)
+
+/*
+* Moves length bytes from the pipe fromFD into targetFD. splice is used whenever the target supports it,
+* otherwise the bytes are copied with read and write. If the target cannot be written to, the bytes are
+* discarded so that the pipe is left empty either way
+*/
+static void moveToTarget(int fromFD, int targetFD, size_t length) {
+	// a buffer for targets that splice cannot write into
+	char buffer[65536];
+
+	while (length > 0) {
+		ssize_t moved = splice(fromFD, NULL, targetFD, NULL, length, SPLICE_F_MOVE);
+		if (moved == -1 && errno == EINTR) {
+			continue;
+		}
+
+		// the target does not support splice or failed - fall back to copying through user space
+		if (moved == -1) {
+			bool targetFailed = errno != EINVAL;
+			moved = read(fromFD, buffer, length < sizeof(buffer) ? length : sizeof(buffer));
+			if (moved <= 0) {
+				return;
+			}
+			for (ssize_t written = 0; !targetFailed && written < moved; ) {
+				ssize_t result = write(targetFD, buffer + written, moved - written);
+				if (result == -1 && errno != EINTR) {
+					targetFailed = true;
+				}
+				else if (result > 0) {
+					written += result;
+				}
+			}
+		}
+		else if (moved == 0) {
+			return;
+		}
+
+		length -= moved;
+	}
+}
+
+/*
+* Moves whatever is currently in the command's pipe into every target. If block is true this waits for data
+* to arrive. Returns the number of bytes moved, 0 once the pipe has reached end of file, or -1 if block is
+* false and no data was available
+*/
+static ssize_t pumpFanout(struct outputFanout* fanout, bool block) {
+	int lastTarget = fanout->numTargets - 1;
+	ssize_t length;
+
+	// duplicate the pipe into the first copy pipe - this decides how many bytes move in this round
+	do {
+		length = tee(fanout->handler.fd, fanout->copyPipes[0][1], FANOUT_PIPE_SIZE, block ? 0 : SPLICE_F_NONBLOCK);
+	} while (length == -1 && errno == EINTR);
+	if (length <= 0) {
+		return (length == -1 && errno == EAGAIN) ? -1 : 0;
+	}
+
+	// duplicate the same bytes into the remaining copy pipes - they are empty, so the bytes always fit
+	for (int index = 1; index < lastTarget; index++) {
+		ssize_t copied;
+		do {
+			copied = tee(fanout->handler.fd, fanout->copyPipes[index][1], length, 0);
+		} while (copied == -1 && errno == EINTR);
+	}
+
+	// empty each copy pipe into its target, then move the original bytes into the last target
+	for (int index = 0; index < lastTarget; index++) {
+		moveToTarget(fanout->copyPipes[index][0], fanout->targetFDs[index], length);
+	}
+	moveToTarget(fanout->handler.fd, fanout->targetFDs[lastTarget], length);
+
+	return length;
+}
+
+/*
+* Closes every file descriptor held by the fan-out and releases its memory
+*/
+static void releaseFanout(struct outputFanout* fanout) {
+	unregisterEventHandler(&fanout->handler);
+	close(fanout->handler.fd);
+	for (int index = 0; index < fanout->numTargets; index++) {
+		close(fanout->targetFDs[index]);
+		if (index < fanout->numTargets - 1) {
+			close(fanout->copyPipes[index][0]);
+			close(fanout->copyPipes[index][1]);
+		}
+	}
+	free(fanout->targetFDs);
+	free(fanout->copyPipes);
+	free(fanout);
+}
+
+/*
+* Event loop callback invoked when the command's pipe is readable
+*/
+static void fanoutReadable(struct eventHandler* handler, unsigned int events) {
+	struct outputFanout* fanout = (struct outputFanout*)handler->data;
+
+	// a detached fan-out releases itself once the command and everything it started are done writing
+	if (pumpFanout(fanout, false) == 0 && fanout->detached) {
+		releaseFanout(fanout);
+	}
+}
+
+/*
+* Opens newOutput and every extra output target of command and creates the pipe the command writes into.
+* The write end of that pipe is stored in the outputFD member of command. Returns NULL after displaying an
+* error message if a target cannot be opened
+*/
+struct outputFanout* startFanout(struct command* command) {
+	// declare a variable used to store the pipe the command writes into
+	int commandPipe[2];
+	// allocate the fan-out with room for newOutput plus every extra target
+	struct outputFanout* fanout = (struct outputFanout*)calloc(1, sizeof(struct outputFanout));
+
+	while (command->teeOutputs[fanout->numTargets]) {
+		fanout->numTargets++;
+	}
+	fanout->numTargets++;
+	fanout->targetFDs = (int*)malloc(fanout->numTargets * sizeof(int));
+	fanout->copyPipes = (int(*)[2])malloc(fanout->numTargets * sizeof(int[2]));
+
+	// open every target - on failure close whatever was opened and report the target
+	for (int index = 0; index < fanout->numTargets; index++) {
+		char* target = index == 0 ? command->newOutput : command->teeOutputs[index - 1];
+		fanout->targetFDs[index] = open(target, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+		if (fanout->targetFDs[index] == -1) {
+			printf("Cannot open %s for output\n", target);
+			fflush(stdout);
+			while (--index >= 0) {
+				close(fanout->targetFDs[index]);
+			}
+			free(fanout->targetFDs);
+			free(fanout->copyPipes);
+			free(fanout);
+			return NULL;
+		}
+	}
+
+	// create the command's pipe and one copy pipe per target but the last, enlarging them where allowed
+	pipe2(commandPipe, O_CLOEXEC);
+	fcntl(commandPipe[0], F_SETPIPE_SZ, FANOUT_PIPE_SIZE);
+	for (int index = 0; index < fanout->numTargets - 1; index++) {
+		pipe2(fanout->copyPipes[index], O_CLOEXEC);
+		fcntl(fanout->copyPipes[index][0], F_SETPIPE_SZ, FANOUT_PIPE_SIZE);
+	}
+
+	// the command writes into the pipe and the event loop moves the data as it arrives
+	command->outputFD = commandPipe[1];
+	fanout->handler.fd = commandPipe[0];
+	fanout->handler.callback = fanoutReadable;
+	fanout->handler.data = fanout;
+	registerEventHandler(&fanout->handler, EPOLLIN);
+
+	return fanout;
+}
+
+/*
+* Copies everything the command writes into the targets until the pipe reaches end of file, then releases
+* the fan-out. Used once a foreground process has terminated
+*/
+void finishFanout(struct outputFanout* fanout) {
+	while (pumpFanout(fanout, true) > 0) {
+	}
+	releaseFanout(fanout);
+}
+
+/*
+* Lets the event loop keep copying the output of a background process, releasing the fan-out once the pipe
+* reaches end of file
+*/
+void detachFanout(struct outputFanout* fanout) {
+	fanout->detached = true;
+}
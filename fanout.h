@@ -0,0 +1,39 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for output fan-out, which copies the output of a command into several targets
+*	within the kernel using tee(2) and splice(2)
+*/
+
+/*
+* A struct representing the output of a command being fanned out to several targets. The command writes into
+* a pipe whose contents are duplicated with tee into one copy pipe per extra target and then spliced into the
+* target files, so the data is never copied through user space
+*/
+struct outputFanout {
+	struct eventHandler handler;  // watches the read end of the pipe the command writes into
+	int numTargets;  // the number of targets being written to
+	int* targetFDs;  // the file descriptor of each target
+	int (*copyPipes)[2];  // the pipe used to duplicate the output for every target but the last
+	bool detached;  // true once the fan-out releases itself at end of file, otherwise false
+};
+
+/*
+* Opens newOutput and every extra output target of command and creates the pipe the command writes into.
+* The write end of that pipe is stored in the outputFD member of command. Returns NULL after displaying an
+* error message if a target cannot be opened
+*/
+struct outputFanout* startFanout(struct command* command);
+
+/*
+* Copies everything the command writes into the targets until the pipe reaches end of file, then releases
+* the fan-out. Used once a foreground process has terminated
+*/
+void finishFanout(struct outputFanout* fanout);
+
+/*
+* Lets the event loop keep copying the output of a background process, releasing the fan-out once the pipe
+* reaches end of file
+*/
+void detachFanout(struct outputFanout* fanout);
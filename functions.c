@@ -0,0 +1,595 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Aliases and shell functions. Both are split into words when they are defined, and a function
+*	call executes its body within the shell itself, so calling one costs neither a fork nor a re-read of
+*	its definition
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "commandExecution.h"
+#include "memory.h"
+#include "variables.h"
+#include "functions.h"
+
+/*
+* A struct representing every alias and shell function along with the state of the function calls in progress
+*/
+struct definitionTable {
+	struct alias* aliases;  // the first alias, in order of name
+	struct shellFunction* functions;  // the first shell function
+	struct positionalParameters* parameters;  // the positional parameters of the innermost call, NULL outside of a function
+	int depth;  // the number of function calls in progress
+	int redirections;  // the number of function calls in progress that redirected the standard streams of the shell
+	int inputRedirections;  // the number of those that redirected the standard input of the shell
+};
+
+// the single table of definitions used by smallsh
+static struct definitionTable definitions = { 0 };
+
+/*
+* Returns a newly allocated NULL terminated array holding copies of the first count words of words
+*/
+static char** copyWords(char** words, int count) {
+	char** copy = (char**)malloc((count + 1) * sizeof(char*));
+
+	for (int index = 0; index < count; index++) {
+		copy[index] = (char*)malloc((strlen(words[index]) + 1) * sizeof(char));
+		strcpy(copy[index], words[index]);
+	}
+	copy[count] = NULL;
+
+	return copy;
+}
+
+/*
+* Returns the alias called name or NULL if no such alias exists
+*/
+static struct alias* findAlias(char* name) {
+	for (struct alias* current = definitions.aliases; current; current = current->next) {
+		if (strcmp(current->name, name) == 0) {
+			return current;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* Releases all memory allocated for an alias
+*/
+static void freeAlias(struct alias* alias) {
+	free(alias->name);
+	free(alias->value);
+	freeWords(alias->words);
+	free(alias);
+}
+
+/*
+* Defines the alias described by "alias NAME=value". Since the words of a command line are split on spaces,
+* the value is everything following the '=' and may be surrounded by a pair of matching quotes
+*/
+static void defineAlias(char** words) {
+	// declare and initialize a variable used to store the length of the definition once its words are joined
+	size_t length = 1;
+	// declare variables used to point to the name and the value within the definition
+	char *name, *value;
+
+	// join the words following "alias" back together with single spaces
+	for (int index = 1; words[index]; index++) {
+		length += strlen(words[index]) + 1;
+	}
+	name = (char*)calloc(length, sizeof(char));
+	for (int index = 1; words[index]; index++) {
+		strcat(name, words[index]);
+		if (words[index + 1]) {
+			strcat(name, " ");
+		}
+	}
+
+	// split the definition at the first '=' and remove any quotes surrounding the value
+	value = strchr(name, '=');
+	*value++ = '\0';
+	length = strlen(value);
+	if (length >= 2 && (value[0] == '\'' || value[0] == '"') && value[length - 1] == value[0]) {
+		value[length - 1] = '\0';
+		value++;
+	}
+
+	// the value is split once, here, and replaces the name whenever it starts a command line
+	char** aliasWords = splitWords(value);
+	if (!aliasWords) {
+		printf("alias: %s: value holds no command\n", name);
+		fflush(stdout);
+		free(name);
+		return;
+	}
+
+	// replace the words of an existing alias
+	struct alias* alias = findAlias(name);
+	if (alias) {
+		free(alias->value);
+		freeWords(alias->words);
+	}
+	// otherwise insert a new alias, keeping the list sorted by name
+	else {
+		struct alias** link = &definitions.aliases;
+		while (*link && strcmp((*link)->name, name) < 0) {
+			link = &(*link)->next;
+		}
+
+		alias = (struct alias*)calloc(1, sizeof(struct alias));
+		alias->name = (char*)malloc((strlen(name) + 1) * sizeof(char));
+		strcpy(alias->name, name);
+		alias->next = *link;
+		*link = alias;
+	}
+
+	alias->value = (char*)malloc((strlen(value) + 1) * sizeof(char));
+	strcpy(alias->value, value);
+	alias->words = aliasWords;
+
+	free(name);
+}
+
+/*
+* Returns true if the command made up of words can be built into a command struct once, when the function
+* holding it is defined, otherwise false. Words referencing variables or holding a pattern must be expanded on
+* each call, and alias definitions, "timeout", "chunk" and "exit" change or free the command struct they are
+* executed from
+*/
+static bool isStaticCommand(char** words) {
+	// the command that is built is the one the alias at its start, if any, is replaced with
+	char** expanded = expandAlias(words);
+	char** command = expanded ? expanded : words;
+	bool isStatic = strcmp(command[0], "alias") != 0 && strcmp(command[0], "timeout") != 0 &&
+		strcmp(command[0], "chunk") != 0 && strcmp(command[0], "exit") != 0;
+
+	for (int index = 0; command[index] && isStatic; index++) {
+		// a here-string, here-document or process substitution is used up by a single call, so each call needs
+		// its own
+		isStatic = !strpbrk(command[index], "$*?[") && strncmp(command[index], "<<", 2) != 0 &&
+			strncmp(command[index], "<(", 2) != 0 && strncmp(command[index], ">(", 2) != 0;
+	}
+
+	free(expanded);
+	return isStatic;
+}
+
+/*
+* Releases all memory allocated for a shell function
+*/
+static void freeFunction(struct shellFunction* function) {
+	struct functionCommand* next;
+
+	for (struct functionCommand* current = function->body; current; current = next) {
+		next = current->next;
+		freeWords(current->words);
+		if (current->command) {
+			cleanupMemory(current->command);
+		}
+		free(current);
+	}
+
+	free(function->name);
+	free(function);
+}
+
+/*
+* Defines the shell function described by words, whose body starts at bodyStart and whose name is the first
+* nameLength characters of words[0]. The body must be enclosed in "{" and "}" and its commands separated by
+* ";", either as a word of its own or at the end of the last word of a command
+*/
+static void defineFunction(char** words, int nameLength, int bodyStart) {
+	// declare and initialize a variable used to store the number of words
+	int numWords = 0;
+	// declare and initialize a variable used to store the index of the first word of the command being collected
+	int commandStart = bodyStart + 1;
+	// declare and initialize a variable used to point to the place where the next command of the body is linked
+	struct functionCommand** link = NULL;
+
+	while (words[numWords]) {
+		numWords++;
+	}
+
+	// the body must be enclosed in braces
+	if (!words[bodyStart] || strcmp(words[bodyStart], "{") != 0 || numWords < bodyStart + 2 || strcmp(words[numWords - 1], "}") != 0) {
+		printf("syntax error: expected NAME() { command ; ... ; }\n");
+		fflush(stdout);
+		return;
+	}
+	// the commands of the body are split at every ';', so a function cannot be defined within another one
+	for (int index = commandStart; index < numWords - 1; index++) {
+		if (strcmp(words[index], "{") == 0 || strcmp(words[index], "}") == 0) {
+			printf("syntax error: a function body cannot hold braces\n");
+			fflush(stdout);
+			return;
+		}
+	}
+
+	// build the function
+	struct shellFunction* function = (struct shellFunction*)calloc(1, sizeof(struct shellFunction));
+	function->name = (char*)malloc((nameLength + 1) * sizeof(char));
+	strncpy(function->name, words[0], nameLength);
+	function->name[nameLength] = '\0';
+	link = &function->body;
+
+	// collect the words of each command of the body, splitting at every ';'
+	for (int index = commandStart; index < numWords; index++) {
+		size_t length = strlen(words[index]);
+		bool separator = index == numWords - 1 || words[index][length - 1] == ';';
+		int commandEnd = index;
+
+		// a ';' at the end of a longer word ends the command after that word
+		if (separator && index < numWords - 1 && length > 1) {
+			commandEnd++;
+		}
+		if (!separator || commandEnd == commandStart) {
+			commandStart = separator ? index + 1 : commandStart;
+			continue;
+		}
+
+		// copy the words of the command, dropping a ';' stuck to the last one
+		struct functionCommand* bodyCommand = (struct functionCommand*)calloc(1, sizeof(struct functionCommand));
+		bodyCommand->words = copyWords(words + commandStart, commandEnd - commandStart);
+		if (commandEnd > index) {
+			bodyCommand->words[index - commandStart][length - 1] = '\0';
+		}
+		// build the command now if no call can change it
+		if (isStaticCommand(bodyCommand->words)) {
+			bodyCommand->command = parsePipeline(bodyCommand->words);
+		}
+
+		*link = bodyCommand;
+		link = &bodyCommand->next;
+		commandStart = index + 1;
+	}
+
+	// replace any existing function of the same name - a function that is being executed is only unlinked and
+	// freed once its last call returns
+	for (struct shellFunction** current = &definitions.functions; *current; current = &(*current)->next) {
+		if (strcmp((*current)->name, function->name) == 0) {
+			struct shellFunction* replaced = *current;
+			*current = replaced->next;
+			if (replaced->activeCalls > 0) {
+				replaced->removed = true;
+			}
+			else {
+				freeFunction(replaced);
+			}
+			break;
+		}
+	}
+	function->next = definitions.functions;
+	definitions.functions = function;
+}
+
+/*
+* Checks if the NULL terminated array of words defines an alias - "alias NAME=value" - or a shell function -
+* "NAME() { command ; command ; }" - and if so, records the definition. Returns true if words held a
+* definition, which leaves nothing to execute, otherwise false
+*/
+bool defineFromWords(char** words) {
+	// declare and initialize a variable used to store the length of the first word
+	size_t length = strlen(words[0]);
+	// declare a variable used to point to the '=' of an alias definition
+	char* equals;
+
+	// "alias NAME=value" defines an alias
+	if (strcmp(words[0], "alias") == 0 && words[1] && (equals = strchr(words[1], '=')) &&
+		isValidVariableName(words[1], equals - words[1])) {
+		defineAlias(words);
+		return true;
+	}
+
+	// "NAME() {" or "NAME () {" starts a function definition - the name may not hold characters that have a
+	// meaning of their own
+	if (length > 2 && strcmp(words[0] + length - 2, "()") == 0 && strcspn(words[0], "/$=&<>()") == length - 2) {
+		defineFunction(words, length - 2, 1);
+		return true;
+	}
+	if (words[1] && strcmp(words[1], "()") == 0 && strcspn(words[0], "/$=&<>()") == length) {
+		defineFunction(words, length, 2);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+* Returns a newly allocated NULL terminated array of words in which an alias at the start of words is
+* replaced with the words it stands for, or NULL if words does not start with an alias. Only the array
+* itself must be freed, the words are shared with words and the alias
+*/
+char** expandAlias(char** words) {
+	// declare and initialize a variable used to store the aliases replaced so far, none of which is replaced twice
+	struct alias* replaced[MAX_ALIAS_DEPTH];
+	int numReplaced = 0;
+	// declare and initialize a variable used to store the words being built
+	char** expanded = NULL;
+	struct alias* alias;
+
+	// keep replacing the first word while it is an alias that has not been replaced yet
+	while (numReplaced < MAX_ALIAS_DEPTH && (alias = findAlias(expanded ? expanded[0] : words[0]))) {
+		for (int index = 0; index < numReplaced; index++) {
+			if (replaced[index] == alias) {
+				return expanded;
+			}
+		}
+		replaced[numReplaced++] = alias;
+
+		// the words of the alias followed by every word after the first
+		char** current = expanded ? expanded : words;
+		int numAliasWords = 0, numWords = 0;
+		while (alias->words[numAliasWords]) {
+			numAliasWords++;
+		}
+		while (current[numWords]) {
+			numWords++;
+		}
+
+		char** next = (char**)malloc((numAliasWords + numWords) * sizeof(char*));
+		memcpy(next, alias->words, numAliasWords * sizeof(char*));
+		memcpy(next + numAliasWords, current + 1, numWords * sizeof(char*));
+		free(expanded);
+		expanded = next;
+	}
+
+	return expanded;
+}
+
+/*
+* Executes the built-in "alias" command without a definition. With no arguments every alias is displayed,
+* otherwise the alias called by each argument
+*/
+void listAliases(struct command* command) {
+	// with no arguments display every alias
+	if (!command->argv[1]) {
+		for (struct alias* current = definitions.aliases; current; current = current->next) {
+			printf("alias %s='%s'\n", current->name, current->value);
+		}
+	}
+
+	// otherwise display each alias asked for
+	for (int index = 1; command->argv[index]; index++) {
+		struct alias* alias = findAlias(command->argv[index]);
+		if (alias) {
+			printf("alias %s='%s'\n", alias->name, alias->value);
+		}
+		else {
+			printf("alias: %s: not found\n", command->argv[index]);
+		}
+	}
+
+	// flush stdout
+	fflush(stdout);
+}
+
+/*
+* Executes the built-in "unalias" command, removing the alias called by each argument
+*/
+void removeAliases(struct command* command) {
+	for (int index = 1; command->argv[index]; index++) {
+		// find the alias and the link pointing to it
+		struct alias** link = &definitions.aliases;
+		while (*link && strcmp((*link)->name, command->argv[index]) != 0) {
+			link = &(*link)->next;
+		}
+
+		if (!*link) {
+			printf("unalias: %s: not found\n", command->argv[index]);
+			fflush(stdout);
+			continue;
+		}
+
+		// unlink the alias and release it
+		struct alias* alias = *link;
+		*link = alias->next;
+		freeAlias(alias);
+	}
+}
+
+/*
+* Returns the shell function called name or NULL if no such function exists
+*/
+struct shellFunction* findFunction(char* name) {
+	for (struct shellFunction* current = definitions.functions; current; current = current->next) {
+		if (strcmp(current->name, name) == 0) {
+			return current;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* Executes each command of the body of function within the current process, with the arguments of command as
+* the positional parameters. The status of the last command executed is stored in lastStatus
+*/
+void callFunction(struct shellFunction* function, struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag) {
+	// declare and initialize the positional parameters of the call, pointing into the argv array of command
+	struct positionalParameters parameters = { function->name, 0, command->argv + 1 };
+	// declare and initialize a variable used to store the positional parameters of the caller
+	struct positionalParameters* callerParameters = definitions.parameters;
+
+	// a function calling itself without end would otherwise exhaust the stack
+	if (definitions.depth >= MAX_FUNCTION_DEPTH) {
+		printf("%s: maximum function nesting level exceeded\n", function->name);
+		fflush(stdout);
+		*lastStatus = 1 << 8;
+		return;
+	}
+
+	while (parameters.values[parameters.count]) {
+		parameters.count++;
+	}
+
+	// make the arguments of the call the positional parameters until it returns
+	definitions.parameters = &parameters;
+	definitions.depth++;
+	function->activeCalls++;
+
+	// execute the body, building only the commands that depend on variables
+	for (struct functionCommand* current = function->body; current; current = current->next) {
+		if (current->command) {
+			executeCommand(current->command, backgroundPids, lastStatus, foregroundFlag);
+		}
+		else {
+			struct command* bodyCommand = parsePipeline(current->words);
+			executeCommand(bodyCommand, backgroundPids, lastStatus, foregroundFlag);
+			cleanupMemory(bodyCommand);
+		}
+	}
+
+	// restore the positional parameters of the caller
+	function->activeCalls--;
+	definitions.depth--;
+	definitions.parameters = callerParameters;
+
+	// the function was redefined while it was being executed
+	if (function->removed && function->activeCalls == 0) {
+		freeFunction(function);
+	}
+}
+
+/*
+* Points targetFD at the file descriptor sourceFD for the duration of a function call, returning a copy of
+* the original targetFD to restore it with
+*/
+static int replaceStream(int sourceFD, int targetFD) {
+	// the copy must not leak into the processes the function starts
+	int savedFD = fcntl(targetFD, F_DUPFD_CLOEXEC, 0);
+
+	dup2(sourceFD, targetFD);
+	close(sourceFD);
+	return savedFD;
+}
+
+/*
+* Executes a call of function as a foreground command within the shell itself, redirecting the input and
+* output of the shell for the duration of the call if the command asks for it
+*/
+void executeFunction(struct shellFunction* function, struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag) {
+	// declare and initialize variables used to store the original standard streams, -1 if they are not redirected
+	int savedIn = -1, savedOut = -1;
+	// declare a variable used to store the file descriptor a stream is redirected to
+	int targetFD;
+
+	// redirect the input of the shell
+	if (command->inputRedirect) {
+		targetFD = command->inputFD != -1 ? dup(command->inputFD) : open(command->newInput, O_RDONLY);
+		if (targetFD == -1) {
+			printf("Cannot open %s for input\n", command->newInput);
+			fflush(stdout);
+			*lastStatus = 1 << 8;
+			return;
+		}
+		savedIn = replaceStream(targetFD, STDIN_FILENO);
+	}
+
+	// redirect the output of the shell, to the pipe of an output fan-out if the executor has set one up
+	if (command->outputFD != -1 || command->outputRedirect) {
+		targetFD = command->outputFD != -1 ? dup(command->outputFD) : open(command->newOutput, O_WRONLY | O_CREAT | O_TRUNC, 0640);
+		if (targetFD == -1) {
+			printf("Cannot open %s for output\n", command->newOutput);
+			fflush(stdout);
+			if (savedIn != -1) {
+				dup2(savedIn, STDIN_FILENO);
+				close(savedIn);
+			}
+			*lastStatus = 1 << 8;
+			return;
+		}
+		// anything already written by the shell belongs to the original output
+		fflush(stdout);
+		savedOut = replaceStream(targetFD, STDOUT_FILENO);
+	}
+
+	// execute the body within the shell
+	definitions.redirections += savedIn != -1 || savedOut != -1;
+	definitions.inputRedirections += savedIn != -1;
+	callFunction(function, command, backgroundPids, lastStatus, foregroundFlag);
+	definitions.redirections -= savedIn != -1 || savedOut != -1;
+	definitions.inputRedirections -= savedIn != -1;
+
+	// restore the standard streams of the shell
+	if (savedOut != -1) {
+		fflush(stdout);
+		dup2(savedOut, STDOUT_FILENO);
+		close(savedOut);
+	}
+	if (savedIn != -1) {
+		dup2(savedIn, STDIN_FILENO);
+		close(savedIn);
+	}
+}
+
+/*
+* Returns true while a function call has redirected the standard streams of the shell, otherwise false
+*/
+bool functionStreamsRedirected(void) {
+	return definitions.redirections > 0;
+}
+
+/*
+* Returns true while a function call has redirected the standard input of the shell, which stdin has not read
+* ahead of, otherwise false
+*/
+bool functionInputRedirected(void) {
+	return definitions.inputRedirections > 0;
+}
+
+/*
+* Returns positional parameter index of the function being executed - index 0 being its name - or NULL if
+* there is no such parameter
+*/
+char* getPositionalParameter(int index) {
+	// outside of a function "$0" is the name of the shell and there are no other parameters
+	if (!definitions.parameters) {
+		return index == 0 ? "smallsh" : NULL;
+	}
+
+	if (index == 0) {
+		return definitions.parameters->name;
+	}
+	return index <= definitions.parameters->count ? definitions.parameters->values[index - 1] : NULL;
+}
+
+/*
+* Returns the number of positional parameters of the function being executed
+*/
+int countPositionalParameters(void) {
+	return definitions.parameters ? definitions.parameters->count : 0;
+}
+
+/*
+* Releases all memory allocated for aliases and shell functions
+*/
+void cleanupFunctions(void) {
+	struct alias* nextAlias;
+	struct shellFunction* nextFunction;
+
+	for (struct alias* current = definitions.aliases; current; current = nextAlias) {
+		nextAlias = current->next;
+		freeAlias(current);
+	}
+	// a function with a call in progress is left alone, since the command the shell is exiting from may be
+	// part of its body
+	for (struct shellFunction* current = definitions.functions; current; current = nextFunction) {
+		nextFunction = current->next;
+		if (current->activeCalls == 0) {
+			freeFunction(current);
+		}
+	}
+
+	definitions.aliases = NULL;
+	definitions.functions = NULL;
+}
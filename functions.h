@@ -0,0 +1,123 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for aliases and shell functions. Their bodies are split into words once, when
+*	they are defined, and functions are executed within the shell itself with positional parameters
+*/
+
+// the maximum number of aliases replaced one after another at the start of a command line
+#define MAX_ALIAS_DEPTH 16
+
+// the maximum number of function calls that may be in progress at once, which stops runaway recursion
+#define MAX_FUNCTION_DEPTH 100
+
+/*
+* A struct representing an alias - a name standing for the words it is replaced with at the start of a
+* command line. Aliases are kept in a list sorted by name
+*/
+struct alias {
+	char* name;  // the name of the alias
+	char* value;  // the text the alias was defined with, used when listing aliases
+	char** words;  // the NULL terminated array of words value was split into
+	struct alias* next;  // the next alias in the list
+};
+
+/*
+* A struct representing a single command of the body of a shell function. A command that holds no variable
+* references is built into a command struct when the function is defined and reused by every call
+*/
+struct functionCommand {
+	char** words;  // the NULL terminated array of unexpanded words of the command
+	struct command* command;  // the command built from words, or NULL if it must be built for each call
+	struct functionCommand* next;  // the next command of the body
+};
+
+/*
+* A struct representing a shell function
+*/
+struct shellFunction {
+	char* name;  // the name of the function
+	struct functionCommand* body;  // the first command of the body
+	int activeCalls;  // the number of calls of the function in progress
+	bool removed;  // true if the function was redefined while a call was in progress, and must be freed when it ends
+	struct shellFunction* next;  // the next function in the list
+};
+
+/*
+* A struct representing the positional parameters of a function call
+*/
+struct positionalParameters {
+	char* name;  // the name of the function, which "$0" expands into
+	int count;  // the number of arguments, which "$#" expands into
+	char** values;  // the arguments, which "$1" to "$N" expand into
+};
+
+/*
+* Checks if the NULL terminated array of words defines an alias - "alias NAME=value" - or a shell function -
+* "NAME() { command ; command ; }" - and if so, records the definition. Returns true if words held a
+* definition, which leaves nothing to execute, otherwise false
+*/
+bool defineFromWords(char** words);
+
+/*
+* Returns a newly allocated NULL terminated array of words in which an alias at the start of words is
+* replaced with the words it stands for, or NULL if words does not start with an alias. Only the array
+* itself must be freed, the words are shared with words and the alias
+*/
+char** expandAlias(char** words);
+
+/*
+* Executes the built-in "alias" command without a definition. With no arguments every alias is displayed,
+* otherwise the alias called by each argument
+*/
+void listAliases(struct command* command);
+
+/*
+* Executes the built-in "unalias" command, removing the alias called by each argument
+*/
+void removeAliases(struct command* command);
+
+/*
+* Returns the shell function called name or NULL if no such function exists
+*/
+struct shellFunction* findFunction(char* name);
+
+/*
+* Executes each command of the body of function within the current process, with the arguments of command as
+* the positional parameters. The status of the last command executed is stored in lastStatus
+*/
+void callFunction(struct shellFunction* function, struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag);
+
+/*
+* Executes a call of function as a foreground command within the shell itself, redirecting the input and
+* output of the shell for the duration of the call if the command asks for it
+*/
+void executeFunction(struct shellFunction* function, struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag);
+
+/*
+* Returns true while a function call has redirected the standard streams of the shell, otherwise false
+*/
+bool functionStreamsRedirected(void);
+
+/*
+* Returns true while a function call has redirected the standard input of the shell, which stdin has not read
+* ahead of, otherwise false
+*/
+bool functionInputRedirected(void);
+
+/*
+* Returns positional parameter index of the function being executed - index 0 being its name - or NULL if
+* there is no such parameter
+*/
+char* getPositionalParameter(int index);
+
+/*
+* Returns the number of positional parameters of the function being executed
+*/
+int countPositionalParameters(void);
+
+/*
+* Releases all memory allocated for aliases and shell functions
+*/
+void cleanupFunctions(void);
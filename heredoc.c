@@ -0,0 +1,197 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Here-documents and here-strings. Their bodies are written once into an anonymous memfd, which
+*	is sealed and handed to the command as its input, so no temporary file is ever created and a large body
+*	is held by the kernel rather than by the shell
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "parser.h"
+#include "lineEditor.h"
+#include "record.h"
+#include "heredoc.h"
+
+// the seals placed on a finished body - it can no longer be written, resized or unsealed
+#define BODY_SEALS (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL)
+
+/*
+* Writes all length bytes of data to fd, returning false if that fails
+*/
+static bool writeAll(int fd, char* data, size_t length) {
+	while (length > 0) {
+		ssize_t written = write(fd, data, length);
+		if (written == -1) {
+			return false;
+		}
+		data += written;
+		length -= written;
+	}
+
+	return true;
+}
+
+/*
+* Seals the finished body in fd and moves its offset back to the start so the command reads all of it
+*/
+static void sealBody(int fd) {
+	fcntl(fd, F_ADD_SEALS, BODY_SEALS);
+	lseek(fd, 0, SEEK_SET);
+}
+
+/*
+* Returns an empty anonymous memory file for the body of a here-document, or -1 after displaying an error
+* message if it cannot be created
+*/
+int createHereDocument(void) {
+	// the file only exists in memory and is closed in every command except the one it is handed to
+	int fd = memfd_create("smallsh-heredoc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+	if (fd == -1) {
+		perror("memfd_create failed");
+	}
+	return fd;
+}
+
+/*
+* Returns an anonymous memory file holding text followed by a newline, sealed against further changes and
+* positioned at its start, or -1 after displaying an error message if it cannot be created
+*/
+int createHereString(char* text) {
+	int fd = createHereDocument();
+
+	if (fd == -1) {
+		return -1;
+	}
+	if (!writeAll(fd, text, strlen(text)) || !writeAll(fd, "\n", 1)) {
+		perror("here-string");
+		close(fd);
+		return -1;
+	}
+
+	sealBody(fd);
+	return fd;
+}
+
+/*
+* Reads the body of the here-document of command - every line up to the one holding only its delimiter - from
+* the NULL terminated array *lines, advancing *lines past them, or from the user if lines is NULL, and writes
+* each line straight into the memory file in command->inputFD, expanding variable references unless the
+* delimiter was quoted. The memory file is then sealed and positioned at its start
+*/
+static void readHereDocument(struct command* command, char*** lines) {
+	// declare variables used by getline - the buffer is reused for every line, so a body of any size only
+	// ever needs as much memory in the shell as its longest line
+	char* line = NULL;
+	size_t capacity = 0;
+	ssize_t length;
+	// declare and initialize a variable used to store whether lines are read with the line editor
+	bool edited = useLineEditor();
+	// declare and initialize a variable used to store whether the body could be written so far
+	bool written = command->inputFD != -1;
+
+	while (true) {
+		// read the next line without its newline
+		if (lines) {
+			free(line);
+			line = **lines ? strdup(*(*lines)++) : NULL;
+			length = line ? (ssize_t)strlen(line) : -1;
+		}
+		else if (edited) {
+			free(line);
+			line = readEditedLine(HERE_DOCUMENT_PROMPT);
+			length = line ? (ssize_t)strlen(line) : -1;
+		}
+		else {
+			length = getline(&line, &capacity, stdin);
+			if (length > 0 && line[length - 1] == '\n') {
+				line[--length] = '\0';
+			}
+		}
+
+		// the body ends at the delimiter or at the end of input
+		if (length == -1 || strcmp(line, command->hereDelimiter) == 0) {
+			break;
+		}
+		// only lines entered by the user belong to the recording of the session
+		if (!lines) {
+			recordLine(line);
+		}
+
+		// write the line into the body, expanding any variable references first
+		if (written && !command->hereLiteral && strchr(line, '$')) {
+			char* expanded = parseArg(line);
+			written = writeAll(command->inputFD, expanded, strlen(expanded));
+			free(expanded);
+		}
+		else if (written) {
+			written = writeAll(command->inputFD, line, length);
+		}
+		written = written && writeAll(command->inputFD, "\n", 1);
+	}
+	if (line && length != -1 && !lines) {
+		recordLine(line);
+	}
+	free(line);
+
+	if (command->inputFD != -1) {
+		if (!written) {
+			perror("here-document");
+		}
+		sealBody(command->inputFD);
+	}
+}
+
+/*
+* Reads the bodies of the here-documents of the commands of the pipeline starting at command, which may be NULL,
+* in the order of its commands - from the NULL terminated array *lines, advancing *lines past them, or from the
+* user if lines is NULL
+*/
+void readHereDocuments(struct command* command, char*** lines) {
+	for (struct command* current = command; current; current = current->pipeNext) {
+		if (current->hereDelimiter) {
+			readHereDocument(current, lines);
+		}
+	}
+}
+
+/*
+* Returns the delimiters of the here-documents started on a command line that was split into words, with their
+* quotes removed and in the order their bodies follow the command line, as a NULL terminated array which must be
+* released with freeWords - or NULL if the command line starts none. This tells the lines of a body from the
+* command lines that follow it before the command line is parsed
+*/
+char** findHereDelimiters(char** words) {
+	// declare and initialize variables used to maintain the delimiters found
+	char** delimiters = NULL;
+	int numDelimiters = 0;
+
+	for (int index = 0; words[index]; index++) {
+		// a here-string has no body, but its text must not be taken for a "<<" of its own
+		if (strncmp(words[index], "<<<", 3) == 0) {
+			index += words[index][3] || !words[index + 1] ? 0 : 1;
+			continue;
+		}
+		if (strncmp(words[index], "<<", 2) != 0) {
+			continue;
+		}
+
+		// the delimiter is either joined to the "<<" or the word after it, just like the parser takes it
+		char* delimiter = words[index][2] ? words[index] + 2 : words[++index];
+		if (!delimiter) {
+			break;
+		}
+		delimiters = (char**)realloc(delimiters, (numDelimiters + 2) * sizeof(char*));
+		delimiters[numDelimiters++] = removeQuotes(delimiter);
+		delimiters[numDelimiters] = NULL;
+	}
+
+	return delimiters;
+}
@@ -0,0 +1,37 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for here-documents (<<DELIMITER) and here-strings (<<< text), whose bodies are
+*	staged in sealed anonymous memory files rather than temporary files
+*/
+
+// the prompt displayed for each line of a here-document read from a terminal
+#define HERE_DOCUMENT_PROMPT "> "
+
+/*
+* Returns an anonymous memory file holding text followed by a newline, sealed against further changes and
+* positioned at its start, or -1 after displaying an error message if it cannot be created
+*/
+int createHereString(char* text);
+
+/*
+* Returns an empty anonymous memory file for the body of a here-document, or -1 after displaying an error
+* message if it cannot be created
+*/
+int createHereDocument(void);
+
+/*
+* Reads the bodies of the here-documents of the commands of the pipeline starting at command, which may be NULL,
+* in the order of its commands - from the NULL terminated array *lines, advancing *lines past them, or from the
+* user if lines is NULL
+*/
+void readHereDocuments(struct command* command, char*** lines);
+
+/*
+* Returns the delimiters of the here-documents started on a command line that was split into words, with their
+* quotes removed and in the order their bodies follow the command line, as a NULL terminated array which must be
+* released with freeWords - or NULL if the command line starts none. This tells the lines of a body from the
+* command lines that follow it before the command line is parsed
+*/
+char** findHereDelimiters(char** words);
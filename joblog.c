@@ -0,0 +1,322 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Job logs. With SMALLSH_JOBLOG=KIB, the standard output and standard error of a background job
+*	that is not redirected go into a pipe which the event loop drains into a ring buffer keeping the last KIB
+*	KiB, instead of "/dev/null". The joblog built-in command displays it and the last lines are displayed
+*	along with the notice of a job that failed. All job logs together never hold more than JOBLOG_TOTAL_KIB
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include "parser.h"
+#include "events.h"
+#include "variables.h"
+#include "joblog.h"
+
+/*
+* A struct representing every job log, oldest first
+*/
+struct jobLogList {
+	struct jobLog* head;  // the oldest job log
+	struct jobLog* tail;  // the newest job log
+	size_t totalSize;  // the number of bytes of ring buffer allocated for all job logs
+};
+
+// every job log
+static struct jobLogList logs = { NULL, NULL, 0 };
+
+/*
+* Unlinks and releases log, closing its pipe if it is still open
+*/
+static void releaseJobLog(struct jobLog* log) {
+	struct jobLog** link = &logs.head;
+	struct jobLog* previous = NULL;
+
+	while (*link && *link != log) {
+		previous = *link;
+		link = &(*link)->next;
+	}
+	if (*link) {
+		*link = log->next;
+		if (logs.tail == log) {
+			logs.tail = previous;
+		}
+	}
+
+	if (log->handler.fd != -1) {
+		unregisterEventHandler(&log->handler);
+		close(log->handler.fd);
+	}
+	logs.totalSize -= log->size;
+	free(log->buffer);
+	free(log);
+}
+
+/*
+* Adds length bytes of data to the ring buffer of log, overwriting the oldest bytes once it is full
+*/
+static void appendToJobLog(struct jobLog* log, char* data, size_t length) {
+	// only the last size bytes of data can be kept
+	if (length > log->size) {
+		log->dropped += length - log->size;
+		data += length - log->size;
+		length = log->size;
+	}
+
+	// copy data after the newest byte, wrapping around the end of the buffer
+	size_t end = (log->start + log->length) % log->size;
+	size_t first = length < log->size - end ? length : log->size - end;
+	memcpy(log->buffer + end, data, first);
+	memcpy(log->buffer, data + first, length - first);
+
+	// the oldest bytes are overwritten once the buffer is full
+	if (log->length + length > log->size) {
+		size_t overwritten = log->length + length - log->size;
+		log->start = (log->start + overwritten) % log->size;
+		log->dropped += overwritten;
+		log->length = log->size;
+	}
+	else {
+		log->length += length;
+	}
+}
+
+/*
+* Moves whatever is in the pipe of log into its ring buffer, closing the pipe once it reaches end of file
+*/
+static void drainJobLog(struct jobLog* log) {
+	char data[65536];
+	ssize_t length;
+
+	while (log->handler.fd != -1 && (length = read(log->handler.fd, data, sizeof(data))) != 0) {
+		if (length == -1) {
+			return;
+		}
+		appendToJobLog(log, data, length);
+	}
+
+	// every process writing to the pipe is done
+	if (log->handler.fd != -1) {
+		unregisterEventHandler(&log->handler);
+		close(log->handler.fd);
+		log->handler.fd = -1;
+	}
+}
+
+/*
+* Event loop callback invoked when the pipe of a job log is readable
+*/
+static void jobLogReadable(struct eventHandler* handler, unsigned int events) {
+	drainJobLog((struct jobLog*)handler->data);
+}
+
+/*
+* Returns the newest job log of the background process pid, or NULL if there is none
+*/
+static struct jobLog* findJobLogByPid(pid_t pid) {
+	struct jobLog* found = NULL;
+
+	for (struct jobLog* current = logs.head; current; current = current->next) {
+		found = current->pid == pid ? current : found;
+	}
+
+	return found;
+}
+
+/*
+* Returns the number of KiB of output to keep for each job, or 0 if output is not captured
+*/
+static long jobLogKib(void) {
+	char* value = getVariable(JOBLOG_VARIABLE);
+	char* end;
+	long kib;
+
+	if (!value) {
+		return 0;
+	}
+	kib = strtol(value, &end, 10);
+	return (*end == '\0' && kib > 0) ? (kib < JOBLOG_TOTAL_KIB ? kib : JOBLOG_TOTAL_KIB) : 0;
+}
+
+/*
+* Starts capturing the output of command if it is a background command whose output is not redirected and
+* SMALLSH_JOBLOG is set. The write end of the pipe is stored in the outputFD and errorFD members of command.
+* Returns NULL if the output is not captured, e.g. when every job log is in use and there is no memory left
+*/
+struct jobLog* startJobLog(struct command* command, int foregroundFlag) {
+	// declare and initialize a variable used to store the size of the ring buffer
+	size_t size = jobLogKib() * 1024;
+	// declare a variable used to store the pipe the job writes into
+	int logPipe[2];
+
+	if (size == 0 || !command->backgroundProcess || foregroundFlag || command->outputRedirect || command->outputFD != -1) {
+		return NULL;
+	}
+
+	// make room by releasing the oldest logs of jobs that are done writing
+	for (struct jobLog* current = logs.head; current && logs.totalSize + size > (size_t)JOBLOG_TOTAL_KIB * 1024; ) {
+		struct jobLog* next = current->next;
+		if (current->handler.fd == -1) {
+			releaseJobLog(current);
+		}
+		current = next;
+	}
+	if (logs.totalSize + size > (size_t)JOBLOG_TOTAL_KIB * 1024 || pipe2(logPipe, O_CLOEXEC) == -1) {
+		return NULL;
+	}
+
+	// the event loop drains the pipe without ever blocking on it
+	fcntl(logPipe[0], F_SETFL, O_NONBLOCK);
+	struct jobLog* log = (struct jobLog*)calloc(1, sizeof(struct jobLog));
+	log->buffer = (char*)malloc(size);
+	log->size = size;
+	log->handler.fd = logPipe[0];
+	log->handler.callback = jobLogReadable;
+	log->handler.data = log;
+	registerEventHandler(&log->handler, EPOLLIN);
+	logs.totalSize += size;
+
+	// append the log to the list
+	if (logs.tail) {
+		logs.tail->next = log;
+	}
+	else {
+		logs.head = log;
+	}
+	logs.tail = log;
+
+	// the job writes both of its output streams into the pipe
+	command->outputFD = logPipe[1];
+	command->errorFD = logPipe[1];
+	return log;
+}
+
+/*
+* Records the process and job number the job log belongs to once the job has started, and closes the write
+* end of the pipe held by the shell. A pid of 0 means the job never started and the log is released
+*/
+void attachJobLog(struct jobLog* log, struct command* command, pid_t pid, int jobNumber) {
+	if (!log) {
+		return;
+	}
+
+	// only the job writes into the pipe
+	close(command->outputFD);
+	command->outputFD = -1;
+	command->errorFD = -1;
+
+	if (pid == 0) {
+		releaseJobLog(log);
+		return;
+	}
+	log->pid = pid;
+	log->jobNumber = jobNumber;
+}
+
+/*
+* Writes the bytes of the ring buffer of log from offset onwards to stdout
+*/
+static void writeJobLog(struct jobLog* log, size_t offset) {
+	for (size_t index = offset; index < log->length; index++) {
+		putchar(log->buffer[(log->start + index) % log->size]);
+	}
+	if (log->length > 0 && log->buffer[(log->start + log->length - 1) % log->size] != '\n') {
+		putchar('\n');
+	}
+	fflush(stdout);
+}
+
+/*
+* Displays the last lines of the output of the background process pid if its status shows it did not succeed
+*/
+void displayJobLogTail(pid_t pid, int childStatus) {
+	struct jobLog* log = findJobLogByPid(pid);
+	// declare and initialize a variable used to store the offset of the first byte displayed
+	size_t offset;
+	// declare and initialize a variable used to count the lines found so far
+	int lines = 0;
+
+	if (!log || (WIFEXITED(childStatus) && WEXITSTATUS(childStatus) == 0)) {
+		return;
+	}
+
+	// the job has terminated, so whatever it wrote is already in the pipe
+	drainJobLog(log);
+	if (log->length == 0) {
+		return;
+	}
+
+	// find the start of the last JOBLOG_TAIL_LINES lines, ignoring a newline ending the output
+	for (offset = log->length - 1; offset > 0; offset--) {
+		if (log->buffer[(log->start + offset - 1) % log->size] == '\n' && ++lines == JOBLOG_TAIL_LINES) {
+			break;
+		}
+	}
+	printf("last output of background pid %d:\n", pid);
+	writeJobLog(log, offset);
+}
+
+/*
+* Executes the built-in "joblog" command. "joblog %N" or "joblog PID" displays the output kept for the job,
+* and with no arguments every job log is listed
+*/
+void showJobLog(struct command* command, int* lastStatus) {
+	// declare and initialize a variable used to store the job log to display
+	struct jobLog* log = NULL;
+	char* spec = command->argv[1];
+
+	*lastStatus = 0;
+
+	// list every job log
+	if (!spec) {
+		for (struct jobLog* current = logs.head; current; current = current->next) {
+			printf("[%d] %d %zu bytes kept, %zu dropped%s\n", current->jobNumber, current->pid, current->length, current->dropped,
+				current->handler.fd != -1 ? ", capturing" : "");
+		}
+		fflush(stdout);
+		return;
+	}
+
+	// find the newest job log of the job number or pid
+	bool isJobNumber = spec[0] == '%';
+	if (isdigit((unsigned char)spec[isJobNumber])) {
+		int value = atoi(spec + isJobNumber);
+		for (struct jobLog* current = logs.head; current; current = current->next) {
+			if ((isJobNumber && current->jobNumber == value) || (!isJobNumber && current->pid == value)) {
+				log = current;
+			}
+		}
+	}
+	if (!log) {
+		printf("joblog: %s: no such job log\n", spec);
+		fflush(stdout);
+		*lastStatus = 127 << 8;
+		return;
+	}
+
+	// pick up whatever the job has written since the event loop last ran
+	drainJobLog(log);
+	if (log->dropped) {
+		printf("[%zu earlier bytes dropped]\n", log->dropped);
+	}
+	writeJobLog(log, 0);
+}
+
+/*
+* Releases all memory allocated for job logs
+*/
+void cleanupJobLogs(void) {
+	while (logs.head) {
+		releaseJobLog(logs.head);
+	}
+}
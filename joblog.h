@@ -0,0 +1,61 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for job logs - the opt-in capture of the output of background jobs into bounded
+*	in-memory ring buffers and the joblog built-in command
+*/
+
+// the variable holding the number of KiB of output kept for each background job, which enables capturing
+#define JOBLOG_VARIABLE "SMALLSH_JOBLOG"
+
+// the number of KiB all job logs may hold together
+#define JOBLOG_TOTAL_KIB 16384
+
+// the number of lines of a job log displayed with the notice of a job that did not succeed
+#define JOBLOG_TAIL_LINES 10
+
+/*
+* A struct representing the captured output of a background job. The event loop drains the pipe the job
+* writes its standard output and standard error into, keeping only the last size bytes
+*/
+struct jobLog {
+	struct eventHandler handler;  // watches the read end of the pipe, whose fd is -1 once it reached end of file
+	pid_t pid;  // the process id of the job
+	int jobNumber;  // the job number of the job
+	char* buffer;  // the ring buffer holding the output
+	size_t size;  // the number of bytes the ring buffer holds
+	size_t start;  // the index of the oldest byte kept
+	size_t length;  // the number of bytes kept
+	size_t dropped;  // the number of older bytes that were overwritten
+	struct jobLog* next;  // the next newer job log
+};
+
+/*
+* Starts capturing the output of command if it is a background command whose output is not redirected and
+* SMALLSH_JOBLOG is set. The write end of the pipe is stored in the outputFD and errorFD members of command.
+* Returns NULL if the output is not captured, e.g. when every job log is in use and there is no memory left
+*/
+struct jobLog* startJobLog(struct command* command, int foregroundFlag);
+
+/*
+* Records the process and job number the job log belongs to once the job has started, and closes the write
+* end of the pipe held by the shell. A pid of 0 means the job never started and the log is released
+*/
+void attachJobLog(struct jobLog* log, struct command* command, pid_t pid, int jobNumber);
+
+/*
+* Displays the last lines of the output of the background process pid if its status shows it did not succeed
+*/
+void displayJobLogTail(pid_t pid, int childStatus);
+
+/*
+* Executes the built-in "joblog" command. "joblog %N" or "joblog PID" displays the output kept for the job,
+* and with no arguments every job log is listed
+*/
+void showJobLog(struct command* command, int* lastStatus);
+
+/*
+* Releases all memory allocated for job logs
+*/
+void cleanupJobLogs(void);
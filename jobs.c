@@ -0,0 +1,375 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: A job table that tracks background processes through pidfds watched by the event loop, along
+*	with the jobs and wait built-in commands
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "events.h"
+#include "commandExecution.h"
+#include "jobs.h"
+#include "prompt.h"
+#include "placement.h"
+
+// the interval in milliseconds at which jobs without a pidfd are polled while the shell waits for jobs
+#define POLL_INTERVAL 50
+
+/*
+* A struct representing the table of running background jobs, ordered by job number
+*/
+struct jobTable {
+	struct job* head;  // the job with the lowest job number
+	struct job* tail;  // the job with the highest job number, used to number and append new jobs
+	int numJobs;  // the number of jobs in the table
+	int numFinished;  // the number of jobs that have terminated but have not been reaped yet
+	int numUnwatched;  // the number of running jobs without a pidfd, which have to be polled with waitid
+};
+
+// the single job table used by smallsh
+static struct jobTable jobs = { 0 };
+
+/*
+* Event loop callback invoked when the pidfd of a job becomes readable, i.e. its process has terminated
+*/
+static void jobTerminated(struct eventHandler* handler, unsigned int events) {
+	struct job* job = (struct job*)handler->data;
+
+	// mark the job as finished and stop watching the pidfd, which stays readable until the job is reaped
+	job->finished = true;
+	jobs.numFinished++;
+	modifyEventHandler(handler, 0);
+}
+
+/*
+* Adds the background process pid started by command to the job table and returns its job number
+*/
+int addJob(pid_t pid, struct command* command) {
+	// declare and initialize a variable used to store the length of the command line
+	size_t length = 2;
+	// allocate and populate the new job, numbering it one past the highest job number in use
+	struct job* job = (struct job*)calloc(1, sizeof(struct job));
+	job->number = jobs.tail ? jobs.tail->number + 1 : 1;
+	job->pid = pid;
+
+	// rebuild the command line from the argv array so that the jobs built-in command can display it
+	for (int index = 0; command->argv[index]; index++) {
+		length += strlen(command->argv[index]) + 1;
+	}
+	job->commandLine = (char*)calloc(length, sizeof(char));
+	for (int index = 0; command->argv[index]; index++) {
+		strcat(job->commandLine, command->argv[index]);
+		strcat(job->commandLine, " ");
+	}
+	strcat(job->commandLine, "&");
+
+	// watch a pidfd for the process so the event loop notices when it terminates - if no pidfd can be opened
+	// (e.g. the shell ran out of file descriptors) the job keeps running and is polled with waitid instead
+	job->handler.fd = syscall(SYS_pidfd_open, pid, 0);
+	job->handler.callback = jobTerminated;
+	job->handler.data = job;
+	if (job->handler.fd != -1) {
+		registerEventHandler(&job->handler, EPOLLIN);
+	}
+	else {
+		jobs.numUnwatched++;
+	}
+
+	// append the job to the end of the table
+	if (jobs.tail) {
+		jobs.tail->next = job;
+	}
+	else {
+		jobs.head = job;
+	}
+	jobs.tail = job;
+	jobs.numJobs++;
+	invalidatePrompt(PROMPT_JOBS);
+
+	return job->number;
+}
+
+/*
+* Removes the job for the process pid from the job table, if there is one
+*/
+void removeJob(pid_t pid) {
+	// declare and initialize a variable used to keep track of the job before the current one
+	struct job* previous = NULL;
+
+	for (struct job* current = jobs.head; current; previous = current, current = current->next) {
+		if (current->pid == pid) {
+			// unlink the job from the table
+			if (previous) {
+				previous->next = current->next;
+			}
+			else {
+				jobs.head = current->next;
+			}
+			if (jobs.tail == current) {
+				jobs.tail = previous;
+			}
+			if (current->finished) {
+				jobs.numFinished--;
+			}
+			else if (current->handler.fd == -1) {
+				jobs.numUnwatched--;
+			}
+			jobs.numJobs--;
+			invalidatePrompt(PROMPT_JOBS);
+
+			// stop watching the pidfd and release the memory allocated for the job
+			if (current->handler.fd != -1) {
+				unregisterEventHandler(&current->handler);
+				close(current->handler.fd);
+			}
+			free(current->commandLine);
+			free(current);
+			return;
+		}
+	}
+}
+
+/*
+* Returns the number of jobs in the job table
+*/
+int countJobs(void) {
+	return jobs.numJobs;
+}
+
+/*
+* Marks every running job without a pidfd whose process has terminated as finished. The process is left
+* waitable so that it is still reaped, and its status collected, by collectJob
+*/
+static void pollUnwatchedJobs(void) {
+	// declare a variable used to store the state of a process reported by waitid
+	siginfo_t info;
+
+	for (struct job* current = jobs.head; jobs.numUnwatched && current; current = current->next) {
+		if (current->finished || current->handler.fd != -1) {
+			continue;
+		}
+
+		// si_pid is only set if the process has terminated
+		info.si_pid = 0;
+		if (waitid(P_PID, current->pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == current->pid) {
+			current->finished = true;
+			jobs.numFinished++;
+			jobs.numUnwatched--;
+		}
+	}
+}
+
+/*
+* Sleeps in the event loop until a pidfd handler runs. If some jobs have no pidfd the sleep is cut short after
+* POLL_INTERVAL milliseconds and those jobs are polled, so that a caller checking for finished jobs in a loop
+* notices them too
+*/
+static void waitForJobEvents(void) {
+	waitForEventsTimeout(-1, jobs.numUnwatched ? POLL_INTERVAL : -1);
+	pollUnwatchedJobs();
+}
+
+/*
+* Executes the built-in "jobs" command by displaying the number, pid, state and command line of each job -
+* "jobs -l" also displays the CPUs each running job may currently run on
+*/
+void listJobs(struct command* command) {
+	// declare and initialize a variable used to store whether "jobs -l" also displays where each job is placed
+	bool listPlacement = command->argv[1] && strcmp(command->argv[1], "-l") == 0;
+	// declare a variable used to store the CPUs a job may currently run on
+	char cpus[256];
+
+	// jobs without a pidfd are not marked as finished by the event loop, so check on them first
+	pollUnwatchedJobs();
+
+	for (struct job* current = jobs.head; current; current = current->next) {
+		if (listPlacement) {
+			describeAffinity(current->finished ? -1 : current->pid, cpus, sizeof(cpus));
+			printf("[%d] %d %-8s cpus %-10s %s\n", current->number, current->pid, current->finished ? "Done" : "Running", cpus, current->commandLine);
+		}
+		else {
+			printf("[%d] %d %-8s %s\n", current->number, current->pid, current->finished ? "Done" : "Running", current->commandLine);
+		}
+	}
+	// flush stdout
+	fflush(stdout);
+}
+
+/*
+* Returns the job referred to by spec - either %N for a job number or the pid of the job - or NULL if there
+* is no such job
+*/
+static struct job* findJob(char* spec) {
+	// declare and initialize a variable used to store whether spec is a job number
+	bool isJobNumber = spec[0] == '%';
+	// declare a variable used to store the job number or pid in spec
+	int value;
+	// declare a variable used to detect trailing characters after the number
+	char* end;
+
+	// the number must be made up of digits only
+	if (!isdigit((unsigned char)spec[isJobNumber])) {
+		return NULL;
+	}
+	value = strtol(spec + isJobNumber, &end, 10);
+	if (*end != '\0') {
+		return NULL;
+	}
+
+	// look for a job with a matching job number or pid
+	for (struct job* current = jobs.head; current; current = current->next) {
+		if ((isJobNumber && current->number == value) || (!isJobNumber && current->pid == value)) {
+			return current;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* Returns the first job in the table that has finished or NULL if every job is still running
+*/
+static struct job* findFinishedJob(void) {
+	for (struct job* current = jobs.head; jobs.numFinished && current; current = current->next) {
+		if (current->finished) {
+			return current;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* Reaps the process of job, displays its completion message and removes it from the job table and the
+* backgroundPids array. Returns the collected status of the process
+*/
+static int collectJob(struct job* job, struct dynamicArray* backgroundPids) {
+	// declare a variable used to store the status of the process
+	int childStatus;
+	// declare a variable used to store the resources used by the process
+	struct rusage usage;
+	// copy the pid since the job is released while the process is collected
+	pid_t pid = job->pid;
+
+	// the job is only collected once its pidfd or waitid reported that the process terminated, so this never blocks
+	wait4(pid, &childStatus, 0, &usage);
+
+	// find the pid in the backgroundPids array and hand the process over to be reported and removed
+	for (int index = 0; index < backgroundPids->size; index++) {
+		if (backgroundPids->staticArray[index] == pid) {
+			return collectBackgroundProcess(backgroundPids, index, childStatus, &usage);
+		}
+	}
+
+	// the pid is not tracked as a background process - just remove the job
+	removeJob(pid);
+	return childStatus;
+}
+
+/*
+* Blocks in the event loop until job has terminated and returns its collected status
+*/
+static int waitForJob(struct job* job, struct dynamicArray* backgroundPids) {
+	// keep dispatching event handlers - one of them will eventually mark the job as finished
+	pollUnwatchedJobs();
+	while (!job->finished) {
+		waitForJobEvents();
+	}
+
+	return collectJob(job, backgroundPids);
+}
+
+/*
+* Executes the built-in "wait" command. With no arguments every job is waited for, "wait -n" waits for the
+* first job to terminate and "wait %N" or "wait PID" waits for the given jobs. The shell sleeps in the event
+* loop while waiting and each job is reaped as soon as its pidfd reports that it terminated. The collected
+* status is stored in lastStatus for use by the status built-in command
+*/
+void waitForJobs(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus) {
+	// with no arguments wait for every job - the status is that of the first job that did not exit with a
+	// value of 0, or 0 if they all did
+	pollUnwatchedJobs();
+	if (!command->argv[1]) {
+		*lastStatus = 0;
+		while (jobs.head) {
+			struct job* job = findFinishedJob();
+			int childStatus;
+
+			// if no job has finished yet, sleep until the event loop reports one
+			if (!job) {
+				waitForJobEvents();
+				continue;
+			}
+
+			childStatus = collectJob(job, backgroundPids);
+			if (*lastStatus == 0) {
+				*lastStatus = childStatus;
+			}
+		}
+		return;
+	}
+
+	// "wait -n" waits for whichever job finishes first
+	if (strcmp(command->argv[1], "-n") == 0) {
+		// with no jobs there is nothing to wait for
+		if (!jobs.head) {
+			*lastStatus = 127 << 8;
+			return;
+		}
+
+		// sleep until the event loop reports a finished job
+		while (!findFinishedJob()) {
+			waitForJobEvents();
+		}
+		*lastStatus = collectJob(findFinishedJob(), backgroundPids);
+		return;
+	}
+
+	// otherwise wait for each job given as an argument in turn - the status is that of the last one
+	for (int index = 1; command->argv[index]; index++) {
+		struct job* job = findJob(command->argv[index]);
+
+		if (!job) {
+			// display an error message to the user
+			printf("wait: %s: no such job\n", command->argv[index]);
+			// flush stdout
+			fflush(stdout);
+			*lastStatus = 127 << 8;
+			continue;
+		}
+
+		*lastStatus = waitForJob(job, backgroundPids);
+	}
+}
+
+/*
+* Releases all memory allocated for the job table
+*/
+void cleanupJobs(void) {
+	// the epoll instance is shared with forked children, so the pidfds are only closed here - unregistering
+	// them from a child would stop the shell itself from watching them
+	while (jobs.head) {
+		struct job* next = jobs.head->next;
+		if (jobs.head->handler.fd != -1) {
+			close(jobs.head->handler.fd);
+		}
+		free(jobs.head->commandLine);
+		free(jobs.head);
+		jobs.head = next;
+	}
+	memset(&jobs, 0, sizeof(jobs));
+}
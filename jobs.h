@@ -0,0 +1,55 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the job table that tracks background processes along with the jobs and wait
+*	built-in commands
+*/
+
+/*
+* A struct representing a background process started with '&'. Every job holds a pidfd that the event loop
+* watches so that the shell is woken up as soon as the process terminates instead of having to poll it - only
+* if no pidfd could be opened is the job polled with waitid while the shell waits for it
+*/
+struct job {
+	int number;  // the job number used to refer to the job as %number
+	pid_t pid;  // the process id of the background process
+	char* commandLine;  // the command line the job was started with, used by the jobs built-in command
+	bool finished;  // true once the process has terminated and is waiting to be reaped, otherwise false
+	struct eventHandler handler;  // the event loop handler watching the pidfd of the process, fd is -1 without one
+	struct job* next;  // the job with the next higher job number
+};
+
+/*
+* Adds the background process pid started by command to the job table and returns its job number
+*/
+int addJob(pid_t pid, struct command* command);
+
+/*
+* Removes the job for the process pid from the job table, if there is one
+*/
+void removeJob(pid_t pid);
+
+/*
+* Returns the number of jobs in the job table
+*/
+int countJobs(void);
+
+/*
+* Executes the built-in "jobs" command by displaying the number, pid, state and command line of each job -
+* "jobs -l" also displays the CPUs each running job may currently run on
+*/
+void listJobs(struct command* command);
+
+/*
+* Executes the built-in "wait" command. With no arguments every job is waited for, "wait -n" waits for the
+* first job to terminate and "wait %N" or "wait PID" waits for the given jobs. The shell sleeps in the event
+* loop while waiting and each job is reaped as soon as its pidfd reports that it terminated. The collected
+* status is stored in lastStatus for use by the status built-in command
+*/
+void waitForJobs(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus);
+
+/*
+* Releases all memory allocated for the job table
+*/
+void cleanupJobs(void);
@@ -0,0 +1,269 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: The lexer. Ordinary bytes make up nearly all of a command line, so the lexer looks for the next
+*	special byte (LEXER_SPECIAL_BYTES) 32 bytes at a time with AVX2 or 16 bytes at a time with SSE2, falling
+*	back to a lookup table on other processors, and copies each word out in one piece. A long generated
+*	command line is therefore split at close to the speed it can be read from memory
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "lexer.h"
+
+// true for every byte in LEXER_SPECIAL_BYTES, filled in the first time a line is split
+static bool specialTable[256];
+
+// the function finding the next special byte on this processor, chosen the first time a line is split
+static size_t (*findSpecial)(const char* text, size_t length) = NULL;
+
+/*
+* Returns the index of the first special byte among the length bytes of text, or length if there is none
+*/
+static size_t findSpecialScalar(const char* text, size_t length) {
+	size_t index = 0;
+
+	while (index < length && !specialTable[(unsigned char)text[index]]) {
+		index++;
+	}
+
+	return index;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+* Returns the index of the first special byte among the length bytes of text, or length if there is none,
+* comparing 16 bytes at a time against every special byte
+*/
+__attribute__((target("sse2"))) static size_t findSpecialSse2(const char* text, size_t length) {
+	size_t position = 0;
+
+	for (; position + 16 <= length; position += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i*)(text + position));
+		__m128i matches = _mm_setzero_si128();
+
+		for (const char* special = LEXER_SPECIAL_BYTES; *special; special++) {
+			matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(*special)));
+		}
+
+		int mask = _mm_movemask_epi8(matches);
+		if (mask) {
+			return position + __builtin_ctz(mask);
+		}
+	}
+
+	return position + findSpecialScalar(text + position, length - position);
+}
+
+/*
+* Returns the index of the first special byte among the length bytes of text, or length if there is none,
+* comparing 32 bytes at a time against every special byte
+*/
+__attribute__((target("avx2"))) static size_t findSpecialAvx2(const char* text, size_t length) {
+	size_t position = 0;
+
+	for (; position + 32 <= length; position += 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i*)(text + position));
+		__m256i matches = _mm256_setzero_si256();
+
+		for (const char* special = LEXER_SPECIAL_BYTES; *special; special++) {
+			matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(*special)));
+		}
+
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(matches);
+		if (mask) {
+			return position + __builtin_ctz(mask);
+		}
+	}
+
+	return position + findSpecialSse2(text + position, length - position);
+}
+#endif
+
+/*
+* Fills in the table of special bytes and picks the widest way of finding them the processor supports
+*/
+static void initializeLexer(void) {
+	for (const char* special = LEXER_SPECIAL_BYTES; *special; special++) {
+		specialTable[(unsigned char)*special] = true;
+	}
+
+	findSpecial = findSpecialScalar;
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		findSpecial = findSpecialAvx2;
+	}
+	else if (__builtin_cpu_supports("sse2")) {
+		findSpecial = findSpecialSse2;
+	}
+#endif
+}
+
+/*
+* Returns true if byte separates words
+*/
+static bool isWhitespace(char byte) {
+	return byte == ' ' || byte == '\t' || byte == '\n' || byte == '\r';
+}
+
+/*
+* Returns the index just past the quote closing the quote opened at line[position], or 0 if it is never
+* closed. Within double quotes a backslash escapes the next byte
+*/
+static size_t skipQuoted(char* line, size_t position, size_t length) {
+	char quote = line[position++];
+
+	// nothing but the closing quote ends single quotes
+	if (quote == '\'') {
+		char* closing = memchr(line + position, '\'', length - position);
+		return closing ? (size_t)(closing - line) + 1 : 0;
+	}
+
+	while (position < length) {
+		position += findSpecial(line + position, length - position);
+		if (position == length) {
+			break;
+		}
+		if (line[position] == '"') {
+			return position + 1;
+		}
+		position += (line[position] == '\\' && position + 1 < length) ? 2 : 1;
+	}
+
+	return 0;
+}
+
+/*
+* Returns the index just past the word of a process substitution starting at line[position] with "<(" or
+* ">(" - which runs to the matching ')' - or 0 if that is never found
+*/
+static size_t skipSubstitution(char* line, size_t position, size_t length) {
+	int depth = 0;
+
+	while (position < length) {
+		char byte = line[position];
+		if (byte == '\'' || byte == '"') {
+			position = skipQuoted(line, position, length);
+			if (position == 0) {
+				return 0;
+			}
+			continue;
+		}
+
+		depth += (byte == '(') - (byte == ')');
+		position += (byte == '\\' && position + 1 < length) ? 2 : 1;
+		if (depth == 0 && byte == ')') {
+			return position;
+		}
+	}
+
+	return 0;
+}
+
+/*
+* Splits line into its words. Words are separated by unquoted whitespace and an unquoted run of '<', '>', '&'
+* and '|' is a word of its own, except that "<(" and ">(" start a word running to the matching ')' and an
+* arithmetic expansion "$((...))" is kept whole. Quotes and backslashes are kept in the words, which expandWord removes once the words are expanded. Returns a NULL
+* terminated array of words which must be released with freeWords, or NULL if line is blank, a comment or
+* holds an unterminated quote, which is reported
+*/
+char** lexWords(char* line) {
+	// declare and initialize variables used to maintain the words found and the room for them
+	int numWords = 0, capacity = 8;
+	char** words = (char**)malloc(capacity * sizeof(char*));
+	// declare and initialize variables used to walk the line
+	size_t length = strlen(line), position = 0;
+
+	if (!findSpecial) {
+		initializeLexer();
+	}
+
+	while (true) {
+		// skip the whitespace before the next word
+		while (position < length && isWhitespace(line[position])) {
+			position++;
+		}
+		// a line that is blank or starts with '#' holds nothing to execute
+		if (position == length || (numWords == 0 && line[position] == '#')) {
+			break;
+		}
+
+		size_t start = position;
+		// declare and initialize a variable used to describe what a word left unterminated opened
+		char* unterminated = "quote";
+		if ((line[position] == '<' || line[position] == '>') && line[position + 1] == '(') {
+			// a process substitution is a single word however many words the command inside it holds
+			position = skipSubstitution(line, position + 1, length);
+		}
+		else if (strchr(LEXER_OPERATOR_BYTES, line[position])) {
+			// a run of operator characters is a word of its own
+			while (position < length && strchr(LEXER_OPERATOR_BYTES, line[position])) {
+				position++;
+			}
+		}
+		else {
+			// the word runs to the first unquoted whitespace or operator character
+			while (position < length) {
+				position += findSpecial(line + position, length - position);
+				if (position == length || isWhitespace(line[position]) || strchr(LEXER_OPERATOR_BYTES, line[position])) {
+					break;
+				}
+				if (line[position] == '\'' || line[position] == '"') {
+					position = skipQuoted(line, position, length);
+					if (position == 0) {
+						break;
+					}
+				}
+				// the operators and spaces of an arithmetic expansion belong to its word
+				else if (line[position] == '$' && line[position + 1] == '(' && line[position + 2] == '(') {
+					position = skipSubstitution(line, position + 1, length);
+					if (position == 0) {
+						unterminated = "arithmetic expansion";
+						break;
+					}
+				}
+				else if (line[position] == '$') {
+					position++;
+				}
+				else {
+					// a backslash escapes the byte after it
+					position += position + 1 < length ? 2 : 1;
+				}
+			}
+		}
+
+		if (position == 0) {
+			printf("syntax error: unterminated %s\n", line[start] == '<' || line[start] == '>' ? "process substitution" :
+				unterminated);
+			fflush(stdout);
+			while (numWords > 0) {
+				free(words[--numWords]);
+			}
+			break;
+		}
+
+		// copy the word out in one piece
+		if (numWords + 2 > capacity) {
+			capacity *= 2;
+			words = (char**)realloc(words, capacity * sizeof(char*));
+		}
+		words[numWords] = (char*)malloc(position - start + 1);
+		memcpy(words[numWords], line + start, position - start);
+		words[numWords][position - start] = '\0';
+		numWords++;
+	}
+
+	if (numWords == 0) {
+		free(words);
+		return NULL;
+	}
+
+	words[numWords] = NULL;
+	return words;
+}
@@ -0,0 +1,23 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the lexer, which splits a command line into words while honouring single
+*	quotes, double quotes and backslash escapes, finding the bytes that matter with SSE2 or AVX2 when available
+*/
+
+// the bytes the lexer stops at - whitespace, quotes, the backslash, the '$' of an arithmetic expansion and the
+// operator characters
+#define LEXER_SPECIAL_BYTES " \t\n\r'\"\\$<>&|"
+
+// the operator characters, an unquoted run of which is a word of its own
+#define LEXER_OPERATOR_BYTES "<>&|"
+
+/*
+* Splits line into its words. Words are separated by unquoted whitespace and an unquoted run of '<', '>', '&'
+* and '|' is a word of its own, except that "<(" and ">(" start a word running to the matching ')' and an
+* arithmetic expansion "$((...))" is kept whole. Quotes and backslashes are kept in the words, which expandWord removes once the words are expanded. Returns a NULL
+* terminated array of words which must be released with freeWords, or NULL if line is blank, a comment or
+* holds an unterminated quote, which is reported
+*/
+char** lexWords(char* line);
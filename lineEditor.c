@@ -0,0 +1,297 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: A line editor that reads command lines from a terminal in raw mode, with cursor movement and
+*	Tab completion of command names and file paths
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <termios.h>
+#include "events.h"
+#include "completion.h"
+#include "lineEditor.h"
+
+// the control characters the line editor responds to
+#define KEY_CTRL_A 1
+#define KEY_CTRL_B 2
+#define KEY_CTRL_D 4
+#define KEY_CTRL_E 5
+#define KEY_CTRL_F 6
+#define KEY_BACKSPACE_ALT 8
+#define KEY_TAB 9
+#define KEY_CTRL_K 11
+#define KEY_ENTER 13
+#define KEY_CTRL_U 21
+#define KEY_ESCAPE 27
+#define KEY_BACKSPACE 127
+
+/*
+* Returns true if command lines should be read with the line editor, i.e. both standard input and standard
+* output are terminals that understand cursor movement
+*/
+bool useLineEditor(void) {
+	char* term = getenv("TERM");
+
+	return isatty(STDIN_FILENO) && isatty(STDOUT_FILENO) && !(term && strcmp(term, "dumb") == 0);
+}
+
+/*
+* Reads a single byte from the terminal into key, running the event loop until one is available. Returns
+* false at end of input
+*/
+static bool readKey(char* key) {
+	while (true) {
+		waitForEvents(STDIN_FILENO);
+		ssize_t nread = read(STDIN_FILENO, key, 1);
+		if (nread == 1) {
+			return true;
+		}
+		// a signal such as SIGTSTP interrupting the read is not the end of input
+		if (nread == -1 && errno == EINTR) {
+			continue;
+		}
+		return false;
+	}
+}
+
+/*
+* Redraws the last line of the prompt and the edited line, placing the terminal cursor at the cursor of the line
+*/
+static void refreshLine(struct editLine* line) {
+	// only the last line of a multi-line prompt is on the same terminal line as the edited line
+	char* promptLine = strrchr(line->prompt, '\n');
+	promptLine = promptLine ? promptLine + 1 : line->prompt;
+
+	// return to the start of the terminal line, draw everything and clear anything left over
+	printf("\r%s%s\x1b[K", promptLine, line->buffer);
+	// move the terminal cursor back to the cursor of the line
+	if (line->length > line->cursor) {
+		printf("\x1b[%dD", line->length - line->cursor);
+	}
+	fflush(stdout);
+}
+
+/*
+* Inserts the first length characters of text at the cursor and moves the cursor past them
+*/
+static void insertText(struct editLine* line, char* text, int length) {
+	// grow the buffer if the text does not fit
+	if (line->length + length > line->capacity) {
+		while (line->length + length > line->capacity) {
+			line->capacity *= 2;
+		}
+		line->buffer = (char*)realloc(line->buffer, (line->capacity + 1) * sizeof(char));
+	}
+
+	memmove(line->buffer + line->cursor + length, line->buffer + line->cursor, line->length - line->cursor + 1);
+	memcpy(line->buffer + line->cursor, text, length);
+	line->length += length;
+	line->cursor += length;
+}
+
+/*
+* Removes count characters starting at position from the line
+*/
+static void deleteText(struct editLine* line, int position, int count) {
+	memmove(line->buffer + position, line->buffer + position + count, line->length - position - count + 1);
+	line->length -= count;
+	if (line->cursor > position + count) {
+		line->cursor -= count;
+	}
+	else if (line->cursor > position) {
+		line->cursor = position;
+	}
+}
+
+/*
+* Completes the word in front of the cursor. The word is extended by the prefix shared by every candidate -
+* with a single candidate the word is finished with a space, or left open after a directory's '/'. If the
+* word cannot be extended, pressing Tab a second time lists the candidates
+*/
+static void completeWord(struct editLine* line) {
+	// find the start of the word in front of the cursor
+	int start = line->cursor;
+	while (start > 0 && line->buffer[start - 1] != ' ') {
+		start--;
+	}
+
+	// the word is a command name if only spaces come before it
+	bool isCommand = true;
+	for (int index = 0; index < start; index++) {
+		isCommand = isCommand && line->buffer[index] == ' ';
+	}
+
+	// copy out the word and look up its candidates
+	char word[line->cursor - start + 1];
+	strncpy(word, line->buffer + start, line->cursor - start);
+	word[line->cursor - start] = '\0';
+	struct completions* completions = findCompletions(word, isCommand);
+
+	// extend the word by whatever all the candidates share
+	int extension = strlen(completions->commonPrefix) - strlen(word);
+	if (extension > 0) {
+		insertText(line, completions->commonPrefix + strlen(word), extension);
+	}
+
+	// a single candidate is complete - finish the word unless it is a directory that can be descended into
+	if (completions->numCandidates == 1) {
+		char* candidate = completions->candidates[0];
+		if (candidate[strlen(candidate) - 1] != '/') {
+			insertText(line, " ", 1);
+		}
+		line->listed = false;
+	}
+	// a second Tab that cannot extend the word lists the candidates on the lines below the prompt
+	else if (completions->numCandidates > 1 && extension <= 0 && line->listed) {
+		printf("\n");
+		for (int index = 0; index < completions->numCandidates && index < MAX_COMPLETION_CANDIDATES; index++) {
+			printf("%s  ", completions->candidates[index]);
+		}
+		if (completions->numCandidates > MAX_COMPLETION_CANDIDATES) {
+			printf("(%d more)", completions->numCandidates - MAX_COMPLETION_CANDIDATES);
+		}
+		printf("\n%s", line->prompt);
+		line->listed = false;
+	}
+	else {
+		line->listed = extension <= 0;
+	}
+
+	freeCompletions(completions);
+}
+
+/*
+* Handles an escape sequence - the arrow, Home, End and Delete keys - once its ESC character has been read
+*/
+static void handleEscape(struct editLine* line) {
+	char sequence[3] = { 0 };
+
+	// every supported sequence is ESC [ followed by a letter or by a digit and '~'
+	if (!readKey(&sequence[0]) || sequence[0] != '[' || !readKey(&sequence[1])) {
+		return;
+	}
+	if (sequence[1] >= '0' && sequence[1] <= '9') {
+		if (!readKey(&sequence[2]) || sequence[2] != '~') {
+			return;
+		}
+		if (sequence[1] == '3' && line->cursor < line->length) {
+			deleteText(line, line->cursor, 1);
+		}
+		else if (sequence[1] == '1' || sequence[1] == '7') {
+			line->cursor = 0;
+		}
+		else if (sequence[1] == '4' || sequence[1] == '8') {
+			line->cursor = line->length;
+		}
+		return;
+	}
+
+	switch (sequence[1]) {
+		case 'C': line->cursor += line->cursor < line->length; break;
+		case 'D': line->cursor -= line->cursor > 0; break;
+		case 'H': line->cursor = 0; break;
+		case 'F': line->cursor = line->length; break;
+	}
+}
+
+/*
+* Displays prompt and reads a command line from the terminal in raw mode, supporting cursor movement and Tab
+* completion of command names and file paths. The event loop keeps running while waiting for each key. Returns
+* the line without its trailing newline, which must be freed by the caller, or NULL at end of input
+*/
+char* readEditedLine(char* prompt) {
+	// declare variables used to store the original terminal settings and the raw mode settings
+	struct termios original, raw;
+	// declare and initialize the line being edited
+	struct editLine line = { NULL, 0, 64, 0, prompt, false };
+	// declare a variable used to store each key read
+	char key;
+	// declare and initialize a variable used to store whether the line was finished with Enter
+	bool finished = false;
+
+	line.buffer = (char*)calloc(line.capacity + 1, sizeof(char));
+
+	// start building the trie of command names while the user types
+	prepareCompletion();
+
+	// switch the terminal to raw mode for the duration of the line - signals stay enabled so that Ctrl-Z still
+	// toggles foreground-only mode
+	tcgetattr(STDIN_FILENO, &original);
+	raw = original;
+	raw.c_iflag &= ~(ICRNL | IXON);
+	raw.c_lflag &= ~(ICANON | ECHO | IEXTEN);
+	raw.c_cc[VMIN] = 1;
+	raw.c_cc[VTIME] = 0;
+	tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+	// display the prompt
+	printf("%s", prompt);
+	fflush(stdout);
+
+	while (!finished && readKey(&key)) {
+		// any key but Tab starts over the count of Tabs that could not extend a word
+		if (key != KEY_TAB) {
+			line.listed = false;
+		}
+
+		switch (key) {
+			case KEY_ENTER:
+			case '\n':
+				finished = true;
+				break;
+			case KEY_CTRL_D:
+				// Ctrl-D on an empty line ends the input, otherwise it deletes the character under the cursor
+				if (line.length == 0) {
+					tcsetattr(STDIN_FILENO, TCSANOW, &original);
+					printf("\n");
+					fflush(stdout);
+					free(line.buffer);
+					return NULL;
+				}
+				if (line.cursor < line.length) {
+					deleteText(&line, line.cursor, 1);
+				}
+				break;
+			case KEY_BACKSPACE:
+			case KEY_BACKSPACE_ALT:
+				if (line.cursor > 0) {
+					deleteText(&line, line.cursor - 1, 1);
+				}
+				break;
+			case KEY_CTRL_A: line.cursor = 0; break;
+			case KEY_CTRL_E: line.cursor = line.length; break;
+			case KEY_CTRL_B: line.cursor -= line.cursor > 0; break;
+			case KEY_CTRL_F: line.cursor += line.cursor < line.length; break;
+			case KEY_CTRL_K: deleteText(&line, line.cursor, line.length - line.cursor); break;
+			case KEY_CTRL_U: deleteText(&line, 0, line.cursor); break;
+			case KEY_TAB: completeWord(&line); break;
+			case KEY_ESCAPE: handleEscape(&line); break;
+			default:
+				// insert any printable character, ignoring other control characters
+				if ((unsigned char)key >= ' ') {
+					insertText(&line, &key, 1);
+				}
+				break;
+		}
+
+		refreshLine(&line);
+	}
+
+	// restore the terminal so that commands run with the usual settings, and move past the line
+	tcsetattr(STDIN_FILENO, TCSANOW, &original);
+	printf("\n");
+	fflush(stdout);
+
+	// end of input before Enter was pressed
+	if (!finished) {
+		free(line.buffer);
+		return NULL;
+	}
+
+	return line.buffer;
+}
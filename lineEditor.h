@@ -0,0 +1,31 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the line editor used to read command lines from a terminal
+*/
+
+/*
+* A struct representing the line being edited
+*/
+struct editLine {
+	char* buffer;  // the characters of the line, NULL terminated
+	int length;  // the number of characters in the line
+	int capacity;  // the number of characters buffer can hold, not counting the NULL terminator
+	int cursor;  // the position of the cursor within the line
+	char* prompt;  // the prompt displayed in front of the line
+	bool listed;  // true if the last key was a Tab that could not extend the word, otherwise false
+};
+
+/*
+* Returns true if command lines should be read with the line editor, i.e. both standard input and standard
+* output are terminals that understand cursor movement
+*/
+bool useLineEditor(void);
+
+/*
+* Displays prompt and reads a command line from the terminal in raw mode, supporting cursor movement and Tab
+* completion of command names and file paths. The event loop keeps running while waiting for each key. Returns
+* the line without its trailing newline, which must be freed by the caller, or NULL at end of input
+*/
+char* readEditedLine(char* prompt);
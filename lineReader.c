@@ -0,0 +1,347 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: The read built-in command. A file is read a block at a time, after which its offset is moved back
+*	to just past the line read so that the next reader of the file - another read or a program - starts at the
+*	next line. A pipe cannot be moved back, so what was read past the line is kept in a lookahead buffer of the
+*	shell for the next read of that pipe. Either way a line costs a few system calls rather than one per byte
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "variables.h"
+#include "functions.h"
+#include "lineReader.h"
+
+/*
+* A struct representing a line being read, which grows as more of it is read
+*/
+struct lineBuffer {
+	char* data;  // the characters of the line read so far, without the newline
+	size_t length;  // the number of characters read so far
+	size_t capacity;  // the number of characters data has room for
+};
+
+/*
+* A struct representing the lookahead buffer of a pipe - what was read from it past the last line read
+*/
+struct lookahead {
+	int fd;  // the file descriptor of the pipe
+	dev_t device;  // the device and inode of the pipe, so that a file descriptor reused for another pipe
+	ino_t inode;  // does not get the lookahead of the old one
+	char* data;  // the characters read but not used yet, from start up to end
+	size_t start;
+	size_t end;
+	struct lookahead* next;  // the lookahead buffer of the next pipe
+};
+
+// the lookahead buffers of the pipes read from
+static struct lookahead* lookaheads = NULL;
+
+/*
+* Makes room for count more characters at the end of line
+*/
+static void reserveBytes(struct lineBuffer* line, size_t count) {
+	if (line->length + count + 1 > line->capacity) {
+		line->capacity = (line->length + count + 1) * 2;
+		line->data = (char*)realloc(line->data, line->capacity);
+	}
+}
+
+/*
+* Appends count characters of bytes to line
+*/
+static void appendBytes(struct lineBuffer* line, char* bytes, size_t count) {
+	reserveBytes(line, count);
+	memcpy(line->data + line->length, bytes, count);
+	line->length += count;
+	line->data[line->length] = '\0';
+}
+
+/*
+* Reads the rest of a line from the standard input stream of the shell, whose buffer the command reader shares
+* - a line read here is not read again as a command. Returns true if the line ended with a newline
+*/
+static bool readFromStream(struct lineBuffer* line) {
+	char* text = NULL;
+	size_t capacity = 0;
+	ssize_t length = getline(&text, &capacity, stdin);
+	bool newline = length > 0 && text[length - 1] == '\n';
+
+	if (length > 0) {
+		appendBytes(line, text, length - newline);
+	}
+	free(text);
+	return newline;
+}
+
+/*
+* Reads the rest of a line from the file open at fd a block at a time, moving the offset of fd back to just past
+* the newline once it is found. Returns true if the line ended with a newline
+*/
+static bool readFromFile(int fd, struct lineBuffer* line) {
+	while (true) {
+		// read straight into the line, which keeps what was read up to the newline
+		reserveBytes(line, READ_BLOCK_SIZE);
+		ssize_t count = read(fd, line->data + line->length, READ_BLOCK_SIZE);
+		if (count <= 0) {
+			line->data[line->length] = '\0';
+			return false;
+		}
+
+		char* newline = memchr(line->data + line->length, '\n', count);
+		if (newline) {
+			// leave the offset just past the newline for whoever reads the file next
+			lseek(fd, -(off_t)(line->data + line->length + count - (newline + 1)), SEEK_CUR);
+			line->length = newline - line->data;
+			line->data[line->length] = '\0';
+			return true;
+		}
+		line->length += count;
+	}
+}
+
+/*
+* Returns the lookahead buffer of the pipe open at fd, whose device and inode are in fileStat, creating an empty
+* one if there is none yet
+*/
+static struct lookahead* getLookahead(int fd, struct stat* fileStat) {
+	struct lookahead* buffer;
+
+	for (buffer = lookaheads; buffer; buffer = buffer->next) {
+		if (buffer->fd == fd) {
+			break;
+		}
+	}
+	if (!buffer) {
+		buffer = (struct lookahead*)calloc(1, sizeof(struct lookahead));
+		buffer->fd = fd;
+		buffer->data = (char*)malloc(READ_BLOCK_SIZE);
+		buffer->next = lookaheads;
+		lookaheads = buffer;
+	}
+
+	// what was read from a pipe since closed belongs to no one
+	if (buffer->device != fileStat->st_dev || buffer->inode != fileStat->st_ino) {
+		buffer->device = fileStat->st_dev;
+		buffer->inode = fileStat->st_ino;
+		buffer->start = 0;
+		buffer->end = 0;
+	}
+
+	return buffer;
+}
+
+/*
+* Reads the rest of a line from the pipe open at fd through its lookahead buffer, which keeps what was read past
+* the newline for the next read. Returns true if the line ended with a newline
+*/
+static bool readFromPipe(int fd, struct stat* fileStat, struct lineBuffer* line) {
+	struct lookahead* buffer = getLookahead(fd, fileStat);
+
+	while (true) {
+		char* start = buffer->data + buffer->start;
+		char* newline = memchr(start, '\n', buffer->end - buffer->start);
+		if (newline) {
+			appendBytes(line, start, newline - start);
+			buffer->start = newline + 1 - buffer->data;
+			return true;
+		}
+
+		// the buffer is used up - refill it with whatever the pipe holds, up to a block
+		appendBytes(line, start, buffer->end - buffer->start);
+		buffer->start = 0;
+		buffer->end = 0;
+		ssize_t count = read(fd, buffer->data, READ_BLOCK_SIZE);
+		if (count <= 0) {
+			return false;
+		}
+		buffer->end = count;
+	}
+}
+
+/*
+* Reads the rest of a line from fd into line, choosing how by what fd is open on. Returns true if the line ended
+* with a newline
+*/
+static bool readLine(int fd, struct lineBuffer* line) {
+	struct stat fileStat;
+
+	if (fstat(fd, &fileStat) == -1) {
+		return false;
+	}
+
+	// the standard input of the shell is read through stdin when the command reader may have read ahead of it -
+	// not while a function call has replaced it, since what stdin holds belongs to the input replaced
+	if (fd == STDIN_FILENO && !functionInputRedirected() &&
+		(stdin->_IO_read_ptr < stdin->_IO_read_end || !S_ISREG(fileStat.st_mode))) {
+		return readFromStream(line);
+	}
+	if (S_ISREG(fileStat.st_mode) || S_ISBLK(fileStat.st_mode)) {
+		return readFromFile(fd, line);
+	}
+
+	return readFromPipe(fd, &fileStat, line);
+}
+
+/*
+* Returns true if the character at index of text separates fields - it is one of the characters of ifs and was not
+* escaped
+*/
+static bool isSeparator(char* text, bool* escaped, size_t index, char* ifs) {
+	return text[index] && !escaped[index] && strchr(ifs, text[index]);
+}
+
+/*
+* Returns true if the character at index of text is a separator that is also whitespace, which runs of are
+* treated as a single separator
+*/
+static bool isSpaceSeparator(char* text, bool* escaped, size_t index, char* ifs) {
+	return isSeparator(text, escaped, index, ifs) && strchr(" \t\n", text[index]);
+}
+
+/*
+* Executes the built-in "read" command - read [-r] [NAME...] - which reads a line from the input of the command
+* and splits it into fields at the characters of IFS (spaces, tabs and newlines by default). Each NAME is set to
+* a field in turn and the last NAME to the rest of the line, or REPLY to the whole line if no NAME is given.
+* Without -r a backslash escapes the character after it and joins a line ending with it to the next. The exit
+* value, stored in lastStatus, is 1 if the input ended before a newline
+*/
+void readVariables(struct command* command, int* lastStatus) {
+	// declare and initialize a variable used to store whether backslashes are kept as they are
+	bool raw = false;
+	// declare and initialize a variable used to store the index of the first variable name
+	int firstName = 1;
+	// declare and initialize a variable used to store the input of the command
+	int inputFD = STDIN_FILENO;
+	// declare and initialize the line being read
+	struct lineBuffer line = { NULL, 0, 0 };
+	// declare a variable used to store whether the line ended with a newline
+	bool complete;
+	// declare and initialize the characters fields are separated at
+	char* ifs = getVariable("IFS");
+	// the default name when no names are given
+	char* defaultNames[] = { READ_DEFAULT_VARIABLE, NULL };
+
+	if (command->argv[1] && strcmp(command->argv[1], "-r") == 0) {
+		raw = true;
+		firstName++;
+	}
+	char** names = command->argv[firstName] ? command->argv + firstName : defaultNames;
+	for (int index = 0; names[index]; index++) {
+		if (!isValidVariableName(names[index], strlen(names[index]))) {
+			printf("read: %s: invalid variable name\n", names[index]);
+			printf("usage: read [-r] [NAME...]\n");
+			fflush(stdout);
+			*lastStatus = 1 << 8;
+			return;
+		}
+	}
+
+	// the input is that of the command - a here-document, here-string or file, or the input of the shell
+	if (command->inputRedirect) {
+		inputFD = command->inputFD != -1 ? command->inputFD : open(command->newInput, O_RDONLY | O_CLOEXEC);
+		if (inputFD == -1) {
+			printf("Cannot open %s for input\n", command->newInput);
+			fflush(stdout);
+			*lastStatus = 1 << 8;
+			return;
+		}
+	}
+
+	// read the line - without -r a backslash at its end joins it to the next one
+	reserveBytes(&line, 0);
+	line.data[0] = '\0';
+	while ((complete = readLine(inputFD, &line)) && !raw) {
+		size_t backslashes = 0;
+		while (backslashes < line.length && line.data[line.length - 1 - backslashes] == '\\') {
+			backslashes++;
+		}
+		if (backslashes % 2 == 0) {
+			break;
+		}
+		line.data[--line.length] = '\0';
+	}
+	if (command->inputRedirect && command->inputFD == -1) {
+		close(inputFD);
+	}
+
+	// remove the backslashes, marking the characters they escaped, which never separate fields
+	bool* escaped = (bool*)calloc(line.length + 1, sizeof(bool));
+	size_t length = 0;
+	for (size_t index = 0; index < line.length; index++, length++) {
+		if (!raw && line.data[index] == '\\' && index + 1 < line.length) {
+			index++;
+			escaped[length] = true;
+		}
+		line.data[length] = line.data[index];
+	}
+	line.data[length] = '\0';
+
+	// split the line - runs of whitespace in IFS separate fields and are dropped at both ends, while any other
+	// character in IFS separates fields on its own along with the whitespace around it
+	ifs = ifs ? ifs : " \t\n";
+	size_t position = 0;
+	while (isSpaceSeparator(line.data, escaped, position, ifs)) {
+		position++;
+	}
+	for (int index = 0; names[index]; index++) {
+		size_t start = position, end;
+
+		if (!names[index + 1]) {
+			// the last name gets the rest of the line, without the whitespace separators at its end
+			end = length;
+			while (end > start && isSpaceSeparator(line.data, escaped, end - 1, ifs)) {
+				end--;
+			}
+			position = end;
+		}
+		else {
+			while (position < length && !isSeparator(line.data, escaped, position, ifs)) {
+				position++;
+			}
+			end = position;
+
+			// skip the separator - whitespace, at most one other character, and whitespace again
+			while (isSpaceSeparator(line.data, escaped, position, ifs)) {
+				position++;
+			}
+			if (isSeparator(line.data, escaped, position, ifs)) {
+				position++;
+				while (isSpaceSeparator(line.data, escaped, position, ifs)) {
+					position++;
+				}
+			}
+		}
+
+		// the field ends where the separator starts
+		char saved = line.data[end];
+		line.data[end] = '\0';
+		setVariable(names[index], line.data + start);
+		line.data[end] = saved;
+	}
+
+	free(escaped);
+	free(line.data);
+	*lastStatus = complete ? 0 : 1 << 8;
+}
+
+/*
+* Releases the lookahead buffers of the pipes read from
+*/
+void cleanupLineReader(void) {
+	while (lookaheads) {
+		struct lookahead* next = lookaheads->next;
+		free(lookaheads->data);
+		free(lookaheads);
+		lookaheads = next;
+	}
+}
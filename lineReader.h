@@ -0,0 +1,28 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the read built-in command, which reads a line of input into shell variables a
+*	block at a time rather than a byte at a time
+*/
+
+// the number of bytes read at once, from a file before seeking back to the end of the line or from a pipe
+// into its lookahead buffer
+#define READ_BLOCK_SIZE 65536
+
+// the variable a line is read into when read is given no variable names
+#define READ_DEFAULT_VARIABLE "REPLY"
+
+/*
+* Executes the built-in "read" command - read [-r] [NAME...] - which reads a line from the input of the command
+* and splits it into fields at the characters of IFS (spaces, tabs and newlines by default). Each NAME is set to
+* a field in turn and the last NAME to the rest of the line, or REPLY to the whole line if no NAME is given.
+* Without -r a backslash escapes the character after it and joins a line ending with it to the next. The exit
+* value, stored in lastStatus, is 1 if the input ended before a newline
+*/
+void readVariables(struct command* command, int* lastStatus);
+
+/*
+* Releases the lookahead buffers of the pipes read from
+*/
+void cleanupLineReader(void);
@@ -10,11 +10,25 @@
 #include <unistd.h>
 #include <signal.h>
 #include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
 #include "dynamicArray.h"
 #include "parser.h"
 #include "commandExecution.h"
 #include "signals.h"
 #include "memory.h"
+#include "variables.h"
+#include "server.h"
+#include "zygote.h"
+#include "events.h"
+#include "prompt.h"
+#include "rc.h"
+#include "record.h"
+#include "heredoc.h"
+#include "metrics.h"
+#include "optimizer.h"
 
 // A variable used to maintain a 0 or 1 value associated with the shell being in foreground
 // only mode or not  1 = foregroundOnlyMode, 0 = !foregroundOnlyMode - this variable is used
@@ -22,6 +36,9 @@
 // Reference citation A
 static volatile sig_atomic_t foregroundOnlyMode = 0;
 
+// the environment smallsh was started with - used to seed the shell variable store
+extern char** environ;
+
 /*
 * Function definition for foregroundOff signal handler
 * Reference citation A
@@ -71,9 +88,12 @@ void foregroundOff(int signo) {
 }
 
 /*
-* Driver code for smallsh program
+* Driver code for smallsh program. "smallsh --serve PATH [--workers N]" runs smallsh as a daemon that executes
+* command lines submitted over the Unix domain socket at PATH. "--norc" skips the startup file ~/.smallshrc,
+* "--explain" displays how the optimizer rewrites command lines and "--record FILE" records every command line
+* entered, with its timing, into FILE for replayDriver
 */
-int main(void) {
+int main(int argc, char* argv[]) {
 	// declare and initialize a variable to store the exit status of the last foreground process
 	int lastStatus = 0;
 	// declare and initialize a variable to store the userInput returned after capturing command line
@@ -89,7 +109,24 @@ int main(void) {
 	// declare and initialize sigaction structs ignore_action and SIGTSTP_action for use in
 	// signal handling
 	struct sigaction ignore_action = { 0 }, SIGTSTP_action = { 0 };
+	// declare and initialize a variable to store the socket path provided via --serve
+	char* socketPath = NULL;
+	// declare and initialize a variable to store the worker limit provided via --workers
+	int workerLimit = DEFAULT_SERVER_WORKERS;
+	// declare and initialize a variable used to store whether the startup file should be executed
+	bool readStartupFile = true;
+	// declare variables used to time each command for the prompt
+	struct timespec commandStart, commandEnd;
 		
+	// import the inherited environment into the shell variable store as exported variables
+	initializeVariables(environ);
+
+	// if SMALLSH_ZYGOTE=1, start the zygote now while the shell is still small so that every command it spawns
+	// later is spawned from a minimal address space
+	if (getVariable("SMALLSH_ZYGOTE") && strcmp(getVariable("SMALLSH_ZYGOTE"), "1") == 0) {
+		startZygote();
+	}
+
 	// populate the ignore_action struct
 	fill_ignore_action(&ignore_action);
 	// register the ignore_action struct with SIGINT
@@ -100,6 +137,52 @@ int main(void) {
 	// register the SIGTSTP_action struct with SIGTSTP
 	sigaction(SIGTSTP, &SIGTSTP_action, NULL);
 
+	// process the command line options
+	for (int index = 1; index < argc; index++) {
+		// "--serve PATH" runs smallsh as a daemon listening on PATH
+		if (strcmp(argv[index], "--serve") == 0 && index + 1 < argc) {
+			socketPath = argv[++index];
+		}
+		// "--workers N" limits how many commands the daemon runs at once
+		else if (strcmp(argv[index], "--workers") == 0 && index + 1 < argc) {
+			workerLimit = atoi(argv[++index]);
+		}
+		// "--norc" skips the startup file
+		else if (strcmp(argv[index], "--norc") == 0) {
+			readStartupFile = false;
+		}
+		// "--explain" displays each command line the optimizer rewrites
+		else if (strcmp(argv[index], "--explain") == 0) {
+			explainRewrites();
+		}
+		// "--record FILE" records the session into FILE
+		else if (strcmp(argv[index], "--record") == 0 && index + 1 < argc) {
+			if (!startRecording(argv[++index])) {
+				exit(1);
+			}
+		}
+		// anything else is not understood - display usage information to the user
+		else {
+			fprintf(stderr, "usage: %s [--norc] [--explain] [--record FILE] [--serve PATH [--workers N]]\n", argv[0]);
+			exit(1);
+		}
+	}
+
+	// publish the live metrics page for monitors outside the shell
+	startMetrics();
+
+	// execute the startup file before anything else
+	if (readStartupFile) {
+		loadStartupFile(backgroundPids, &lastStatus);
+	}
+
+	// in daemon mode, execute command lines from the socket instead of the user - this only returns on failure
+	if (socketPath) {
+		serveRequests(socketPath, workerLimit, backgroundPids);
+		cleanupMemoryAndExit(NULL, backgroundPids);
+		exit(1);
+	}
+
 	// continue capture user input and executing the provided commands until the user exits the
 	// program via the "exit" command
 	while (true) {
@@ -115,9 +198,24 @@ int main(void) {
 		// display the command prompt ":" and await user input
 		userInput = getCommandLineInput();
 
+		// if userInput is NULL then the input has ended - behave as if the user entered "exit"
+		if (!userInput) {
+			// cleanup memory and terminate any background processes
+			cleanupMemoryAndExit(NULL, backgroundPids);
+			// exit with status 0
+			exit(0);
+		}
+
+		// add the command line to the recording of the session, if it is being recorded
+		recordLine(userInput);
+
 		// parse user input and capture the return command struct pointer
 		command = parseUserInput(userInput);
 
+		// the body of a here-document follows the command line it was started on, in the order of the commands of
+		// a pipeline
+		readHereDocuments(command, NULL);
+
 		// if command is a NULL pointer then the user entered a blank line or a comment - ignore this
 		if (!command) {
 			// check for any completed background processes and clean them up
@@ -128,8 +226,14 @@ int main(void) {
 			continue;
 		}
 
-		// execute the command provided by the user
+		// rewrite wasteful forms of the command line into cheaper ones that behave the same
+		command = optimizeCommand(command);
+
+		// execute the command provided by the user, timing it for the prompt
+		clock_gettime(CLOCK_MONOTONIC, &commandStart);
 		executeCommand(command, backgroundPids, &lastStatus, foregroundFlag);
+		clock_gettime(CLOCK_MONOTONIC, &commandEnd);
+		setPromptStatus(lastStatus, (commandEnd.tv_sec - commandStart.tv_sec) * 1000000 + (commandEnd.tv_nsec - commandStart.tv_nsec) / 1000);
 
 		// clean-up all allocated memory before returning the user back to the command prompt
 		cleanupMemory(command);
@@ -0,0 +1,506 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: The memo built-in command. The key of a memoized command is made of the program it resolves to
+*	(with its size and modification time), its arguments, the working directory, the locale, time zone and
+*	PATH variables and its NAME=value prefixes, and a description of what it reads - the contents of a
+*	here-document or here-string, or the size and modification time of its input file and of any argument
+*	naming a file. Results are stored under a hash of the key in ~/.cache/smallsh/memo and the least recently
+*	used ones are evicted once they take up more than SMALLSH_MEMO_LIMIT MiB
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "commandExecution.h"
+#include "variables.h"
+#include "memo.h"
+
+/*
+* A struct representing the key of a command while it is being built
+*/
+struct memoKey {
+	char* data;  // the fields of the key, each ending in a null character
+	size_t length;  // the number of bytes in data
+	size_t capacity;  // the number of bytes data can hold
+};
+
+/*
+* A struct representing a cached result found while enforcing the limit of the cache
+*/
+struct memoEntry {
+	char* name;  // the file name of the cached result
+	off_t size;  // the number of bytes the cached result takes up
+	struct timespec used;  // the time the cached result was last used
+};
+
+/*
+* A struct representing how the cache has been used by this shell
+*/
+struct memoStatistics {
+	long hits;  // the number of commands replayed from the cache
+	long misses;  // the number of commands executed because they were not cached
+	long stored;  // the number of results added to the cache
+	long evicted;  // the number of results evicted from the cache
+};
+
+// how the cache has been used by this shell
+static struct memoStatistics statistics = { 0, 0, 0, 0 };
+
+/*
+* Appends a field to the key, formatted like printf, ending it with a null character
+*/
+static void appendKeyField(struct memoKey* key, char* format, ...) __attribute__((format(printf, 2, 3)));
+static void appendKeyField(struct memoKey* key, char* format, ...) {
+	va_list arguments;
+	int length;
+
+	va_start(arguments, format);
+	length = vsnprintf(NULL, 0, format, arguments);
+	va_end(arguments);
+
+	// grow the key if the field does not fit
+	while (key->length + length + 1 > key->capacity) {
+		key->capacity = key->capacity ? key->capacity * 2 : 1024;
+		key->data = (char*)realloc(key->data, key->capacity);
+	}
+
+	va_start(arguments, format);
+	vsnprintf(key->data + key->length, length + 1, format, arguments);
+	va_end(arguments);
+	key->length += length + 1;
+}
+
+/*
+* Returns the 64 bit FNV-1a hash of length bytes starting at data, continuing from hash
+*/
+static uint64_t hashBytes(uint64_t hash, char* data, size_t length) {
+	for (size_t index = 0; index < length; index++) {
+		hash = (hash ^ (unsigned char)data[index]) * 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/*
+* Appends a field describing the file at path to the key - its identity, size and modification time - if it
+* exists
+*/
+static void appendFileField(struct memoKey* key, char* label, char* path) {
+	struct stat info;
+
+	if (stat(path, &info) == 0 && S_ISREG(info.st_mode)) {
+		appendKeyField(key, "%s %s %lu %lu %lld %lld.%09ld", label, path, (unsigned long)info.st_dev, (unsigned long)info.st_ino,
+			(long long)info.st_size, (long long)info.st_mtim.tv_sec, info.st_mtim.tv_nsec);
+	}
+}
+
+/*
+* Returns the path of the cache directory, which must be freed by the caller, creating it if create is true.
+* Returns NULL if HOME is not set
+*/
+static char* memoDirectory(bool create) {
+	char* home = getVariable("HOME");
+	char* directory;
+
+	if (!home || !home[0]) {
+		return NULL;
+	}
+	directory = (char*)malloc(strlen(home) + strlen(MEMO_DIRECTORY) + 2);
+	sprintf(directory, "%s/%s", home, MEMO_DIRECTORY);
+
+	// create the cache directory one level at a time
+	if (create) {
+		for (char* slash = strchr(directory + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+			*slash = '\0';
+			mkdir(directory, 0700);
+			*slash = '/';
+		}
+		mkdir(directory, 0700);
+	}
+
+	return directory;
+}
+
+/*
+* Returns the number of bytes the cached results may take up
+*/
+static off_t memoLimit(void) {
+	char* value = getVariable(MEMO_LIMIT_VARIABLE);
+	long megabytes = value ? atol(value) : 0;
+
+	return (off_t)(megabytes > 0 ? megabytes : MEMO_DEFAULT_LIMIT_MB) * 1024 * 1024;
+}
+
+/*
+* Builds the key of command into key. Returns false if command cannot be cached
+*/
+static bool buildKey(struct command* command, struct memoKey* key) {
+	char* executable = findExecutable(command->pathName);
+	char* directory = getcwd(NULL, 0);
+	char** environment = getEnvironment();
+	struct stat info;
+
+	if (!executable || !directory || stat(executable, &info) == -1) {
+		free(executable);
+		free(directory);
+		return false;
+	}
+
+	// the program the command resolves to
+	appendFileField(key, "program", executable);
+	free(executable);
+
+	// the arguments and the directory they are relative to, along with any argument naming a file
+	for (int index = 0; command->argv[index]; index++) {
+		appendKeyField(key, "argument %s", command->argv[index]);
+	}
+	appendKeyField(key, "directory %s", directory);
+	free(directory);
+	for (int index = 1; command->argv[index]; index++) {
+		appendFileField(key, "file", command->argv[index]);
+	}
+
+	// the variables that commonly change what a program does
+	for (int index = 0; environment[index]; index++) {
+		if (strncmp(environment[index], "LANG=", 5) == 0 || strncmp(environment[index], "LC_", 3) == 0 ||
+			strncmp(environment[index], "TZ=", 3) == 0 || strncmp(environment[index], "PATH=", 5) == 0) {
+			appendKeyField(key, "variable %s", environment[index]);
+		}
+	}
+	for (int index = 0; command->assignments[index]; index++) {
+		appendKeyField(key, "assignment %s", command->assignments[index]);
+	}
+
+	// what the command reads - the contents of a here-document or here-string are hashed
+	if (command->inputFD != -1) {
+		char data[65536];
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		ssize_t length;
+		off_t offset = 0;
+
+		while ((length = pread(command->inputFD, data, sizeof(data), offset)) > 0) {
+			hash = hashBytes(hash, data, length);
+			offset += length;
+		}
+		appendKeyField(key, "input contents %016llx %lld", (unsigned long long)hash, (long long)offset);
+	}
+	else if (command->inputRedirect) {
+		if (stat(command->newInput, &info) == -1 || !S_ISREG(info.st_mode)) {
+			return false;
+		}
+		appendFileField(key, "input", command->newInput);
+	}
+	else {
+		appendKeyField(key, "input /dev/null");
+	}
+
+	return true;
+}
+
+/*
+* Copies length bytes of fromFD starting at offset to toFD
+*/
+static void copyOutput(int fromFD, off_t offset, uint64_t length, int toFD) {
+	char data[65536];
+
+	while (length > 0) {
+		ssize_t numRead = pread(fromFD, data, length < sizeof(data) ? length : sizeof(data), offset);
+		if (numRead <= 0) {
+			return;
+		}
+		for (ssize_t written = 0, result; written < numRead; written += result) {
+			result = write(toFD, data + written, numRead - written);
+			if (result == -1) {
+				return;
+			}
+		}
+		offset += numRead;
+		length -= numRead;
+	}
+}
+
+/*
+* Returns the file descriptor the output of command goes to, opening its output file if it is redirected, or
+* -1 after displaying an error message if it cannot be opened
+*/
+static int openOutput(struct command* command) {
+	int outputFD;
+
+	if (!command->outputRedirect) {
+		return STDOUT_FILENO;
+	}
+	outputFD = open(command->newOutput, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+	if (outputFD == -1) {
+		printf("Cannot open %s for output\n", command->newOutput);
+		fflush(stdout);
+	}
+	return outputFD;
+}
+
+/*
+* Compares two cached results by the time they were last used for qsort, least recently used first
+*/
+static int compareEntries(const void* first, const void* second) {
+	const struct memoEntry* firstEntry = (const struct memoEntry*)first;
+	const struct memoEntry* secondEntry = (const struct memoEntry*)second;
+
+	if (firstEntry->used.tv_sec != secondEntry->used.tv_sec) {
+		return firstEntry->used.tv_sec < secondEntry->used.tv_sec ? -1 : 1;
+	}
+	return (firstEntry->used.tv_nsec > secondEntry->used.tv_nsec) - (firstEntry->used.tv_nsec < secondEntry->used.tv_nsec);
+}
+
+/*
+* Reads every cached result in directory into entries, returning their number and storing their total size in
+* totalSize
+*/
+static int readEntries(char* directory, struct memoEntry** entries, off_t* totalSize) {
+	DIR* cacheDirectory = opendir(directory);
+	struct dirent* entry;
+	struct stat info;
+	int numEntries = 0;
+
+	*entries = NULL;
+	*totalSize = 0;
+	while (cacheDirectory && (entry = readdir(cacheDirectory))) {
+		size_t length = strlen(entry->d_name);
+		if (length < 6 || strcmp(entry->d_name + length - 5, ".memo") != 0 ||
+			fstatat(dirfd(cacheDirectory), entry->d_name, &info, 0) == -1) {
+			continue;
+		}
+
+		*entries = (struct memoEntry*)realloc(*entries, (numEntries + 1) * sizeof(struct memoEntry));
+		(*entries)[numEntries].name = strdup(entry->d_name);
+		(*entries)[numEntries].size = info.st_size;
+		(*entries)[numEntries].used = info.st_mtim;
+		*totalSize += info.st_size;
+		numEntries++;
+	}
+	if (cacheDirectory) {
+		closedir(cacheDirectory);
+	}
+
+	return numEntries;
+}
+
+/*
+* Evicts the least recently used cached results until the cache is within its limit
+*/
+static void evictEntries(char* directory) {
+	struct memoEntry* entries;
+	off_t totalSize;
+	off_t limit = memoLimit();
+	int numEntries = readEntries(directory, &entries, &totalSize);
+
+	qsort(entries, numEntries, sizeof(struct memoEntry), compareEntries);
+	for (int index = 0; index < numEntries; index++) {
+		if (totalSize > limit) {
+			char* path = (char*)malloc(strlen(directory) + strlen(entries[index].name) + 2);
+			sprintf(path, "%s/%s", directory, entries[index].name);
+			if (unlink(path) == 0) {
+				totalSize -= entries[index].size;
+				statistics.evicted++;
+			}
+			free(path);
+		}
+		free(entries[index].name);
+	}
+	free(entries);
+}
+
+/*
+* Displays the number and size of the cached results and how this shell has used the cache
+*/
+static void displayStatistics(void) {
+	char* directory = memoDirectory(false);
+	struct memoEntry* entries = NULL;
+	off_t totalSize = 0;
+	int numEntries = directory ? readEntries(directory, &entries, &totalSize) : 0;
+
+	for (int index = 0; index < numEntries; index++) {
+		free(entries[index].name);
+	}
+	free(entries);
+
+	printf("memo cache %s\n", directory ? directory : "unavailable, HOME is not set");
+	printf("entries    %d\n", numEntries);
+	printf("size       %lld of %lld bytes\n", (long long)totalSize, (long long)memoLimit());
+	printf("hits       %ld\n", statistics.hits);
+	printf("misses     %ld\n", statistics.misses);
+	printf("stored     %ld\n", statistics.stored);
+	printf("evicted    %ld\n", statistics.evicted);
+	fflush(stdout);
+	free(directory);
+}
+
+/*
+* Parses the arguments of the built-in "memo" command - memo command [args...] - stripping "memo" so that
+* the remaining command is executed with its result cached. "memo --stats" displays the state of the cache
+* instead, in which case false is returned as there is nothing left to execute
+*/
+bool applyMemo(struct command* command, int* lastStatus) {
+	if (command->argv[1] && strcmp(command->argv[1], "--stats") == 0) {
+		displayStatistics();
+		*lastStatus = 0;
+		return false;
+	}
+	if (!command->argv[1]) {
+		printf("usage: memo command [args...] | memo --stats\n");
+		fflush(stdout);
+		*lastStatus = 1 << 8;
+		return false;
+	}
+
+	removeLeadingArgs(command, 1);
+	command->memoize = true;
+	return true;
+}
+
+/*
+* Looks up the cached result of command. On a hit its output is written where the output of command goes, its
+* exit value is stored in lastStatus and true is returned. On a miss false is returned and run is set to a
+* new cached result that the output of command is directed into, or NULL if command cannot be cached
+*/
+bool replayMemo(struct command* command, int* lastStatus, struct memoRun** run) {
+	struct memoKey key = { NULL, 0, 0 };
+	struct memoHeader header;
+	char* directory;
+	char* path;
+	int entryFD;
+
+	*run = NULL;
+	if (!buildKey(command, &key) || !(directory = memoDirectory(true))) {
+		free(key.data);
+		return false;
+	}
+
+	// the cached result is named after the hash of the key
+	path = (char*)malloc(strlen(directory) + 24);
+	sprintf(path, "%s/%016llx.memo", directory, (unsigned long long)hashBytes(0xcbf29ce484222325ULL, key.data, key.length));
+	free(directory);
+
+	// a hit must hold exactly the same key
+	entryFD = open(path, O_RDONLY | O_CLOEXEC);
+	if (entryFD != -1) {
+		char* storedKey = (char*)malloc(key.length);
+		bool hit = pread(entryFD, &header, sizeof(header), 0) == sizeof(header) &&
+			memcmp(header.magic, MEMO_MAGIC, sizeof(header.magic)) == 0 && header.keyLength == key.length &&
+			pread(entryFD, storedKey, key.length, sizeof(header)) == (ssize_t)key.length &&
+			memcmp(storedKey, key.data, key.length) == 0;
+		free(storedKey);
+
+		if (hit) {
+			int outputFD = openOutput(command);
+			if (outputFD != -1) {
+				fflush(stdout);
+				copyOutput(entryFD, sizeof(header) + key.length, header.dataLength, outputFD);
+				*lastStatus = header.exitValue << 8;
+			}
+			else {
+				*lastStatus = 1 << 8;
+			}
+			if (outputFD > STDERR_FILENO) {
+				close(outputFD);
+			}
+
+			// mark the result as recently used
+			futimens(entryFD, NULL);
+			close(entryFD);
+			statistics.hits++;
+			free(key.data);
+			free(path);
+			return true;
+		}
+		close(entryFD);
+	}
+	statistics.misses++;
+
+	// the output is written after the space left for the header and key of the new cached result
+	*run = (struct memoRun*)calloc(1, sizeof(struct memoRun));
+	(*run)->key = key.data;
+	(*run)->keyLength = key.length;
+	(*run)->path = path;
+	(*run)->temporaryPath = (char*)malloc(strlen(path) + 8);
+	sprintf((*run)->temporaryPath, "%s.XXXXXX", path);
+	(*run)->fd = mkostemp((*run)->temporaryPath, O_CLOEXEC);
+	if ((*run)->fd == -1 || lseek((*run)->fd, sizeof(header) + key.length, SEEK_SET) == -1) {
+		if ((*run)->fd != -1) {
+			close((*run)->fd);
+			unlink((*run)->temporaryPath);
+		}
+		free((*run)->key);
+		free((*run)->path);
+		free((*run)->temporaryPath);
+		free(*run);
+		*run = NULL;
+		return false;
+	}
+
+	// the command writes into the new cached result, and reads "/dev/null" unless its input is redirected
+	command->outputFD = (*run)->fd;
+	if (!command->inputRedirect) {
+		command->inputRedirect = true;
+		command->newInput = strdup("/dev/null");
+	}
+	return false;
+}
+
+/*
+* Completes the cached result of a command that has terminated with childStatus, writing its output where the
+* output of command goes. Only a command that exited is cached. Old results are evicted once the cache is
+* over its limit. Releases run
+*/
+void finishMemo(struct memoRun* run, struct command* command, int childStatus) {
+	struct memoHeader header;
+	struct stat info;
+	int outputFD;
+
+	command->outputFD = -1;
+	fstat(run->fd, &info);
+	memcpy(header.magic, MEMO_MAGIC, sizeof(header.magic));
+	header.exitValue = WIFEXITED(childStatus) ? WEXITSTATUS(childStatus) : 0;
+	header.keyLength = run->keyLength;
+	header.dataLength = info.st_size > (off_t)(sizeof(header) + run->keyLength) ? info.st_size - sizeof(header) - run->keyLength : 0;
+
+	// the output goes where the command would have written it
+	outputFD = openOutput(command);
+	if (outputFD != -1) {
+		fflush(stdout);
+		copyOutput(run->fd, sizeof(header) + run->keyLength, header.dataLength, outputFD);
+		if (outputFD > STDERR_FILENO) {
+			close(outputFD);
+		}
+	}
+
+	// a command that exited is cached by renaming the completed result into place
+	if (WIFEXITED(childStatus) && pwrite(run->fd, &header, sizeof(header), 0) == sizeof(header) &&
+		pwrite(run->fd, run->key, run->keyLength, sizeof(header)) == (ssize_t)run->keyLength &&
+		rename(run->temporaryPath, run->path) == 0) {
+		char* directory = memoDirectory(false);
+		statistics.stored++;
+		evictEntries(directory);
+		free(directory);
+	}
+	else {
+		unlink(run->temporaryPath);
+	}
+
+	close(run->fd);
+	free(run->key);
+	free(run->path);
+	free(run->temporaryPath);
+	free(run);
+}
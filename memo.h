@@ -0,0 +1,61 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the memo built-in command, which caches the output and exit value of commands
+*	in a content addressed store and replays them when the same command is run again over unchanged inputs
+*/
+
+// the directory within the home directory holding the cached results
+#define MEMO_DIRECTORY ".cache/smallsh/memo"
+
+// the identifier at the start of every cached result, which changes whenever its layout does
+#define MEMO_MAGIC "SMSHMEM1"
+
+// the variable holding the number of MiB the cached results may take up, and its default
+#define MEMO_LIMIT_VARIABLE "SMALLSH_MEMO_LIMIT"
+#define MEMO_DEFAULT_LIMIT_MB 256
+
+/*
+* A struct representing the start of a cached result, which is followed by keyLength bytes of key - used to
+* tell apart commands whose keys hash alike - and then dataLength bytes of output
+*/
+struct memoHeader {
+	char magic[8];  // MEMO_MAGIC, without a null character
+	int32_t exitValue;  // the exit value of the command
+	uint32_t keyLength;  // the number of bytes of key following the header
+	uint64_t dataLength;  // the number of bytes of output following the key
+};
+
+/*
+* A struct representing a command whose result is being cached while it runs - its output goes into a new
+* cached result after the space left for the header and key
+*/
+struct memoRun {
+	char* key;  // the key of the command
+	size_t keyLength;  // the number of bytes in key
+	char* path;  // the path the cached result is stored at
+	char* temporaryPath;  // the path of the cached result while it is being written
+	int fd;  // the cached result being written
+};
+
+/*
+* Parses the arguments of the built-in "memo" command - memo command [args...] - stripping "memo" so that
+* the remaining command is executed with its result cached. "memo --stats" displays the state of the cache
+* instead, in which case false is returned as there is nothing left to execute
+*/
+bool applyMemo(struct command* command, int* lastStatus);
+
+/*
+* Looks up the cached result of command. On a hit its output is written where the output of command goes, its
+* exit value is stored in lastStatus and true is returned. On a miss false is returned and run is set to a
+* new cached result that the output of command is directed into, or NULL if command cannot be cached
+*/
+bool replayMemo(struct command* command, int* lastStatus, struct memoRun** run);
+
+/*
+* Completes the cached result of a command that has terminated with childStatus, writing its output where the
+* output of command goes. Only a command that exited is cached. Old results are evicted once the cache is
+* over its limit. Releases run
+*/
+void finishMemo(struct memoRun* run, struct command* command, int childStatus);
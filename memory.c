@@ -8,9 +8,23 @@
 #include <stdbool.h>
 #include <signal.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
 #include <sys/wait.h>
 #include "dynamicArray.h"
 #include "parser.h"
+#include "variables.h"
+#include "zygote.h"
+#include "events.h"
+#include "jobs.h"
+#include "prompt.h"
+#include "completion.h"
+#include "functions.h"
+#include "record.h"
+#include "substitution.h"
+#include "joblog.h"
+#include "metrics.h"
+#include "lineReader.h"
 
 /*
 * Releases all memory allocated for the command struct and for use with the attributes of
@@ -19,6 +33,11 @@
 void cleanupMemory(struct command* command) {
 	int index = 0;
 
+	// release the rest of the pipeline first
+	if (command->pipeNext) {
+		cleanupMemory(command->pipeNext);
+	}
+
 	// iterate over each character pointer in the argv array and release the memory allocated
 	// for each one
 	while (command->argv[index]) {
@@ -27,12 +46,37 @@ void cleanupMemory(struct command* command) {
 	}
 	// release the memory allocated for the argv array itself
 	free(command->argv);
+	// release the generators of any items produced as the batches of a chunked command are filled
+	freeBraceItems(command);
+
+	// iterate over each prefix assignment and release the memory allocated for each one
+	for (index = 0; command->assignments[index]; index++) {
+		free(command->assignments[index]);
+	}
+	// release the memory allocated for the assignments array itself
+	free(command->assignments);
 
 	// check if newInput is not NULL
 	if (command->newInput) {
 		// release the memory allocated for newInput
 		free(command->newInput);
 	}
+	// close the memory file holding the body of a here-document or here-string and release its delimiter
+	if (command->inputFD != -1) {
+		close(command->inputFD);
+	}
+	free(command->hereDelimiter);
+	// close the pipes and release the memory of any process substitutions
+	freeSubstitutions(command);
+	// release the placement of the command
+	free(command->placement);
+
+	// iterate over each additional output target and release the memory allocated for each one
+	for (index = 0; command->teeOutputs[index]; index++) {
+		free(command->teeOutputs[index]);
+	}
+	// release the memory allocated for the teeOutputs array itself
+	free(command->teeOutputs);
 
 	// check if newOutput is not NULL
 	if (command->newOutput) {
@@ -55,8 +99,10 @@ void cleanupMemoryAndExit(struct command* command, struct dynamicArray* backgrou
 	// declare a variable used to store the status of a process
 	int backgroundPidStatus;
 
-	// release memory allocated for the command struct and its members
-	cleanupMemory(command);
+	// release memory allocated for the command struct and its members, if there is one
+	if (command) {
+		cleanupMemory(command);
+	}
 
 	// iterate over each element in the backgroundPids array
 	for (int index = 0; index < backgroundPids->size; index++) {
@@ -71,4 +117,23 @@ void cleanupMemoryAndExit(struct command* command, struct dynamicArray* backgrou
 	free(backgroundPids->staticArray);
 	// free memory allocated for the dynamic array struct
 	free(backgroundPids);
+
+	// release memory allocated for the variable store, the job table, the job logs, the prompt, completion, the
+	// aliases and shell functions and the lookahead buffers of read
+	cleanupVariables();
+	cleanupJobs();
+	cleanupJobLogs();
+	cleanupPrompt();
+	cleanupCompletion();
+	cleanupFunctions();
+	cleanupLineReader();
+
+	// close the recording of the session
+	stopRecording();
+
+	// stop the zygote if it is running
+	stopZygote();
+
+	// remove the metrics page
+	stopMetrics();
 }
@@ -0,0 +1,256 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: The live metrics page, a small memory file in /dev/shm holding counters the shell updates as it
+*	runs. Updates are plain stores guarded by a seqlock, so neither the shell nor a monitor reading the page
+*	makes a system call for it
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "metrics.h"
+
+/*
+* A struct representing the state of the metrics page of the shell
+*/
+static struct {
+	struct metricsPage* page;  // the mapped metrics page, or NULL if it is not published
+	bool child;  // true in a forked child of the shell, which must leave the counters to the shell
+	char path[64];  // the path of the metrics page
+} metrics = { NULL, false, "" };
+
+/*
+* Marks the process as a forked child of the shell - runs in the child after every fork
+*/
+static void metricsForked(void) {
+	metrics.child = true;
+}
+
+/*
+* Creates the metrics page of the shell at METRICS_PATH_PREFIX followed by its pid and maps it, unless
+* SMALLSH_METRICS is 0. Without a page, e.g. if /dev/shm is not available, every update does nothing
+*/
+void startMetrics(void) {
+	// declare a variable used to store the time the shell started
+	struct timespec now;
+	// declare and initialize a variable used to store whether the page is turned off
+	char* setting = getenv(METRICS_VARIABLE);
+
+	if (metrics.page || (setting && strcmp(setting, "0") == 0)) {
+		return;
+	}
+
+	// the page only has to outlive the descriptor as a mapping. A stale page left behind by an earlier shell with
+	// the same pid is removed, and the page is only ever created afresh, so that a file or symlink another user
+	// placed at the path is never written through
+	snprintf(metrics.path, sizeof(metrics.path), METRICS_PATH_PREFIX "%d", getpid());
+	unlink(metrics.path);
+	int pageFD = open(metrics.path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+	if (pageFD == -1) {
+		return;
+	}
+	if (ftruncate(pageFD, sizeof(struct metricsPage)) == -1) {
+		close(pageFD);
+		unlink(metrics.path);
+		return;
+	}
+	struct metricsPage* page = mmap(NULL, sizeof(struct metricsPage), PROT_READ | PROT_WRITE, MAP_SHARED, pageFD, 0);
+	close(pageFD);
+	if (page == MAP_FAILED) {
+		unlink(metrics.path);
+		return;
+	}
+
+	// the new file is already zeroed, so only the identification is filled in - the magic goes last so that a
+	// reader never sees a page that is not filled in yet
+	clock_gettime(CLOCK_REALTIME, &now);
+	page->pageSize = sizeof(struct metricsPage);
+	page->pid = getpid();
+	page->startTime = now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(page->magic, METRICS_MAGIC, sizeof(page->magic));
+
+	metrics.page = page;
+	pthread_atfork(NULL, NULL, metricsForked);
+}
+
+/*
+* Starts an update of the metrics page, returning false if the shell does not publish one
+*/
+static bool beginUpdate(void) {
+	if (!metrics.page || metrics.child) {
+		return false;
+	}
+
+	// an odd sequence tells readers the counters are changing
+	__atomic_store_n(&metrics.page->sequence, metrics.page->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return true;
+}
+
+/*
+* Ends an update of the metrics page, publishing the updated counters to readers
+*/
+static void endUpdate(void) {
+	__atomic_store_n(&metrics.page->sequence, metrics.page->sequence + 1, __ATOMIC_RELEASE);
+}
+
+/*
+* Adds amount to a counter of the metrics page during an update
+*/
+static void addCounter(uint64_t* counter, uint64_t amount) {
+	__atomic_store_n(counter, *counter + amount, __ATOMIC_RELAXED);
+}
+
+/*
+* Returns the histogram bucket counting a latency of nanoseconds
+*/
+static int latencyBucket(uint64_t nanoseconds) {
+	// declare and initialize the bucket from the number of bits needed to hold the latency
+	int bucket = nanoseconds ? 64 - __builtin_clzll(nanoseconds) : 0;
+
+	return bucket < METRICS_BUCKETS ? bucket : METRICS_BUCKETS - 1;
+}
+
+/*
+* Returns the current time of the monotonic clock in nanoseconds, used to time what the histograms measure
+*/
+uint64_t metricsClock(void) {
+	struct timespec now;
+
+	// without a page there is nothing to time
+	if (!metrics.page) {
+		return 0;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/*
+* Counts a command being executed
+*/
+void countCommand(void) {
+	if (beginUpdate()) {
+		addCounter(&metrics.page->commands, 1);
+		endUpdate();
+	}
+}
+
+/*
+* Counts a command line parsed in the nanoseconds since start, as returned by metricsClock
+*/
+void countParse(uint64_t start) {
+	if (beginUpdate()) {
+		uint64_t elapsed = metricsClock() - start;
+		addCounter(&metrics.page->parseCount, 1);
+		addCounter(&metrics.page->parseTime, elapsed);
+		addCounter(&metrics.page->parseHistogram[latencyBucket(elapsed)], 1);
+		endUpdate();
+	}
+}
+
+/*
+* Counts a process spawned in the nanoseconds since start, as returned by metricsClock
+*/
+void countSpawn(uint64_t start) {
+	if (beginUpdate()) {
+		uint64_t elapsed = metricsClock() - start;
+		addCounter(&metrics.page->forks, 1);
+		addCounter(&metrics.page->spawnCount, 1);
+		addCounter(&metrics.page->spawnTime, elapsed);
+		addCounter(&metrics.page->spawnHistogram[latencyBucket(elapsed)], 1);
+		endUpdate();
+	}
+}
+
+/*
+* Counts rewrites made by the optimizer and the forks they avoided
+*/
+void countRewrites(int rewrites, int forksAvoided) {
+	if (beginUpdate()) {
+		addCounter(&metrics.page->rewrites, rewrites);
+		addCounter(&metrics.page->forksAvoided, forksAvoided);
+		endUpdate();
+	}
+}
+
+/*
+* Counts a program that could not be executed. Called in the forked child, which shares the page with the shell
+*/
+void countExecFailure(void) {
+	// the shell never writes this counter, so the child adds to it atomically without the seqlock
+	if (metrics.page) {
+		__atomic_fetch_add(&metrics.page->execFailures, 1, __ATOMIC_RELAXED);
+	}
+}
+
+/*
+* Updates the number of background jobs running and waiting, and the CPU time of the reaped child processes
+*/
+void updateJobMetrics(int running, int queued) {
+	// declare a variable used to store the CPU time of the reaped child processes
+	struct rusage usage;
+
+	if (!metrics.page || metrics.child || getrusage(RUSAGE_CHILDREN, &usage) == -1) {
+		return;
+	}
+
+	beginUpdate();
+	__atomic_store_n(&metrics.page->runningJobs, running, __ATOMIC_RELAXED);
+	__atomic_store_n(&metrics.page->queuedJobs, queued, __ATOMIC_RELAXED);
+	__atomic_store_n(&metrics.page->childUserTime, usage.ru_utime.tv_sec * 1000000ULL + usage.ru_utime.tv_usec, __ATOMIC_RELAXED);
+	__atomic_store_n(&metrics.page->childSystemTime, usage.ru_stime.tv_sec * 1000000ULL + usage.ru_stime.tv_usec, __ATOMIC_RELAXED);
+	endUpdate();
+}
+
+/*
+* Copies the metrics page at page into copy, retrying while the shell is updating it. Returns false if page
+* is not a metrics page of this layout
+*/
+bool readMetrics(struct metricsPage* page, struct metricsPage* copy) {
+	// declare variables used to store the sequence before and after copying
+	uint64_t before, after;
+
+	if (memcmp(page->magic, METRICS_MAGIC, sizeof(page->magic)) != 0 || page->pageSize != sizeof(struct metricsPage)) {
+		return false;
+	}
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	do {
+		before = __atomic_load_n(&page->sequence, __ATOMIC_ACQUIRE);
+		// copy the page a word at a time - its size is a multiple of 8 bytes
+		for (size_t index = 0; index < sizeof(struct metricsPage) / sizeof(uint64_t); index++) {
+			((uint64_t*)copy)[index] = __atomic_load_n((uint64_t*)page + index, __ATOMIC_RELAXED);
+		}
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		after = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
+	} while ((before & 1) || before != after);
+
+	return true;
+}
+
+/*
+* Unmaps the metrics page and removes it, unless called in a forked child of the shell
+*/
+void stopMetrics(void) {
+	if (!metrics.page) {
+		return;
+	}
+
+	munmap(metrics.page, sizeof(struct metricsPage));
+	metrics.page = NULL;
+	if (!metrics.child) {
+		unlink(metrics.path);
+	}
+}
@@ -0,0 +1,100 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the live metrics page, a small memory file in /dev/shm holding counters the
+*	shell updates as it runs, which a monitor outside the shell can map and read without the shell's help
+*/
+
+// the start of the path of the metrics page of each shell, which is followed by its pid
+#define METRICS_PATH_PREFIX "/dev/shm/smallsh."
+
+// the identifier at the start of every metrics page, which changes whenever its layout does
+#define METRICS_MAGIC "SMSHMET2"
+
+// the variable that stops the metrics page from being published when set to 0
+#define METRICS_VARIABLE "SMALLSH_METRICS"
+
+// the number of buckets of each latency histogram - bucket 0 counts latencies below 1 ns and bucket N those of
+// 2^(N-1) ns up to 2^N ns, except the last bucket, which also counts everything longer
+#define METRICS_BUCKETS 32
+
+/*
+* A struct representing the metrics page. The shell is its only writer and follows a seqlock: sequence is odd
+* while the counters are being updated, so a reader copies the page and keeps the copy only if sequence was
+* even and unchanged before and after copying it
+*/
+struct metricsPage {
+	char magic[8];  // METRICS_MAGIC, without a null character
+	uint32_t pageSize;  // the size of this struct, so that a reader can tell the layout apart
+	uint32_t pid;  // the pid of the shell
+	uint64_t sequence;  // the seqlock sequence number
+	uint64_t startTime;  // the time the shell started, in microseconds since the epoch
+	uint64_t commands;  // the number of commands executed, built-in commands included
+	uint64_t forks;  // the number of processes forked or spawned by the zygote
+	uint64_t execFailures;  // the number of programs that could not be executed
+	uint64_t runningJobs;  // the number of background jobs or daemon requests running
+	uint64_t queuedJobs;  // the number of daemon requests waiting for a worker
+	uint64_t childUserTime;  // the user CPU time of the reaped child processes, in microseconds
+	uint64_t childSystemTime;  // the system CPU time of the reaped child processes, in microseconds
+	uint64_t parseCount;  // the number of command lines parsed
+	uint64_t parseTime;  // the total time spent parsing them, in nanoseconds
+	uint64_t parseHistogram[METRICS_BUCKETS];  // the number of command lines parsed within each latency bucket
+	uint64_t spawnCount;  // the number of processes spawned
+	uint64_t spawnTime;  // the total time the shell spent spawning them, in nanoseconds
+	uint64_t spawnHistogram[METRICS_BUCKETS];  // the number of processes spawned within each latency bucket
+	uint64_t rewrites;  // the number of rewrites made by the optimizer
+	uint64_t forksAvoided;  // the number of processes the rewrites saved spawning
+};
+
+/*
+* Creates the metrics page of the shell at METRICS_PATH_PREFIX followed by its pid and maps it, unless
+* SMALLSH_METRICS is 0. Without a page, e.g. if /dev/shm is not available, every update does nothing
+*/
+void startMetrics(void);
+
+/*
+* Returns the current time of the monotonic clock in nanoseconds, used to time what the histograms measure
+*/
+uint64_t metricsClock(void);
+
+/*
+* Counts a command being executed
+*/
+void countCommand(void);
+
+/*
+* Counts a command line parsed in the nanoseconds since start, as returned by metricsClock
+*/
+void countParse(uint64_t start);
+
+/*
+* Counts a process spawned in the nanoseconds since start, as returned by metricsClock
+*/
+void countSpawn(uint64_t start);
+
+/*
+* Counts rewrites made by the optimizer and the forks they avoided
+*/
+void countRewrites(int rewrites, int forksAvoided);
+
+/*
+* Counts a program that could not be executed. Called in the forked child, which shares the page with the shell
+*/
+void countExecFailure(void);
+
+/*
+* Updates the number of background jobs running and waiting, and the CPU time of the reaped child processes
+*/
+void updateJobMetrics(int running, int queued);
+
+/*
+* Copies the metrics page at page into copy, retrying while the shell is updating it. Returns false if page
+* is not a metrics page of this layout
+*/
+bool readMetrics(struct metricsPage* page, struct metricsPage* copy);
+
+/*
+* Unmaps the metrics page and removes it, unless called in a forked child of the shell
+*/
+void stopMetrics(void);
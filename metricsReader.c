@@ -0,0 +1,169 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Reader for the live metrics pages smallsh publishes in /dev/shm, displaying the counters and
+*	latency histograms of one or every running shell
+*
+* Usage: ./metricsReader [-w SECONDS] [PID...]
+*	Each PID names the shell whose page is displayed, by default every page found. -w displays the pages again
+*	every SECONDS until interrupted. The page is mapped and read with the seqlock, so the shell does nothing
+*	to be read
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include "metrics.h"
+
+/*
+* Displays a latency histogram of the metrics page, one line per bucket holding any latencies
+*/
+static void displayHistogram(char* name, uint64_t* histogram, uint64_t count, uint64_t total) {
+	printf("  %s latency: %llu samples", name, (unsigned long long)count);
+	if (count == 0) {
+		printf("\n");
+		return;
+	}
+	printf(", mean %.1f us\n", total / 1e3 / count);
+
+	for (int bucket = 0; bucket < METRICS_BUCKETS; bucket++) {
+		if (histogram[bucket] == 0) {
+			continue;
+		}
+
+		// bucket N holds the latencies from 2^(N-1) ns up to 2^N ns
+		double low = bucket ? (double)(1ULL << (bucket - 1)) : 0, high = (double)(1ULL << bucket);
+		int width = (int)(40.0 * histogram[bucket] / count + 0.5);
+		if (bucket == METRICS_BUCKETS - 1) {
+			printf("    %10.1f us and up     %10llu ", low / 1e3, (unsigned long long)histogram[bucket]);
+		}
+		else {
+			printf("    %10.1f - %-10.1f us %10llu ", low / 1e3, high / 1e3, (unsigned long long)histogram[bucket]);
+		}
+		for (int index = 0; index < width; index++) {
+			putchar('#');
+		}
+		putchar('\n');
+	}
+}
+
+/*
+* Maps and displays the metrics page at path. Returns false if it is not a metrics page
+*/
+static bool displayPage(char* path) {
+	struct metricsPage copy;
+	struct timespec now;
+
+	int pageFD = open(path, O_RDONLY | O_CLOEXEC);
+	if (pageFD == -1) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return false;
+	}
+	struct metricsPage* page = mmap(NULL, sizeof(struct metricsPage), PROT_READ, MAP_SHARED, pageFD, 0);
+	close(pageFD);
+	if (page == MAP_FAILED) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	// a page that was truncated or belongs to another layout is not read
+	if (!readMetrics(page, &copy)) {
+		fprintf(stderr, "%s: not a metrics page of this version\n", path);
+		munmap(page, sizeof(struct metricsPage));
+		return false;
+	}
+	munmap(page, sizeof(struct metricsPage));
+
+	// a shell killed before it could remove its page leaves the page behind
+	clock_gettime(CLOCK_REALTIME, &now);
+	bool running = kill(copy.pid, 0) == 0 || errno == EPERM;
+	double uptime = (now.tv_sec * 1e6 + now.tv_nsec / 1e3 - copy.startTime) / 1e6;
+
+	printf("smallsh %u%s, up %.0f s\n", copy.pid, running ? "" : " (not running)", uptime);
+	printf("  commands %llu, forks %llu, exec failures %llu\n", (unsigned long long)copy.commands,
+		(unsigned long long)copy.forks, (unsigned long long)copy.execFailures);
+	printf("  background jobs %llu running, %llu queued\n", (unsigned long long)copy.runningJobs, (unsigned long long)copy.queuedJobs);
+	printf("  child CPU %.3f s user, %.3f s system\n", copy.childUserTime / 1e6, copy.childSystemTime / 1e6);
+	printf("  optimizer %llu rewrites, %llu forks avoided\n", (unsigned long long)copy.rewrites, (unsigned long long)copy.forksAvoided);
+	displayHistogram("parse", copy.parseHistogram, copy.parseCount, copy.parseTime);
+	displayHistogram("spawn", copy.spawnHistogram, copy.spawnCount, copy.spawnTime);
+
+	return true;
+}
+
+/*
+* Displays the metrics page of every shell in pids, or of every shell that published one if there are none.
+* Returns the number of pages displayed
+*/
+static int displayPages(char** pids, int numPids) {
+	char path[300];
+	int displayed = 0;
+
+	for (int index = 0; index < numPids; index++) {
+		snprintf(path, sizeof(path), METRICS_PATH_PREFIX "%s", pids[index]);
+		displayed += displayPage(path);
+	}
+	if (numPids > 0) {
+		return displayed;
+	}
+
+	// look through /dev/shm for the pages
+	char* prefix = strrchr(METRICS_PATH_PREFIX, '/') + 1;
+	DIR* directory = opendir("/dev/shm");
+	struct dirent* entry;
+	while (directory && (entry = readdir(directory))) {
+		if (strncmp(entry->d_name, prefix, strlen(prefix)) == 0) {
+			snprintf(path, sizeof(path), "/dev/shm/%s", entry->d_name);
+			displayed += displayPage(path);
+		}
+	}
+	if (directory) {
+		closedir(directory);
+	}
+
+	return displayed;
+}
+
+/*
+* Driver code for the metrics reader
+*/
+int main(int argc, char* argv[]) {
+	int option;
+	double interval = 0;
+
+	// process the command line options
+	while ((option = getopt(argc, argv, "w:")) != -1) {
+		switch (option) {
+			case 'w': interval = atof(optarg); break;
+			default: interval = -1; break;
+		}
+	}
+	if (interval < 0) {
+		fprintf(stderr, "usage: %s [-w SECONDS] [PID...]\n", argv[0]);
+		return 1;
+	}
+
+	int displayed = displayPages(argv + optind, argc - optind);
+	while (interval > 0) {
+		fflush(stdout);
+		usleep((useconds_t)(interval * 1e6));
+		printf("\n");
+		displayPages(argv + optind, argc - optind);
+	}
+
+	if (displayed == 0) {
+		fprintf(stderr, "no metrics pages found\n");
+		return 1;
+	}
+	return 0;
+}
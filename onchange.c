@@ -0,0 +1,408 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: The onchange built-in command. Every directory under the paths watched has an inotify watch, and
+*	the inotify file descriptor, a timerfd ending each burst of changes, a signalfd receiving SIGINT and a pidfd
+*	of the run in progress are all handlers of the event loop - the shell sleeps in epoll_wait until one of them
+*	is ready, using no CPU while nothing changes
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "commandExecution.h"
+#include "events.h"
+#include "zygote.h"
+#include "metrics.h"
+#include "onchange.h"
+
+/*
+* A struct representing a path with an inotify watch
+*/
+struct watchedPath {
+	char* path;  // the path watched, NULL if the watch descriptor is unused
+	bool root;  // true if the path was given to onchange rather than found under one that was
+};
+
+/*
+* A struct representing the state of an onchange command while it watches its paths
+*/
+struct watchState {
+	struct command* command;  // the command run after each burst of changes
+	struct dynamicArray* backgroundPids;  // the background processes of the shell
+	int foregroundFlag;  // the foreground-only mode of the shell
+	long debounceMs;  // the number of milliseconds without a change that ends a burst
+	bool queue;  // true if a change during a run queues another run rather than cancelling the run
+	struct watchedPath* paths;  // the paths watched, indexed by watch descriptor
+	int numPaths;  // the number of elements in the paths array
+	struct eventHandler changeHandler;  // the handler of the inotify file descriptor
+	struct eventHandler settleHandler;  // the handler of the timerfd ending a burst of changes
+	struct eventHandler signalHandler;  // the handler of the signalfd receiving SIGINT
+	struct eventHandler runHandler;  // the handler of the pidfd of the run in progress
+	pid_t runner;  // the process of the run in progress, -1 if there is none
+	bool rerun;  // true if another run starts once the run in progress terminates
+	bool interrupted;  // true once SIGINT has been received
+	int lastStatus;  // the wait status of the last run
+	sigset_t savedMask;  // the signal mask of the shell before SIGINT was blocked
+};
+
+/*
+* Adds an inotify watch for path and, if it is a directory, for every directory under it. root is true if path
+* was given to onchange. Returns false after displaying an error message if a watch could not be added
+*/
+static bool addWatches(struct watchState* state, char* path, bool root) {
+	// symbolic links are only followed when they were given to onchange
+	int watch = inotify_add_watch(state->changeHandler.fd, path, ONCHANGE_EVENTS | IN_EXCL_UNLINK | (root ? 0 : IN_DONT_FOLLOW));
+
+	if (watch == -1) {
+		printf("onchange: %s: %s\n", path, strerror(errno));
+		fflush(stdout);
+		return false;
+	}
+
+	// watch descriptors are small integers, so the path of each is kept at its index
+	if (watch >= state->numPaths) {
+		int numPaths = watch * 2 + 16;
+		state->paths = (struct watchedPath*)realloc(state->paths, numPaths * sizeof(struct watchedPath));
+		memset(state->paths + state->numPaths, 0, (numPaths - state->numPaths) * sizeof(struct watchedPath));
+		state->numPaths = numPaths;
+	}
+	// a path reached twice, e.g. given twice, shares the watch of the first
+	if (!state->paths[watch].path) {
+		state->paths[watch].path = strdup(path);
+	}
+	state->paths[watch].root = state->paths[watch].root || root;
+
+	// a file has nothing under it to watch
+	DIR* directory = opendir(path);
+	if (!directory) {
+		return true;
+	}
+
+	bool watched = true;
+	struct dirent* entry;
+	while (watched && (entry = readdir(directory))) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+			continue;
+		}
+
+		char* child = (char*)malloc(strlen(path) + strlen(entry->d_name) + 2);
+		sprintf(child, "%s/%s", path, entry->d_name);
+
+		// the type is only looked up when the file system does not report it
+		struct stat childStat;
+		if (entry->d_type == DT_DIR || (entry->d_type == DT_UNKNOWN && lstat(child, &childStat) == 0 && S_ISDIR(childStat.st_mode))) {
+			watched = addWatches(state, child, false);
+		}
+		free(child);
+	}
+
+	closedir(directory);
+	return watched;
+}
+
+/*
+* Forgets the watch descriptor watch, whose file or directory has been removed. A path given to onchange that was
+* replaced, as an editor saving by renaming does, is watched again
+*/
+static void forgetWatch(struct watchState* state, int watch) {
+	if (watch < 0 || watch >= state->numPaths || !state->paths[watch].path) {
+		return;
+	}
+
+	char* path = state->paths[watch].path;
+	bool root = state->paths[watch].root;
+	state->paths[watch].path = NULL;
+	state->paths[watch].root = false;
+
+	if (root && access(path, F_OK) == 0) {
+		addWatches(state, path, true);
+	}
+	free(path);
+}
+
+/*
+* Starts a run of the command in a child of the shell, which executes it like any other command. A run already in
+* progress is cancelled first, or with -q left to finish, and the new run starts once it terminates
+*/
+static void startRun(struct watchState* state) {
+	if (state->runner != -1) {
+		state->rerun = true;
+		if (!state->queue) {
+			kill(-state->runner, SIGTERM);
+		}
+		return;
+	}
+
+	// every run counts as a command and a spawn on the metrics page - the child running it is a forked child of
+	// the shell, which leaves the counters to the shell
+	countCommand();
+
+	// For the following code structure, reference citation F
+	fflush(stdout);
+	uint64_t spawnStart = metricsClock();
+	pid_t spawnPid = fork();
+	if (spawnPid == -1) {
+		perror("fork failed");
+		return;
+	}
+	else if (spawnPid == 0) {
+		// the run gets a process group of its own, so that cancelling it stops everything it started, and the
+		// signal mask, zygote and event loop of the shell are left behind
+		setpgid(0, 0);
+		sigprocmask(SIG_SETMASK, &state->savedMask, NULL);
+		detachZygote();
+		resetEventLoop();
+
+		int runStatus = 0;
+		executeCommand(state->command, state->backgroundPids, &runStatus, state->foregroundFlag);
+		// _exit leaves the offset of a shared standard input alone, which exit would rewind to what stdio has read
+		fflush(stdout);
+		_exit(WIFSIGNALED(runStatus) ? 128 + WTERMSIG(runStatus) : WEXITSTATUS(runStatus));
+	}
+
+	// set the process group here as well, so that it exists before the run can be cancelled
+	countSpawn(spawnStart);
+	setpgid(spawnPid, spawnPid);
+	state->runner = spawnPid;
+
+	// the event loop notices the run terminating through its pidfd - without one the run cannot be cancelled
+	state->runHandler.fd = syscall(SYS_pidfd_open, spawnPid, 0);
+	if (state->runHandler.fd == -1) {
+		state->lastStatus = waitForForegroundProcess(spawnPid);
+		state->runner = -1;
+		return;
+	}
+	registerEventHandler(&state->runHandler, EPOLLIN);
+}
+
+/*
+* Invoked by the event loop when the run in progress terminates. Reaps it and starts the run that was waiting for
+* it, if any
+*/
+static void runFinished(struct eventHandler* handler, unsigned int events) {
+	struct watchState* state = (struct watchState*)handler->data;
+
+	waitpid(state->runner, &state->lastStatus, 0);
+	unregisterEventHandler(handler);
+	close(handler->fd);
+	state->runner = -1;
+
+	if (state->rerun && !state->interrupted) {
+		state->rerun = false;
+		startRun(state);
+	}
+}
+
+/*
+* Invoked by the event loop when the timerfd expires, a burst of changes having ended. Starts a run
+*/
+static void changesSettled(struct eventHandler* handler, unsigned int events) {
+	struct watchState* state = (struct watchState*)handler->data;
+	uint64_t expirations;
+
+	if (read(handler->fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+		startRun(state);
+	}
+}
+
+/*
+* Invoked by the event loop when the inotify file descriptor is readable. Watches any directory created under the
+* paths watched and restarts the timerfd, so that a run only starts once the changes stop for the debounce time
+*/
+static void filesChanged(struct eventHandler* handler, unsigned int events) {
+	struct watchState* state = (struct watchState*)handler->data;
+	// declare a buffer large enough for many events, aligned as inotify writes them
+	char buffer[65536] __attribute__((aligned(__alignof__(struct inotify_event))));
+	// declare and initialize a variable used to store whether any event was a change
+	bool changed = false;
+	ssize_t length;
+
+	while ((length = read(handler->fd, buffer, sizeof(buffer))) > 0) {
+		for (char* position = buffer; position < buffer + length;) {
+			struct inotify_event* event = (struct inotify_event*)position;
+			position += sizeof(struct inotify_event) + event->len;
+
+			// events were dropped, so anything may have changed
+			if (event->mask & IN_Q_OVERFLOW) {
+				changed = true;
+				continue;
+			}
+			// the file or directory of the watch is gone
+			if (event->mask & IN_IGNORED) {
+				forgetWatch(state, event->wd);
+				continue;
+			}
+			if (event->wd < 0 || event->wd >= state->numPaths || !state->paths[event->wd].path) {
+				continue;
+			}
+
+			// a directory created or moved in is watched along with everything already in it
+			if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && (event->mask & IN_ISDIR) && event->len) {
+				char* child = (char*)malloc(strlen(state->paths[event->wd].path) + strlen(event->name) + 2);
+				sprintf(child, "%s/%s", state->paths[event->wd].path, event->name);
+				addWatches(state, child, false);
+				free(child);
+			}
+			// a path given to onchange that is renamed away is watched again at its name once its watch is gone
+			if ((event->mask & IN_MOVE_SELF) && state->paths[event->wd].root) {
+				inotify_rm_watch(handler->fd, event->wd);
+			}
+			changed = true;
+		}
+	}
+
+	// every change restarts the debounce time
+	if (changed) {
+		struct itimerspec settle = { { 0, 0 }, { state->debounceMs / 1000, (state->debounceMs % 1000) * 1000000 } };
+		// a time of zero would disarm the timer rather than expire it at once
+		if (state->debounceMs == 0) {
+			settle.it_value.tv_nsec = 1;
+		}
+		timerfd_settime(state->settleHandler.fd, 0, &settle, NULL);
+	}
+}
+
+/*
+* Invoked by the event loop when SIGINT is received, which ends watching
+*/
+static void watchInterrupted(struct eventHandler* handler, unsigned int events) {
+	struct watchState* state = (struct watchState*)handler->data;
+	struct signalfd_siginfo info;
+
+	if (read(handler->fd, &info, sizeof(info)) == sizeof(info)) {
+		state->interrupted = true;
+	}
+}
+
+/*
+* Executes the built-in "onchange" command - onchange [-d MS] [-q] PATH... -- command [args...] - which runs the
+* command once and again after every burst of changes to the files under each PATH, directories being watched
+* recursively. A burst ends once MS milliseconds pass without a change. A change while the command is still
+* running cancels the run, or with -q queues another run for when it finishes. Each run is executed like any
+* other command, in a process group of its own so that a cancelled run is stopped along with everything it
+* started. Watching ends with SIGINT, after which lastStatus holds the status of the last run
+*/
+void watchAndRun(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag) {
+	// declare and initialize the state of the command while it watches
+	struct watchState state = { command, backgroundPids, foregroundFlag, ONCHANGE_DEBOUNCE_MS, false };
+	// declare and initialize a variable used to maintain the index of the argument being parsed
+	int index = 1;
+	// declare and initialize a variable used to store the index of the separator
+	int separator = 0;
+	// declare a variable used to store the signals received through the signalfd
+	sigset_t signals;
+
+	// "-d MS" sets the debounce time and "-q" queues runs rather than cancelling them
+	while (command->argv[index] && command->argv[index][0] == '-' && strcmp(command->argv[index], ONCHANGE_SEPARATOR) != 0) {
+		if (strcmp(command->argv[index], "-q") == 0) {
+			state.queue = true;
+			index++;
+			continue;
+		}
+		if (strcmp(command->argv[index], "-d") == 0 && command->argv[index + 1]) {
+			char* end;
+			state.debounceMs = strtol(command->argv[index + 1], &end, 10);
+			if (*end == '\0' && end != command->argv[index + 1] && state.debounceMs >= 0) {
+				index += 2;
+				continue;
+			}
+			printf("onchange: %s: invalid debounce time\n", command->argv[index + 1]);
+		}
+		separator = -1;
+		break;
+	}
+
+	// at least one path and a command to run are required
+	for (int position = index; separator == 0 && command->argv[position]; position++) {
+		if (strcmp(command->argv[position], ONCHANGE_SEPARATOR) == 0) {
+			separator = position;
+		}
+	}
+	if (separator <= index || !command->argv[separator + 1]) {
+		printf("usage: onchange [-d MS] [-q] PATH... " ONCHANGE_SEPARATOR " command [args...]\n");
+		fflush(stdout);
+		*lastStatus = 1 << 8;
+		return;
+	}
+
+	// watch every path
+	state.changeHandler = (struct eventHandler){ inotify_init1(IN_NONBLOCK | IN_CLOEXEC), filesChanged, &state };
+	if (state.changeHandler.fd == -1) {
+		perror("inotify_init1 failed");
+		*lastStatus = 1 << 8;
+		return;
+	}
+	for (; index < separator; index++) {
+		if (!addWatches(&state, command->argv[index], true)) {
+			for (int watch = 0; watch < state.numPaths; watch++) {
+				free(state.paths[watch].path);
+			}
+			free(state.paths);
+			close(state.changeHandler.fd);
+			*lastStatus = 1 << 8;
+			return;
+		}
+	}
+
+	// SIGINT, which the shell ignores, is blocked so that it waits in the signalfd rather than being discarded
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigprocmask(SIG_BLOCK, &signals, &state.savedMask);
+	state.signalHandler = (struct eventHandler){ signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC), watchInterrupted, &state };
+	state.settleHandler = (struct eventHandler){ timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC), changesSettled, &state };
+	state.runHandler = (struct eventHandler){ -1, runFinished, &state };
+	state.runner = -1;
+	registerEventHandler(&state.changeHandler, EPOLLIN);
+	registerEventHandler(&state.signalHandler, EPOLLIN);
+	registerEventHandler(&state.settleHandler, EPOLLIN);
+
+	// what remains is the command to run, in the foreground as onchange itself is
+	removeLeadingArgs(command, separator + 1);
+	command->backgroundProcess = false;
+
+	// run the command once, then after every burst of changes until SIGINT
+	startRun(&state);
+	while (!state.interrupted) {
+		waitForEventsTimeout(-1, -1);
+	}
+
+	// stop the run in progress
+	if (state.runner != -1) {
+		kill(-state.runner, SIGTERM);
+		waitpid(state.runner, &state.lastStatus, 0);
+		unregisterEventHandler(&state.runHandler);
+		close(state.runHandler.fd);
+	}
+
+	// release the watches, the file descriptors and the paths, and unblock SIGINT
+	unregisterEventHandler(&state.changeHandler);
+	unregisterEventHandler(&state.signalHandler);
+	unregisterEventHandler(&state.settleHandler);
+	close(state.changeHandler.fd);
+	close(state.signalHandler.fd);
+	close(state.settleHandler.fd);
+	sigprocmask(SIG_SETMASK, &state.savedMask, NULL);
+	for (int watch = 0; watch < state.numPaths; watch++) {
+		free(state.paths[watch].path);
+	}
+	free(state.paths);
+
+	*lastStatus = state.lastStatus;
+}
@@ -0,0 +1,26 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the onchange built-in command, which reruns a command whenever the files under a
+*	set of paths change, waiting on inotify rather than polling the files with stat
+*/
+
+// the number of milliseconds without a change that ends a burst of changes and starts a run when -d is not given
+#define ONCHANGE_DEBOUNCE_MS 50
+
+// the word separating the paths watched from the command run
+#define ONCHANGE_SEPARATOR "--"
+
+// the inotify events that count as a change - a file written, created, removed or renamed
+#define ONCHANGE_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+/*
+* Executes the built-in "onchange" command - onchange [-d MS] [-q] PATH... -- command [args...] - which runs the
+* command once and again after every burst of changes to the files under each PATH, directories being watched
+* recursively. A burst ends once MS milliseconds pass without a change. A change while the command is still
+* running cancels the run, or with -q queues another run for when it finishes. Each run is executed like any
+* other command, in a process group of its own so that a cancelled run is stopped along with everything it
+* started. Watching ends with SIGINT, after which lastStatus holds the status of the last run
+*/
+void watchAndRun(struct command* command, struct dynamicArray* backgroundPids, int* lastStatus, int foregroundFlag);
@@ -0,0 +1,261 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: The optimizer, a pass between parsing and execution that rewrites wasteful command lines - a
+*	useless cat, an echo feeding a pipe, a built-in command whose output is discarded - into cheaper ones that
+*	behave the same
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "memory.h"
+#include "variables.h"
+#include "functions.h"
+#include "commandExecution.h"
+#include "heredoc.h"
+#include "metrics.h"
+#include "optimizer.h"
+
+// true if each rewritten command line is displayed, set by --explain
+static bool explain = false;
+
+/*
+* Makes the optimizer display each command line it rewrites along with its rewritten form, for --explain
+*/
+void explainRewrites(void) {
+	explain = true;
+}
+
+/*
+* Returns true if command is the plain program name with its arguments and nothing else - no assignments,
+* redirections, process substitutions or background - and name is not a shell function
+*/
+static bool isPlainCommand(struct command* command, char* name) {
+	return command->argv[0] && strcmp(command->argv[0], name) == 0 && !command->assignments[0] &&
+		!command->inputRedirect && !command->outputRedirect && !command->numSubstitutions &&
+		!command->backgroundProcess && !findFunction(name);
+}
+
+/*
+* Returns true if command is a program that reads its standard input, which may be given to it in place of a pipe.
+* A built-in command, a shell function or an "@" prefix is not - once it is no longer part of a pipeline it would
+* be executed within the shell itself, e.g. "echo /tmp | cd" would change the directory of the shell
+*/
+static bool readsPipe(struct command* command) {
+	return command && command->argv[0] && !command->inputRedirect && command->argv[0][0] != '@' &&
+		!isBuiltin(command->argv[0]) && !findFunction(command->argv[0]);
+}
+
+/*
+* Returns true if path names a regular file that can be read
+*/
+static bool isReadableFile(char* path) {
+	struct stat fileStat;
+
+	return stat(path, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && access(path, R_OK) == 0;
+}
+
+/*
+* Releases command, which has been rewritten away, and returns the command that followed it in its pipeline
+*/
+static struct command* dropCommand(struct command* command) {
+	struct command* next = command->pipeNext;
+
+	command->pipeNext = NULL;
+	cleanupMemory(command);
+	return next;
+}
+
+/*
+* Appends text to the description being built in buffer, within single quotes if quote is true and text holds
+* anything other than letters, digits and "-_./=,:+%@"
+*/
+static void appendDescription(char** buffer, size_t* length, char* text, bool quote) {
+	// declare and initialize a variable used to store whether text must be quoted
+	bool quoted = quote && (text[0] == '\0' || text[strspn(text, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_./=,:+%@")] != '\0');
+
+	// every quote within text becomes four bytes
+	*buffer = (char*)realloc(*buffer, *length + 4 * strlen(text) + 3);
+	if (quoted) {
+		(*buffer)[(*length)++] = '\'';
+	}
+	for (; *text; text++) {
+		if (quoted && *text == '\'') {
+			memcpy(*buffer + *length, "'\\''", 4);
+			*length += 4;
+		}
+		else {
+			(*buffer)[(*length)++] = *text;
+		}
+	}
+	if (quoted) {
+		(*buffer)[(*length)++] = '\'';
+	}
+	(*buffer)[*length] = '\0';
+}
+
+/*
+* Returns a newly allocated description of the command line starting at command as it would be entered. The
+* text of a here-string created by the optimizer for hereCommand is hereText
+*/
+static char* describeCommand(struct command* command, struct command* hereCommand, char* hereText) {
+	char* buffer = NULL;
+	size_t length = 0;
+
+	appendDescription(&buffer, &length, "", false);
+	if (!command) {
+		appendDescription(&buffer, &length, "(nothing)", false);
+		return buffer;
+	}
+
+	for (struct command* current = command; current; current = current->pipeNext) {
+		for (int index = 0; current->assignments[index]; index++) {
+			appendDescription(&buffer, &length, current->assignments[index], true);
+			appendDescription(&buffer, &length, " ", false);
+		}
+		for (int index = 0; current->argv[index]; index++) {
+			appendDescription(&buffer, &length, current->argv[index], true);
+			appendDescription(&buffer, &length, current->argv[index + 1] ? " " : "", false);
+		}
+
+		// the input of a here-document or here-string is held in a memory file
+		if (current == hereCommand) {
+			appendDescription(&buffer, &length, " <<< ", false);
+			appendDescription(&buffer, &length, hereText, true);
+		}
+		else if (current->hereDelimiter) {
+			appendDescription(&buffer, &length, " <<", false);
+			appendDescription(&buffer, &length, current->hereDelimiter, true);
+		}
+		else if (current->inputRedirect) {
+			appendDescription(&buffer, &length, " < ", false);
+			appendDescription(&buffer, &length, current->newInput, current->inputFD == -1);
+		}
+		if (current->outputRedirect) {
+			appendDescription(&buffer, &length, " > ", false);
+			appendDescription(&buffer, &length, current->newOutput, true);
+		}
+		for (int index = 0; current->teeOutputs[index]; index++) {
+			appendDescription(&buffer, &length, " > ", false);
+			appendDescription(&buffer, &length, current->teeOutputs[index], true);
+		}
+		appendDescription(&buffer, &length, current->backgroundProcess ? " &" : "", false);
+		appendDescription(&buffer, &length, current->pipeNext ? " | " : "", false);
+	}
+
+	return buffer;
+}
+
+/*
+* Rewrites the command line starting at command, unless SMALLSH_OPT is 0, and returns its first command:
+*	"cat FILE | command" becomes "command < FILE" if FILE is a readable regular file
+*	"echo words | command" becomes "command <<< 'words'"
+*	"command | cat | command" drops the cat
+*	"status", "jobs" or "alias" redirected to /dev/null is not executed at all
+* Commands dropped by a rewrite are released. Each rewrite and the forks it avoided are counted on the metrics page
+*/
+struct command* optimizeCommand(struct command* command) {
+	// declare and initialize a variable used to store whether the optimizer is turned off
+	char* setting = getVariable(OPTIMIZER_VARIABLE);
+	// declare and initialize variables used to count the rewrites and the forks they avoid
+	int rewrites = 0, forksAvoided = 0;
+	// declare and initialize variables used to describe a here-string created from an echo
+	struct command* hereCommand = NULL;
+	char* hereText = NULL;
+	// declare and initialize a variable used to store the description of the command line before it is rewritten
+	char* original = NULL;
+
+	if (!command || !command->argv[0] || (setting && strcmp(setting, "0") == 0)) {
+		return command;
+	}
+	if (explain) {
+		original = describeCommand(command, NULL, NULL);
+	}
+
+	// "cat FILE | command" - the command reads FILE itself. A file that cat could not read is left to cat to report
+	if (isPlainCommand(command, "cat") && command->argv[1] && !command->argv[2] && command->argv[1][0] != '-' &&
+		readsPipe(command->pipeNext) && isReadableFile(command->argv[1])) {
+		command->pipeNext->inputRedirect = true;
+		command->pipeNext->newInput = (char*)malloc(strlen(command->argv[1]) + 1);
+		strcpy(command->pipeNext->newInput, command->argv[1]);
+		command = dropCommand(command);
+		rewrites++;
+		forksAvoided++;
+	}
+	// "echo words | command" - the words become a here-string, which is what echo writes without options
+	else if (isPlainCommand(command, "echo") && (!command->argv[1] || command->argv[1][0] != '-') && readsPipe(command->pipeNext)) {
+		// declare and initialize a variable used to store the length of the words joined by spaces
+		size_t length = 1;
+		for (int index = 1; command->argv[index]; index++) {
+			length += strlen(command->argv[index]) + 1;
+		}
+		hereText = (char*)malloc(length);
+		hereText[0] = '\0';
+		// copy each word to the end of the text so far rather than searching for it, which takes a brace
+		// expansion of a million words from minutes to milliseconds
+		char* end = hereText;
+		for (int index = 1; command->argv[index]; index++) {
+			end = stpcpy(end, command->argv[index]);
+			end = stpcpy(end, command->argv[index + 1] ? " " : "");
+		}
+
+		int hereFD = createHereString(hereText);
+		if (hereFD != -1) {
+			hereCommand = command->pipeNext;
+			hereCommand->inputRedirect = true;
+			hereCommand->inputFD = hereFD;
+			hereCommand->newInput = (char*)malloc(strlen("here-string") + 1);
+			strcpy(hereCommand->newInput, "here-string");
+			command = dropCommand(command);
+			rewrites++;
+			forksAvoided++;
+		}
+	}
+
+	// "command | cat | command" - a cat between two commands only copies one pipe into the other
+	for (struct command* current = command; current && current->pipeNext; current = current->pipeNext) {
+		while (current->pipeNext->pipeNext && isPlainCommand(current->pipeNext, "cat") && !current->pipeNext->argv[1]) {
+			current->pipeNext = dropCommand(current->pipeNext);
+			rewrites++;
+			forksAvoided++;
+		}
+	}
+
+	// a built-in command that only displays something has no effect once its output is discarded
+	if (!command->pipeNext && command->argv[0] && (strcmp(command->argv[0], "status") == 0 || strcmp(command->argv[0], "jobs") == 0 ||
+		strcmp(command->argv[0], "alias") == 0) && command->outputRedirect && strcmp(command->newOutput, "/dev/null") == 0 &&
+		!command->teeOutputs[0]) {
+		for (int index = 0; command->argv[index]; index++) {
+			free(command->argv[index]);
+		}
+		for (int index = 0; command->assignments[index]; index++) {
+			free(command->assignments[index]);
+		}
+		command->argv[0] = NULL;
+		command->pathName = NULL;
+		command->assignments[0] = NULL;
+		rewrites++;
+	}
+
+	// count the rewrites on the metrics page and, with --explain, display what became of the command line
+	if (rewrites) {
+		countRewrites(rewrites, forksAvoided);
+	}
+	if (explain && rewrites) {
+		char* rewritten = describeCommand(command->argv[0] ? command : NULL, hereCommand, hereText);
+		fprintf(stderr, "optimized: %s => %s (%d fork%s avoided)\n", original, rewritten, forksAvoided, forksAvoided == 1 ? "" : "s");
+		free(rewritten);
+	}
+	free(original);
+	free(hereText);
+
+	return command;
+}
@@ -0,0 +1,25 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the optimizer, a pass between parsing and execution that rewrites wasteful
+*	command lines into cheaper ones that behave the same
+*/
+
+// the variable that turns the optimizer off when set to 0
+#define OPTIMIZER_VARIABLE "SMALLSH_OPT"
+
+/*
+* Makes the optimizer display each command line it rewrites along with its rewritten form, for --explain
+*/
+void explainRewrites(void);
+
+/*
+* Rewrites the command line starting at command, unless SMALLSH_OPT is 0, and returns its first command:
+*	"cat FILE | command" becomes "command < FILE" if FILE is a readable regular file
+*	"echo words | command" becomes "command <<< 'words'"
+*	"command | cat | command" drops the cat
+*	"status", "jobs" or "alias" redirected to /dev/null is not executed at all
+* Commands dropped by a rewrite are released. Each rewrite and the forks it avoided are counted on the metrics page
+*/
+struct command* optimizeCommand(struct command* command);
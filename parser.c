@@ -9,24 +9,33 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <signal.h>
+#include <glob.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "variables.h"
+#include "events.h"
+#include "timeout.h"
+#include "prompt.h"
+#include "lineEditor.h"
+#include "functions.h"
+#include "heredoc.h"
+#include "substitution.h"
+#include "lexer.h"
+#include "arithmetic.h"
+#include "braces.h"
+#include "chunk.h"
+#include "memory.h"
+#include "metrics.h"
 
-/*
-* A struct used in command line parsing. This struct holds all the details about the 
-* type of command that was entered by the user
-*/
-struct command {
-	char* pathName;  // the pathname of the binary executable
-	char** argv;  // an array of arguments
-	bool inputRedirect;  // true if input should be redirected, otherwise false
-	char* newInput;  // the file to redirect input from
-	bool outputRedirect;  // true if output should be redirected, otherwise false
-	char* newOutput;  // the file to redirect output to
-	bool backgroundProcess;  // true if the process should run in the background, otherwise false
-};
+// true once parseWords has dropped a command because of a syntax error, so that its whole pipeline is dropped
+static bool droppedCommand = false;
 
 /*
 * Displays a colon ":" symbol as a prompt for each command line. Captures any input provided by
-* the user and returns that input as a character pointer.
+* the user and returns that input as a character pointer. NULL is returned once the input has ended.
 */
 char* getCommandLineInput(void) {
 	// declare and initialize a character pointer used to store user command line input
@@ -36,12 +45,33 @@ char* getCommandLineInput(void) {
 	// for use with getline
 	ssize_t nread;
 
-	// display ":" as command line prompt
-	printf(": ");
+	// on a terminal, read the command line with the line editor which supports Tab completion
+	if (useLineEditor()) {
+		return readEditedLine(getPrompt());
+	}
+
+	// display the command line prompt - ":" unless PS1 is set
+	fputs(getPrompt(), stdout);
+	// flush standard output so the prompt is visible while waiting
+	fflush(stdout);
+
+	// if no input is already buffered in stdin, let the event loop service the timers and other file
+	// descriptors of running processes until the user provides more input
+	if (stdin->_IO_read_ptr >= stdin->_IO_read_end) {
+		waitForEvents(STDIN_FILENO);
+	}
+
 	// use getline to capture user input from stdin and store in userInput variable
 	nread = getline(&userInput, &length, stdin);
+	// if getline returns -1, then the end of input has been reached - signal this by returning NULL
+	if (nread == -1) {
+		free(userInput);
+		return NULL;
+	}
 	// remove '\n' resulting from the user pressing enter and replace with null character
-	*(userInput + strlen(userInput) - 1) = '\0';
+	if (nread > 0 && userInput[nread - 1] == '\n') {
+		userInput[nread - 1] = '\0';
+	}
 	// flush standard output
 	fflush(stdout);
 
@@ -58,15 +88,53 @@ void initializeCommandStruct(struct command* command, int numArgs) {
 	command->inputRedirect = false;
 	// initialize new input source as NULL
 	command->newInput = NULL;
+	// initialize the command as having no here-document or here-string
+	command->inputFD = -1;
+	command->hereDelimiter = NULL;
+	command->hereLiteral = false;
 
 	// initialize output redirection as false
 	command->outputRedirect = false;
 	// intialize new output source as NULL
 	command->newOutput = NULL;
+	// allocate memory for the NULL terminated array of additional output targets and initialize it as empty
+	command->teeOutputs = (char**)malloc(sizeof(char*));
+	command->teeOutputs[0] = NULL;
+	// initialize the output and error output file descriptors as unused
+	command->outputFD = -1;
+	command->errorFD = -1;
 
 	// initialize background process as false
 	command->backgroundProcess = false;
 
+	// initialize the command as having no timeout - SIGTERM is sent when a timeout is given
+	command->timeoutMs = 0;
+	command->timeoutSignal = SIGTERM;
+	command->killAfterMs = DEFAULT_KILL_AFTER_MS;
+
+	// initialize the command as not chunked
+	command->chunkJobs = 0;
+	command->chunkStart = 0;
+	command->braceItems = NULL;
+	command->numBraceItems = 0;
+
+	// initialize the command as having no process substitutions
+	command->substitutions = NULL;
+	command->numSubstitutions = 0;
+
+	// initialize the command as not memoized
+	command->memoize = false;
+
+	// initialize the command as inheriting the placement of the shell
+	command->placement = NULL;
+
+	// initialize the command as the last command of its pipeline
+	command->pipeNext = NULL;
+
+	// allocate memory for the NULL terminated array of prefix assignments and initialize it as empty
+	command->assignments = (char**)malloc(sizeof(char*));
+	command->assignments[0] = NULL;
+
 	// allocate memory large enough to store numArgs number of character pointers
 	command->argv = (char**)malloc(numArgs * sizeof(char*));
 	// initialize each character pointer in the argv array to be NULL
@@ -151,75 +219,151 @@ char* updateFinalExpandedArg(char* finalExpandedArg, char* currExpandedArg) {
 	return finalExpandedArg;
 }
 
+/*
+* Examines the variable reference that begins with the '$' at the address in dollar and returns the text
+* it expands to. "$$" expands into the process ID of smallsh, "$NAME" and "${NAME}" expand into the value
+* of the variable NAME (or nothing if NAME is unset), "$1" to "$9" and "${N}" into the positional
+* parameters of the function being executed, "$#" into their number and "$((EXPRESSION))" into the value of
+* the arithmetic expression (or nothing if it is invalid). Any other '$' is left as is. The address of the
+* first character following the reference is stored in referenceEnd
+*/
+char* expandReference(char* dollar, char** referenceEnd, char* pidString) {
+	// declare and initialize a variable used to hold the length of a variable name
+	int nameLength = 0;
+	// declare and initialize a variable used to hold the value of a referenced variable
+	char* value = NULL;
+	// declare a buffer large enough to hold a braced variable name
+	char name[256];
+	// declare a buffer large enough to hold the number of positional parameters
+	static char countString[16];
+
+	// "$$" expands into the pid of smallsh
+	if (dollar[1] == '$') {
+		*referenceEnd = dollar + 2;
+		return pidString;
+	}
+
+	// "$0" to "$9" expand into the positional parameters of the function being executed
+	if (dollar[1] >= '0' && dollar[1] <= '9') {
+		value = getPositionalParameter(dollar[1] - '0');
+		*referenceEnd = dollar + 2;
+		return value ? value : "";
+	}
+
+	// "$((EXPRESSION))" expands into the value of the expression, evaluated within the shell
+	if (dollar[1] == '(' && dollar[2] == '(' && (value = expandArithmetic(dollar, referenceEnd))) {
+		return value;
+	}
+
+	// "$#" expands into the number of positional parameters
+	if (dollar[1] == '#') {
+		snprintf(countString, sizeof(countString), "%d", countPositionalParameters());
+		*referenceEnd = dollar + 2;
+		return countString;
+	}
+
+	// "${NAME}" expands into the value of NAME
+	if (dollar[1] == '{') {
+		char* closingBrace = strchr(dollar + 2, '}');
+		nameLength = closingBrace ? closingBrace - (dollar + 2) : 0;
+
+		// "${N}" expands into positional parameter N, which is the only way to reach those past the ninth
+		if (closingBrace && nameLength > 0 && (int)strspn(dollar + 2, "0123456789") == nameLength) {
+			value = getPositionalParameter(atoi(dollar + 2));
+			*referenceEnd = closingBrace + 1;
+			return value ? value : "";
+		}
+
+		// if the braces do not hold a valid name, leave the '$' alone
+		if (!closingBrace || nameLength >= (int)sizeof(name) || !isValidVariableName(dollar + 2, nameLength)) {
+			*referenceEnd = dollar + 1;
+			return "$";
+		}
+
+		// look up the variable by copying its name into a null terminated buffer
+		strncpy(name, dollar + 2, nameLength);
+		name[nameLength] = '\0';
+		value = getVariable(name);
+		*referenceEnd = closingBrace + 1;
+		return value ? value : "";
+	}
+
+	// "$NAME" expands into the value of the longest valid name following the '$'
+	while (isValidVariableName(dollar + 1, nameLength + 1) && nameLength + 1 < (int)sizeof(name)) {
+		nameLength++;
+	}
+	// if no valid name follows the '$', leave the '$' alone
+	if (nameLength == 0) {
+		*referenceEnd = dollar + 1;
+		return "$";
+	}
+
+	// look up the variable by copying its name into a null terminated buffer
+	strncpy(name, dollar + 1, nameLength);
+	name[nameLength] = '\0';
+	value = getVariable(name);
+	*referenceEnd = dollar + 1 + nameLength;
+	return value ? value : "";
+}
+
 /*
 * Parses each individual argument being added to the argv member of the command struct and
-* searches for any instances of "$$". If "$$" is found, it is expanded into the process ID
-* of smallsh itself.
+* searches for any variable references. "$$" is expanded into the process ID of smallsh itself
+* and "$NAME" or "${NAME}" is expanded into the value of the shell variable NAME.
 */
 char* parseArg(char* arg) {
-	int index;
 	// delcare and initialize a character pointer that will consistently be pointing to the first character
-	// in the provided arg or the first character following an instance of "$$"
+	// in the provided arg or the first character following a variable reference
 	char* startToken = arg;
-	// declare and initialize a character pointer that will consistently be pointing to the next instance
-	// of "$$" if one is found
+	// declare and initialize a character pointer that will consistently be pointing to the next '$'
+	// if one is found
 	char* endToken = NULL;
+	// declare and initialize a character pointer that will point to the first character following the
+	// variable reference being expanded
+	char* referenceEnd = NULL;
+	// declare and initialize a variable that will point to the text a variable reference expands into
+	char* expansion = NULL;
 	// declare and initialize a variable that will maintain the final epxanded argument state
 	char* finalExpandedArg = NULL;
 	// declare and initialize a variable that will maintain the current expanded argument state
 	char* currExpandedArg = NULL;
-	// declare and initialize a variable that stores the number of digits in the pid of smallsh (reference citation E)
-	int pidLength = snprintf(NULL, 0, "%d", getpid());
-	// allocate memory large enough to hold characters equal to the length of the pid of smallsh
-	// plus a null character
-	char* pidString = (char*)malloc((pidLength + 1) * sizeof(char));
-
-	// populate pidString with characters representing the current pid of smallsh
-	sprintf(pidString, "%d", getpid());
-
-	// search for the first instance of "$$" starting from startToken's address
-	endToken = strstr(startToken, "$$");
-	// iterate until no more instances of "$$" are detected
+	// declare a buffer large enough to hold the pid of smallsh
+	char pidString[32];
+
+	// search for the first '$' starting from startToken's address
+	endToken = strchr(startToken, '$');
+
+	// populate pidString with characters representing the current pid of smallsh (reference citation E) - only
+	// needed if the arg holds a '$', which saves a system call for most args
+	if (endToken) {
+		snprintf(pidString, sizeof(pidString), "%d", getpid());
+	}
+	// iterate until no more instances of '$' are detected
 	while (endToken) {
-		// since endToken is the first address of the first instance of "$$" and startToken is the address
-		// of the first character in the provided arg, the following memory allocation will allocate memory
-		// large enough to hold all characters found starting from the address in startToken and up to but 
-		// not including the address in endToken plus the length of the pid of smallsh plus an additional
-		// byte to store the null character
-		currExpandedArg = (char*)malloc((pidLength + (endToken - startToken) + 1) * sizeof(char));
-
-		// if the address in startToken is equal to the address in endToken, then both addresses are pointing
-		// to an instance of "$$"
-		if (startToken == endToken) {
-			// copy the contents of pidString into currExpandedArg - currExpandedArg will only hold the pid
-			// of smallsh
-			strcpy(currExpandedArg, pidString);
-		}
-		// if the address in startToken is different than the address in endToken, then startToken is pointing
-		// to a character and endToken is pointing to an instance of "$$"
-		else {
-			// populate currExpandedArg with the characters found starting at startToken and up to, but not
-			// including endToken
-			startToken = populateCurrExpandedArg(currExpandedArg, startToken, endToken);
-			// concatenate currExpandedArg and the pid of smallsh to account for the expansion of "$$"
-			strcat(currExpandedArg, pidString);
-		}
+		// determine what the reference starting at endToken expands into
+		expansion = expandReference(endToken, &referenceEnd, pidString);
+
+		// allocate memory large enough to hold all characters found starting from the address in startToken
+		// and up to but not including the address in endToken plus the expansion plus the null character
+		currExpandedArg = (char*)malloc(((endToken - startToken) + strlen(expansion) + 1) * sizeof(char));
+
+		// populate currExpandedArg with the characters found starting at startToken and up to, but not
+		// including endToken, then concatenate the expansion of the reference
+		populateCurrExpandedArg(currExpandedArg, startToken, endToken);
+		strcat(currExpandedArg, expansion);
 
 		// add the characters of currExpandedArg to the array of characters being maintained by finalExpandedArg
 		finalExpandedArg = updateFinalExpandedArg(finalExpandedArg, currExpandedArg);
 
-		// position startToken two bytes up from it's current position since after processing it will be pointing
-		// at endToken which is pointing at "$$". Moving startToken up 2 bytes allows it to point to the first
-		// character following "$$"
-		startToken = startToken + 2;
-		// find the next instance of "$$" using startToken as the starting address
-		endToken = strstr(startToken, "$$");
+		// position startToken at the first character following the reference and find the next '$'
+		startToken = referenceEnd;
+		endToken = strchr(startToken, '$');
 	}
 
 	// after exiting the while loop check if there are any characters remaining since the while loop only breaks
-	// when no more instances of "$$" are found - there may be additional characters following the last instance
-	// of "$$"
-	if (strlen(startToken) > 0) {
+	// when no more instances of '$' are found - there may be additional characters following the last reference.
+	// An argument that expands into nothing still needs an empty string
+	if (strlen(startToken) > 0 || !finalExpandedArg) {
 		// allocate memory large enough to hold all remaining characters plus the null character
 		currExpandedArg = (char*)malloc((strlen(startToken) + 1) * sizeof(char));
 
@@ -231,60 +375,348 @@ char* parseArg(char* arg) {
 		finalExpandedArg = updateFinalExpandedArg(finalExpandedArg, currExpandedArg);
 	}
 
-	// free memory allocated by pidString and set pidString to NULL
-	free(pidString);
-	pidString = NULL;
-
 	// return the final fully expanded arg as a character pointer
 	return finalExpandedArg;
 }
 
+/*
+* Returns true if word holds a '*', '?' or '[' that is neither quoted, escaped nor within an arithmetic
+* expansion, which makes it a pattern to be expanded into the paths it matches
+*/
+bool isPattern(char* word) {
+	// declare and initialize a variable used to store the quote the current character is within, if any
+	char quote = '\0';
+
+	for (; *word; word++) {
+		if (quote == '\'') {
+			quote = (*word == '\'') ? '\0' : quote;
+		}
+		else if (quote == '"') {
+			if (*word == '\\' && word[1]) {
+				word++;
+			}
+			else if (*word == '"') {
+				quote = '\0';
+			}
+		}
+		else if (*word == '\'' || *word == '"') {
+			quote = *word;
+		}
+		else if (*word == '\\' && word[1]) {
+			word++;
+		}
+		else if (word[0] == '$' && word[1] == '(' && word[2] == '(' && findArithmeticEnd(word)) {
+			word = findArithmeticEnd(word) - 1;
+		}
+		else if (*word == '*' || *word == '?' || *word == '[') {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+* Appends length characters of text to the string being built in result, preceding each of "*?[]\" with a
+* backslash if escape is true
+*/
+static void appendText(char** result, size_t* resultLength, size_t* capacity, char* text, size_t length, bool escape) {
+	// grow the result so that every character fits even if it is escaped
+	if (*resultLength + 2 * length + 1 > *capacity) {
+		*capacity = (*resultLength + 2 * length + 1) * 2;
+		*result = (char*)realloc(*result, *capacity);
+	}
+
+	for (size_t index = 0; index < length; index++) {
+		if (escape && strchr("*?[]\\", text[index])) {
+			(*result)[(*resultLength)++] = '\\';
+		}
+		(*result)[(*resultLength)++] = text[index];
+	}
+	(*result)[*resultLength] = '\0';
+}
+
+/*
+* Returns a newly allocated copy of word with its quotes and backslash escapes removed. Variable references
+* outside of single quotes are expanded if expand is true, and every quoted or escaped "*?[]\" is preceded
+* with a backslash if pattern is true
+*/
+static char* unquoteWord(char* word, bool expand, bool pattern) {
+	// declare and initialize variables used to build the result
+	size_t resultLength = 0, capacity = strlen(word) + 1;
+	char* result = (char*)malloc(capacity);
+	// declare and initialize a variable used to store the quote the current character is within, if any
+	char quote = '\0';
+	// declare a buffer large enough to hold the process ID of smallsh, filled in at the first reference
+	char pidString[32] = "";
+	// declare a variable used to point to the first character following a variable reference
+	char* referenceEnd;
+
+	result[0] = '\0';
+	while (*word) {
+		// a variable reference outside of single quotes is expanded - its value is only a pattern if unquoted
+		if (expand && *word == '$' && quote != '\'') {
+			if (!pidString[0]) {
+				snprintf(pidString, sizeof(pidString), "%d", getpid());
+			}
+			char* value = expandReference(word, &referenceEnd, pidString);
+			appendText(&result, &resultLength, &capacity, value, strlen(value), pattern && quote);
+			word = referenceEnd;
+		}
+		// quotes open and close without becoming part of the result
+		else if ((!quote && (*word == '\'' || *word == '"')) || (quote && *word == quote)) {
+			quote = quote ? '\0' : *word;
+			word++;
+		}
+		// a backslash escapes the character after it, though within double quotes only '$', '"' and '\'
+		else if (*word == '\\' && quote != '\'' && word[1] && (!quote || strchr("$\"\\", word[1]))) {
+			appendText(&result, &resultLength, &capacity, word + 1, 1, pattern);
+			word += 2;
+		}
+		else {
+			appendText(&result, &resultLength, &capacity, word, 1, pattern && quote);
+			word++;
+		}
+	}
+
+	return result;
+}
+
+/*
+* Returns a newly allocated copy of word with its variable references expanded and its quotes and backslash
+* escapes removed. Nothing within single quotes is expanded, and within double quotes a backslash only escapes
+* '$', '"' and '\'. If pattern is true, every quoted or escaped "*?[]\" is preceded with a backslash so that
+* the result can be passed to glob
+*/
+char* expandWord(char* word, bool pattern) {
+	// a word without references, quotes or escapes is used as it is
+	if (!strpbrk(word, "$'\"\\")) {
+		return strdup(word);
+	}
+
+	return unquoteWord(word, true, pattern);
+}
+
+/*
+* Returns a newly allocated copy of word with its quotes and backslash escapes removed, leaving its variable
+* references unexpanded
+*/
+char* removeQuotes(char* word) {
+	return unquoteWord(word, false, false);
+}
+
 /*
 * Appends the current arg to the argv array member of the command struct.
 */
 char** appendArg(char* arg, char* argv[], int numArgs, int argvIndex) {
-	// declare and initialize a variable to maintain index position relative to newArgv array
+	// argv is always NULL terminated and argvIndex always holds the index position of the next argument,
+	// so *(argv + argvIndex) always exists and is always NULL. Store the expanded arg there, with its
+	// quotes and escapes removed, and grow argv by one so that it stays NULL terminated. Growing argv in
+	// place keeps a command line with many thousands of arguments from being copied once per argument
+	argv[argvIndex] = expandWord(arg, false);
+	argv = (char**)realloc(argv, (numArgs + 1) * sizeof(char*));
+
+	// set the very last index position of argv to NULL as is expected by execvp
+	argv[numArgs] = NULL;
+
+	// return argv as a pointer to a character pointer
+	return argv;
+}
+
+/*
+* Expands the pattern arg, after expanding any variable references, into the paths it matches and appends
+* them to the argv array member of the command struct in one step, updating numArgs and argvIndex. Quoted or
+* escaped characters of arg match only themselves. A pattern matching nothing is appended as it is, with its
+* quotes removed
+*/
+char** appendMatches(char* arg, char* argv[], int* numArgs, int* argvIndex) {
+	// declare a variable used to store the paths the pattern matches
+	glob_t matches;
+	// expand any variable references in the pattern first, escaping whatever was quoted
+	char* pattern = expandWord(arg, true);
+
+	// find the matching paths in sorted order - without a match the word itself is appended
+	if (glob(pattern, 0, NULL, &matches) != 0) {
+		free(pattern);
+		argv = appendArg(arg, argv, *numArgs, *argvIndex);
+		(*numArgs)++;
+		(*argvIndex)++;
+		return argv;
+	}
+
+	// grow the argv array once for every path, which keeps a pattern matching many thousands of files cheap
+	argv = (char**)realloc(argv, (*numArgs + matches.gl_pathc) * sizeof(char*));
+	for (size_t index = 0; index < matches.gl_pathc; index++) {
+		argv[*argvIndex] = (char*)malloc((strlen(matches.gl_pathv[index]) + 1) * sizeof(char));
+		strcpy(argv[*argvIndex], matches.gl_pathv[index]);
+		(*argvIndex)++;
+	}
+	argv[*argvIndex] = NULL;
+	*numArgs += matches.gl_pathc;
+
+	// free memory allocated for the pattern and the matches
+	globfree(&matches);
+	free(pattern);
+
+	return argv;
+}
+
+/*
+* Appends every word produced by generator to the argv array member of the command struct, updating numArgs
+* and argvIndex. Each word is expanded like a word of its own - a pattern into the paths it matches
+*/
+static char** appendBraces(struct braceGenerator* generator, char* argv[], int* numArgs, int* argvIndex) {
+	for (char* word = nextBrace(generator); word; word = nextBrace(generator)) {
+		if (isPattern(word)) {
+			argv = appendMatches(word, argv, numArgs, argvIndex);
+		}
+		else {
+			argv = appendArg(word, argv, *numArgs, *argvIndex);
+			(*numArgs)++;
+			(*argvIndex)++;
+		}
+	}
+
+	return argv;
+}
+
+/*
+* Returns true if the word to be appended at argvIndex of the argv array member of the command struct is an item
+* of a chunked command, with words holding the words still to be parsed after it. Without a ":::" separator
+* every argument after the command being chunked is an item
+*/
+static bool isChunkItem(struct command* command, int argvIndex, char** words) {
+	if (strcmp(command->argv[0], "chunk") != 0) {
+		return false;
+	}
+
+	// the items follow the separator, wherever it is
+	for (int index = 1; index < argvIndex; index++) {
+		if (strcmp(command->argv[index], CHUNK_SEPARATOR) == 0) {
+			return true;
+		}
+	}
+	for (int index = 0; words[index]; index++) {
+		if (strcmp(words[index], CHUNK_SEPARATOR) == 0) {
+			return false;
+		}
+	}
+
+	// the command being chunked follows "-P JOBS", if given
+	int commandIndex = command->argv[1] && strcmp(command->argv[1], "-P") == 0 ? 3 : 1;
+	return argvIndex > commandIndex;
+}
+
+/*
+* Replaces each item of a chunked command holding a brace expression with the words it produces, for a command
+* that is given all of its items at once rather than in batches
+*/
+void expandBraceItems(struct command* command) {
+	// declare and initialize a variable used to maintain the numbers of elements in the new argv array
+	int numArgs = 1;
+	// declare and initialize a variable used to maintain the index position to insert the next arg at
+	int argvIndex = 0;
+	// allocate memory for the new argv array, which starts out empty
+	char** argv = (char**)malloc(sizeof(char*));
+	// declare and initialize a variable used to store the index of the next item holding a brace expression
+	int braceIndex = 0;
+
+	argv[0] = NULL;
+	for (int index = 0; command->argv[index]; index++) {
+		if (braceIndex < command->numBraceItems && command->argv[index] == command->braceItems[braceIndex].arg) {
+			argv = appendBraces(command->braceItems[braceIndex++].generator, argv, &numArgs, &argvIndex);
+			free(command->argv[index]);
+			continue;
+		}
+
+		// every other argument is already expanded and is moved over as it is
+		argv = (char**)realloc(argv, (numArgs + 1) * sizeof(char*));
+		argv[argvIndex++] = command->argv[index];
+		argv[argvIndex] = NULL;
+		numArgs++;
+	}
+
+	free(command->argv);
+	command->argv = argv;
+	freeBraceItems(command);
+}
+
+/*
+* Releases the generators of the items of a chunked command holding brace expressions
+*/
+void freeBraceItems(struct command* command) {
+	for (int index = 0; index < command->numBraceItems; index++) {
+		freeBraces(command->braceItems[index].generator);
+	}
+	free(command->braceItems);
+	command->braceItems = NULL;
+	command->numBraceItems = 0;
+}
+
+/*
+* Removes the first count arguments from the argv array member of the command struct and makes the
+* first remaining argument the new pathName. Used by built-in commands such as "timeout" that prefix
+* another command
+*/
+void removeLeadingArgs(struct command* command, int count) {
+	// declare and initialize a variable to maintain index position relative to the argv array
 	int index = 0;
-	// allocate memory large enough to hold the current number of character pointers in argv plus
-	// one to hold the new arg being appended
-	char** newArgv = (char**)malloc((numArgs + 1) * sizeof(char*));
-
-	// parse the current arg being appended and expand each instance of "$$" found
-	arg = parseArg(arg);
-
-	// argv index will always be NULL terminated and argvIndex will always be holding the index
-	// position of the next argument. At this point, *(argv + argvIndex) will always exist and
-	// will always be NULL. Before transferring every character pointer in argv to newArgv, 
-	// allocate memory large enough to hold arg after it has been parsed and copy the characters
-	// in arg to the address argv + argvIndex
-	argv[argvIndex] = (char*)malloc((strlen(arg) + 1) * sizeof(char));
-	strcpy(argv[argvIndex], arg);
-
-	// copy every character pointer in argv into newArgv
-	while (index < numArgs) {
-		newArgv[index] = argv[index];
-		index++;
+
+	// release the memory allocated for each removed argument - argv[0] is the same memory segment as pathName
+	for (index = 0; index < count; index++) {
+		free(command->argv[index]);
 	}
-	// set the very last index position of newArgv to NULL as is expected by execvp
-	newArgv[index] = NULL;
 
-	// free memory allocated by arg and set arg to NULL
-	free(arg);
-	arg = NULL;
+	// shift the remaining arguments, including the NULL terminator, to the front of the argv array
+	for (index = 0; command->argv[index + count]; index++) {
+		command->argv[index] = command->argv[index + count];
+	}
+	command->argv[index] = NULL;
 
-	// free memory allocated by argv and set srgv to NULL
-	free(argv);
-	argv = NULL;
+	// the command being executed is now the first remaining argument
+	command->pathName = command->argv[0];
+}
 
-	// return new argv as a pointer to a character pointer
-	return newArgv;
+/*
+* Splits the userInput string into its words without expanding any variable references - words are separated
+* by whitespace outside of quotes and keep their quotes and backslashes until they are expanded. Returns a
+* NULL terminated array of words which must be released with freeWords, or NULL if userInput is blank or a
+* comment
+*/
+char** splitWords(char* userInput) {
+	// the lexer finds the words in a single pass over userInput
+	return lexWords(userInput);
 }
 
 /*
-* Fully parses the userInput string and sets / updates the appropriate members of the command struct
-* instance that is built for use in executing the user provided command
+* Releases the memory allocated for a NULL terminated array of words returned by splitWords
 */
-struct command* parseUserInput(char* userInput) {
+void freeWords(char** words) {
+	for (int index = 0; words[index]; index++) {
+		free(words[index]);
+	}
+	free(words);
+}
+
+/*
+* Returns a newly allocated command struct with nothing to execute
+*/
+static struct command* emptyCommand(void) {
+	struct command* command = (struct command*)malloc(sizeof(struct command));
+
+	initializeCommandStruct(command, 2);
+	command->pathName = NULL;
+	return command;
+}
+
+/*
+* Builds the command struct from the NULL terminated array of unexpanded words of a command line, expanding
+* variable references as each word is added to the command struct. An alias at the start of words is replaced
+* first, and a definition of an alias or function is recorded and leaves a command with nothing to execute, as
+* does a redirection missing its target, which is reported. words must hold at least one word and is left
+* untouched so that it can be parsed again, e.g. from the rc snapshot
+*/
+struct command* parseWords(char** words) {
 	// declare and initialize a variable used to maintain the numbers of elements in the argv array
 	// of the command struct initialized below. Num args includes NULL as the last element in the argv
 	// array will always be NULL
@@ -299,42 +731,67 @@ struct command* parseUserInput(char* userInput) {
 	// declare and initialize a variable used to maintain the index of where the lastToken exists in the argv
 	// array - this allows setting this element to NULL if lastToken is "&"
 	int lastTokenIndex = 0;
-	// declare and initialize a variable to maintain each token while parsing userInput
-	char* token = NULL;
-	// declare and initialize a variable to maintain the position in userInput while parsing
-	char* savePtr = NULL;
-	// allocate memory large enough to hold userInput plus an additional byte for the null character
-	char* userInputCopy = (char*)malloc((strlen(userInput) + 1) * sizeof(char));
+	// declare and initialize a variable used to maintain the number of prefix assignments found
+	int numAssignments = 0;
+	// declare and initialize a variable used to maintain the number of additional output targets found
+	int numTeeOutputs = 0;
+	// declare and initialize a variable used to maintain the index of the next word to parse
+	int wordIndex = 0;
+	// declare and initialize a variable used to store whether a syntax error drops the command
+	bool dropped = false;
+	// declare and initialize a variable to maintain each word while parsing
+	char* token = words[wordIndex++];
 	// allocate memory large enough to hold the command struct
 	struct command* command = (struct command*)malloc(sizeof(struct command));
 
-	// parsing of userInput will effect userInput. In order to free this memory later, the original
-	// userInput address is preserved by copying the characters into userInputCopy for parsing
-	strcpy(userInputCopy, userInput);
-
-	// get the first token
-	token = strtok_r(userInputCopy, " ", &savePtr);
-	// if the first token is NULL, then the input was empty, if the first character in the first token
-	// is '#', then the user entered a comment - in either case we will just return the user back to the
-	// command prompt
-	if (!token || (*token == '#')) {
-		// free memory allocated by userInputCopy
-		free(userInputCopy);
-		// free memory allocated by command
+	// declare a variable used to store the generator of the words of a token holding a brace expression
+	struct braceGenerator* generator;
+	// declare a variable used to store the words an alias at the start of words is replaced with
+	char** aliasWords = NULL;
+
+	// if the line starts with an alias, build the command from the words it stands for instead - a definition of
+	// an alias is never expanded itself
+	aliasWords = strcmp(words[0], "alias") != 0 ? expandAlias(words) : NULL;
+	if (aliasWords) {
 		free(command);
-		// return a NULL pointer
-		return NULL;
+		command = parseWords(aliasWords);
+		free(aliasWords);
+		return command;
 	}
 
 	// initialize the command struct which will hold components of the parsed userInput
 	initializeCommandStruct(command, numArgs);
 
+	// a definition of an alias or a function is recorded here - like a line of assignments only, there is no
+	// command to execute, so both pathName and argv[0] remain NULL
+	if (defineFromWords(words)) {
+		command->pathName = NULL;
+		return command;
+	}
+
+	// any leading NAME=value tokens are variable assignments rather than the command itself - collect them
+	// into the assignments array of the command struct
+	while (token && isAssignment(token)) {
+		// append the assignment to the assignments array and grow the count of assignments by one
+		command->assignments = appendArg(token, command->assignments, numAssignments + 1, numAssignments);
+		numAssignments++;
+
+		// get the next token
+		token = words[wordIndex++];
+	}
+
+	// if nothing followed the assignments then the line only sets shell variables
+	if (!token) {
+		// there is no command to execute so both pathName and argv[0] remain NULL
+		command->pathName = NULL;
+		// return the address of the command struct holding only assignments
+		return command;
+	}
+
 	// the first token will be the actual command provided by the user and will also be executed by using
-	// the PATH variable if the command is not a built-in command - allocate memory for the pathName 
-	// attribute large enough for the first token plus an additional byte for the null character
-	command->pathName = (char*)malloc((strlen(token) + 1) * sizeof(char));
-	// copy the characters of token into the memory segment allocated for pathName
-	strcpy(command->pathName, token);
+	// the PATH variable if the command is not a built-in command - parse the token to expand any variable
+	// references and remove its quotes, keeping the resulting memory segment as the pathName attribute
+	command->pathName = expandWord(token, false);
 
 	// the first element of argv will also be the command provided by the user based on later usage of
 	// execvp. Set argv[0] equal to the same memory segment that the pathName attribute is equal to
@@ -343,7 +800,7 @@ struct command* parseUserInput(char* userInput) {
 	argvIndex++;
 
 	// get the second token
-	token = strtok_r(NULL, " ", &savePtr);
+	token = words[wordIndex++];
 	// continue parsing userInput until everything has been parsed - when this happens, token will be NULL
 	while (token) {
 		// this if statement is being used to maintain the lastToken found as well as what index position
@@ -366,15 +823,99 @@ struct command* parseUserInput(char* userInput) {
 			strcpy(lastToken, token);
 		}
 
+		// "<<< text" is a here-string - text followed by a newline becomes the input of the command
+		if (strncmp(token, "<<<", 3) == 0 || strncmp(token, "<<", 2) == 0) {
+			// declare and initialize a variable used to store whether this is a here-string
+			bool hereString = strncmp(token, "<<<", 3) == 0;
+			// the text or delimiter may be attached to the operator or be the next word
+			char* word = token[hereString ? 3 : 2] ? token + (hereString ? 3 : 2) : words[wordIndex++];
+
+			// any earlier input redirection is replaced
+			command->inputRedirect = true;
+			free(command->newInput);
+			free(command->hereDelimiter);
+			command->hereDelimiter = NULL;
+			if (command->inputFD != -1) {
+				close(command->inputFD);
+				command->inputFD = -1;
+			}
+
+			if (!word) {
+				printf("syntax error: expected %s after %s\n", hereString ? "a string" : "a delimiter", hereString ? "<<<" : "<<");
+				fflush(stdout);
+				command->newInput = (char*)malloc((strlen("/dev/null") + 1) * sizeof(char));
+				strcpy(command->newInput, "/dev/null");
+				// there is nothing left to parse
+				break;
+			}
+
+			// the name displayed if the body cannot be read
+			command->newInput = (char*)malloc(strlen("here-document") + 1);
+			strcpy(command->newInput, hereString ? "here-string" : "here-document");
+
+			// the text of a here-string is expanded like any other word, and written into its memory file
+			// straight away
+			if (hereString) {
+				char* text = expandWord(word, false);
+				command->inputFD = createHereString(text);
+				free(text);
+			}
+			// the body of a here-document is read once the whole command line has been parsed, without
+			// expansion if any part of the delimiter was quoted or escaped
+			else {
+				command->hereDelimiter = removeQuotes(word);
+				command->hereLiteral = strpbrk(word, "'\"\\") != NULL;
+				command->inputFD = createHereDocument();
+			}
+		}
+		// "< <(command)" and "> >(command)" redirect the input or output of the command to a process substitution
+		else if ((strcmp(token, "<") == 0 || strcmp(token, ">") == 0) && words[wordIndex] &&
+			(*words[wordIndex] == '<' || *words[wordIndex] == '>') && words[wordIndex][1] == '(') {
+			// declare and initialize a variable used to store whether the output is redirected
+			bool output = *token == '>';
+
+			token = joinSubstitution(words[wordIndex++], words, &wordIndex);
+			if (!token) {
+				// the rest of the line belonged to the substitution
+				break;
+			}
+			addSubstitution(command, token, output ? SUBSTITUTED_OUTPUT : SUBSTITUTED_INPUT);
+
+			// the substitution itself is the name displayed if the redirection fails
+			if (output) {
+				command->outputRedirect = true;
+				free(command->newOutput);
+				command->newOutput = token;
+			}
+			else {
+				command->inputRedirect = true;
+				free(command->newInput);
+				command->newInput = token;
+			}
+		}
 		// if a '<' character is encountered then the user has specified input redirection
-		if (strcmp(token, "<") == 0) {
+		else if (strcmp(token, "<") == 0) {
 			// set the inputRedirect attribute to true
 			command->inputRedirect = true;
+			// a later '<' replaces a here-document or here-string
+			if (command->inputFD != -1) {
+				close(command->inputFD);
+				command->inputFD = -1;
+			}
+			free(command->hereDelimiter);
+			command->hereDelimiter = NULL;
 
 			// get the next token since the next token following '<' will be the location to redirect input from
-			token = strtok_r(NULL, " ", &savePtr);
-			// parse the current token to expand any instances of "$$"
-			token = parseArg(token);
+			token = words[wordIndex++];
+			if (!token) {
+				printf("syntax error: expected a file after <\n");
+				fflush(stdout);
+				dropped = true;
+				// there is nothing left to parse
+				break;
+			}
+			// parse the current token to expand any variable references and remove its quotes
+			token = expandWord(token, false);
 			// allocate memory large enough to hold the current token plus an additional byte for the NULL
 			// character
 			command->newInput = (char*)malloc((strlen(token) + 1) * sizeof(char));
@@ -385,14 +926,37 @@ struct command* parseUserInput(char* userInput) {
 			// free the memory allocated for token
 			free(token);
 		}
+		// if a '>' character is encountered again then the output is also copied to another target
+		else if (strcmp(token, ">") == 0 && command->outputRedirect) {
+			// get the next token since the next token following '>' will be the additional output target and
+			// append it to the teeOutputs array attribute
+			token = words[wordIndex++];
+			if (!token) {
+				printf("syntax error: expected a file after >\n");
+				fflush(stdout);
+				dropped = true;
+				// there is nothing left to parse
+				break;
+			}
+			command->teeOutputs = appendArg(token, command->teeOutputs, numTeeOutputs + 1, numTeeOutputs);
+			// increment numTeeOutputs by one
+			numTeeOutputs++;
+		}
 		else if (strcmp(token, ">") == 0) {
 			// set the outputRedirect attribute to true
 			command->outputRedirect = true;
 
 			// get the next token since the next token following '>' will be the location to redirect output to
-			token = strtok_r(NULL, " ", &savePtr);
-			// parse the current token to expand any instances of "$$"
-			token = parseArg(token);
+			token = words[wordIndex++];
+			if (!token) {
+				printf("syntax error: expected a file after >\n");
+				fflush(stdout);
+				dropped = true;
+				// there is nothing left to parse
+				break;
+			}
+			// parse the current token to expand any variable references and remove its quotes
+			token = expandWord(token, false);
 			// allocate memory large enough to hold the current token plus an additional byte for the NULL
 			// character
 			command->newOutput = (char*)malloc((strlen(token) + 1) * sizeof(char));
@@ -403,6 +967,40 @@ struct command* parseUserInput(char* userInput) {
 			// free the memory allocated for token
 			free(token);
 		}
+		// "<(command)" and ">(command)" are replaced with the path of a pipe once the command is executed - until
+		// then the argument holds the substitution itself
+		else if ((*token == '<' || *token == '>') && token[1] == '(') {
+			token = joinSubstitution(token, words, &wordIndex);
+			if (!token) {
+				// the rest of the line belonged to the substitution
+				break;
+			}
+			addSubstitution(command, token, argvIndex);
+			command->argv = appendArg(token, command->argv, numArgs, argvIndex);
+			argvIndex++;
+			numArgs++;
+			free(token);
+		}
+		// a token holding a brace expression stands for the words it produces - the items of a chunked command are
+		// only produced as its batches are filled, so that a range of millions of items is never held in memory
+		else if ((generator = startBraces(token))) {
+			if (isChunkItem(command, argvIndex, words + wordIndex)) {
+				command->braceItems = (struct braceItem*)realloc(command->braceItems, (command->numBraceItems + 1) * sizeof(struct braceItem));
+				command->braceItems[command->numBraceItems].arg = strdup(token);
+				command->braceItems[command->numBraceItems++].generator = generator;
+				command->argv[argvIndex++] = command->braceItems[command->numBraceItems - 1].arg;
+				command->argv = (char**)realloc(command->argv, ++numArgs * sizeof(char*));
+				command->argv[argvIndex] = NULL;
+			}
+			else {
+				command->argv = appendBraces(generator, command->argv, &numArgs, &argvIndex);
+				freeBraces(generator);
+			}
+		}
+		// a token holding an unquoted '*', '?' or '[' is a pattern which is replaced with the paths it matches
+		else if (isPattern(token)) {
+			command->argv = appendMatches(token, command->argv, &numArgs, &argvIndex);
+		}
 		else {
 			// append the current token to the argv array attribute at the index position specified by argvIndex
 			command->argv = appendArg(token, command->argv, numArgs, argvIndex);
@@ -413,7 +1011,7 @@ struct command* parseUserInput(char* userInput) {
 		}
 
 		// get the next token
-		token = strtok_r(NULL, " ", &savePtr);
+		token = words[wordIndex++];
 	}
 
 	// if lastToken is equal to "&" then the command will need to be run as a background process
@@ -435,10 +1033,120 @@ struct command* parseUserInput(char* userInput) {
 		free(lastToken);
 	}
 
-	// free memory allocated for userInput
+	// a command with a syntax error is released and leaves nothing to execute
+	if (dropped) {
+		cleanupMemory(command);
+		droppedCommand = true;
+		return emptyCommand();
+	}
+
+	// return the address of the fully populated command struct
+	return command;
+}
+
+/*
+* Builds the command structs of a pipeline - commands separated by "|" words, each reading the output of the
+* one before it - from the NULL terminated array of unexpanded words of a command line. Each command is built
+* by parseWords and linked to the next through its pipeNext member. An alias at the start of words is replaced
+* and a definition is recorded before words are split, so either may hold "|". A line with an empty command
+* or a command parseWords drops is reported and leaves a command with nothing to execute. words is left untouched
+*/
+struct command* parsePipeline(char** words) {
+	// declare and initialize a variable used to store the number of words
+	int numWords = 0;
+	// declare and initialize a variable used to store whether any word is a "|"
+	bool piped = false;
+	// declare and initialize variables used to store the first and last command of the pipeline
+	struct command* head = NULL;
+	struct command* tail = NULL;
+
+	for (numWords = 0; words[numWords]; numWords++) {
+		piped = piped || strcmp(words[numWords], "|") == 0;
+	}
+
+	// replace an alias first, as its words may hold "|" themselves
+	char** aliasWords = strcmp(words[0], "alias") != 0 ? expandAlias(words) : NULL;
+	if (aliasWords) {
+		head = parsePipeline(aliasWords);
+		free(aliasWords);
+		return head;
+	}
+
+	// a single command is built as it is
+	if (!piped) {
+		return parseWords(words);
+	}
+
+	// the body of a function definition is split when the function is called
+	if (defineFromWords(words)) {
+		return emptyCommand();
+	}
+
+	// build a command from the words of each segment in turn, copied into their own NULL terminated array
+	droppedCommand = false;
+	char** segment = (char**)malloc((numWords + 1) * sizeof(char*));
+	for (int start = 0; start <= numWords; ) {
+		int length = 0;
+		while (words[start + length] && strcmp(words[start + length], "|") != 0) {
+			segment[length] = words[start + length];
+			length++;
+		}
+		segment[length] = NULL;
+
+		// every "|" must have a command on both sides
+		if (length == 0) {
+			printf("syntax error near unexpected token |\n");
+			fflush(stdout);
+			if (head) {
+				cleanupMemory(head);
+			}
+			free(segment);
+			return emptyCommand();
+		}
+
+		struct command* command = parseWords(segment);
+		if (tail) {
+			tail->pipeNext = command;
+		}
+		else {
+			head = command;
+		}
+		tail = command;
+		start += length + 1;
+	}
+	free(segment);
+
+	// a command dropped because of a syntax error drops the whole pipeline
+	if (droppedCommand) {
+		cleanupMemory(head);
+		return emptyCommand();
+	}
+
+	return head;
+}
+
+/*
+* Fully parses the userInput string and sets / updates the appropriate members of the command struct
+* instance that is built for use in executing the user provided command
+*/
+struct command* parseUserInput(char* userInput) {
+	// declare and initialize a variable used to time the parse for the metrics page
+	uint64_t parseStart = metricsClock();
+	// split userInput into its words
+	char** words = splitWords(userInput);
+	// declare a variable used to store the command struct built from the words
+	struct command* command = NULL;
+
+	// if userInput is blank or a comment then there is no command - userInput is left for the caller to free
+	if (!words) {
+		return NULL;
+	}
+
+	// build the command struct from the words, then release the words and userInput
+	command = parsePipeline(words);
+	freeWords(words);
 	free(userInput);
-	// free memory allocated for userInputCopy
-	free(userInputCopy);
+	countParse(parseStart);
 
 	// return the address of the fully populated command struct
 	return command;
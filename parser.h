@@ -12,16 +12,35 @@
 struct command {
 	char* pathName;  // the pathname of the binary executable
 	char** argv;  // an array of arguments
+	char** assignments;  // an array of NAME=value assignments that prefixed the command
 	bool inputRedirect;  // true if input should be redirected, otherwise false
 	char* newInput;  // the file to redirect input from
+	int inputFD;  // a file descriptor holding the body of a here-document or here-string to read input from instead of newInput, -1 if unused
+	char* hereDelimiter;  // the line ending the body of a here-document still to be read, NULL if there is none
+	bool hereLiteral;  // true if the delimiter of the here-document was quoted, which leaves its body unexpanded
 	bool outputRedirect;  // true if output should be redirected, otherwise false
 	char* newOutput;  // the file to redirect output to
+	char** teeOutputs;  // an array of additional files the output is also copied to
+	int outputFD;  // a file descriptor set up by the executor to write output into instead of newOutput, -1 if unused
+	int errorFD;  // a file descriptor set up by the executor to write error output into, -1 to keep that of the shell
 	bool backgroundProcess;  // true if the process should run in the background, otherwise false
+	long timeoutMs;  // the number of milliseconds the command may run before it is signalled, 0 for no limit
+	int timeoutSignal;  // the signal sent to the command once its timeout expires
+	long killAfterMs;  // the number of milliseconds between the timeout signal and SIGKILL
+	int chunkJobs;  // the number of batches of a chunked command that run at once, 0 if the command is not chunked
+	int chunkStart;  // the index in argv of the first argument of a chunked command that is split across batches
+	struct braceItem* braceItems;  // the items of a chunked command holding brace expressions, expanded as its batches are filled
+	int numBraceItems;  // the number of elements in the braceItems array
+	struct processSubstitution* substitutions;  // an array of the "<(command)" and ">(command)" arguments
+	int numSubstitutions;  // the number of elements in the substitutions array
+	bool memoize;  // true if the result of the command is looked up in and added to the memo cache
+	struct placement* placement;  // the CPUs the command is placed on, NULL to inherit those of the shell
+	struct command* pipeNext;  // the next command of a pipeline, whose input is the output of this one, or NULL
 };
 
 /*
 * Displays a colon ":" symbol as a prompt for each command line. Captures any input provided by
-* the user and returns that input as a character pointer.
+* the user and returns that input as a character pointer. NULL is returned once the input has ended.
 */
 char* getCommandLineInput(void);
 
@@ -43,18 +62,104 @@ char* populateCurrExpandedArg(char* currExpandedArg, char* startToken, char* end
 */
 char* updateFinalExpandedArg(char* finalExpandedArg, char* currExpandedArg);
 
+/*
+* Examines the variable reference that begins with the '$' at the address in dollar and returns the text
+* it expands to. "$$" expands into the process ID of smallsh, "$NAME" and "${NAME}" expand into the value
+* of the variable NAME (or nothing if NAME is unset), "$1" to "$9" and "${N}" into the positional
+* parameters of the function being executed, "$#" into their number and "$((EXPRESSION))" into the value of
+* the arithmetic expression (or nothing if it is invalid). Any other '$' is left as is. The address of the
+* first character following the reference is stored in referenceEnd
+*/
+char* expandReference(char* dollar, char** referenceEnd, char* pidString);
+
 /*
 * Parses each individual argument being added to the argv member of the command struct and
-* searches for any instances of "$$". If "$$" is found, it is expanded into the process ID
-* of smallsh itself.
+* searches for any variable references. "$$" is expanded into the process ID of smallsh itself
+* and "$NAME" or "${NAME}" is expanded into the value of the shell variable NAME.
 */
 char* parseArg(char* arg);
 
+/*
+* Returns true if word holds a '*', '?' or '[' that is neither quoted, escaped nor within an arithmetic
+* expansion, which makes it a pattern to be expanded into the paths it matches
+*/
+bool isPattern(char* word);
+
+/*
+* Returns a newly allocated copy of word with its variable references expanded and its quotes and backslash
+* escapes removed. Nothing within single quotes is expanded, and within double quotes a backslash only escapes
+* '$', '"' and '\'. If pattern is true, every quoted or escaped "*?[]\" is preceded with a backslash so that
+* the result can be passed to glob
+*/
+char* expandWord(char* word, bool pattern);
+
+/*
+* Returns a newly allocated copy of word with its quotes and backslash escapes removed, leaving its variable
+* references unexpanded
+*/
+char* removeQuotes(char* word);
+
 /*
 * Appends the current arg to the argv array member of the command struct.
 */
 char** appendArg(char* arg, char* argv[], int numArgs, int argvIndex);
 
+/*
+* Expands the pattern arg, after expanding any variable references, into the paths it matches and appends
+* them to the argv array member of the command struct in one step, updating numArgs and argvIndex. A pattern
+* matching nothing is appended as it is
+*/
+char** appendMatches(char* arg, char* argv[], int* numArgs, int* argvIndex);
+
+/*
+* Replaces each item of a chunked command holding a brace expression with the words it produces, for a command
+* that is given all of its items at once rather than in batches
+*/
+void expandBraceItems(struct command* command);
+
+/*
+* Releases the generators of the items of a chunked command holding brace expressions
+*/
+void freeBraceItems(struct command* command);
+
+/*
+* Removes the first count arguments from the argv array member of the command struct and makes the
+* first remaining argument the new pathName. Used by built-in commands such as "timeout" that prefix
+* another command
+*/
+void removeLeadingArgs(struct command* command, int count);
+
+/*
+* Splits the userInput string into its words without expanding any variable references - words are separated
+* by whitespace outside of quotes and keep their quotes and backslashes until they are expanded. Returns a
+* NULL terminated array of words which must be released with freeWords, or NULL if userInput is blank or a
+* comment
+*/
+char** splitWords(char* userInput);
+
+/*
+* Releases the memory allocated for a NULL terminated array of words returned by splitWords
+*/
+void freeWords(char** words);
+
+/*
+* Builds the command struct from the NULL terminated array of unexpanded words of a command line, expanding
+* variable references as each word is added to the command struct. An alias at the start of words is replaced
+* first, and a definition of an alias or function is recorded and leaves a command with nothing to execute, as
+* does a redirection missing its target, which is reported. words must hold at least one word and is left
+* untouched so that it can be parsed again, e.g. from the rc snapshot
+*/
+struct command* parseWords(char** words);
+
+/*
+* Builds the command structs of a pipeline - commands separated by "|" words, each reading the output of the
+* one before it - from the NULL terminated array of unexpanded words of a command line. Each command is built
+* by parseWords and linked to the next through its pipeNext member. An alias at the start of words is replaced
+* and a definition is recorded before words are split, so either may hold "|". A line with an empty command
+* or a command parseWords drops is reported and leaves a command with nothing to execute. words is left untouched
+*/
+struct command* parsePipeline(char** words);
+
 /*
 * Fully parses the userInput string and sets / updates the appropriate members of the command struct
 * instance that is built for use in executing the user provided command
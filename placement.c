@@ -0,0 +1,652 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Placement of commands on CPUs. "@cpu=LIST" pins a single command and SMALLSH_SPREAD=cores|numa
+*	hands background jobs out round-robin over the online cores or NUMA nodes, so that CPU-bound jobs are not
+*	packed onto the same cores. "@nice=N", "@io=CLASS", "@mem=SIZE" and the ulimit built-in command keep a
+*	runaway job from starving the rest. Everything is applied in the forked child before exec, without a
+*	wrapper process
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sched.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "parser.h"
+#include "variables.h"
+#include "placement.h"
+
+/*
+* A struct representing the places background jobs are spread across, found the first time they are needed
+*/
+struct spreadTargets {
+	int numCores;  // the number of cores the shell itself may run on
+	int* cores;  // the cores the shell itself may run on
+	int numNodes;  // the number of NUMA nodes holding any of those cores
+	cpu_set_t* nodes;  // the cores of each NUMA node the shell may run on
+	unsigned int nextCore;  // the index of the core the next job spread across cores is placed on
+	unsigned int nextNode;  // the index of the node the next job spread across nodes is placed on
+};
+
+// the places background jobs are spread across
+static struct spreadTargets targets = { -1, NULL, -1, NULL, 0, 0 };
+
+// the I/O scheduling classes and the layout of an I/O priority, which glibc has no header for
+#define IOPRIO_CLASS_RT 1
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_WHO_PROCESS 1
+
+/*
+* A struct representing a resource limit the ulimit built-in command knows
+*/
+struct limitType {
+	char option;  // the option of ulimit naming the limit
+	int resource;  // the resource passed to setrlimit
+	char* description;  // the description displayed by "ulimit -a"
+	rlim_t unit;  // the number of bytes (or seconds, or files) in a unit of the values ulimit takes
+};
+
+// the resource limits the ulimit built-in command knows, in the order it lists them - units follow bash
+static struct limitType limitTypes[NUM_LIMITS] = {
+	{ 'c', RLIMIT_CORE, "core file size (KiB)", 1024 },
+	{ 'f', RLIMIT_FSIZE, "file size (KiB)", 1024 },
+	{ 'n', RLIMIT_NOFILE, "open files", 1 },
+	{ 's', RLIMIT_STACK, "stack size (KiB)", 1024 },
+	{ 't', RLIMIT_CPU, "cpu time (seconds)", 1 },
+	{ 'u', RLIMIT_NPROC, "max user processes", 1 },
+	{ 'v', RLIMIT_AS, "virtual memory (KiB)", 1024 },
+};
+
+// the index of the limits that stop a process with a signal of their own, and of the address space limit
+#define CPU_LIMIT 4
+#define FILE_LIMIT 1
+#define MEMORY_LIMIT 6
+
+// the share of its address space limit, in percent, a process must have had resident for a crash to be put down
+// to the limit - the address space also holds mappings that are never touched, so the peak resident set size of a
+// process out of address space stays below the limit itself
+#define MEMORY_LIMIT_RESIDENT_PERCENT 50
+
+/*
+* A struct representing a process started with a CPU time, file size or memory limit
+*/
+struct watchedProcess {
+	pid_t pid;  // the process
+	int flags;  // the flags of the limits placed on it - CPU_LIMIT_FLAG, FILE_LIMIT_FLAG and MEMORY_LIMIT_FLAG
+	rlim_t cpuLimit;  // the CPU time limit in seconds, if any
+	rlim_t memoryLimit;  // the address space limit in bytes, if any
+	struct watchedProcess* next;  // the next watched process
+};
+
+/*
+* A struct representing the shell-wide resource limits set with ulimit and the processes started with limits
+*/
+static struct {
+	bool limited[NUM_LIMITS];  // true for each limit set with ulimit
+	rlim_t limits[NUM_LIMITS];  // the value of each limit set with ulimit
+	struct watchedProcess* watched;  // the processes started with a CPU time, file size or memory limit
+} resourceLimits = { { false }, { 0 }, NULL };
+
+/*
+* Parses a list of CPUs such as "0-3,8" into cpus. Returns false if list is not a valid list
+*/
+static bool parseCpuList(char* list, cpu_set_t* cpus) {
+	CPU_ZERO(cpus);
+
+	while (*list) {
+		char* end;
+		long first, last;
+
+		if (!isdigit((unsigned char)*list)) {
+			return false;
+		}
+		first = last = strtol(list, &end, 10);
+		if (*end == '-') {
+			if (!isdigit((unsigned char)end[1])) {
+				return false;
+			}
+			last = strtol(end + 1, &end, 10);
+		}
+		if (last < first || last >= CPU_SETSIZE || (*end != ',' && *end != '\0' && *end != '\n')) {
+			return false;
+		}
+
+		for (long cpu = first; cpu <= last; cpu++) {
+			CPU_SET(cpu, cpus);
+		}
+		list = (*end == ',') ? end + 1 : end + strlen(end);
+	}
+
+	return CPU_COUNT(cpus) > 0;
+}
+
+/*
+* Writes cpus into buffer as a list such as "0-3,8"
+*/
+static void formatCpuList(cpu_set_t* cpus, char* buffer, size_t size) {
+	// declare and initialize a variable used to store the number of characters written so far
+	size_t length = 0;
+
+	buffer[0] = '\0';
+	for (int cpu = 0; cpu < CPU_SETSIZE && length < size; cpu++) {
+		if (!CPU_ISSET(cpu, cpus)) {
+			continue;
+		}
+
+		// find the end of the run of CPUs starting at cpu
+		int last = cpu;
+		while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, cpus)) {
+			last++;
+		}
+		length += snprintf(buffer + length, size - length, last > cpu ? "%s%d-%d" : "%s%d", length ? "," : "", cpu, last);
+		cpu = last;
+	}
+}
+
+/*
+* Finds the cores the shell may run on and the NUMA nodes holding them, unless that has already been done
+*/
+static void findSpreadTargets(void) {
+	cpu_set_t allowed;
+	DIR* nodeDirectory;
+	struct dirent* entry;
+
+	if (targets.numCores != -1) {
+		return;
+	}
+
+	// the cores of the shell's own affinity, which every job inherits
+	targets.numCores = 0;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+		return;
+	}
+	targets.cores = (int*)malloc(CPU_COUNT(&allowed) * sizeof(int));
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, &allowed)) {
+			targets.cores[targets.numCores++] = cpu;
+		}
+	}
+
+	// the cores of each NUMA node that the shell may run on
+	targets.numNodes = 0;
+	nodeDirectory = opendir(NUMA_NODE_PATH);
+	while (nodeDirectory && (entry = readdir(nodeDirectory))) {
+		char path[sizeof(NUMA_NODE_PATH) + 300];
+		char* list = NULL;
+		size_t capacity = 0;
+		cpu_set_t nodeCpus;
+		FILE* cpuListFile;
+
+		if (strncmp(entry->d_name, "node", 4) != 0 || !isdigit((unsigned char)entry->d_name[4])) {
+			continue;
+		}
+		snprintf(path, sizeof(path), NUMA_NODE_PATH "/%s/cpulist", entry->d_name);
+		cpuListFile = fopen(path, "r");
+		if (cpuListFile && getline(&list, &capacity, cpuListFile) > 0 && parseCpuList(list, &nodeCpus)) {
+			CPU_AND(&nodeCpus, &nodeCpus, &allowed);
+			if (CPU_COUNT(&nodeCpus) > 0) {
+				targets.nodes = (cpu_set_t*)realloc(targets.nodes, (targets.numNodes + 1) * sizeof(cpu_set_t));
+				targets.nodes[targets.numNodes++] = nodeCpus;
+			}
+		}
+		free(list);
+		if (cpuListFile) {
+			fclose(cpuListFile);
+		}
+	}
+	if (nodeDirectory) {
+		closedir(nodeDirectory);
+	}
+
+	// without NUMA information every core is on a single node
+	if (targets.numNodes == 0) {
+		targets.nodes = (cpu_set_t*)malloc(sizeof(cpu_set_t));
+		targets.nodes[0] = allowed;
+		targets.numNodes = 1;
+	}
+}
+
+/*
+* Parses an I/O scheduling class - "idle", "be[:LEVEL]" or "rt[:LEVEL]" with LEVEL from 0 to 7, 4 by default -
+* into the I/O priority passed to ioprio_set. Returns false if class is not a valid class
+*/
+static bool parseIoPriority(char* class, int* ioPriority) {
+	// declare and initialize a variable used to store the level within the class
+	long level = 4;
+	// declare and initialize a variable used to point to the level, if any
+	char* colon = strchr(class, ':');
+	size_t nameLength = colon ? (size_t)(colon - class) : strlen(class);
+	int ioClass;
+
+	if (nameLength == 4 && strncmp(class, "idle", 4) == 0 && !colon) {
+		*ioPriority = IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+		return true;
+	}
+	if (nameLength == 2 && strncmp(class, "be", 2) == 0) {
+		ioClass = IOPRIO_CLASS_BE;
+	}
+	else if (nameLength == 2 && strncmp(class, "rt", 2) == 0) {
+		ioClass = IOPRIO_CLASS_RT;
+	}
+	else {
+		return false;
+	}
+
+	if (colon) {
+		char* end;
+		level = strtol(colon + 1, &end, 10);
+		if (*end != '\0' || end == colon + 1 || level < 0 || level > 7) {
+			return false;
+		}
+	}
+
+	*ioPriority = (ioClass << IOPRIO_CLASS_SHIFT) | level;
+	return true;
+}
+
+/*
+* Parses a size such as "512M" - a number of bytes with an optional K, M, G or T suffix - into size. Returns false
+* if text is not a valid size
+*/
+static bool parseSize(char* text, rlim_t* size) {
+	char* end;
+	unsigned long long value;
+
+	if (!isdigit((unsigned char)*text)) {
+		return false;
+	}
+	value = strtoull(text, &end, 10);
+	switch (toupper((unsigned char)*end)) {
+		case 'T': value <<= 10;  // fall through
+		case 'G': value <<= 10;  // fall through
+		case 'M': value <<= 10;  // fall through
+		case 'K': value <<= 10; end++; break;
+		default: break;
+	}
+	if (*end != '\0' || value == 0) {
+		return false;
+	}
+
+	*size = value;
+	return true;
+}
+
+/*
+* Returns the placement of command, creating it if the command has none yet
+*/
+static struct placement* getPlacement(struct command* command) {
+	if (!command->placement) {
+		command->placement = (struct placement*)calloc(1, sizeof(struct placement));
+	}
+
+	return command->placement;
+}
+
+/*
+* Parses the "@NAME=VALUE" placement prefixes at the start of the argv array of command - "@cpu=LIST" pins the
+* command to the CPUs in LIST, "@nice=N" sets its nice value, "@io=CLASS" its I/O scheduling class and
+* "@mem=SIZE" limits its address space - and strips them so that the remaining command can be executed
+* normally. Returns false after displaying an error message if a prefix is invalid
+*/
+bool applyPlacement(struct command* command) {
+	// declare and initialize a variable used to maintain the index of the prefix being parsed
+	int index = 0;
+
+	for (; command->argv[index] && command->argv[index][0] == '@'; index++) {
+		char* prefix = command->argv[index];
+		char* end;
+		if (strncmp(prefix, CPU_PREFIX, strlen(CPU_PREFIX)) == 0) {
+			if (!parseCpuList(prefix + strlen(CPU_PREFIX), &getPlacement(command)->cpus)) {
+				printf("%s: invalid CPU list\n", prefix);
+				fflush(stdout);
+				return false;
+			}
+		}
+		// "@nice=N" takes a nice value from -20 to 19
+		else if (strncmp(prefix, NICE_PREFIX, strlen(NICE_PREFIX)) == 0) {
+			long nice = strtol(prefix + strlen(NICE_PREFIX), &end, 10);
+			if (*end != '\0' || end == prefix + strlen(NICE_PREFIX) || nice < -20 || nice > 19) {
+				printf("%s: invalid nice value, expected -20 to 19\n", prefix);
+				fflush(stdout);
+				return false;
+			}
+			getPlacement(command)->niced = true;
+			command->placement->nice = nice;
+		}
+		// "@io=idle", "@io=be:LEVEL" or "@io=rt:LEVEL" - best-effort and realtime take a level from 0 to 7
+		else if (strncmp(prefix, IO_PREFIX, strlen(IO_PREFIX)) == 0) {
+			if (!parseIoPriority(prefix + strlen(IO_PREFIX), &getPlacement(command)->ioPriority)) {
+				printf("%s: invalid I/O class, expected idle, be[:0-7] or rt[:0-7]\n", prefix);
+				fflush(stdout);
+				return false;
+			}
+		}
+		// "@mem=SIZE" limits the address space to SIZE bytes, with an optional K, M, G or T suffix
+		else if (strncmp(prefix, MEMORY_PREFIX, strlen(MEMORY_PREFIX)) == 0) {
+			if (!parseSize(prefix + strlen(MEMORY_PREFIX), &getPlacement(command)->limits[MEMORY_LIMIT])) {
+				printf("%s: invalid size\n", prefix);
+				fflush(stdout);
+				return false;
+			}
+			command->placement->limited[MEMORY_LIMIT] = true;
+		}
+		else {
+			printf("%s: unknown placement\n", prefix);
+			fflush(stdout);
+			return false;
+		}
+	}
+
+	// a command to run is required after the prefixes
+	if (!command->argv[index]) {
+		printf("usage: [" CPU_PREFIX "LIST] [" NICE_PREFIX "N] [" IO_PREFIX "CLASS] [" MEMORY_PREFIX "SIZE] command [args...]\n");
+		fflush(stdout);
+		return false;
+	}
+
+	removeLeadingArgs(command, index);
+	return true;
+}
+
+/*
+* Places a background command that was not pinned with "@cpu=" on the next online core, or the CPUs of the
+* next NUMA node, in turn if SMALLSH_SPREAD is "cores" or "numa"
+*/
+void spreadPlacement(struct command* command, int foregroundFlag) {
+	// declare and initialize a variable used to store how background jobs are spread
+	char* spread = getVariable("SMALLSH_SPREAD");
+
+	// only background jobs not pinned to CPUs of their own are spread
+	if (!spread || !command->backgroundProcess || foregroundFlag || (command->placement && CPU_COUNT(&command->placement->cpus) > 0)) {
+		return;
+	}
+
+	if (strcmp(spread, "cores") == 0) {
+		findSpreadTargets();
+		if (targets.numCores > 0) {
+			CPU_SET(targets.cores[targets.nextCore++ % targets.numCores], &getPlacement(command)->cpus);
+		}
+	}
+	else if (strcmp(spread, "numa") == 0) {
+		findSpreadTargets();
+		if (targets.numNodes > 0) {
+			getPlacement(command)->cpus = targets.nodes[targets.nextNode++ % targets.numNodes];
+		}
+	}
+}
+
+/*
+* Adds the shell-wide resource limits set with ulimit to the placement of command, except those the command
+* sets itself
+*/
+void applyLimitDefaults(struct command* command) {
+	for (int index = 0; index < NUM_LIMITS; index++) {
+		if (resourceLimits.limited[index] && !(command->placement && command->placement->limited[index])) {
+			getPlacement(command)->limited[index] = true;
+			command->placement->limits[index] = resourceLimits.limits[index];
+		}
+	}
+}
+
+/*
+* Applies the placement of command to the current process, which must be a forked child of the shell - its
+* CPUs, nice value, I/O priority and resource limits. Returns false after displaying an error message if it
+* cannot be applied
+*/
+bool applyPlacementInChild(struct command* command) {
+	struct placement* placement = command->placement;
+
+	if (!placement) {
+		return true;
+	}
+
+	if (CPU_COUNT(&placement->cpus) > 0 && sched_setaffinity(0, sizeof(cpu_set_t), &placement->cpus) == -1) {
+		char list[256];
+		formatCpuList(&placement->cpus, list, sizeof(list));
+		printf("%s: cannot run on CPUs %s\n", command->pathName, list);
+		fflush(stdout);
+		return false;
+	}
+
+	// a nice value below that of the shell requires privileges
+	if (placement->niced && setpriority(PRIO_PROCESS, 0, placement->nice) == -1) {
+		printf("%s: cannot set nice value %d: %s\n", command->pathName, placement->nice, strerror(errno));
+		fflush(stdout);
+		return false;
+	}
+
+	if (placement->ioPriority && syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, placement->ioPriority) == -1) {
+		printf("%s: cannot set I/O priority: %s\n", command->pathName, strerror(errno));
+		fflush(stdout);
+		return false;
+	}
+
+	// both the soft and the hard limit are set so that the command cannot raise them again
+	for (int index = 0; index < NUM_LIMITS; index++) {
+		struct rlimit limit = { placement->limits[index], placement->limits[index] };
+		if (placement->limited[index] && setrlimit(limitTypes[index].resource, &limit) == -1) {
+			printf("%s: cannot set %s limit: %s\n", command->pathName, limitTypes[index].description, strerror(errno));
+			fflush(stdout);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+* Remembers the CPU time, file size and memory limits placed on the process pid started by command, so that
+* finishLimits can tell whether one of them stopped it
+*/
+void watchLimits(struct command* command, pid_t pid) {
+	// declare and initialize a variable used to store the flags of the limits placed on the process
+	int flags = 0;
+
+	if (!command->placement) {
+		return;
+	}
+	flags |= command->placement->limited[CPU_LIMIT] ? CPU_LIMIT_FLAG : 0;
+	flags |= command->placement->limited[FILE_LIMIT] ? FILE_LIMIT_FLAG : 0;
+	flags |= command->placement->limited[MEMORY_LIMIT] ? MEMORY_LIMIT_FLAG : 0;
+
+	if (flags) {
+		struct watchedProcess* watched = (struct watchedProcess*)malloc(sizeof(struct watchedProcess));
+		watched->pid = pid;
+		watched->flags = flags;
+		watched->cpuLimit = command->placement->limits[CPU_LIMIT];
+		watched->memoryLimit = command->placement->limits[MEMORY_LIMIT];
+		watched->next = resourceLimits.watched;
+		resourceLimits.watched = watched;
+	}
+}
+
+/*
+* Forgets the limits of the process pid, which has terminated with childStatus after using the resources in usage,
+* and returns CPU_LIMIT_FLAG, FILE_LIMIT_FLAG or MEMORY_LIMIT_FLAG if the limit it names stopped the process,
+* otherwise 0
+*/
+int finishLimits(pid_t pid, int childStatus, struct rusage* usage) {
+	// walk the list keeping track of the link that points at the current process
+	for (struct watchedProcess** link = &resourceLimits.watched; *link; link = &(*link)->next) {
+		struct watchedProcess* watched = *link;
+		if (watched->pid != pid) {
+			continue;
+		}
+
+		int flags = watched->flags;
+		rlim_t cpuLimit = watched->cpuLimit;
+		rlim_t memoryLimit = watched->memoryLimit;
+		*link = watched->next;
+		free(watched);
+
+		// the file size limit signals the process with a signal of its own and so does the soft CPU time limit
+		if (!WIFSIGNALED(childStatus)) {
+			return 0;
+		}
+		if (WTERMSIG(childStatus) == SIGXFSZ) {
+			return flags & FILE_LIMIT_FLAG;
+		}
+		if (WTERMSIG(childStatus) == SIGXCPU) {
+			return flags & CPU_LIMIT_FLAG;
+		}
+
+		// the hard CPU time limit is enforced with SIGKILL, and a process out of address space fails to allocate
+		// memory and usually crashes or aborts - any other signal is only put down to one of these limits if the
+		// process actually used up to it, as the same signals are sent for many other reasons
+		if (!usage) {
+			return 0;
+		}
+		long long cpuMicroseconds = (long long)(usage->ru_utime.tv_sec + usage->ru_stime.tv_sec) * 1000000 +
+			usage->ru_utime.tv_usec + usage->ru_stime.tv_usec;
+		if ((flags & CPU_LIMIT_FLAG) && cpuMicroseconds >= (long long)cpuLimit * 1000000) {
+			return CPU_LIMIT_FLAG;
+		}
+		if ((flags & MEMORY_LIMIT_FLAG) && (rlim_t)usage->ru_maxrss * 1024 >= memoryLimit / 100 * MEMORY_LIMIT_RESIDENT_PERCENT) {
+			return MEMORY_LIMIT_FLAG;
+		}
+		return 0;
+	}
+
+	return 0;
+}
+
+/*
+* Displays the resource limit at index in limitTypes - the value set with ulimit, or the limit the shell itself
+* has and every command inherits
+*/
+static void displayLimit(int index, bool showOption) {
+	// declare a variable used to store the limit of the shell itself
+	struct rlimit limit;
+	// declare and initialize a variable used to store the limit displayed
+	rlim_t value = RLIM_INFINITY;
+
+	if (resourceLimits.limited[index]) {
+		value = resourceLimits.limits[index];
+	}
+	else if (getrlimit(limitTypes[index].resource, &limit) == 0) {
+		value = limit.rlim_cur;
+	}
+
+	if (showOption) {
+		printf("%-24s (-%c) ", limitTypes[index].description, limitTypes[index].option);
+	}
+	if (value == RLIM_INFINITY) {
+		printf("unlimited\n");
+	}
+	else {
+		printf("%llu\n", (unsigned long long)(value / limitTypes[index].unit));
+	}
+}
+
+/*
+* Executes the built-in "ulimit" command - ulimit [-a] [-c|-f|-n|-s|-t|-u|-v [VALUE|unlimited]]... - which
+* displays or sets the resource limits placed on every command the shell starts. The shell itself is not
+* limited. The exit value is stored in lastStatus
+*/
+void setResourceLimits(struct command* command, int* lastStatus) {
+	// declare a variable used to store the limit of the shell itself
+	struct rlimit limit;
+
+	*lastStatus = 0;
+
+	// without arguments, or with -a, every limit is displayed
+	if (!command->argv[1] || strcmp(command->argv[1], "-a") == 0) {
+		for (int index = 0; index < NUM_LIMITS; index++) {
+			displayLimit(index, true);
+		}
+		fflush(stdout);
+		return;
+	}
+
+	for (int argIndex = 1; command->argv[argIndex]; argIndex++) {
+		char* option = command->argv[argIndex];
+		int index = 0;
+
+		// find the limit named by the option
+		while (index < NUM_LIMITS && !(option[0] == '-' && option[1] == limitTypes[index].option && option[2] == '\0')) {
+			index++;
+		}
+		if (index == NUM_LIMITS) {
+			printf("ulimit: %s: invalid option\n", option);
+			printf("usage: ulimit [-a] [-c|-f|-n|-s|-t|-u|-v [VALUE|unlimited]]...\n");
+			fflush(stdout);
+			*lastStatus = 1 << 8;
+			return;
+		}
+
+		// an option without a value displays the limit
+		char* text = command->argv[argIndex + 1];
+		if (!text || text[0] == '-') {
+			displayLimit(index, false);
+			continue;
+		}
+		argIndex++;
+
+		// the value is a number of units or "unlimited"
+		rlim_t value = RLIM_INFINITY;
+		if (strcmp(text, "unlimited") != 0) {
+			char* end;
+			unsigned long long units = strtoull(text, &end, 10);
+			if (*end != '\0' || !isdigit((unsigned char)*text)) {
+				printf("ulimit: %s: invalid number\n", text);
+				fflush(stdout);
+				*lastStatus = 1 << 8;
+				return;
+			}
+
+			// the value in bytes must not wrap around or reach RLIM_INFINITY, which would lift the limit instead
+			if (units > (RLIM_INFINITY - 1) / limitTypes[index].unit) {
+				printf("ulimit: %s: value too large\n", text);
+				fflush(stdout);
+				*lastStatus = 1 << 8;
+				return;
+			}
+			value = units * limitTypes[index].unit;
+		}
+
+		// a command cannot be given more than the hard limit of the shell, unless the shell is privileged - the limit
+		// of the shell is only known if getrlimit succeeds
+		bool haveLimit = getrlimit(limitTypes[index].resource, &limit) == 0;
+		if (haveLimit && limit.rlim_max != RLIM_INFINITY &&
+			(value == RLIM_INFINITY || value > limit.rlim_max) && geteuid() != 0) {
+			printf("ulimit: %s: cannot exceed the hard limit\n", limitTypes[index].description);
+			fflush(stdout);
+			*lastStatus = 1 << 8;
+			return;
+		}
+
+		// a limit that matches what every command inherits anyway needs not be set, and one that cannot be compared
+		// with the limit of the shell is always set
+		resourceLimits.limited[index] = value != RLIM_INFINITY || !haveLimit || limit.rlim_cur != RLIM_INFINITY;
+		resourceLimits.limits[index] = value;
+	}
+
+	fflush(stdout);
+}
+
+/*
+* Writes the CPUs the process pid may currently run on into buffer as a list such as "0-3,8", or "-" if they
+* cannot be found
+*/
+void describeAffinity(pid_t pid, char* buffer, size_t size) {
+	cpu_set_t cpus;
+
+	if (sched_getaffinity(pid, sizeof(cpus), &cpus) == -1) {
+		snprintf(buffer, size, "-");
+		return;
+	}
+	formatCpuList(&cpus, buffer, size);
+}
@@ -0,0 +1,97 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the placement of commands - the "@cpu=LIST", "@nice=N", "@io=CLASS" and
+*	"@mem=SIZE" command prefixes, the spreading of background jobs across the online cores or NUMA nodes selected
+*	by SMALLSH_SPREAD and the shell-wide resource limits set with the ulimit built-in command
+*/
+
+// the prefix pinning a command to a list of CPUs, e.g. "@cpu=0-3,8"
+#define CPU_PREFIX "@cpu="
+
+// the prefix setting the nice value of a command, e.g. "@nice=10"
+#define NICE_PREFIX "@nice="
+
+// the prefix setting the I/O scheduling class of a command - "@io=idle", "@io=be:LEVEL" or "@io=rt:LEVEL"
+#define IO_PREFIX "@io="
+
+// the prefix limiting the address space of a command, e.g. "@mem=2G"
+#define MEMORY_PREFIX "@mem="
+
+// the number of resource limits the ulimit built-in command knows
+#define NUM_LIMITS 7
+
+// flags combined with a wait status, like TIMED_OUT_FLAG, to mark a process that was stopped by the CPU time,
+// file size or memory limit placed on it
+#define CPU_LIMIT_FLAG 0x20000
+#define FILE_LIMIT_FLAG 0x40000
+#define MEMORY_LIMIT_FLAG 0x80000
+
+// the directory holding a "nodeN/cpulist" file for every NUMA node
+#define NUMA_NODE_PATH "/sys/devices/system/node"
+
+/*
+* A struct representing where a command is placed
+*/
+struct placement {
+	cpu_set_t cpus;  // the CPUs the command may run on, none to inherit those of the shell
+	bool niced;  // true if the nice value of the command is set
+	int nice;  // the nice value of the command
+	int ioPriority;  // the I/O priority of the command as passed to ioprio_set, 0 to inherit that of the shell
+	bool limited[NUM_LIMITS];  // true for each resource limit set for the command, in the order ulimit lists them
+	rlim_t limits[NUM_LIMITS];  // the value of each resource limit set for the command
+};
+
+/*
+* Parses the "@NAME=VALUE" placement prefixes at the start of the argv array of command - "@cpu=LIST" pins the
+* command to the CPUs in LIST, "@nice=N" sets its nice value, "@io=CLASS" its I/O scheduling class and
+* "@mem=SIZE" limits its address space - and strips them so that the remaining command can be executed
+* normally. Returns false after displaying an error message if a prefix is invalid
+*/
+bool applyPlacement(struct command* command);
+
+/*
+* Places a background command that was not pinned with "@cpu=" on the next online core, or the CPUs of the
+* next NUMA node, in turn if SMALLSH_SPREAD is "cores" or "numa"
+*/
+void spreadPlacement(struct command* command, int foregroundFlag);
+
+/*
+* Adds the shell-wide resource limits set with ulimit to the placement of command, except those the command
+* sets itself
+*/
+void applyLimitDefaults(struct command* command);
+
+/*
+* Applies the placement of command to the current process, which must be a forked child of the shell - its
+* CPUs, nice value, I/O priority and resource limits. Returns false after displaying an error message if it
+* cannot be applied
+*/
+bool applyPlacementInChild(struct command* command);
+
+/*
+* Remembers the CPU time, file size and memory limits placed on the process pid started by command, so that
+* finishLimits can tell whether one of them stopped it
+*/
+void watchLimits(struct command* command, pid_t pid);
+
+/*
+* Forgets the limits of the process pid, which has terminated with childStatus after using the resources in usage,
+* and returns CPU_LIMIT_FLAG, FILE_LIMIT_FLAG or MEMORY_LIMIT_FLAG if the limit it names stopped the process,
+* otherwise 0
+*/
+int finishLimits(pid_t pid, int childStatus, struct rusage* usage);
+
+/*
+* Executes the built-in "ulimit" command - ulimit [-a] [-c|-f|-n|-s|-t|-u|-v [VALUE|unlimited]]... - which
+* displays or sets the resource limits placed on every command the shell starts. The shell itself is not
+* limited. The exit value is stored in lastStatus
+*/
+void setResourceLimits(struct command* command, int* lastStatus);
+
+/*
+* Writes the CPUs the process pid may currently run on into buffer as a list such as "0-3,8", or "-" if they
+* cannot be found
+*/
+void describeAffinity(pid_t pid, char* buffer, size_t size);
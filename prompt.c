@@ -0,0 +1,455 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: A programmable prompt - the PS1 shell variable is split into segments such as \w, \j and \?
+*	whose values are cached and only recomputed when the input they depend on changes
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "events.h"
+#include "variables.h"
+#include "jobs.h"
+#include "prompt.h"
+
+/*
+* A struct representing the state of the prompt
+*/
+struct promptState {
+	char* template;  // a copy of the PS1 value the segments were parsed from
+	struct promptSegment* segments;  // the segments parsed from template
+	char* rendered;  // the prompt rendered from the cached segment values
+	bool dirty;  // true if a segment value changed since rendered was built, otherwise false
+	unsigned long cwdGeneration;  // incremented whenever the current working directory changes
+	unsigned long jobsGeneration;  // incremented whenever the job table changes
+	unsigned long statusGeneration;  // incremented whenever a command finishes
+	int lastStatus;  // the wait status of the last command
+	long elapsedMicroseconds;  // how long the last command took
+};
+
+// the single prompt used by smallsh - every generation starts at 1 so that new segments, which start at
+// generation 0, are computed the first time they are displayed
+static struct promptState prompt = { NULL, NULL, NULL, false, 1, 1, 1, 0, 0 };
+
+/*
+* Returns the current time of the monotonic clock in milliseconds
+*/
+static long nowMilliseconds(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/*
+* Records that the inputs in the provided bitmask - PROMPT_CWD, PROMPT_JOBS and PROMPT_STATUS - have changed
+* so that the segments depending on them are recomputed the next time the prompt is displayed
+*/
+void invalidatePrompt(unsigned int inputs) {
+	if (inputs & PROMPT_CWD) {
+		prompt.cwdGeneration++;
+	}
+	if (inputs & PROMPT_JOBS) {
+		prompt.jobsGeneration++;
+	}
+	if (inputs & PROMPT_STATUS) {
+		prompt.statusGeneration++;
+	}
+}
+
+/*
+* Records the wait status and the elapsed time in microseconds of the command that just finished
+*/
+void setPromptStatus(int lastStatus, long elapsedMicroseconds) {
+	prompt.lastStatus = lastStatus;
+	prompt.elapsedMicroseconds = elapsedMicroseconds;
+	invalidatePrompt(PROMPT_STATUS);
+}
+
+/*
+* Returns the generation of the input the segment depends on. Command segments depend on the current
+* working directory since their output usually does too
+*/
+static unsigned long inputGeneration(struct promptSegment* segment) {
+	switch (segment->type) {
+		case SEGMENT_CWD:
+		case SEGMENT_CWD_BASE:
+		case SEGMENT_COMMAND:
+			return prompt.cwdGeneration;
+		case SEGMENT_JOBS:
+			return prompt.jobsGeneration;
+		case SEGMENT_STATUS:
+		case SEGMENT_ELAPSED:
+			return prompt.statusGeneration;
+		default:
+			return 0;
+	}
+}
+
+/*
+* Replaces the cached value of segment with value and marks the prompt for rendering
+*/
+static void setSegmentValue(struct promptSegment* segment, char* value) {
+	free(segment->value);
+	segment->value = (char*)malloc((strlen(value) + 1) * sizeof(char));
+	strcpy(segment->value, value);
+	prompt.dirty = true;
+}
+
+/*
+* Stops a running command segment, reaping its process. The process is killed if it has not exited by the
+* time its output is closed
+*/
+static void stopSegmentCommand(struct promptSegment* segment) {
+	unregisterEventHandler(&segment->handler);
+	close(segment->handler.fd);
+	if (waitpid(segment->pid, NULL, WNOHANG) == 0) {
+		kill(segment->pid, SIGKILL);
+		waitpid(segment->pid, NULL, 0);
+	}
+	segment->pid = -1;
+}
+
+/*
+* Event loop callback invoked when the output of a command segment is readable
+*/
+static void segmentOutputReadable(struct eventHandler* handler, unsigned int events) {
+	struct promptSegment* segment = (struct promptSegment*)handler->data;
+	char discard[PROMPT_SEGMENT_MAX];
+	ssize_t nread;
+
+	// collect the output, discarding whatever does not fit
+	bool full = segment->outputLength == PROMPT_SEGMENT_MAX - 1;
+	if (!full) {
+		nread = read(handler->fd, segment->output + segment->outputLength, PROMPT_SEGMENT_MAX - 1 - segment->outputLength);
+	}
+	else {
+		nread = read(handler->fd, discard, sizeof(discard));
+	}
+	if (nread > 0) {
+		segment->outputLength += full ? 0 : nread;
+		return;
+	}
+	if (nread == -1 && errno == EINTR) {
+		return;
+	}
+
+	// at end of output, keep the first line as the value of the segment
+	stopSegmentCommand(segment);
+	segment->output[segment->outputLength] = '\0';
+	segment->output[strcspn(segment->output, "\n")] = '\0';
+	setSegmentValue(segment, segment->output);
+	segment->refreshedAt = nowMilliseconds();
+}
+
+/*
+* Starts running the command of a command segment in the background. Its output is collected by the event
+* loop and becomes the value of the segment once the command finishes
+*/
+static void startSegmentCommand(struct promptSegment* segment) {
+	// declare a variable used to store the pipe the command writes its output into
+	int outputPipe[2];
+	// declare and initialize the argv array used to run the command with /bin/sh
+	char* argv[] = { "sh", "-c", segment->text, NULL };
+
+	if (pipe(outputPipe) == -1) {
+		return;
+	}
+	fcntl(outputPipe[0], F_SETFD, FD_CLOEXEC);
+
+	segment->pid = fork();
+	if (segment->pid == -1) {
+		close(outputPipe[0]);
+		close(outputPipe[1]);
+		return;
+	}
+	if (segment->pid == 0) {
+		// the command reads nothing and only its standard output is kept
+		int devNull = open("/dev/null", O_RDWR);
+		dup2(devNull, STDIN_FILENO);
+		dup2(outputPipe[1], STDOUT_FILENO);
+		dup2(devNull, STDERR_FILENO);
+		signal(SIGTSTP, SIG_IGN);
+		execve("/bin/sh", argv, getEnvironment());
+		_exit(127);
+	}
+
+	// collect the output in the event loop, recording which working directory the value belongs to
+	close(outputPipe[1]);
+	segment->outputLength = 0;
+	segment->generation = prompt.cwdGeneration;
+	segment->handler.fd = outputPipe[0];
+	segment->handler.callback = segmentOutputReadable;
+	segment->handler.data = segment;
+	registerEventHandler(&segment->handler, EPOLLIN);
+}
+
+/*
+* Computes the value of a segment that does not run a command
+*/
+static void computeSegment(struct promptSegment* segment) {
+	// declare a buffer large enough to hold any computed value
+	char value[PATH_MAX + 32];
+	// get the home directory, used to abbreviate the current working directory
+	char* home = getVariable("HOME");
+	// declare a variable used to store the exit value of the last command
+	int exitValue = WIFEXITED(prompt.lastStatus) ? WEXITSTATUS(prompt.lastStatus) : 128 + WTERMSIG(prompt.lastStatus);
+
+	switch (segment->type) {
+		case SEGMENT_CWD:
+			// show the home directory and anything beneath it relative to ~
+			if (!getcwd(value, PATH_MAX)) {
+				strcpy(value, "?");
+			}
+			else if (home && home[0] && strncmp(value, home, strlen(home)) == 0 &&
+				(value[strlen(home)] == '/' || value[strlen(home)] == '\0')) {
+				value[0] = '~';
+				memmove(value + 1, value + strlen(home), strlen(value + strlen(home)) + 1);
+			}
+			break;
+		case SEGMENT_CWD_BASE:
+			if (!getcwd(value, PATH_MAX)) {
+				strcpy(value, "?");
+			}
+			else if (strcmp(value, "/") != 0) {
+				memmove(value, strrchr(value, '/') + 1, strlen(strrchr(value, '/')));
+			}
+			break;
+		case SEGMENT_JOBS:
+			sprintf(value, "%d", countJobs());
+			break;
+		case SEGMENT_STATUS:
+			sprintf(value, "%d", exitValue);
+			break;
+		case SEGMENT_ELAPSED:
+			// use milliseconds for short commands, seconds for longer ones and minutes for the longest
+			if (prompt.elapsedMicroseconds < 1000000) {
+				sprintf(value, "%ldms", prompt.elapsedMicroseconds / 1000);
+			}
+			else if (prompt.elapsedMicroseconds < 60000000) {
+				sprintf(value, "%.2fs", prompt.elapsedMicroseconds / 1e6);
+			}
+			else {
+				sprintf(value, "%ldm%02lds", prompt.elapsedMicroseconds / 60000000, prompt.elapsedMicroseconds / 1000000 % 60);
+			}
+			break;
+		default:
+			return;
+	}
+
+	setSegmentValue(segment, value);
+	segment->generation = inputGeneration(segment);
+}
+
+/*
+* Appends a new segment of the provided type holding the first length characters of text to the segments
+* ending at tail and returns the new segment
+*/
+static struct promptSegment* appendSegment(struct promptSegment** tail, enum promptSegmentType type, char* text, int length) {
+	struct promptSegment* segment = (struct promptSegment*)calloc(1, sizeof(struct promptSegment));
+
+	segment->type = type;
+	segment->text = (char*)malloc((length + 1) * sizeof(char));
+	strncpy(segment->text, text, length);
+	segment->text[length] = '\0';
+	segment->pid = -1;
+
+	// literal segments never change, so their value is simply their text
+	if (type == SEGMENT_LITERAL) {
+		segment->value = (char*)malloc((length + 1) * sizeof(char));
+		strcpy(segment->value, segment->text);
+	}
+
+	*tail = segment;
+	return segment;
+}
+
+/*
+* Releases the segments of the prompt, stopping any command segment that is still running
+*/
+static void freeSegments(bool stopCommands) {
+	while (prompt.segments) {
+		struct promptSegment* next = prompt.segments->next;
+		if (prompt.segments->pid != -1) {
+			if (stopCommands) {
+				stopSegmentCommand(prompt.segments);
+			}
+			else {
+				close(prompt.segments->handler.fd);
+			}
+		}
+		free(prompt.segments->text);
+		free(prompt.segments->value);
+		free(prompt.segments);
+		prompt.segments = next;
+	}
+}
+
+/*
+* Splits the template into a list of segments. A backslash followed by w, W, j, ?, or T starts the segment of
+* the same name, \(command) starts a command segment, \n is a newline and \\ is a backslash. Everything else
+* is literal text
+*/
+static void parseTemplate(char* template) {
+	// declare and initialize a variable pointing at the link the next segment is stored in
+	struct promptSegment** tail = &prompt.segments;
+	// declare and initialize a variable used to store the start of the current literal text
+	char* literal = template;
+	// declare and initialize a variable used to walk the template
+	char* current = template;
+
+	// release the segments of the previous template and keep a copy of the new one
+	freeSegments(true);
+	free(prompt.template);
+	prompt.template = (char*)malloc((strlen(template) + 1) * sizeof(char));
+	strcpy(prompt.template, template);
+	prompt.dirty = true;
+
+	while (*current) {
+		// declare and initialize a variable used to store the type of segment an escape starts
+		enum promptSegmentType type = SEGMENT_LITERAL;
+		// declare a variable pointing at the end of a command segment
+		char* closing;
+
+		if (*current != '\\' || !current[1]) {
+			current++;
+			continue;
+		}
+
+		// end the literal text that comes before the escape
+		if (current > literal) {
+			tail = &appendSegment(tail, SEGMENT_LITERAL, literal, current - literal)->next;
+		}
+
+		switch (current[1]) {
+			case 'w': type = SEGMENT_CWD; break;
+			case 'W': type = SEGMENT_CWD_BASE; break;
+			case 'j': type = SEGMENT_JOBS; break;
+			case '?': type = SEGMENT_STATUS; break;
+			case 'T': type = SEGMENT_ELAPSED; break;
+			case 'n': tail = &appendSegment(tail, SEGMENT_LITERAL, "\n", 1)->next; break;
+			case '(':
+				// the command runs up to the closing parenthesis - without one the rest is literal text
+				closing = strchr(current + 2, ')');
+				if (closing) {
+					tail = &appendSegment(tail, SEGMENT_COMMAND, current + 2, closing - current - 2)->next;
+					current = closing - 1;
+				}
+				else {
+					tail = &appendSegment(tail, SEGMENT_LITERAL, current, 2)->next;
+				}
+				break;
+			default:
+				// any other escaped character, including a backslash, stands for itself
+				tail = &appendSegment(tail, SEGMENT_LITERAL, current + 1, 1)->next;
+				break;
+		}
+		if (type != SEGMENT_LITERAL) {
+			tail = &appendSegment(tail, type, "", 0)->next;
+		}
+
+		// skip past the escape
+		current += 2;
+		literal = current;
+	}
+
+	// add any literal text left at the end of the template
+	if (current > literal) {
+		appendSegment(tail, SEGMENT_LITERAL, literal, current - literal);
+	}
+}
+
+/*
+* Returns the prompt to display. If PS1 is not set the prompt is ": ", otherwise PS1 is rendered from the
+* cached values of its segments. The returned string belongs to the prompt and must not be freed
+*/
+char* getPrompt(void) {
+	// get the prompt template and the number of seconds command segments are cached for
+	char* template = getVariable("PS1");
+	char* ttlValue = getVariable("PS1_TTL");
+	long ttlMilliseconds = (ttlValue ? atol(ttlValue) : DEFAULT_PROMPT_TTL) * 1000;
+	// declare and initialize a variable used to store the current time, only looked up when needed
+	long now = -1;
+	// declare and initialize a variable used to store the length of the rendered prompt
+	size_t length = 1;
+
+	// without a template the prompt is the classic ": "
+	if (!template) {
+		return ": ";
+	}
+
+	// parse the template again only when PS1 has changed
+	if (!prompt.template || strcmp(template, prompt.template) != 0) {
+		parseTemplate(template);
+	}
+
+	// bring every segment up to date
+	for (struct promptSegment* segment = prompt.segments; segment; segment = segment->next) {
+		if (segment->type == SEGMENT_LITERAL) {
+			continue;
+		}
+		if (segment->type != SEGMENT_COMMAND) {
+			if (segment->generation != inputGeneration(segment)) {
+				computeSegment(segment);
+			}
+			continue;
+		}
+
+		// a command segment that is not already running is rerun when the working directory changed or its
+		// value has expired
+		if (segment->pid == -1) {
+			if (segment->generation != prompt.cwdGeneration) {
+				startSegmentCommand(segment);
+			}
+			else {
+				now = now == -1 ? nowMilliseconds() : now;
+				if (now - segment->refreshedAt >= ttlMilliseconds) {
+					startSegmentCommand(segment);
+				}
+			}
+		}
+	}
+
+	// render the prompt again only if a segment value changed
+	if (prompt.dirty) {
+		for (struct promptSegment* segment = prompt.segments; segment; segment = segment->next) {
+			length += segment->value ? strlen(segment->value) : 0;
+		}
+		free(prompt.rendered);
+		prompt.rendered = (char*)calloc(length, sizeof(char));
+		for (struct promptSegment* segment = prompt.segments; segment; segment = segment->next) {
+			if (segment->value) {
+				strcat(prompt.rendered, segment->value);
+			}
+		}
+		prompt.dirty = false;
+	}
+
+	return prompt.rendered;
+}
+
+/*
+* Releases all memory allocated for the prompt
+*/
+void cleanupPrompt(void) {
+	// the epoll instance and any running command segments are shared with forked children, so they are left
+	// alone and only the memory and file descriptors are released
+	freeSegments(false);
+	free(prompt.template);
+	free(prompt.rendered);
+	prompt.template = NULL;
+	prompt.rendered = NULL;
+}
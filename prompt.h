@@ -0,0 +1,72 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the programmable prompt, which renders the PS1 shell variable from segments
+*	whose values are cached until their inputs change
+*/
+
+// the inputs a prompt segment can depend on - passed to invalidatePrompt when one of them changes
+#define PROMPT_CWD 0x1  // the current working directory
+#define PROMPT_JOBS 0x2  // the job table
+#define PROMPT_STATUS 0x4  // the status and elapsed time of the last command
+
+// the number of seconds a command segment is cached for when PS1_TTL is not set
+#define DEFAULT_PROMPT_TTL 5
+
+// the maximum number of bytes of output kept from a command segment
+#define PROMPT_SEGMENT_MAX 256
+
+/*
+* The kinds of segment a prompt template is made of
+*/
+enum promptSegmentType {
+	SEGMENT_LITERAL,  // text copied into the prompt as is
+	SEGMENT_CWD,  // \w - the current working directory with $HOME shown as ~
+	SEGMENT_CWD_BASE,  // \W - the last component of the current working directory
+	SEGMENT_JOBS,  // \j - the number of jobs in the job table
+	SEGMENT_STATUS,  // \? - the exit value of the last command, or 128 plus the signal that terminated it
+	SEGMENT_ELAPSED,  // \T - how long the last command took
+	SEGMENT_COMMAND  // \(command) - the first line of output of a command run by /bin/sh
+};
+
+/*
+* A struct representing one segment of the prompt template. The value of a segment is only recomputed when
+* the generation of the input it depends on moves past the generation it was computed at. Command segments
+* are also recomputed once their value is PS1_TTL seconds old, and they run in the background so that the
+* prompt is never held up by them - the previous value is displayed until the new one arrives
+*/
+struct promptSegment {
+	enum promptSegmentType type;  // the kind of segment
+	char* text;  // the literal text or the command to run
+	char* value;  // the cached value of the segment
+	unsigned long generation;  // the generation of the segment's input when value was computed
+	long refreshedAt;  // the monotonic time in milliseconds when a command segment last produced a value
+	pid_t pid;  // the process running a command segment, or -1 if it is not running
+	struct eventHandler handler;  // the event loop handler reading the output of a running command segment
+	char output[PROMPT_SEGMENT_MAX];  // the output collected from a running command segment
+	size_t outputLength;  // the number of bytes in output
+	struct promptSegment* next;  // the next segment of the prompt
+};
+
+/*
+* Records that the inputs in the provided bitmask - PROMPT_CWD, PROMPT_JOBS and PROMPT_STATUS - have changed
+* so that the segments depending on them are recomputed the next time the prompt is displayed
+*/
+void invalidatePrompt(unsigned int inputs);
+
+/*
+* Records the wait status and the elapsed time in microseconds of the command that just finished
+*/
+void setPromptStatus(int lastStatus, long elapsedMicroseconds);
+
+/*
+* Returns the prompt to display. If PS1 is not set the prompt is ": ", otherwise PS1 is rendered from the
+* cached values of its segments. The returned string belongs to the prompt and must not be freed
+*/
+char* getPrompt(void);
+
+/*
+* Releases all memory allocated for the prompt
+*/
+void cleanupPrompt(void);
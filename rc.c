@@ -0,0 +1,355 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Loads the startup file ~/.smallshrc. The split words of its command lines are recorded in a word
+*	snapshot file which later shells memory map, so reading and splitting the startup file is kept off the start
+*	up path of short-lived shells. Parsing is not cached - it expands variables and aliases, which earlier
+*	command lines of the startup file may change - so each command line still goes through the parser, the
+*	here-document reader and the optimizer just like one entered at the prompt
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "commandExecution.h"
+#include "memory.h"
+#include "variables.h"
+#include "heredoc.h"
+#include "optimizer.h"
+#include "rc.h"
+
+/*
+* A struct representing the records of a snapshot while they are being built
+*/
+struct snapshotBuffer {
+	char* data;  // the records built so far
+	size_t length;  // the number of bytes in data
+	size_t capacity;  // the number of bytes data can hold
+	uint32_t numLines;  // the number of records in data
+};
+
+/*
+* Appends length bytes starting at bytes to the snapshot buffer
+*/
+static void appendBytes(struct snapshotBuffer* buffer, void* bytes, size_t length) {
+	// grow the buffer if the bytes do not fit
+	if (buffer->length + length > buffer->capacity) {
+		while (buffer->length + length > buffer->capacity) {
+			buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+		}
+		buffer->data = (char*)realloc(buffer->data, buffer->capacity);
+	}
+
+	memcpy(buffer->data + buffer->length, bytes, length);
+	buffer->length += length;
+}
+
+/*
+* Appends a record holding the NULL terminated array of words of a command line to the snapshot buffer
+*/
+static void appendWords(struct snapshotBuffer* buffer, char** words) {
+	uint32_t numWords = 0;
+
+	while (words[numWords]) {
+		numWords++;
+	}
+	appendBytes(buffer, &numWords, sizeof(numWords));
+	for (uint32_t word = 0; word < numWords; word++) {
+		appendBytes(buffer, words[word], strlen(words[word]) + 1);
+	}
+	buffer->numLines++;
+}
+
+/*
+* Appends a record holding a line of the body of a here-document to the snapshot buffer - a word count of 0
+* followed by the line
+*/
+static void appendBodyLine(struct snapshotBuffer* buffer, char* line) {
+	uint32_t numWords = 0;
+
+	appendBytes(buffer, &numWords, sizeof(numWords));
+	appendBytes(buffer, line, strlen(line) + 1);
+	buffer->numLines++;
+}
+
+/*
+* Parses the NULL terminated array of words of a command line into a command struct and executes it as a
+* foreground command. The bodies of its here-documents are read from the NULL terminated array bodyLines and
+* the command is then rewritten just like in the interactive loop
+*/
+static void executeWords(char** words, char** bodyLines, struct dynamicArray* backgroundPids, int* lastStatus) {
+	struct command* command = parsePipeline(words);
+
+	readHereDocuments(command, &bodyLines);
+	command = optimizeCommand(command);
+	executeCommand(command, backgroundPids, lastStatus, 0);
+	cleanupMemory(command);
+}
+
+/*
+* Executes the numLines records starting at cursor, which must have been checked already. The words of each
+* command line and the lines of the here-document bodies that follow it point straight into the records
+*/
+static void executeRecords(char* cursor, uint32_t numLines, struct dynamicArray* backgroundPids, int* lastStatus) {
+	for (uint32_t line = 0; line < numLines;) {
+		uint32_t numWords;
+		memcpy(&numWords, cursor, sizeof(numWords));
+		cursor += sizeof(numWords);
+
+		// a body line without a command line before it is skipped
+		if (numWords == 0) {
+			cursor += strlen(cursor) + 1;
+			line++;
+			continue;
+		}
+
+		char** words = (char**)malloc((numWords + 1) * sizeof(char*));
+		for (uint32_t word = 0; word < numWords; word++) {
+			words[word] = cursor;
+			cursor += strlen(cursor) + 1;
+		}
+		words[numWords] = NULL;
+		line++;
+
+		// collect the body lines recorded after the command line
+		int numBodyLines = 0;
+		char** bodyLines = (char**)malloc(sizeof(char*));
+		while (line < numLines && memcmp(cursor, &(uint32_t){ 0 }, sizeof(uint32_t)) == 0) {
+			cursor += sizeof(uint32_t);
+			bodyLines = (char**)realloc(bodyLines, (numBodyLines + 2) * sizeof(char*));
+			bodyLines[numBodyLines++] = cursor;
+			cursor += strlen(cursor) + 1;
+			line++;
+		}
+		bodyLines[numBodyLines] = NULL;
+
+		executeWords(words, bodyLines, backgroundPids, lastStatus);
+		free(bodyLines);
+		free(words);
+	}
+}
+
+/*
+* Returns the path of the file at relativePath within the home directory, which must be freed by the caller,
+* or NULL if HOME is not set
+*/
+static char* homePath(char* relativePath) {
+	char* home = getVariable("HOME");
+	char* path;
+
+	if (!home || !home[0]) {
+		return NULL;
+	}
+
+	path = (char*)malloc((strlen(home) + strlen(relativePath) + 2) * sizeof(char));
+	sprintf(path, "%s/%s", home, relativePath);
+	return path;
+}
+
+/*
+* Memory maps the snapshot at snapshotPath and, if it was recorded from the startup file described by
+* rcInfo and is intact, executes the command lines it holds. Returns false without executing anything if
+* the snapshot cannot be used
+*/
+static bool runSnapshot(char* snapshotPath, struct stat* rcInfo, struct dynamicArray* backgroundPids, int* lastStatus) {
+	// declare a variable used to store the size of the snapshot
+	struct stat info;
+	// declare a variable used to store the header of the snapshot
+	struct snapshotHeader* header;
+	// declare a variable used to walk the records of the snapshot
+	char* cursor;
+	// declare a variable pointing one past the last byte of the snapshot
+	char* end;
+	// open the snapshot
+	int snapshotFD = open(snapshotPath, O_RDONLY | O_CLOEXEC);
+
+	if (snapshotFD == -1) {
+		return false;
+	}
+	if (fstat(snapshotFD, &info) == -1 || info.st_size < (off_t)sizeof(struct snapshotHeader)) {
+		close(snapshotFD);
+		return false;
+	}
+
+	// map the whole snapshot - the mapping stays valid after the file descriptor is closed
+	header = (struct snapshotHeader*)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, snapshotFD, 0);
+	close(snapshotFD);
+	if (header == MAP_FAILED) {
+		return false;
+	}
+
+	// the snapshot is only valid for the exact startup file it was recorded from
+	if (memcmp(header->magic, RC_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+		header->device != (uint64_t)rcInfo->st_dev || header->inode != (uint64_t)rcInfo->st_ino ||
+		header->size != (int64_t)rcInfo->st_size ||
+		header->modifiedSeconds != (int64_t)rcInfo->st_mtim.tv_sec ||
+		header->modifiedNanoseconds != (int64_t)rcInfo->st_mtim.tv_nsec ||
+		header->dataLength != (uint64_t)(info.st_size - sizeof(struct snapshotHeader))) {
+		munmap(header, info.st_size);
+		return false;
+	}
+
+	// check that every record lies within the snapshot before executing any of them, so that a damaged
+	// snapshot is never partly executed
+	cursor = (char*)(header + 1);
+	end = (char*)header + info.st_size;
+	for (uint32_t line = 0; line < header->numLines; line++) {
+		uint32_t numWords;
+		if (end - cursor < (ptrdiff_t)sizeof(numWords)) {
+			munmap(header, info.st_size);
+			return false;
+		}
+		memcpy(&numWords, cursor, sizeof(numWords));
+		cursor += sizeof(numWords);
+		// a record of a body line holds the line in place of the words
+		for (uint32_t word = 0; word < (numWords ? numWords : 1); word++) {
+			char* terminator = memchr(cursor, '\0', end - cursor);
+			if (!terminator) {
+				munmap(header, info.st_size);
+				return false;
+			}
+			cursor = terminator + 1;
+		}
+	}
+
+	// execute each record, pointing the words straight into the mapping
+	executeRecords((char*)(header + 1), header->numLines, backgroundPids, lastStatus);
+
+	munmap(header, info.st_size);
+	return true;
+}
+
+/*
+* Writes the records in buffer to a new snapshot for the startup file described by rcInfo. The snapshot is
+* written to a temporary file that is renamed into place so that a shell never maps a partial snapshot
+*/
+static void writeSnapshot(char* snapshotPath, struct stat* rcInfo, struct snapshotBuffer* buffer) {
+	struct snapshotHeader header = { { 0 } };
+	char* directory = homePath(RC_SNAPSHOT_DIRECTORY);
+	char* temporaryPath = (char*)malloc((strlen(snapshotPath) + 8) * sizeof(char));
+	int snapshotFD;
+
+	// create the cache directory one level at a time
+	for (char* slash = strchr(directory + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+		*slash = '\0';
+		mkdir(directory, 0700);
+		*slash = '/';
+	}
+	mkdir(directory, 0700);
+	free(directory);
+
+	// describe the startup file the records belong to
+	memcpy(header.magic, RC_SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.numLines = buffer->numLines;
+	header.device = rcInfo->st_dev;
+	header.inode = rcInfo->st_ino;
+	header.size = rcInfo->st_size;
+	header.modifiedSeconds = rcInfo->st_mtim.tv_sec;
+	header.modifiedNanoseconds = rcInfo->st_mtim.tv_nsec;
+	header.dataLength = buffer->length;
+
+	// write the header and the records, then move the snapshot into place
+	sprintf(temporaryPath, "%s.XXXXXX", snapshotPath);
+	snapshotFD = mkstemp(temporaryPath);
+	if (snapshotFD != -1) {
+		bool written = write(snapshotFD, &header, sizeof(header)) == sizeof(header) &&
+			(buffer->length == 0 || write(snapshotFD, buffer->data, buffer->length) == (ssize_t)buffer->length);
+		close(snapshotFD);
+		if (!written || rename(temporaryPath, snapshotPath) == -1) {
+			unlink(temporaryPath);
+		}
+	}
+
+	free(temporaryPath);
+}
+
+/*
+* Reads and splits every command line of the startup file at rcPath, records the words and the lines of any
+* here-document bodies in a new snapshot and executes the command lines
+*/
+static void runStartupFile(char* rcPath, char* snapshotPath, struct stat* rcInfo, struct dynamicArray* backgroundPids, int* lastStatus) {
+	struct snapshotBuffer buffer = { NULL, 0, 0, 0 };
+	char** delimiters = NULL;
+	int delimiterIndex = 0;
+	char* line = NULL;
+	size_t length = 0;
+	ssize_t nread;
+	FILE* rcFile = fopen(rcPath, "r");
+
+	if (!rcFile) {
+		return;
+	}
+
+	// split every line first, recording the words of each command line in the snapshot buffer
+	while ((nread = getline(&line, &length, rcFile)) != -1) {
+		if (nread > 0 && line[nread - 1] == '\n') {
+			line[nread - 1] = '\0';
+		}
+
+		// the lines following a command line that starts here-documents are their bodies, up to the line holding
+		// the delimiter of the last one
+		if (delimiters) {
+			appendBodyLine(&buffer, line);
+			if (strcmp(line, delimiters[delimiterIndex]) == 0 && !delimiters[++delimiterIndex]) {
+				freeWords(delimiters);
+				delimiters = NULL;
+			}
+			continue;
+		}
+
+		char** words = splitWords(line);
+		if (!words) {
+			continue;
+		}
+		appendWords(&buffer, words);
+		delimiters = findHereDelimiters(words);
+		delimiterIndex = 0;
+		freeWords(words);
+	}
+	if (delimiters) {
+		freeWords(delimiters);
+	}
+	free(line);
+	fclose(rcFile);
+
+	// save the snapshot before executing anything, since a command line may well end the shell
+	writeSnapshot(snapshotPath, rcInfo, &buffer);
+
+	// execute the command lines in order
+	executeRecords(buffer.data, buffer.numLines, backgroundPids, lastStatus);
+	free(buffer.data);
+}
+
+/*
+* Executes every command line of the startup file ~/.smallshrc as if it had been entered at the prompt. If a
+* word snapshot matching the startup file exists, it is memory mapped and its pre-split words are parsed and
+* executed instead of reading the startup file; otherwise the word snapshot is written for the next shell
+*/
+void loadStartupFile(struct dynamicArray* backgroundPids, int* lastStatus) {
+	// find the startup file and the snapshot kept for it
+	char* rcPath = homePath(RC_FILE_NAME);
+	char* snapshotPath = homePath(RC_SNAPSHOT_DIRECTORY "/" RC_SNAPSHOT_NAME);
+	struct stat rcInfo;
+
+	// use the snapshot when it is still valid, otherwise read the startup file and write a new snapshot -
+	// without a startup file there is nothing to do
+	if (rcPath && stat(rcPath, &rcInfo) == 0 && S_ISREG(rcInfo.st_mode) &&
+		!runSnapshot(snapshotPath, &rcInfo, backgroundPids, lastStatus)) {
+		runStartupFile(rcPath, snapshotPath, &rcInfo, backgroundPids, lastStatus);
+	}
+
+	free(rcPath);
+	free(snapshotPath);
+}
@@ -0,0 +1,44 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the startup file ~/.smallshrc and the word snapshot of its split command lines
+*	that lets later shells skip reading and splitting it - the words are still parsed on every start up
+*/
+
+// the name of the startup file within the home directory
+#define RC_FILE_NAME ".smallshrc"
+
+// the directory within the home directory where the word snapshot of the startup file is kept
+#define RC_SNAPSHOT_DIRECTORY ".cache/smallsh"
+
+// the name of the snapshot file within RC_SNAPSHOT_DIRECTORY
+#define RC_SNAPSHOT_NAME "smallshrc.snapshot"
+
+// identifies a snapshot file and the version of its layout
+#define RC_SNAPSHOT_MAGIC "SMSHRC04"
+
+/*
+* A struct representing the header of a word snapshot file. It is followed by numLines records, each made up of a
+* 32 bit word count and that many NULL terminated words, or of a word count of 0 and a NULL terminated line of
+* the body of a here-document started by the command line before it. The snapshot is only used while the device, inode,
+* size and modification time of the startup file still match the ones recorded here
+*/
+struct snapshotHeader {
+	char magic[8];  // RC_SNAPSHOT_MAGIC
+	uint32_t numLines;  // the number of command lines recorded in the snapshot
+	uint32_t reserved;  // unused, keeps the following members aligned
+	uint64_t device;  // the device the startup file is stored on
+	uint64_t inode;  // the inode of the startup file
+	int64_t size;  // the size of the startup file in bytes
+	int64_t modifiedSeconds;  // the modification time of the startup file, seconds part
+	int64_t modifiedNanoseconds;  // the modification time of the startup file, nanoseconds part
+	uint64_t dataLength;  // the number of bytes of records following the header
+};
+
+/*
+* Executes every command line of the startup file ~/.smallshrc as if it had been entered at the prompt. If a
+* word snapshot matching the startup file exists, it is memory mapped and its pre-split words are parsed and
+* executed instead of reading the startup file; otherwise the word snapshot is written for the next shell
+*/
+void loadStartupFile(struct dynamicArray* backgroundPids, int* lastStatus);
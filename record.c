@@ -0,0 +1,73 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Records the command lines of a session with the time between them, so that real sessions can
+*	be replayed against smallsh by replayDriver
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include "record.h"
+
+/*
+* A struct representing the recording being written
+*/
+struct recording {
+	int fd;  // the file the recording is written to, -1 if the session is not being recorded
+	struct timespec lastArrival;  // the time the previous command line arrived, or recording started
+};
+
+// the single recording of the session
+static struct recording recording = { -1 };
+
+/*
+* Starts recording every command line read from the user into the file at path, replacing anything in it.
+* Returns false after displaying an error message if the file cannot be opened
+*/
+bool startRecording(char* path) {
+	// commands must not inherit the recording
+	recording.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+	if (recording.fd == -1) {
+		perror(path);
+		return false;
+	}
+
+	dprintf(recording.fd, "%s\n", RECORDING_HEADER);
+	clock_gettime(CLOCK_MONOTONIC, &recording.lastArrival);
+	return true;
+}
+
+/*
+* Appends userInput to the recording, along with the time that has passed since the previous command line
+* arrived. Nothing happens if no recording was started
+*/
+void recordLine(char* userInput) {
+	// declare a variable used to store the time the command line arrived
+	struct timespec arrival;
+
+	if (recording.fd == -1) {
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &arrival);
+	int64_t elapsed = (arrival.tv_sec - recording.lastArrival.tv_sec) * 1000000LL + (arrival.tv_nsec - recording.lastArrival.tv_nsec) / 1000;
+	recording.lastArrival = arrival;
+
+	// the file is written without buffering, so the recording is complete even if the shell is killed
+	dprintf(recording.fd, "%lld\t%s\n", (long long)elapsed, userInput);
+}
+
+/*
+* Closes the recording, if there is one
+*/
+void stopRecording(void) {
+	if (recording.fd != -1) {
+		close(recording.fd);
+		recording.fd = -1;
+	}
+}
@@ -0,0 +1,31 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for recording the command lines of a session, with their timing, so that the
+*	session can be replayed later by replayDriver
+*
+* Format: a recording is a text file. Lines starting with '#' are comments, every other line holds the
+* number of microseconds since the previous command line arrived (since the shell started for the first
+* one), a tab and the command line itself
+*/
+
+// the first line of every recording
+#define RECORDING_HEADER "# smallsh recording: microseconds since the previous line, a tab, the command line"
+
+/*
+* Starts recording every command line read from the user into the file at path, replacing anything in it.
+* Returns false after displaying an error message if the file cannot be opened
+*/
+bool startRecording(char* path);
+
+/*
+* Appends userInput to the recording, along with the time that has passed since the previous command line
+* arrived. Nothing happens if no recording was started
+*/
+void recordLine(char* userInput);
+
+/*
+* Closes the recording, if there is one
+*/
+void stopRecording(void);
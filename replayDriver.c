@@ -0,0 +1,312 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Load generator replaying a session recorded with "smallsh --record FILE" against one or many
+*	concurrent smallsh instances, reporting throughput, latency percentiles and error counts
+*
+* Usage: ./replayDriver [-c INSTANCES] [-s SPEED] [-n LOOPS] RECORDING [SMALLSH]
+*	SMALLSH (default ./smallsh) is started INSTANCES (default 1) times with --norc and each instance is fed the
+*	command lines of RECORDING LOOPS (default 1) times. SPEED scales the recorded time between lines - 1 (the
+*	default) replays them in real time, 10 ten times faster - and "max" sends each line as soon as the previous
+*	one has finished. A line is never sent before the previous one has finished, which smallsh signals by
+*	displaying its prompt: the driver sets PS1 to a marker holding the exit value of the line
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// the bytes surrounding the exit value in the prompt of a replayed instance
+#define MARKER_START '\036'
+#define MARKER_END '\037'
+
+/*
+* A struct representing a command line of the recording
+*/
+struct recordedLine {
+	double delay;  // the microseconds between the previous line and this one when recorded
+	char* text;  // the command line, ending in '\n'
+};
+
+/*
+* A struct representing a running smallsh instance being fed the recording
+*/
+struct instance {
+	pid_t pid;  // the pid of the instance
+	int inputFD;  // the pipe the instance reads command lines from, -1 once closed
+	int outputFD;  // the pipe the instance writes its prompts and output to, -1 at end of output
+	int nextLine;  // the index of the next line to send
+	int loopsLeft;  // the number of times the recording is still to be sent after this one
+	bool waiting;  // true while a line has been sent and its prompt has not been seen
+	bool ready;  // true once the first prompt has been seen
+	bool inMarker;  // true while the exit value in a prompt is being read
+	int markerStatus;  // the exit value read so far
+	double sentAt;  // the time the last line was sent
+	double dueAt;  // the time the next line is due
+};
+
+/*
+* Returns the current time of the monotonic clock in microseconds
+*/
+static double nowMicroseconds(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+/*
+* Compares two latencies for qsort
+*/
+static int compareLatencies(const void* first, const void* second) {
+	double difference = *(const double*)first - *(const double*)second;
+	return (difference > 0) - (difference < 0);
+}
+
+/*
+* Reads the recording at path into lines, returning the number of command lines or -1 if it cannot be read
+*/
+static int readRecording(char* path, struct recordedLine** lines) {
+	FILE* recordingFile = fopen(path, "r");
+	char* line = NULL;
+	size_t length = 0;
+	ssize_t nread;
+	int numLines = 0;
+
+	if (!recordingFile) {
+		return -1;
+	}
+
+	*lines = NULL;
+	while ((nread = getline(&line, &length, recordingFile)) != -1) {
+		char* tab = strchr(line, '\t');
+		if (line[0] == '#' || !tab) {
+			continue;
+		}
+
+		// keep the command line with a newline so that it can be written as it is
+		*lines = (struct recordedLine*)realloc(*lines, (numLines + 1) * sizeof(struct recordedLine));
+		(*lines)[numLines].delay = atof(line);
+		(*lines)[numLines].text = (char*)malloc(strlen(tab + 1) + 2);
+		strcpy((*lines)[numLines].text, tab + 1);
+		if (line[nread - 1] != '\n') {
+			strcat((*lines)[numLines].text, "\n");
+		}
+		numLines++;
+	}
+
+	free(line);
+	fclose(recordingFile);
+	return numLines;
+}
+
+/*
+* Starts an instance of smallsh with its input and output connected to pipes
+*/
+static void startInstance(struct instance* instance, char* smallsh, int loops) {
+	int inputPipe[2], outputPipe[2];
+
+	pipe2(inputPipe, O_CLOEXEC);
+	pipe2(outputPipe, O_CLOEXEC);
+
+	instance->pid = fork();
+	if (instance->pid == 0) {
+		int devNull = open("/dev/null", O_WRONLY);
+		dup2(inputPipe[0], STDIN_FILENO);
+		dup2(outputPipe[1], STDOUT_FILENO);
+		dup2(devNull, STDERR_FILENO);
+		execl(smallsh, smallsh, "--norc", NULL);
+		_exit(127);
+	}
+
+	close(inputPipe[0]);
+	close(outputPipe[1]);
+	instance->inputFD = inputPipe[1];
+	instance->outputFD = outputPipe[0];
+	instance->loopsLeft = loops - 1;
+}
+
+/*
+* Driver code for the replay driver
+*/
+int main(int argc, char* argv[]) {
+	int numInstances = 1, loops = 1, option;
+	double speed = 1;
+	struct recordedLine* lines;
+	int numLines;
+	char* smallsh;
+
+	// process the command line options
+	while ((option = getopt(argc, argv, "c:s:n:")) != -1) {
+		switch (option) {
+			case 'c': numInstances = atoi(optarg); break;
+			case 's': speed = strcmp(optarg, "max") == 0 ? 0 : atof(optarg); break;
+			case 'n': loops = atoi(optarg); break;
+			default: optind = argc + 1; break;
+		}
+	}
+	if (optind >= argc || optind + 2 < argc || numInstances < 1 || loops < 1 || speed < 0) {
+		fprintf(stderr, "usage: %s [-c INSTANCES] [-s SPEED|max] [-n LOOPS] RECORDING [SMALLSH]\n", argv[0]);
+		return 1;
+	}
+	smallsh = optind + 1 < argc ? argv[optind + 1] : "./smallsh";
+
+	numLines = readRecording(argv[optind], &lines);
+	if (numLines <= 0) {
+		fprintf(stderr, "%s: no command lines to replay\n", argv[optind]);
+		return 1;
+	}
+
+	// every instance displays "<start>exit value<end>" as its prompt, so the end of each line can be found in
+	// its output along with whether it failed
+	char marker[] = { MARKER_START, '\\', '?', MARKER_END, '\0' };
+	setenv("PS1", marker, 1);
+	signal(SIGPIPE, SIG_IGN);
+
+	struct instance* instances = (struct instance*)calloc(numInstances, sizeof(struct instance));
+	struct pollfd* pollFDs = (struct pollfd*)calloc(numInstances, sizeof(struct pollfd));
+	double* latencies = (double*)malloc((size_t)numInstances * numLines * loops * sizeof(double));
+	long numLatencies = 0, failedLines = 0, failedInstances = 0;
+	int running = numInstances;
+	char buffer[65536];
+
+	double start = nowMicroseconds();
+	for (int index = 0; index < numInstances; index++) {
+		startInstance(&instances[index], smallsh, loops);
+	}
+
+	while (running > 0) {
+		double now = nowMicroseconds();
+		int timeoutMs = -1;
+
+		// send every line that is due, and work out how long to wait for the next one
+		for (int index = 0; index < numInstances; index++) {
+			struct instance* instance = &instances[index];
+			if (instance->inputFD == -1 || !instance->ready || instance->waiting) {
+				continue;
+			}
+
+			// once every loop has been sent, end the input so that the instance exits
+			if (instance->nextLine == numLines && instance->loopsLeft == 0) {
+				close(instance->inputFD);
+				instance->inputFD = -1;
+				continue;
+			}
+			if (instance->nextLine == numLines) {
+				instance->nextLine = 0;
+				instance->loopsLeft--;
+			}
+
+			if (instance->dueAt <= now) {
+				char* text = lines[instance->nextLine++].text;
+				instance->sentAt = now;
+				instance->waiting = true;
+				if (write(instance->inputFD, text, strlen(text)) == -1) {
+					close(instance->inputFD);
+					instance->inputFD = -1;
+				}
+			}
+			else {
+				int wait = (int)((instance->dueAt - now) / 1000) + 1;
+				timeoutMs = timeoutMs == -1 || wait < timeoutMs ? wait : timeoutMs;
+			}
+		}
+
+		// wait for output or for the next line to become due
+		for (int index = 0; index < numInstances; index++) {
+			pollFDs[index].fd = instances[index].outputFD;
+			pollFDs[index].events = POLLIN;
+		}
+		if (poll(pollFDs, numInstances, timeoutMs) <= 0) {
+			continue;
+		}
+
+		now = nowMicroseconds();
+		for (int index = 0; index < numInstances; index++) {
+			struct instance* instance = &instances[index];
+			if (!(pollFDs[index].revents & (POLLIN | POLLHUP))) {
+				continue;
+			}
+
+			ssize_t nread = read(instance->outputFD, buffer, sizeof(buffer));
+			if (nread <= 0) {
+				// the instance has exited - a line still waiting for its prompt never finished
+				int status;
+				close(instance->outputFD);
+				instance->outputFD = -1;
+				if (instance->inputFD != -1) {
+					close(instance->inputFD);
+					instance->inputFD = -1;
+				}
+				waitpid(instance->pid, &status, 0);
+				failedInstances += !(WIFEXITED(status) && WEXITSTATUS(status) == 0) || instance->waiting;
+				running--;
+				continue;
+			}
+
+			// find the prompts in the output, ignoring whatever the commands wrote
+			for (ssize_t position = 0; position < nread; position++) {
+				char byte = buffer[position];
+				if (byte == MARKER_START) {
+					instance->inMarker = true;
+					instance->markerStatus = 0;
+				}
+				else if (instance->inMarker && byte >= '0' && byte <= '9') {
+					instance->markerStatus = instance->markerStatus * 10 + byte - '0';
+				}
+				else if (instance->inMarker && byte == MARKER_END) {
+					instance->inMarker = false;
+					if (instance->waiting) {
+						latencies[numLatencies++] = now - instance->sentAt;
+						failedLines += instance->markerStatus != 0;
+						instance->waiting = false;
+					}
+					instance->ready = true;
+
+					// the next line is due its recorded time after this one was sent, divided by the speed
+					double delay = speed > 0 && instance->nextLine < numLines ? lines[instance->nextLine].delay / speed : 0;
+					instance->dueAt = (instance->sentAt ? instance->sentAt : now) + delay;
+				}
+				else {
+					instance->inMarker = false;
+				}
+			}
+		}
+	}
+	double elapsed = nowMicroseconds() - start;
+
+	// report throughput, latency percentiles and errors
+	qsort(latencies, numLatencies, sizeof(double), compareLatencies);
+	printf("replayed %ld command lines on %d instance(s) in %.3f s", numLatencies, numInstances, elapsed / 1e6);
+	printf(speed > 0 ? " at %gx speed\n" : " at max speed\n", speed);
+	printf("%-12s %10.1f lines/s\n", "throughput", numLatencies / (elapsed / 1e6));
+	if (numLatencies > 0) {
+		double percentiles[] = { 50, 90, 99, 99.9 };
+		for (int index = 0; index < 4; index++) {
+			long rank = (long)(percentiles[index] / 100 * numLatencies + 0.5);
+			rank = rank < 1 ? 1 : (rank > numLatencies ? numLatencies : rank);
+			printf("latency p%-4g %10.1f us\n", percentiles[index], latencies[rank - 1]);
+		}
+		printf("latency %-4s %10.1f us\n", "max", latencies[numLatencies - 1]);
+	}
+	printf("%-12s %10ld lines with a non-zero exit value\n", "errors", failedLines);
+	printf("%-12s %10ld instance(s) exited abnormally or early\n", "", failedInstances);
+
+	for (int index = 0; index < numLines; index++) {
+		free(lines[index].text);
+	}
+	free(lines);
+	free(instances);
+	free(pollFDs);
+	free(latencies);
+	return failedLines || failedInstances ? 1 : 0;
+}
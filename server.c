@@ -0,0 +1,752 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Daemon mode - command lines submitted over a Unix domain socket are executed through the parser
+*	and executor and their output and results are sent back to the client as framed messages
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "commandExecution.h"
+#include "memory.h"
+#include "events.h"
+#include "timeout.h"
+#include "server.h"
+#include "metrics.h"
+#include "optimizer.h"
+#include "zygote.h"
+#include "heredoc.h"
+
+// the number of bytes read from a client or a command output pipe at a time
+#define READ_CHUNK 65536
+
+// the number of bytes of unsent frames a client may have before the output of its commands stops being read
+#define MAX_CLIENT_BACKLOG (1024 * 1024)
+
+// the interval in milliseconds at which child processes without a pidfd are polled
+#define POLL_INTERVAL 50
+
+/*
+* A struct representing a connected client
+*/
+struct serverClient {
+	struct eventHandler handler;  // watches the client socket
+	char* inBuffer;  // bytes received from the client that do not form a complete line yet
+	size_t inLength;  // the number of bytes in inBuffer
+	char* outBuffer;  // frames waiting to be sent to the client
+	size_t outLength;  // the number of bytes in outBuffer
+	size_t outCapacity;  // the number of bytes outBuffer can hold
+	uint32_t nextRequestId;  // the id given to the next line received from the client
+	int activeRequests;  // the number of requests of the client that have not sent their result yet
+	bool closed;  // true once the client has disconnected, otherwise false
+	struct serverRequest* requests;  // the running requests of the client
+	struct serverRequest* heldRequest;  // the request whose here-document bodies are still being received, if any
+	char** hereDelimiters;  // the delimiters of the here-documents of heldRequest
+	int delimiterIndex;  // the index of the delimiter of the body being received
+	struct serverClient* next;  // the next connected client
+};
+
+/*
+* A struct representing a command line submitted by a client
+*/
+struct serverRequest {
+	struct serverClient* client;  // the client that submitted the request
+	uint32_t id;  // the id of the request on its connection
+	char* line;  // the command line, held until the request starts running
+	char** bodyLines;  // the lines of the bodies of its here-documents, NULL terminated, or NULL if it has none
+	int numBodyLines;  // the number of lines in bodyLines
+	pid_t pid;  // the pid of the child process executing the command
+	int childStatus;  // the wait status of the child process
+	struct rusage usage;  // the resources consumed by the child process
+	int statusFD;  // the read end of the pipe the child process passes the full status of the command through
+	bool exited;  // true once the child process has been reaped, otherwise false
+	bool outputOpen;  // true while the output pipe of the child process is open, otherwise false
+	bool outputPaused;  // true while the output pipe is not read because the client is backlogged
+	struct eventHandler outputHandler;  // watches the read end of the output pipe
+	struct eventHandler exitHandler;  // watches the pidfd of the child process, fd is -1 without one
+	struct serverRequest* next;  // the next request in the pending queue or in the requests of a client
+};
+
+/*
+* A struct representing the state of the server
+*/
+struct server {
+	struct eventHandler listenHandler;  // watches the listening socket
+	struct serverClient* clients;  // every connected client
+	struct serverRequest* pendingHead;  // the oldest request waiting for a worker
+	struct serverRequest* pendingTail;  // the newest request waiting for a worker
+	int numPending;  // the number of requests waiting for a worker
+	int numRunning;  // the number of requests currently running
+	int numUnwatched;  // the number of running requests without a pidfd, which have to be polled with waitid
+	int workerLimit;  // the maximum number of requests that may run at once
+	bool readingPaused;  // true while clients are not read from because too many requests are waiting
+	struct dynamicArray* backgroundPids;  // passed along to the executor
+};
+
+// the single server run by smallsh
+static struct server server = { 0 };
+
+static void dispatchRequests(void);
+
+/*
+* Updates the events a client is watched for - the socket is read from unless reading is paused and is
+* written to while frames are waiting to be sent
+*/
+static void updateClientEvents(struct serverClient* client) {
+	unsigned int events = 0;
+
+	if (!server.readingPaused) {
+		events |= EPOLLIN;
+	}
+	if (client->outLength > 0) {
+		events |= EPOLLOUT;
+	}
+	modifyEventHandler(&client->handler, events);
+}
+
+/*
+* Pauses or resumes reading from every client and accepting new ones depending on how many requests are
+* waiting for a worker
+*/
+static void updateBackpressure(void) {
+	bool shouldPause = server.numPending >= server.workerLimit;
+
+	// nothing to do if the state is unchanged
+	if (shouldPause == server.readingPaused) {
+		return;
+	}
+
+	// apply the new state to the listening socket and every client
+	server.readingPaused = shouldPause;
+	modifyEventHandler(&server.listenHandler, shouldPause ? 0 : EPOLLIN);
+	for (struct serverClient* client = server.clients; client; client = client->next) {
+		if (!client->closed) {
+			updateClientEvents(client);
+		}
+	}
+}
+
+/*
+* Releases a disconnected client once none of its requests still need it
+*/
+static void releaseClientIfDone(struct serverClient* client) {
+	if (!client->closed || client->activeRequests > 0) {
+		return;
+	}
+
+	// unlink the client from the list of clients
+	for (struct serverClient** link = &server.clients; *link; link = &(*link)->next) {
+		if (*link == client) {
+			*link = client->next;
+			break;
+		}
+	}
+
+	// release the memory allocated for the client
+	free(client->inBuffer);
+	free(client->outBuffer);
+	free(client);
+}
+
+/*
+* Closes the connection to a client. Its running requests continue but their frames are discarded
+*/
+static void closeClient(struct serverClient* client) {
+	unregisterEventHandler(&client->handler);
+	close(client->handler.fd);
+	client->closed = true;
+	client->outLength = 0;
+
+	// a request whose here-document bodies were not received in full is dropped like any other request of a
+	// disconnected client that has not started yet
+	if (client->heldRequest) {
+		free(client->heldRequest->line);
+		if (client->heldRequest->bodyLines) {
+			freeWords(client->heldRequest->bodyLines);
+		}
+		free(client->heldRequest);
+		freeWords(client->hereDelimiters);
+		client->heldRequest = NULL;
+		client->activeRequests--;
+	}
+
+	// output of the running requests is discarded from now on, so none of them may stay paused
+	for (struct serverRequest* request = client->requests; request; request = request->next) {
+		if (request->outputPaused) {
+			request->outputPaused = false;
+			modifyEventHandler(&request->outputHandler, EPOLLIN);
+		}
+	}
+
+	releaseClientIfDone(client);
+}
+
+/*
+* Sends as many waiting frames to a client as its socket accepts without blocking. Output pipes that were
+* paused because the client was backlogged are resumed once the backlog drains
+*/
+static void flushClient(struct serverClient* client) {
+	// declare and initialize a variable used to track how many bytes have been sent
+	size_t sent = 0;
+
+	while (sent < client->outLength) {
+		ssize_t result = send(client->handler.fd, client->outBuffer + sent, client->outLength - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (result == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				// the client went away
+				closeClient(client);
+				return;
+			}
+			break;
+		}
+		sent += result;
+	}
+
+	// keep whatever could not be sent at the front of the buffer
+	memmove(client->outBuffer, client->outBuffer + sent, client->outLength - sent);
+	client->outLength -= sent;
+	updateClientEvents(client);
+
+	// resume reading the output of requests that were paused for this client
+	if (client->outLength < MAX_CLIENT_BACKLOG) {
+		for (struct serverRequest* request = client->requests; request; request = request->next) {
+			if (request->outputPaused) {
+				request->outputPaused = false;
+				modifyEventHandler(&request->outputHandler, EPOLLIN);
+			}
+		}
+	}
+}
+
+/*
+* Queues a frame for a client and tries to send it right away
+*/
+static void sendFrame(struct serverClient* client, uint32_t type, uint32_t requestId, void* payload, uint32_t length) {
+	struct serverFrameHeader header = { type, requestId, length };
+
+	// frames for a client that disconnected are dropped
+	if (client->closed) {
+		return;
+	}
+
+	// grow the output buffer until the header and payload fit
+	while (client->outLength + sizeof(header) + length > client->outCapacity) {
+		client->outCapacity = client->outCapacity ? client->outCapacity * 2 : READ_CHUNK;
+		client->outBuffer = (char*)realloc(client->outBuffer, client->outCapacity);
+	}
+
+	// append the frame and send what the socket will take
+	memcpy(client->outBuffer + client->outLength, &header, sizeof(header));
+	memcpy(client->outBuffer + client->outLength + sizeof(header), payload, length);
+	client->outLength += sizeof(header) + length;
+	flushClient(client);
+}
+
+/*
+* Sends the result of a request to its client and releases the request
+*/
+static void finishRequest(struct serverRequest* request, int childStatus, struct rusage* usage) {
+	struct serverClient* client = request->client;
+	struct serverResult result = { 0 };
+
+	// describe how the command terminated
+	result.exitStatus = WIFEXITED(childStatus) ? WEXITSTATUS(childStatus) : -1;
+	result.signal = WIFSIGNALED(childStatus) ? WTERMSIG(childStatus) : 0;
+	result.timedOut = (childStatus & TIMED_OUT_FLAG) ? 1 : 0;
+	if (usage) {
+		result.userMicroseconds = (int64_t)usage->ru_utime.tv_sec * 1000000 + usage->ru_utime.tv_usec;
+		result.systemMicroseconds = (int64_t)usage->ru_stime.tv_sec * 1000000 + usage->ru_stime.tv_usec;
+		result.maxResidentKilobytes = usage->ru_maxrss;
+	}
+	sendFrame(client, SERVER_FRAME_RESULT, request->id, &result, sizeof(result));
+
+	// unlink the request from the running requests of its client
+	for (struct serverRequest** link = &client->requests; *link; link = &(*link)->next) {
+		if (*link == request) {
+			*link = request->next;
+			break;
+		}
+	}
+
+	// release the request and, if it was the last thing keeping a disconnected client around, the client
+	free(request->line);
+	if (request->bodyLines) {
+		freeWords(request->bodyLines);
+	}
+	free(request);
+	client->activeRequests--;
+	releaseClientIfDone(client);
+}
+
+/*
+* Finishes a running request once its child process has been reaped and all of its output has been read
+*/
+static void finishRequestIfDone(struct serverRequest* request) {
+	if (request->exited && !request->outputOpen) {
+		finishRequest(request, request->childStatus, &request->usage);
+	}
+}
+
+/*
+* Event loop callback invoked when the output pipe of a request is readable
+*/
+static void requestOutputReadable(struct eventHandler* handler, unsigned int events) {
+	struct serverRequest* request = (struct serverRequest*)handler->data;
+	char buffer[READ_CHUNK];
+	ssize_t numRead = read(handler->fd, buffer, sizeof(buffer));
+
+	// a read error is only retried if it was an interruption
+	if (numRead == -1 && (errno == EINTR || errno == EAGAIN)) {
+		return;
+	}
+
+	// forward any output to the client
+	if (numRead > 0) {
+		sendFrame(request->client, SERVER_FRAME_OUTPUT, request->id, buffer, numRead);
+
+		// stop reading output while the client is backlogged
+		if (request->client->outLength >= MAX_CLIENT_BACKLOG) {
+			request->outputPaused = true;
+			modifyEventHandler(handler, 0);
+		}
+		return;
+	}
+
+	// the pipe reached end of file - every writer has exited
+	unregisterEventHandler(handler);
+	close(handler->fd);
+	request->outputOpen = false;
+	finishRequestIfDone(request);
+}
+
+/*
+* Reaps the terminated child process of a request, then starts the next waiting request and finishes this one
+* if its output is done
+*/
+static void reapRequest(struct serverRequest* request) {
+	// declare a variable used to store the status of the command as seen by the executor in the child process
+	int commandStatus;
+
+	// reap the child process and capture the resources it used
+	wait4(request->pid, &request->childStatus, 0, &request->usage);
+	request->exited = true;
+
+	// the child process passes the status of the command, including any timeout or limit flags, before exiting -
+	// if it did not get that far, its own wait status is reported instead
+	if (read(request->statusFD, &commandStatus, sizeof(commandStatus)) == sizeof(commandStatus)) {
+		request->childStatus = commandStatus;
+	}
+	close(request->statusFD);
+
+	// a worker is free again - start the next waiting request and finish this one if its output is done
+	server.numRunning--;
+	finishRequestIfDone(request);
+	dispatchRequests();
+}
+
+/*
+* Event loop callback invoked when the child process of a request terminates
+*/
+static void requestExited(struct eventHandler* handler, unsigned int events) {
+	// stop watching the pidfd before the request may be released
+	unregisterEventHandler(handler);
+	close(handler->fd);
+	handler->fd = -1;
+
+	reapRequest((struct serverRequest*)handler->data);
+}
+
+/*
+* Returns a running request without a pidfd whose child process has terminated, or NULL if there is none
+*/
+static struct serverRequest* findExitedRequest(void) {
+	// declare a variable used to store the state of a process reported by waitid
+	siginfo_t info;
+
+	for (struct serverClient* client = server.clients; client; client = client->next) {
+		for (struct serverRequest* request = client->requests; request; request = request->next) {
+			if (request->exited || request->exitHandler.fd != -1) {
+				continue;
+			}
+
+			// si_pid is only set if the process has terminated, which leaves it waitable for reapRequest
+			info.si_pid = 0;
+			if (waitid(P_PID, request->pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == request->pid) {
+				return request;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* Reaps every running request without a pidfd whose child process has terminated. The search starts over after
+* each one since finishing a request may release it and its client
+*/
+static void pollUnwatchedRequests(void) {
+	struct serverRequest* request;
+
+	while (server.numUnwatched && (request = findExitedRequest())) {
+		server.numUnwatched--;
+		reapRequest(request);
+	}
+}
+
+/*
+* Starts executing a request in a child process whose stdout and stderr feed a pipe read by the server
+*/
+static void startRequest(struct serverRequest* request) {
+	// declare a variable used to store the pipe the child writes its output into
+	int outputPipe[2];
+	// declare a variable used to store the pipe the child passes the status of the command through
+	int statusPipe[2];
+	// declare and initialize a variable used to store the status of the command executed by the child
+	int lastStatus = 0;
+	// parse the command line - parseUserInput releases the line it is given unless it is blank or a comment
+	struct command* command = parseUserInput(request->line);
+
+	// a blank line or a comment succeeds without doing anything
+	if (!command) {
+		finishRequest(request, 0, NULL);
+		return;
+	}
+	request->line = NULL;
+
+	// the bodies of here-documents are the lines received after the command line, and the command is then
+	// rewritten just like in the interactive loop
+	char** bodyLines = request->bodyLines;
+	if (bodyLines) {
+		readHereDocuments(command, &bodyLines);
+	}
+	command = optimizeCommand(command);
+
+	// create the output and status pipes - the shell's ends are closed on exec
+	if (pipe2(outputPipe, O_CLOEXEC) == -1) {
+		perror("pipe2 failed");
+		cleanupMemory(command);
+		finishRequest(request, 1 << 8, NULL);
+		return;
+	}
+	if (pipe2(statusPipe, O_CLOEXEC) == -1) {
+		perror("pipe2 failed");
+		close(outputPipe[0]);
+		close(outputPipe[1]);
+		cleanupMemory(command);
+		finishRequest(request, 1 << 8, NULL);
+		return;
+	}
+
+	// every request counts as a command and a spawn on the metrics page - the child executing it is a forked
+	// child of the shell, which leaves the counters to the shell
+	countCommand();
+
+	// For the following code structure, reference citation F
+	uint64_t spawnStart = metricsClock();
+	request->pid = fork();
+	if (request->pid == -1) {
+		perror("fork failed");
+		close(outputPipe[0]);
+		close(outputPipe[1]);
+		close(statusPipe[0]);
+		close(statusPipe[1]);
+		cleanupMemory(command);
+		finishRequest(request, 1 << 8, NULL);
+		return;
+	}
+	else if (request->pid == 0) {
+		// the child reads from /dev/null and writes stdout and stderr into the output pipe
+		int nullFD = open("/dev/null", O_RDONLY);
+		dup2(nullFD, STDIN_FILENO);
+		dup2(outputPipe[1], STDOUT_FILENO);
+		dup2(outputPipe[1], STDERR_FILENO);
+
+		// the command is executed just like in the interactive loop, in the foreground - the child waits for the
+		// processes it starts with an event loop of its own rather than the one of the server. Built-in commands
+		// run within the child and have no lasting effect on the server
+		detachZygote();
+		resetEventLoop();
+		executeCommand(command, server.backgroundPids, &lastStatus, 1);
+		fflush(stdout);
+
+		// pass the full status of the command to the server and exit with its exit value
+		if (write(statusPipe[1], &lastStatus, sizeof(lastStatus)) == -1) {
+			perror("write failed");
+		}
+		_exit(WIFSIGNALED(lastStatus) ? 128 + WTERMSIG(lastStatus) : WEXITSTATUS(lastStatus));
+	}
+
+	// the parent keeps only the read ends of the pipes and records how long spawning took
+	countSpawn(spawnStart);
+	close(outputPipe[1]);
+	close(statusPipe[1]);
+	request->statusFD = statusPipe[0];
+	server.numRunning++;
+	cleanupMemory(command);
+
+	// link the request into the running requests of its client
+	request->next = request->client->requests;
+	request->client->requests = request;
+
+	// watch the output pipe and the termination of the child process
+	request->outputOpen = true;
+	request->outputHandler.fd = outputPipe[0];
+	request->outputHandler.callback = requestOutputReadable;
+	request->outputHandler.data = request;
+	registerEventHandler(&request->outputHandler, EPOLLIN);
+
+	// if no pidfd can be opened (e.g. the server ran out of file descriptors) the child process is polled instead
+	request->exitHandler.fd = syscall(SYS_pidfd_open, request->pid, 0);
+	request->exitHandler.callback = requestExited;
+	request->exitHandler.data = request;
+	if (request->exitHandler.fd != -1) {
+		registerEventHandler(&request->exitHandler, EPOLLIN);
+	}
+	else {
+		server.numUnwatched++;
+	}
+}
+
+/*
+* Starts waiting requests while workers are available
+*/
+static void dispatchRequests(void) {
+	while (server.pendingHead && server.numRunning < server.workerLimit) {
+		// remove the oldest request from the pending queue
+		struct serverRequest* request = server.pendingHead;
+		server.pendingHead = request->next;
+		if (!server.pendingHead) {
+			server.pendingTail = NULL;
+		}
+		server.numPending--;
+		request->next = NULL;
+
+		// requests of a client that already disconnected are dropped
+		if (request->client->closed) {
+			struct serverClient* client = request->client;
+			free(request->line);
+			if (request->bodyLines) {
+				freeWords(request->bodyLines);
+			}
+			free(request);
+			client->activeRequests--;
+			releaseClientIfDone(client);
+			continue;
+		}
+
+		startRequest(request);
+	}
+
+	updateBackpressure();
+	// publish the number of requests running and waiting for a worker
+	updateJobMetrics(server.numRunning, server.numPending);
+}
+
+/*
+* Adds a request to the pending queue
+*/
+static void queueRequest(struct serverRequest* request) {
+	// append the request to the pending queue
+	if (server.pendingTail) {
+		server.pendingTail->next = request;
+	}
+	else {
+		server.pendingHead = request;
+	}
+	server.pendingTail = request;
+	server.numPending++;
+}
+
+/*
+* Handles a line received from a client. A line of the body of a here-document belongs to the request that
+* started it, any other line is a new request. A request is only queued once the bodies of all of its
+* here-documents have been received
+*/
+static void receiveLine(struct serverClient* client, char* line, size_t length) {
+	// copy the line without its '\n'
+	char* text = (char*)malloc(length + 1);
+	memcpy(text, line, length);
+	text[length] = '\0';
+
+	// add a body line to the held request, queueing it after the delimiter of its last here-document
+	struct serverRequest* request = client->heldRequest;
+	if (request) {
+		request->bodyLines = (char**)realloc(request->bodyLines, (request->numBodyLines + 2) * sizeof(char*));
+		request->bodyLines[request->numBodyLines++] = text;
+		request->bodyLines[request->numBodyLines] = NULL;
+		if (strcmp(text, client->hereDelimiters[client->delimiterIndex]) == 0 &&
+			!client->hereDelimiters[++client->delimiterIndex]) {
+			freeWords(client->hereDelimiters);
+			client->hereDelimiters = NULL;
+			client->heldRequest = NULL;
+			queueRequest(request);
+		}
+		return;
+	}
+
+	request = (struct serverRequest*)calloc(1, sizeof(struct serverRequest));
+	request->client = client;
+	request->id = ++client->nextRequestId;
+	request->line = text;
+	client->activeRequests++;
+
+	// a command line starting here-documents is held until their bodies have been received
+	char** words = strstr(text, "<<") ? splitWords(text) : NULL;
+	char** delimiters = words ? findHereDelimiters(words) : NULL;
+	if (words) {
+		freeWords(words);
+	}
+	if (delimiters) {
+		client->heldRequest = request;
+		client->hereDelimiters = delimiters;
+		client->delimiterIndex = 0;
+		return;
+	}
+	queueRequest(request);
+}
+
+/*
+* Event loop callback invoked when a client socket is readable or writable
+*/
+static void clientReady(struct eventHandler* handler, unsigned int events) {
+	struct serverClient* client = (struct serverClient*)handler->data;
+	char buffer[READ_CHUNK];
+
+	// send waiting frames if the socket has room
+	if (events & EPOLLOUT) {
+		flushClient(client);
+		if (client->closed) {
+			return;
+		}
+	}
+
+	// the client has only hung up or errored once there is nothing left to read
+	if (!(events & EPOLLIN)) {
+		if (events & (EPOLLHUP | EPOLLERR)) {
+			closeClient(client);
+		}
+		return;
+	}
+
+	// read what the client sent
+	ssize_t numRead = read(handler->fd, buffer, sizeof(buffer));
+	if (numRead == -1 && (errno == EINTR || errno == EAGAIN)) {
+		return;
+	}
+	if (numRead <= 0) {
+		closeClient(client);
+		return;
+	}
+
+	// append the bytes to whatever partial line was left over
+	client->inBuffer = (char*)realloc(client->inBuffer, client->inLength + numRead);
+	memcpy(client->inBuffer + client->inLength, buffer, numRead);
+	client->inLength += numRead;
+
+	// queue every complete line
+	char* lineStart = client->inBuffer;
+	char* newline = NULL;
+	while ((newline = memchr(lineStart, '\n', client->inLength - (lineStart - client->inBuffer)))) {
+		receiveLine(client, lineStart, newline - lineStart);
+		lineStart = newline + 1;
+	}
+
+	// keep the partial line that remains at the front of the buffer
+	client->inLength -= lineStart - client->inBuffer;
+	memmove(client->inBuffer, lineStart, client->inLength);
+
+	dispatchRequests();
+}
+
+/*
+* Event loop callback invoked when a new client is waiting to be accepted
+*/
+static void clientWaiting(struct eventHandler* handler, unsigned int events) {
+	int clientFD = accept4(handler->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+	if (clientFD == -1) {
+		return;
+	}
+
+	// populate the client and add it to the list of clients
+	struct serverClient* client = (struct serverClient*)calloc(1, sizeof(struct serverClient));
+	client->handler.fd = clientFD;
+	client->handler.callback = clientReady;
+	client->handler.data = client;
+	client->next = server.clients;
+	server.clients = client;
+
+	registerEventHandler(&client->handler, server.readingPaused ? 0 : EPOLLIN);
+}
+
+/*
+* Listens on the Unix domain socket at socketPath and executes every command line submitted by any
+* number of concurrent clients through the parser and executor. At most workerLimit commands run at
+* once - while that many requests are waiting, smallsh stops reading from clients so that they are
+* pushed back on by the socket. This function only returns if the socket cannot be set up
+*/
+void serveRequests(char* socketPath, int workerLimit, struct dynamicArray* backgroundPids) {
+	struct sockaddr_un address = { 0 };
+
+	// the path must fit into the socket address
+	if (strlen(socketPath) >= sizeof(address.sun_path)) {
+		printf("%s: socket path too long\n", socketPath);
+		fflush(stdout);
+		return;
+	}
+
+	// a stale socket left behind by an earlier server is replaced, but anything else at the path is left alone
+	struct stat pathStatus;
+	if (lstat(socketPath, &pathStatus) == 0) {
+		if (!S_ISSOCK(pathStatus.st_mode)) {
+			printf("%s: exists and is not a socket\n", socketPath);
+			fflush(stdout);
+			return;
+		}
+		unlink(socketPath);
+	}
+
+	// create, bind and listen on the socket
+	int listenFD = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socketPath);
+	if (listenFD == -1 || bind(listenFD, (struct sockaddr*)&address, sizeof(address)) == -1 || listen(listenFD, SOMAXCONN) == -1) {
+		perror(socketPath);
+		return;
+	}
+
+	// populate the server state
+	server.workerLimit = workerLimit > 0 ? workerLimit : DEFAULT_SERVER_WORKERS;
+	server.backgroundPids = backgroundPids;
+	server.listenHandler.fd = listenFD;
+	server.listenHandler.callback = clientWaiting;
+	registerEventHandler(&server.listenHandler, EPOLLIN);
+
+	// service clients, output pipes, child processes and deadlines forever - waking up regularly while some child
+	// processes have no pidfd
+	while (true) {
+		waitForEventsTimeout(-1, server.numUnwatched ? POLL_INTERVAL : -1);
+		pollUnwatchedRequests();
+	}
+}
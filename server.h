@@ -0,0 +1,54 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for daemon mode, where smallsh executes command lines submitted over a Unix
+*	domain socket
+*
+* Protocol: a client connects to the socket and writes command lines, each terminated by '\n'. The n-th
+* command line sent on a connection is request n (starting at 1). The lines following a command line that
+* starts here-documents are their bodies, up to the line holding the delimiter of the last one, and belong to
+* that request. Every message sent back to the client starts
+* with a serverFrameHeader followed by length bytes of payload:
+*	SERVER_FRAME_OUTPUT - payload is output (stdout and stderr) written by the command of the request
+*	SERVER_FRAME_RESULT - payload is a serverResult, sent once per request after all of its output
+* Requests on one connection run concurrently, so frames of different requests may be interleaved
+*/
+
+// the frame type carrying output of a request
+#define SERVER_FRAME_OUTPUT 1
+// the frame type carrying the result of a request
+#define SERVER_FRAME_RESULT 2
+
+// the number of commands that may run at once when --workers is not provided
+#define DEFAULT_SERVER_WORKERS 64
+
+/*
+* A struct representing the header at the start of every frame sent to a client
+*/
+struct serverFrameHeader {
+	uint32_t type;  // SERVER_FRAME_OUTPUT or SERVER_FRAME_RESULT
+	uint32_t requestId;  // the request the frame belongs to
+	uint32_t length;  // the number of payload bytes following the header
+};
+
+/*
+* A struct representing the payload of a SERVER_FRAME_RESULT frame
+*/
+struct serverResult {
+	int32_t exitStatus;  // the exit value of the command or -1 if it was terminated by a signal
+	int32_t signal;  // the signal that terminated the command or 0 if it exited
+	int32_t timedOut;  // 1 if the command was signalled because its timeout expired, otherwise 0
+	int32_t reserved;  // always 0
+	int64_t userMicroseconds;  // the user CPU time consumed by the command
+	int64_t systemMicroseconds;  // the system CPU time consumed by the command
+	int64_t maxResidentKilobytes;  // the peak resident set size of the command
+};
+
+/*
+* Listens on the Unix domain socket at socketPath and executes every command line submitted by any
+* number of concurrent clients through the parser and executor. At most workerLimit commands run at
+* once - while that many requests are waiting, smallsh stops reading from clients so that they are
+* pushed back on by the socket. This function only returns if the socket cannot be set up
+*/
+void serveRequests(char* socketPath, int workerLimit, struct dynamicArray* backgroundPids);
@@ -0,0 +1,117 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Benchmark measuring how long smallsh takes to start up and exit without a startup file, with a
+*	startup file but no snapshot (cold) and with a startup file and a valid snapshot (warm)
+*
+* Usage: ./startupBenchmark [SMALLSH] [ITERATIONS] [LINES]
+*	SMALLSH (default ./smallsh) is run ITERATIONS (default 200) times in each mode with "exit" as its input.
+*	The startup file is generated in a temporary home directory and holds LINES (default 200) assignments
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/*
+* Returns the current time of the monotonic clock in microseconds
+*/
+static double nowMicroseconds(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+/*
+* Runs smallsh once with "exit" as its input and waits for it to finish. The startup file is skipped when
+* useStartupFile is false
+*/
+static void runShell(char* smallsh, bool useStartupFile) {
+	int inputPipe[2];
+	pid_t spawnPid;
+
+	pipe(inputPipe);
+	write(inputPipe[1], "exit\n", 5);
+	close(inputPipe[1]);
+
+	spawnPid = fork();
+	if (spawnPid == 0) {
+		int devNull = open("/dev/null", O_WRONLY);
+		dup2(inputPipe[0], STDIN_FILENO);
+		dup2(devNull, STDOUT_FILENO);
+		execl(smallsh, smallsh, useStartupFile ? NULL : "--norc", NULL);
+		_exit(127);
+	}
+	close(inputPipe[0]);
+	waitpid(spawnPid, NULL, 0);
+}
+
+/*
+* Driver code for the benchmark
+*/
+int main(int argc, char* argv[]) {
+	char* smallsh = argc > 1 ? argv[1] : "./smallsh";
+	int iterations = argc > 2 ? atoi(argv[2]) : 200;
+	int numLines = argc > 3 ? atoi(argv[3]) : 200;
+	char home[] = "/tmp/smallshStartupXXXXXX";
+	char path[256];
+	double start, noRcTime, coldTime, warmTime;
+
+	// the shell is started by path, so make it absolute before moving into the temporary home directory
+	smallsh = realpath(smallsh, NULL);
+	if (!smallsh || !mkdtemp(home)) {
+		perror("setup failed");
+		return 1;
+	}
+	setenv("HOME", home, 1);
+
+	// generate a startup file of assignments, exporting every tenth variable
+	snprintf(path, sizeof(path), "%s/.smallshrc", home);
+	FILE* rcFile = fopen(path, "w");
+	for (int line = 0; line < numLines; line++) {
+		fprintf(rcFile, line % 10 ? "VARIABLE_%d=value_%d_$HOME\n" : "export VARIABLE_%d=value_%d\n", line, line);
+	}
+	fclose(rcFile);
+	snprintf(path, sizeof(path), "%s/.cache/smallsh/smallshrc.snapshot", home);
+
+	// without the startup file
+	start = nowMicroseconds();
+	for (int index = 0; index < iterations; index++) {
+		runShell(smallsh, false);
+	}
+	noRcTime = (nowMicroseconds() - start) / iterations;
+
+	// with the startup file but without a snapshot, which every run writes again
+	start = nowMicroseconds();
+	for (int index = 0; index < iterations; index++) {
+		unlink(path);
+		runShell(smallsh, true);
+	}
+	coldTime = (nowMicroseconds() - start) / iterations;
+
+	// with the startup file and the snapshot written by the last run
+	start = nowMicroseconds();
+	for (int index = 0; index < iterations; index++) {
+		runShell(smallsh, true);
+	}
+	warmTime = (nowMicroseconds() - start) / iterations;
+
+	printf("%d lines in the startup file, %d runs each\n", numLines, iterations);
+	printf("%-24s %10.1f us\n", "no startup file", noRcTime);
+	printf("%-24s %10.1f us\n", "cold (no snapshot)", coldTime);
+	printf("%-24s %10.1f us\n", "warm (snapshot)", warmTime);
+
+	// remove the temporary home directory
+	unlink(path);
+	snprintf(path, sizeof(path), "rm -rf %s", home);
+	system(path);
+	free(smallsh);
+	return 0;
+}
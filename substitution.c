@@ -0,0 +1,281 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Process substitution. Each "<(command)" or ">(command)" argument is replaced with "/dev/fd/N",
+*	the end of a pipe whose other end is the output or input of command. Every substituted command is started
+*	before the command it is an argument of, so all of them run in parallel, and they are reaped together
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "dynamicArray.h"
+#include "parser.h"
+#include "commandExecution.h"
+#include "memory.h"
+#include "substitution.h"
+#include "metrics.h"
+
+// the pids of the processes of substitutions of background commands that have not yet been reaped
+static struct dynamicArray* pendingSubstitutions = NULL;
+
+/*
+* Returns the depth of the parentheses still open after text, starting from depth
+*/
+static int parenthesesDepth(char* text, int depth) {
+	for (; *text; text++) {
+		depth += (*text == '(') - (*text == ')');
+	}
+
+	return depth;
+}
+
+/*
+* Returns a newly allocated string holding word - which starts with "<(" or ">(" - joined, separated by single
+* spaces, with the words following it up to the one closing its parentheses, moving *wordIndex past them.
+* Returns NULL after displaying an error message if the parentheses are never closed
+*/
+char* joinSubstitution(char* word, char** words, int* wordIndex) {
+	// declare and initialize a variable used to store the depth of the parentheses still open
+	int depth = parenthesesDepth(word, 0);
+	// allocate memory for the joined text, which starts as word itself
+	char* text = (char*)malloc((strlen(word) + 1) * sizeof(char));
+
+	strcpy(text, word);
+	while (depth > 0 && words[*wordIndex]) {
+		depth = parenthesesDepth(words[*wordIndex], depth);
+		text = (char*)realloc(text, (strlen(text) + strlen(words[*wordIndex]) + 2) * sizeof(char));
+		strcat(text, " ");
+		strcat(text, words[(*wordIndex)++]);
+	}
+
+	// the substitution must end with the parenthesis that closes it
+	if (depth != 0 || text[strlen(text) - 1] != ')') {
+		printf("syntax error: %c( is not closed by )\n", *word);
+		fflush(stdout);
+		free(text);
+		return NULL;
+	}
+
+	return text;
+}
+
+/*
+* Records that argument argIndex of command, whose text is substitution, is a process substitution - an argIndex
+* of SUBSTITUTED_INPUT or SUBSTITUTED_OUTPUT makes it the target of "<" or ">" instead
+*/
+void addSubstitution(struct command* command, char* substitution, int argIndex) {
+	// grow the array of substitutions by one
+	command->substitutions = (struct processSubstitution*)realloc(command->substitutions, (command->numSubstitutions + 1) * sizeof(struct processSubstitution));
+	struct processSubstitution* added = &command->substitutions[command->numSubstitutions++];
+
+	// keep the command line between "<(" or ">(" and the closing ")"
+	added->commandLine = (char*)malloc((strlen(substitution) - 2) * sizeof(char));
+	memcpy(added->commandLine, substitution + 2, strlen(substitution) - 3);
+	added->commandLine[strlen(substitution) - 3] = '\0';
+	added->output = *substitution == '>';
+	added->argIndex = argIndex;
+	added->fd = -1;
+	added->pid = -1;
+}
+
+/*
+* Executes command in the current process, a forked child of the shell whose input or output is already the
+* pipe of a substitution. Built-in commands are executed here too. This function never returns
+*/
+static void executeSubstitution(struct command* command, struct dynamicArray* backgroundPids) {
+	// declare and initialize a variable used to store the status of a built-in command
+	int builtinStatus = 0;
+
+	// a substituted command may hold substitutions of its own
+	if (command->numSubstitutions && !startSubstitutions(command, backgroundPids)) {
+		_exit(1);
+	}
+	// nothing is left to execute after assignments only, and "exit" must not clean up the jobs of the shell
+	if (!command->argv[0] || strcmp(command->argv[0], "exit") == 0) {
+		_exit(0);
+	}
+	if (executeBuiltin(command, backgroundPids, &builtinStatus)) {
+		fflush(stdout);
+		_exit(WEXITSTATUS(builtinStatus));
+	}
+
+	executeInChild(command, backgroundPids, 0);
+}
+
+/*
+* Starts the command of every process substitution of command on its own pipe, all of them running at once,
+* and replaces each argument with the path of the end of the pipe kept by the shell, or redirects the input or
+* output of command to it. Returns false after
+* displaying an error message if a pipe or process cannot be created, in which case nothing is left running
+*/
+bool startSubstitutions(struct command* command, struct dynamicArray* backgroundPids) {
+	for (int index = 0; index < command->numSubstitutions; index++) {
+		struct processSubstitution* substitution = &command->substitutions[index];
+		// declare a variable used to store the ends of the pipe - the shell keeps the read end of "<(command)"
+		// and the write end of ">(command)"
+		int ends[2];
+		// the command line is parsed here, so that "$$" still expands into the pid of the shell - parseUserInput
+		// releases the copy it is given
+		char* commandLine = (char*)malloc((strlen(substitution->commandLine) + 1) * sizeof(char));
+		strcpy(commandLine, substitution->commandLine);
+		struct command* substituted = parseUserInput(commandLine);
+
+		// the pipe is not inherited by any program but the one the argument is passed to
+		if (pipe2(ends, O_CLOEXEC) == -1) {
+			perror("pipe failed");
+			if (substituted) {
+				cleanupMemory(substituted);
+			}
+			else {
+				free(commandLine);
+			}
+			closeSubstitutions(command);
+			waitSubstitutions(command, false);
+			return false;
+		}
+
+		// For the following code structure, reference citation F
+		uint64_t spawnStart = metricsClock();
+		substitution->pid = fork();
+		if (substitution->pid == 0) {
+			dup2(ends[substitution->output ? 0 : 1], substitution->output ? STDIN_FILENO : STDOUT_FILENO);
+			if (!substituted) {
+				_exit(0);
+			}
+			executeSubstitution(substituted, backgroundPids);
+		}
+
+		// keep the end of the pipe for the command and release the substituted command
+		substitution->fd = ends[substitution->output ? 1 : 0];
+		close(ends[substitution->output ? 0 : 1]);
+		if (substituted) {
+			cleanupMemory(substituted);
+		}
+		else {
+			free(commandLine);
+		}
+
+		if (substitution->pid == -1) {
+			perror("fork failed");
+			closeSubstitutions(command);
+			waitSubstitutions(command, false);
+			return false;
+		}
+		countSpawn(spawnStart);
+
+		// the target of "<" or ">" is the end of the pipe itself
+		if (substitution->argIndex == SUBSTITUTED_INPUT) {
+			if (command->inputFD != -1) {
+				close(command->inputFD);
+			}
+			command->inputFD = substitution->fd;
+			continue;
+		}
+		if (substitution->argIndex == SUBSTITUTED_OUTPUT) {
+			command->outputFD = command->outputFD == -1 ? substitution->fd : command->outputFD;
+			continue;
+		}
+
+		// replace the argument with the path of the end of the pipe
+		char path[sizeof(SUBSTITUTION_FD_PATH) + 12];
+		snprintf(path, sizeof(path), SUBSTITUTION_FD_PATH "%d", substitution->fd);
+		command->argv[substitution->argIndex] = (char*)realloc(command->argv[substitution->argIndex], (strlen(path) + 1) * sizeof(char));
+		strcpy(command->argv[substitution->argIndex], path);
+		if (substitution->argIndex == 0) {
+			command->pathName = command->argv[0];
+		}
+	}
+
+	return true;
+}
+
+/*
+* Lets the pipes of the process substitutions of command be inherited by the program executed in the current
+* process, which must be a forked child of the shell
+*/
+void exposeSubstitutions(struct command* command) {
+	for (int index = 0; index < command->numSubstitutions; index++) {
+		if (command->substitutions[index].fd != -1) {
+			fcntl(command->substitutions[index].fd, F_SETFD, 0);
+		}
+	}
+}
+
+/*
+* Closes the ends of the pipes of the process substitutions of command kept by the shell, which must be done
+* once command has started so that each substituted command sees the end of its input or output
+*/
+void closeSubstitutions(struct command* command) {
+	for (int index = 0; index < command->numSubstitutions; index++) {
+		int fd = command->substitutions[index].fd;
+		if (fd == -1) {
+			continue;
+		}
+
+		// the input or output of command may have been redirected to the pipe
+		if (command->inputFD == fd) {
+			command->inputFD = -1;
+		}
+		if (command->outputFD == fd) {
+			command->outputFD = -1;
+		}
+		close(fd);
+		command->substitutions[index].fd = -1;
+	}
+}
+
+/*
+* Reaps the processes of the process substitutions of command once command has finished - a command run in the
+* background leaves them to be reaped by reapSubstitutions once they terminate
+*/
+void waitSubstitutions(struct command* command, bool background) {
+	for (int index = 0; index < command->numSubstitutions; index++) {
+		pid_t pid = command->substitutions[index].pid;
+		if (pid <= 0) {
+			continue;
+		}
+
+		if (background) {
+			if (!pendingSubstitutions) {
+				pendingSubstitutions = newDynamicArray();
+			}
+			append(pendingSubstitutions, pid);
+		}
+		else {
+			waitpid(pid, NULL, 0);
+		}
+		command->substitutions[index].pid = -1;
+	}
+}
+
+/*
+* Reaps the processes of process substitutions of background commands that have terminated
+*/
+void reapSubstitutions(void) {
+	for (int index = 0; pendingSubstitutions && index < pendingSubstitutions->size; index++) {
+		if (waitpid(pendingSubstitutions->staticArray[index], NULL, WNOHANG) != 0) {
+			// revisit this index since the next pid has shifted into it
+			delete(pendingSubstitutions, index);
+			index--;
+		}
+	}
+}
+
+/*
+* Closes the pipes and releases the memory of the process substitutions of command
+*/
+void freeSubstitutions(struct command* command) {
+	closeSubstitutions(command);
+	for (int index = 0; index < command->numSubstitutions; index++) {
+		free(command->substitutions[index].commandLine);
+	}
+	free(command->substitutions);
+}
@@ -0,0 +1,75 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for process substitution - an argument "<(command)" or ">(command)" is replaced with
+*	"/dev/fd/N", the end of a pipe whose other end is the output or input of command, which runs alongside
+*	the command it is an argument of
+*/
+
+// the directory the pipes of process substitutions are passed through
+#define SUBSTITUTION_FD_PATH "/dev/fd/"
+
+// the argIndex of a substitution that is the target of "<" or ">" rather than an argument
+#define SUBSTITUTED_INPUT -1
+#define SUBSTITUTED_OUTPUT -2
+
+/*
+* A struct representing a process substitution in the arguments of a command
+*/
+struct processSubstitution {
+	char* commandLine;  // the command line between the parentheses
+	bool output;  // true for ">(command)", which reads what is written to the argument, false for "<(command)"
+	int argIndex;  // the index in argv of the argument replaced with the pipe, or SUBSTITUTED_INPUT or SUBSTITUTED_OUTPUT
+	int fd;  // the end of the pipe kept by the shell for the command, -1 once closed
+	pid_t pid;  // the pid of the process running commandLine, -1 if it is not running
+};
+
+/*
+* Returns a newly allocated string holding word - which starts with "<(" or ">(" - joined, separated by single
+* spaces, with the words following it up to the one closing its parentheses, moving *wordIndex past them.
+* Returns NULL after displaying an error message if the parentheses are never closed
+*/
+char* joinSubstitution(char* word, char** words, int* wordIndex);
+
+/*
+* Records that argument argIndex of command, whose text is substitution, is a process substitution - an argIndex
+* of SUBSTITUTED_INPUT or SUBSTITUTED_OUTPUT makes it the target of "<" or ">" instead
+*/
+void addSubstitution(struct command* command, char* substitution, int argIndex);
+
+/*
+* Starts the command of every process substitution of command on its own pipe, all of them running at once,
+* and replaces each argument with the path of the end of the pipe kept by the shell, or redirects the input or
+* output of command to it. Returns false after
+* displaying an error message if a pipe or process cannot be created, in which case nothing is left running
+*/
+bool startSubstitutions(struct command* command, struct dynamicArray* backgroundPids);
+
+/*
+* Lets the pipes of the process substitutions of command be inherited by the program executed in the current
+* process, which must be a forked child of the shell
+*/
+void exposeSubstitutions(struct command* command);
+
+/*
+* Closes the ends of the pipes of the process substitutions of command kept by the shell, which must be done
+* once command has started so that each substituted command sees the end of its input or output
+*/
+void closeSubstitutions(struct command* command);
+
+/*
+* Reaps the processes of the process substitutions of command once command has finished - a command run in the
+* background leaves them to be reaped by reapSubstitutions once they terminate
+*/
+void waitSubstitutions(struct command* command, bool background);
+
+/*
+* Reaps the processes of process substitutions of background commands that have terminated
+*/
+void reapSubstitutions(void);
+
+/*
+* Closes the pipes and releases the memory of the process substitutions of command
+*/
+void freeSubstitutions(struct command* command);
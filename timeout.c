@@ -0,0 +1,322 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: The timeout built-in command. Deadlines are kept in timerfds watched by the event loop so
+*	that foreground and background processes are signalled without any helper process. A timed command runs in
+*	a process group of its own, which is what the deadline signals
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "parser.h"
+#include "events.h"
+#include "timeout.h"
+
+// the list of deadlines that are currently running
+static struct deadline* deadlines = NULL;
+
+/*
+* Converts a duration such as "10", "2.5s", "3m", "1h" or "1d" into milliseconds. Returns -1 if the
+* duration is not valid
+*/
+static long parseDuration(char* duration) {
+	// declare a variable used to find the end of the numeric part of the duration
+	char* end = NULL;
+	// convert the numeric part of the duration
+	double value = strtod(duration, &end);
+
+	// the duration must start with a non-negative number
+	if (end == duration || value < 0) {
+		return -1;
+	}
+
+	// scale the value by its unit suffix, if any
+	if (*end == '\0' || strcmp(end, "s") == 0) {
+		value *= 1000;
+	}
+	else if (strcmp(end, "m") == 0) {
+		value *= 60 * 1000;
+	}
+	else if (strcmp(end, "h") == 0) {
+		value *= 60 * 60 * 1000;
+	}
+	else if (strcmp(end, "d") == 0) {
+		value *= 24 * 60 * 60 * 1000;
+	}
+	else {
+		return -1;
+	}
+
+	return (long)value;
+}
+
+/*
+* Converts a signal name such as "TERM", "SIGTERM" or a signal number such as "15" into a signal number.
+* Returns -1 if the signal is not recognized
+*/
+static int parseSignal(char* name) {
+	// a table of the signals a user is likely to ask for by name
+	static const struct { const char* name; int number; } signalNames[] = {
+		{ "HUP", SIGHUP }, { "INT", SIGINT }, { "QUIT", SIGQUIT }, { "KILL", SIGKILL },
+		{ "USR1", SIGUSR1 }, { "USR2", SIGUSR2 }, { "ALRM", SIGALRM }, { "TERM", SIGTERM },
+	};
+	// declare a variable used to find the end of a numeric signal
+	char* end = NULL;
+	// try to convert the signal as a number first
+	long number = strtol(name, &end, 10);
+
+	if (end != name && *end == '\0') {
+		return (number > 0 && number < NSIG) ? (int)number : -1;
+	}
+
+	// skip an optional "SIG" prefix and look the name up in the table
+	if (strncasecmp(name, "SIG", 3) == 0) {
+		name += 3;
+	}
+	for (int index = 0; index < (int)(sizeof(signalNames) / sizeof(signalNames[0])); index++) {
+		if (strcasecmp(name, signalNames[index].name) == 0) {
+			return signalNames[index].number;
+		}
+	}
+
+	return -1;
+}
+
+/*
+* Parses the arguments of the built-in "timeout" command - timeout [-s SIGNAL] [-k KILLAFTER] DURATION
+* command [args...] - and strips them from the front of the argv array so that the remaining command can
+* be executed normally with its deadline recorded in the command struct. Returns false after displaying
+* an error message if the arguments are invalid
+*/
+bool applyTimeout(struct command* command) {
+	// declare and initialize a variable used to maintain the index of the argument being parsed
+	int index = 1;
+	// declare and initialize a variable used to signal that the duration has been found
+	bool haveDuration = false;
+
+	// options may appear both before and after the duration, the command starts at the first other argument
+	while (command->argv[index]) {
+		if (strcmp(command->argv[index], "-s") == 0 && command->argv[index + 1]) {
+			command->timeoutSignal = parseSignal(command->argv[index + 1]);
+			if (command->timeoutSignal == -1) {
+				printf("timeout: %s: invalid signal\n", command->argv[index + 1]);
+				fflush(stdout);
+				return false;
+			}
+			index += 2;
+		}
+		else if (strcmp(command->argv[index], "-k") == 0 && command->argv[index + 1]) {
+			command->killAfterMs = parseDuration(command->argv[index + 1]);
+			if (command->killAfterMs == -1) {
+				printf("timeout: %s: invalid duration\n", command->argv[index + 1]);
+				fflush(stdout);
+				return false;
+			}
+			index += 2;
+		}
+		else if (!haveDuration) {
+			command->timeoutMs = parseDuration(command->argv[index]);
+			if (command->timeoutMs == -1) {
+				printf("timeout: %s: invalid duration\n", command->argv[index]);
+				fflush(stdout);
+				return false;
+			}
+			haveDuration = true;
+			index++;
+		}
+		else {
+			break;
+		}
+	}
+
+	// a duration and a command to run are both required
+	if (!haveDuration || !command->argv[index]) {
+		printf("usage: timeout [-s SIGNAL] [-k KILLAFTER] DURATION command [args...]\n");
+		fflush(stdout);
+		return false;
+	}
+
+	// strip the arguments that belonged to the timeout command itself
+	removeLeadingArgs(command, index);
+
+	return true;
+}
+
+/*
+* Arms the timerfd of a deadline to expire once after the provided number of milliseconds
+*/
+static void armTimer(int timerFD, long milliseconds) {
+	struct itimerspec expiry = { 0 };
+
+	// a zero it_value would disarm the timer, so expire as soon as possible instead
+	if (milliseconds <= 0) {
+		milliseconds = 1;
+	}
+	expiry.it_value.tv_sec = milliseconds / 1000;
+	expiry.it_value.tv_nsec = (milliseconds % 1000) * 1000000;
+	timerfd_settime(timerFD, 0, &expiry, NULL);
+}
+
+/*
+* Sends signal to the process group led by the process of a deadline, or to the process alone if it never got a
+* process group of its own (e.g. the zygote spawned it)
+*/
+static void signalDeadlineGroup(struct deadline* current, int signal) {
+	if (kill(-current->pid, signal) == -1) {
+		kill(current->pid, signal);
+	}
+}
+
+/*
+* Returns true if the terminal on standard input belongs to the process group processGroup, otherwise false
+*/
+static bool ownsTerminal(pid_t processGroup) {
+	return isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == processGroup;
+}
+
+/*
+* Makes processGroup the foreground process group of the terminal on standard input. SIGTTOU is blocked
+* meanwhile since the caller may itself be in a background process group of the terminal
+*/
+static void handTerminal(pid_t processGroup) {
+	// declare variables used to block SIGTTOU and restore the previous signal mask
+	sigset_t blocked, saved;
+
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGTTOU);
+	sigprocmask(SIG_BLOCK, &blocked, &saved);
+	tcsetpgrp(STDIN_FILENO, processGroup);
+	sigprocmask(SIG_SETMASK, &saved, NULL);
+}
+
+/*
+* Moves the calling child process into a process group of its own if command has a timeout, so that the
+* deadline signals every process the command starts and not just the first one. If foreground is true and the
+* shell owns the terminal, the process group takes over the terminal so that the command can still read from it
+* and be interrupted with SIGINT. Called in the child before its standard input is redirected
+*/
+void enterDeadlineGroup(struct command* command, bool foreground) {
+	// declare and initialize a variable used to store whether the terminal goes along with the process group -
+	// checked first, while the child is still in the process group of the shell
+	bool terminal = foreground && ownsTerminal(getpgrp());
+
+	// a command without a timeout stays in the process group of the shell
+	if (command->timeoutMs <= 0) {
+		return;
+	}
+
+	setpgid(0, 0);
+	if (terminal) {
+		handTerminal(getpgrp());
+	}
+}
+
+/*
+* Event loop callback invoked when the timerfd of a deadline expires. The first expiry sends the timeout
+* signal and re-arms the timer, the second expiry sends SIGKILL
+*/
+static void deadlineExpired(struct eventHandler* handler, unsigned int events) {
+	struct deadline* current = (struct deadline*)handler->data;
+	unsigned long long expirations;
+
+	// consume the expiration count so the timerfd stops being readable
+	read(handler->fd, &expirations, sizeof(expirations));
+
+	if (!current->timedOut) {
+		// the deadline has passed - send the timeout signal and escalate to SIGKILL later
+		current->timedOut = true;
+		signalDeadlineGroup(current, current->timeoutSignal);
+		if (current->timeoutSignal != SIGKILL) {
+			armTimer(handler->fd, current->killAfterMs);
+		}
+	}
+	else {
+		// the process ignored the timeout signal
+		signalDeadlineGroup(current, SIGKILL);
+	}
+}
+
+/*
+* Starts a deadline for the process pid using the timeout recorded in command and places pid in the process
+* group of its own that enterDeadlineGroup also creates from within the child. If foreground is true and the
+* shell owns the terminal, the terminal is handed to that process group until the deadline is finished.
+* Nothing happens if the command has no timeout
+*/
+void startDeadline(struct command* command, pid_t pid, bool foreground) {
+	// a command without a timeout has no deadline
+	if (command->timeoutMs <= 0) {
+		return;
+	}
+
+	// create the process group here as well, so that it exists before the deadline can expire - this fails once
+	// the child has executed its program, by which time the child created it itself
+	setpgid(pid, pid);
+
+	// create the timerfd that will expire at the deadline - without one the deadline is still recorded so that
+	// the terminal is taken back, but it never expires
+	int timerFD = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (timerFD == -1) {
+		perror("timerfd_create failed");
+	}
+
+	// populate the deadline and add it to the list of running deadlines
+	struct deadline* current = (struct deadline*)calloc(1, sizeof(struct deadline));
+	current->pid = pid;
+	current->timeoutSignal = command->timeoutSignal;
+	current->killAfterMs = command->killAfterMs;
+	current->timedOut = false;
+	current->terminal = foreground && (ownsTerminal(getpgrp()) || ownsTerminal(pid));
+	current->handler.fd = timerFD;
+	current->handler.callback = deadlineExpired;
+	current->handler.data = current;
+	current->next = deadlines;
+	deadlines = current;
+
+	// hand the terminal over, unless the child already took it, then arm the timer and let the event loop watch it
+	if (current->terminal) {
+		handTerminal(pid);
+	}
+	if (timerFD != -1) {
+		armTimer(timerFD, command->timeoutMs);
+		registerEventHandler(&current->handler, EPOLLIN);
+	}
+}
+
+/*
+* Stops and releases the deadline of the process pid, if any, and takes the terminal back if it had been handed
+* to the process. Returns TIMED_OUT_FLAG if the deadline had expired before the process terminated, otherwise 0
+*/
+int finishDeadline(pid_t pid) {
+	// walk the list keeping track of the link that points at the current deadline
+	for (struct deadline** link = &deadlines; *link; link = &(*link)->next) {
+		struct deadline* current = *link;
+		if (current->pid == pid) {
+			int result = current->timedOut ? TIMED_OUT_FLAG : 0;
+
+			// the shell reads its next command line from the terminal again
+			if (current->terminal) {
+				handTerminal(getpgrp());
+			}
+
+			// unlink the deadline, stop watching its timer and release it
+			*link = current->next;
+			if (current->handler.fd != -1) {
+				unregisterEventHandler(&current->handler);
+				close(current->handler.fd);
+			}
+			free(current);
+
+			return result;
+		}
+	}
+
+	return 0;
+}
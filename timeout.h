@@ -0,0 +1,59 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the timeout built-in command and the timerfd based deadlines it places on
+*	foreground and background processes
+*/
+
+// a flag combined with a wait status to mark a process that was signalled because its deadline expired - it
+// sits above the 16 bits used by wait statuses so WIFEXITED, WTERMSIG and friends are unaffected by it
+#define TIMED_OUT_FLAG 0x10000
+
+// the number of milliseconds between the timeout signal and SIGKILL when -k is not provided
+#define DEFAULT_KILL_AFTER_MS 5000
+
+/*
+* A struct representing a deadline placed on a running process. When the timer first expires the timeout
+* signal is sent to the process group of the process and the timer is re-armed so that SIGKILL follows
+* killAfterMs later
+*/
+struct deadline {
+	pid_t pid;  // the process the deadline applies to, which also leads a process group of its own
+	int timeoutSignal;  // the signal sent once the deadline expires
+	long killAfterMs;  // the number of milliseconds between the timeout signal and SIGKILL
+	bool timedOut;  // true once the timeout signal has been sent, otherwise false
+	bool terminal;  // true if the terminal was handed to the process group and has to be taken back, otherwise false
+	struct eventHandler handler;  // the event loop handler watching the timerfd
+	struct deadline* next;  // the next active deadline
+};
+
+/*
+* Parses the arguments of the built-in "timeout" command - timeout [-s SIGNAL] [-k KILLAFTER] DURATION
+* command [args...] - and strips them from the front of the argv array so that the remaining command can
+* be executed normally with its deadline recorded in the command struct. Returns false after displaying
+* an error message if the arguments are invalid
+*/
+bool applyTimeout(struct command* command);
+
+/*
+* Moves the calling child process into a process group of its own if command has a timeout, so that the
+* deadline signals every process the command starts and not just the first one. If foreground is true and the
+* shell owns the terminal, the process group takes over the terminal so that the command can still read from it
+* and be interrupted with SIGINT. Called in the child before its standard input is redirected
+*/
+void enterDeadlineGroup(struct command* command, bool foreground);
+
+/*
+* Starts a deadline for the process pid using the timeout recorded in command and places pid in the process
+* group of its own that enterDeadlineGroup also creates from within the child. If foreground is true and the
+* shell owns the terminal, the terminal is handed to that process group until the deadline is finished.
+* Nothing happens if the command has no timeout
+*/
+void startDeadline(struct command* command, pid_t pid, bool foreground);
+
+/*
+* Stops and releases the deadline of the process pid, if any, and takes the terminal back if it had been handed
+* to the process. Returns TIMED_OUT_FLAG if the deadline had expired before the process terminated, otherwise 0
+*/
+int finishDeadline(pid_t pid);
@@ -0,0 +1,422 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: A hash table backed store for shell-local and exported variables along with the export
+*	and unset built-in commands
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include "parser.h"
+#include "variables.h"
+
+// the number of buckets the variable table starts out with
+#define INITIAL_BUCKETS 64
+
+/*
+* A struct representing the hash table that stores every shell variable
+*/
+struct variableTable {
+	int size;  // the number of variables currently stored in the table
+	int capacity;  // the number of buckets in the table
+	struct variable** buckets;  // the underlying array of bucket chains
+	int numExported;  // the number of variables currently marked for export
+	char** environment;  // the cached NULL terminated array of "NAME=value" strings passed to execve
+	bool environmentDirty;  // true if an exported variable changed since environment was last built
+};
+
+// the single variable table used by smallsh
+static struct variableTable variables = { 0 };
+
+/*
+* Returns the FNV-1a hash of the first length characters of name
+*/
+static unsigned int hashName(char* name, int length) {
+	// start from the FNV offset basis
+	unsigned int hash = 2166136261u;
+
+	// fold each character into the hash
+	for (int index = 0; index < length; index++) {
+		hash ^= (unsigned char)name[index];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/*
+* Returns the variable whose name matches the first length characters of name or NULL if no such
+* variable exists
+*/
+static struct variable* findVariable(char* name, int length) {
+	// if the table has not been initialized there is nothing to find
+	if (!variables.buckets) {
+		return NULL;
+	}
+
+	// walk the chain of the bucket the name hashes into
+	struct variable* current = variables.buckets[hashName(name, length) % variables.capacity];
+	while (current) {
+		if (strncmp(current->name, name, length) == 0 && current->name[length] == '\0') {
+			return current;
+		}
+		current = current->next;
+	}
+
+	return NULL;
+}
+
+/*
+* Doubles the number of buckets in the variable table and rehashes every variable into the new buckets
+*/
+static void upsizeTable(void) {
+	// allocate the new, larger, array of buckets
+	int newCapacity = variables.capacity * 2;
+	struct variable** newBuckets = (struct variable**)calloc(newCapacity, sizeof(struct variable*));
+
+	// move every variable from the old buckets into the new buckets
+	for (int index = 0; index < variables.capacity; index++) {
+		struct variable* current = variables.buckets[index];
+		while (current) {
+			struct variable* next = current->next;
+			unsigned int bucket = hashName(current->name, strlen(current->name)) % newCapacity;
+
+			current->next = newBuckets[bucket];
+			newBuckets[bucket] = current;
+			current = next;
+		}
+	}
+
+	// release the old buckets and install the new ones
+	free(variables.buckets);
+	variables.buckets = newBuckets;
+	variables.capacity = newCapacity;
+}
+
+/*
+* Returns the variable whose name matches the first length characters of name, creating an empty,
+* non-exported variable if it does not exist yet
+*/
+static struct variable* findOrCreateVariable(char* name, int length) {
+	struct variable* current = findVariable(name, length);
+
+	// if the variable already exists, return it
+	if (current) {
+		return current;
+	}
+
+	// lazily initialize the table the first time a variable is created
+	if (!variables.buckets) {
+		variables.capacity = INITIAL_BUCKETS;
+		variables.buckets = (struct variable**)calloc(variables.capacity, sizeof(struct variable*));
+	}
+
+	// if the ratio of variables to buckets would reach 0.75, upsize the table first
+	if (((float)(variables.size + 1) / (float)(variables.capacity)) >= 0.75) {
+		upsizeTable();
+	}
+
+	// allocate and populate the new variable
+	current = (struct variable*)calloc(1, sizeof(struct variable));
+	current->name = (char*)malloc((length + 1) * sizeof(char));
+	memcpy(current->name, name, length);
+	current->name[length] = '\0';
+	current->value = (char*)calloc(1, sizeof(char));
+	current->exported = false;
+
+	// link the new variable in at the head of its bucket chain
+	unsigned int bucket = hashName(name, length) % variables.capacity;
+	current->next = variables.buckets[bucket];
+	variables.buckets[bucket] = current;
+	variables.size++;
+
+	return current;
+}
+
+/*
+* Initializes the variable store and imports every "NAME=value" string found in environment as an
+* exported variable
+*/
+void initializeVariables(char** environment) {
+	// import each environment string that is a valid assignment
+	for (int index = 0; environment && environment[index]; index++) {
+		if (isAssignment(environment[index])) {
+			applyAssignment(environment[index], true);
+		}
+	}
+}
+
+/*
+* Returns true if name is a valid variable name - a letter or underscore followed by any number of
+* letters, digits, or underscores - otherwise false
+*/
+bool isValidVariableName(char* name, int length) {
+	// a variable name may not be empty and may not start with a digit
+	if (length <= 0 || !(isalpha((unsigned char)name[0]) || name[0] == '_')) {
+		return false;
+	}
+
+	// every remaining character must be a letter, digit, or underscore
+	for (int index = 1; index < length; index++) {
+		if (!(isalnum((unsigned char)name[index]) || name[index] == '_')) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+* Returns true if word has the form NAME=value where NAME is a valid variable name, otherwise false
+*/
+bool isAssignment(char* word) {
+	char* equals = strchr(word, '=');
+
+	return equals && isValidVariableName(word, equals - word);
+}
+
+/*
+* Returns the value of the variable called name or NULL if no such variable exists
+*/
+char* getVariable(char* name) {
+	struct variable* current = findVariable(name, strlen(name));
+
+	return current ? current->value : NULL;
+}
+
+/*
+* Replaces the value of the provided variable with the first length characters of value
+*/
+static void replaceValue(struct variable* current, char* value, int length) {
+	// release the old value and copy in the new one
+	free(current->value);
+	current->value = (char*)malloc((length + 1) * sizeof(char));
+	memcpy(current->value, value, length);
+	current->value[length] = '\0';
+
+	// the cached environment only goes stale when an exported variable changes
+	if (current->exported) {
+		variables.environmentDirty = true;
+	}
+}
+
+/*
+* Sets the variable called name to value, creating the variable if it does not exist. The exported
+* flag of an existing variable is preserved
+*/
+void setVariable(char* name, char* value) {
+	replaceValue(findOrCreateVariable(name, strlen(name)), value, strlen(value));
+}
+
+/*
+* Applies an assignment of the form NAME=value to the variable store. If exported is true then the
+* variable is also marked for export
+*/
+void applyAssignment(char* assignment, bool exported) {
+	char* equals = strchr(assignment, '=');
+	struct variable* current = findOrCreateVariable(assignment, equals - assignment);
+
+	replaceValue(current, equals + 1, strlen(equals + 1));
+	if (exported) {
+		exportVariable(current->name);
+	}
+}
+
+/*
+* Marks the variable called name for export, creating it with an empty value if it does not exist
+*/
+void exportVariable(char* name) {
+	struct variable* current = findOrCreateVariable(name, strlen(name));
+
+	// only a change in the export flag invalidates the cached environment
+	if (!current->exported) {
+		current->exported = true;
+		variables.numExported++;
+		variables.environmentDirty = true;
+	}
+}
+
+/*
+* Removes the variable called name from the variable store
+*/
+void unsetVariable(char* name) {
+	// if the table has not been initialized there is nothing to remove
+	if (!variables.buckets) {
+		return;
+	}
+
+	// walk the bucket chain keeping track of the link that points at the current variable
+	struct variable** link = &variables.buckets[hashName(name, strlen(name)) % variables.capacity];
+	while (*link) {
+		struct variable* current = *link;
+		if (strcmp(current->name, name) == 0) {
+			// unlink the variable from its chain
+			*link = current->next;
+			variables.size--;
+
+			// removing an exported variable changes the environment
+			if (current->exported) {
+				variables.numExported--;
+				variables.environmentDirty = true;
+			}
+
+			// release the memory allocated for the variable
+			free(current->name);
+			free(current->value);
+			free(current);
+			return;
+		}
+		link = &current->next;
+	}
+}
+
+/*
+* Releases the cached environment array and every string it holds
+*/
+static void freeEnvironment(void) {
+	if (variables.environment) {
+		for (int index = 0; variables.environment[index]; index++) {
+			free(variables.environment[index]);
+		}
+		free(variables.environment);
+		variables.environment = NULL;
+	}
+}
+
+/*
+* Returns a NULL terminated array of "NAME=value" strings for every exported variable. The array is
+* cached and only rebuilt after an exported variable has changed
+*/
+char** getEnvironment(void) {
+	int envIndex = 0;
+
+	// if nothing exported has changed since the last build, hand back the cached array
+	if (variables.environment && !variables.environmentDirty) {
+		return variables.environment;
+	}
+
+	// release the stale array and allocate room for every exported variable plus the NULL terminator
+	freeEnvironment();
+	variables.environment = (char**)malloc((variables.numExported + 1) * sizeof(char*));
+
+	// build a "NAME=value" string for each exported variable
+	for (int index = 0; index < variables.capacity; index++) {
+		for (struct variable* current = variables.buckets[index]; current; current = current->next) {
+			if (current->exported) {
+				variables.environment[envIndex] = (char*)malloc((strlen(current->name) + strlen(current->value) + 2) * sizeof(char));
+				sprintf(variables.environment[envIndex], "%s=%s", current->name, current->value);
+				envIndex++;
+			}
+		}
+	}
+	variables.environment[envIndex] = NULL;
+	variables.environmentDirty = false;
+
+	return variables.environment;
+}
+
+/*
+* Returns a newly allocated NULL terminated environment array holding the NAME=value strings in assignments
+* followed by every exported variable that is not overridden by them. Only the array itself must be freed
+*/
+char** getEnvironmentWith(char** assignments) {
+	char** environment = getEnvironment();
+	int numAssignments = 0;
+	int envIndex = 0;
+
+	// count the assignments so the array can be sized
+	while (assignments[numAssignments]) {
+		numAssignments++;
+	}
+	char** combined = (char**)malloc((numAssignments + variables.numExported + 1) * sizeof(char*));
+
+	// the assignments come first
+	for (int index = 0; index < numAssignments; index++) {
+		combined[envIndex++] = assignments[index];
+	}
+
+	// followed by every exported variable whose name is not assigned
+	for (int index = 0; environment[index]; index++) {
+		int nameLength = strchr(environment[index], '=') - environment[index] + 1;
+		bool overridden = false;
+		for (int assignIndex = 0; assignIndex < numAssignments && !overridden; assignIndex++) {
+			overridden = strncmp(environment[index], assignments[assignIndex], nameLength) == 0;
+		}
+		if (!overridden) {
+			combined[envIndex++] = environment[index];
+		}
+	}
+	combined[envIndex] = NULL;
+
+	return combined;
+}
+
+/*
+* Executes the built-in "export" command. With no arguments every exported variable is displayed,
+* otherwise each NAME or NAME=value argument is marked for export
+*/
+void exportVariables(struct command* command) {
+	// with no arguments, display every exported variable
+	if (!command->argv[1]) {
+		for (int index = 0; index < variables.capacity; index++) {
+			for (struct variable* current = variables.buckets[index]; current; current = current->next) {
+				if (current->exported) {
+					printf("export %s=\"%s\"\n", current->name, current->value);
+				}
+			}
+		}
+		// flush stdout
+		fflush(stdout);
+		return;
+	}
+
+	// export each argument, assigning a value first if one was provided
+	for (int index = 1; command->argv[index]; index++) {
+		if (isAssignment(command->argv[index])) {
+			applyAssignment(command->argv[index], true);
+		}
+		else if (isValidVariableName(command->argv[index], strlen(command->argv[index]))) {
+			exportVariable(command->argv[index]);
+		}
+		else {
+			// display an error message to the user
+			printf("export: %s: not a valid identifier\n", command->argv[index]);
+			// flush stdout
+			fflush(stdout);
+		}
+	}
+}
+
+/*
+* Executes the built-in "unset" command by removing each named variable from the variable store
+*/
+void unsetVariables(struct command* command) {
+	for (int index = 1; command->argv[index]; index++) {
+		unsetVariable(command->argv[index]);
+	}
+}
+
+/*
+* Releases all memory allocated for the variable store
+*/
+void cleanupVariables(void) {
+	// release every variable in every bucket chain
+	for (int index = 0; index < variables.capacity; index++) {
+		struct variable* current = variables.buckets[index];
+		while (current) {
+			struct variable* next = current->next;
+			free(current->name);
+			free(current->value);
+			free(current);
+			current = next;
+		}
+	}
+
+	// release the buckets and the cached environment
+	free(variables.buckets);
+	freeEnvironment();
+	memset(&variables, 0, sizeof(variables));
+}
@@ -0,0 +1,89 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the shell variable store and the export / unset built-in commands
+*/
+
+/*
+* A struct representing a single shell variable. Variables that hash to the same bucket are chained
+* together through the next member
+*/
+struct variable {
+	char* name;  // the name of the variable
+	char* value;  // the value of the variable
+	bool exported;  // true if the variable is passed to the environment of child processes, otherwise false
+	struct variable* next;  // the next variable in the same hash bucket
+};
+
+/*
+* Initializes the variable store and imports every "NAME=value" string found in environment as an
+* exported variable
+*/
+void initializeVariables(char** environment);
+
+/*
+* Returns true if name is a valid variable name - a letter or underscore followed by any number of
+* letters, digits, or underscores - otherwise false
+*/
+bool isValidVariableName(char* name, int length);
+
+/*
+* Returns true if word has the form NAME=value where NAME is a valid variable name, otherwise false
+*/
+bool isAssignment(char* word);
+
+/*
+* Returns the value of the variable called name or NULL if no such variable exists
+*/
+char* getVariable(char* name);
+
+/*
+* Sets the variable called name to value, creating the variable if it does not exist. The exported
+* flag of an existing variable is preserved
+*/
+void setVariable(char* name, char* value);
+
+/*
+* Applies an assignment of the form NAME=value to the variable store. If exported is true then the
+* variable is also marked for export
+*/
+void applyAssignment(char* assignment, bool exported);
+
+/*
+* Marks the variable called name for export, creating it with an empty value if it does not exist
+*/
+void exportVariable(char* name);
+
+/*
+* Removes the variable called name from the variable store
+*/
+void unsetVariable(char* name);
+
+/*
+* Returns a NULL terminated array of "NAME=value" strings for every exported variable. The array is
+* cached and only rebuilt after an exported variable has changed
+*/
+char** getEnvironment(void);
+
+/*
+* Returns a newly allocated NULL terminated environment array holding the NAME=value strings in assignments
+* followed by every exported variable that is not overridden by them. Only the array itself must be freed
+*/
+char** getEnvironmentWith(char** assignments);
+
+/*
+* Executes the built-in "export" command. With no arguments every exported variable is displayed,
+* otherwise each NAME or NAME=value argument is marked for export
+*/
+void exportVariables(struct command* command);
+
+/*
+* Executes the built-in "unset" command by removing each named variable from the variable store
+*/
+void unsetVariables(struct command* command);
+
+/*
+* Releases all memory allocated for the variable store
+*/
+void cleanupVariables(void);
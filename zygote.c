@@ -0,0 +1,305 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: The zygote - a helper process forked while the shell is still small. Spawn requests are sent to
+*	it over a socket and it creates each process with CLONE_PARENT, so the cost of copying the address space
+*	stays constant and the spawned processes are still children of the shell
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include "zygote.h"
+
+// the shell's end of the socket connected to the zygote, -1 if the zygote is not running
+static int zygoteFD = -1;
+
+// the pid of the zygote
+static pid_t zygotePid = -1;
+
+/*
+* Executed by the process the zygote clones for a request - replaces the standard streams, moves to the
+* working directory of the shell, sets up signal dispositions and executes the program. Never returns
+*/
+static void execSpawned(struct zygoteRequest* request, int* fds, char* path, char* cwd, char** argv, char** envp) {
+	// replace the standard streams with the file descriptors that were passed along
+	for (unsigned int index = 0; index < request->numFDs; index++) {
+		dup2(fds[index], request->fdTargets[index]);
+	}
+	for (unsigned int index = 0; index < request->numFDs; index++) {
+		if (fds[index] > STDERR_FILENO) {
+			close(fds[index]);
+		}
+	}
+
+	// run in the working directory the shell is in now rather than the one the zygote started in
+	if (chdir(cwd) == -1) {
+		perror(cwd);
+	}
+
+	// a foreground process terminates itself upon receiving SIGINT, every spawned process ignores SIGTSTP
+	signal(SIGINT, (request->flags & ZYGOTE_FOREGROUND) ? SIG_DFL : SIG_IGN);
+	signal(SIGTSTP, SIG_IGN);
+
+	execve(path, argv, envp);
+
+	// if we return, then execve failed - display an error message to the user just like the shell does
+	printf("%s: %s\n", argv[0], strerror(errno));
+	fflush(stdout);
+	_exit(1);
+}
+
+/*
+* The main loop of the zygote - receives spawn requests, clones a process for each one and replies with
+* its pid. Returns once the shell closes its end of the socket
+*/
+static void runZygote(int socketFD) {
+	// the buffer that receives each request, allocated once
+	char* message = (char*)malloc(ZYGOTE_MAX_MESSAGE);
+	// the buffer that receives the passed file descriptors
+	char control[CMSG_SPACE(3 * sizeof(int))];
+	// the pointers into message for the arguments and environment of the request being handled
+	char** strings = (char**)malloc((ZYGOTE_MAX_MESSAGE / 2 + 2) * sizeof(char*));
+
+	while (true) {
+		struct iovec iov = { message, ZYGOTE_MAX_MESSAGE };
+		struct msghdr header = { 0 };
+		int fds[3] = { -1, -1, -1 };
+		int reply;
+
+		// wait for the next request
+		header.msg_iov = &iov;
+		header.msg_iovlen = 1;
+		header.msg_control = control;
+		header.msg_controllen = sizeof(control);
+		ssize_t length = recvmsg(socketFD, &header, MSG_CMSG_CLOEXEC);
+		if (length == -1 && errno == EINTR) {
+			continue;
+		}
+		// the shell has gone away
+		if (length <= 0) {
+			break;
+		}
+
+		// collect the passed file descriptors
+		struct zygoteRequest* request = (struct zygoteRequest*)message;
+		struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+		if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+			memcpy(fds, CMSG_DATA(cmsg), cmsg->cmsg_len - CMSG_LEN(0));
+		}
+
+		// split the strings following the header - path, working directory, arguments, environment
+		char* cursor = message + sizeof(struct zygoteRequest);
+		char* path = cursor;
+		cursor += strlen(cursor) + 1;
+		char* cwd = cursor;
+		cursor += strlen(cursor) + 1;
+		char** argv = strings;
+		for (unsigned int index = 0; index < request->argc; index++) {
+			argv[index] = cursor;
+			cursor += strlen(cursor) + 1;
+		}
+		argv[request->argc] = NULL;
+		char** envp = argv + request->argc + 1;
+		for (unsigned int index = 0; index < request->envc; index++) {
+			envp[index] = cursor;
+			cursor += strlen(cursor) + 1;
+		}
+		envp[request->envc] = NULL;
+
+		// clone the new process as a sibling so that it is a child of the shell rather than the zygote
+		pid_t spawnPid = syscall(SYS_clone, CLONE_PARENT, 0, NULL, NULL, 0);
+		if (spawnPid == 0) {
+			execSpawned(request, fds, path, cwd, argv, envp);
+		}
+		reply = (spawnPid == -1) ? -errno : spawnPid;
+
+		// the zygote has no further use for the passed file descriptors
+		for (unsigned int index = 0; index < request->numFDs; index++) {
+			close(fds[index]);
+		}
+
+		// reply with the pid of the new process or the negated errno
+		send(socketFD, &reply, sizeof(reply), MSG_NOSIGNAL);
+	}
+
+	free(strings);
+	free(message);
+}
+
+/*
+* Forks the zygote. It should be called as early as possible so that the zygote has a minimal address space.
+* Returns true if the zygote is running, otherwise false
+*/
+bool startZygote(void) {
+	int sockets[2];
+
+	// a sequenced packet socket keeps each request in a single message
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == -1) {
+		perror("socketpair failed");
+		return false;
+	}
+
+	// For the following code structure, reference citation F
+	zygotePid = fork();
+	if (zygotePid == -1) {
+		perror("fork failed");
+		close(sockets[0]);
+		close(sockets[1]);
+		return false;
+	}
+	else if (zygotePid == 0) {
+		// the zygote itself ignores the job control signals sent to the shell's process group
+		signal(SIGINT, SIG_IGN);
+		signal(SIGTSTP, SIG_IGN);
+		close(sockets[0]);
+		runZygote(sockets[1]);
+		_exit(0);
+	}
+
+	// the shell keeps its end of the socket
+	close(sockets[1]);
+	zygoteFD = sockets[0];
+	return true;
+}
+
+/*
+* Returns true if the zygote is running, otherwise false
+*/
+bool zygoteRunning(void) {
+	return zygoteFD != -1;
+}
+
+/*
+* Appends a null terminated string to a request being built, returning false if it does not fit
+*/
+static bool appendString(char* message, size_t* length, char* string) {
+	size_t stringLength = strlen(string) + 1;
+
+	if (*length + stringLength > ZYGOTE_MAX_MESSAGE) {
+		return false;
+	}
+	memcpy(message + *length, string, stringLength);
+	*length += stringLength;
+	return true;
+}
+
+/*
+* Asks the zygote to spawn the executable at path with the provided argv and envp. Each of fds[0], fds[1]
+* and fds[2] that is not -1 replaces stdin, stdout or stderr respectively in the spawned process. The spawned
+* process is a child of the shell itself, so it is waited on with waitpid as usual. Returns the pid of the
+* spawned process or -1 if the zygote could not spawn it
+*/
+pid_t zygoteSpawn(char* path, char** argv, char** envp, int* fds, unsigned int flags) {
+	// the request is built in a static buffer to avoid an allocation per spawn
+	static char message[ZYGOTE_MAX_MESSAGE];
+	struct zygoteRequest* request = (struct zygoteRequest*)message;
+	char control[CMSG_SPACE(3 * sizeof(int))] = { 0 };
+	char cwd[4096];
+	size_t length = sizeof(struct zygoteRequest);
+	int passedFDs[3];
+	bool fits = true;
+	int reply;
+
+	if (zygoteFD == -1 || !getcwd(cwd, sizeof(cwd))) {
+		return -1;
+	}
+
+	// populate the header and the file descriptors being passed
+	memset(request, 0, sizeof(struct zygoteRequest));
+	request->flags = flags;
+	for (int target = 0; target < 3; target++) {
+		if (fds[target] != -1) {
+			request->fdTargets[request->numFDs] = target;
+			passedFDs[request->numFDs] = fds[target];
+			request->numFDs++;
+		}
+	}
+
+	// append the path, working directory, arguments and environment
+	fits = appendString(message, &length, path) && appendString(message, &length, cwd);
+	for (request->argc = 0; fits && argv[request->argc]; request->argc++) {
+		fits = appendString(message, &length, argv[request->argc]);
+	}
+	for (request->envc = 0; fits && envp[request->envc]; request->envc++) {
+		fits = appendString(message, &length, envp[request->envc]);
+	}
+	// a request too large for a single message is left to fork
+	if (!fits) {
+		return -1;
+	}
+
+	// send the request with the file descriptors attached
+	struct iovec iov = { message, length };
+	struct msghdr header = { 0 };
+	header.msg_iov = &iov;
+	header.msg_iovlen = 1;
+	if (request->numFDs > 0) {
+		header.msg_control = control;
+		header.msg_controllen = CMSG_SPACE(request->numFDs * sizeof(int));
+		struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(request->numFDs * sizeof(int));
+		memcpy(CMSG_DATA(cmsg), passedFDs, request->numFDs * sizeof(int));
+	}
+	if (sendmsg(zygoteFD, &header, MSG_NOSIGNAL) == -1) {
+		// the zygote is gone - stop using it
+		stopZygote();
+		return -1;
+	}
+
+	// wait for the pid of the new process
+	while (recv(zygoteFD, &reply, sizeof(reply), 0) == -1) {
+		if (errno != EINTR) {
+			stopZygote();
+			return -1;
+		}
+	}
+	if (reply < 0) {
+		errno = -reply;
+		return -1;
+	}
+
+	return reply;
+}
+
+/*
+* Stops the zygote and waits for it to exit
+*/
+void stopZygote(void) {
+	if (zygoteFD == -1) {
+		return;
+	}
+
+	// closing the socket tells the zygote to exit
+	close(zygoteFD);
+	zygoteFD = -1;
+	waitpid(zygotePid, NULL, 0);
+	zygotePid = -1;
+}
+
+/*
+* Forgets the zygote without stopping it. Called in a forked child of the shell that keeps executing commands,
+* which must fork them itself since the zygote spawns its processes as children of the shell
+*/
+void detachZygote(void) {
+	if (zygoteFD == -1) {
+		return;
+	}
+
+	// only this process's copy of the socket is closed, so the zygote keeps serving the shell
+	close(zygoteFD);
+	zygoteFD = -1;
+	zygotePid = -1;
+}
@@ -0,0 +1,55 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Header file for the zygote - a small helper process forked at startup that spawns commands on
+*	behalf of the shell so that the cost of spawning does not grow with the memory used by the shell
+*/
+
+// the spawned process is a foreground process and terminates itself upon receiving SIGINT
+#define ZYGOTE_FOREGROUND 0x1
+
+// the largest spawn request, in bytes, the zygote accepts - larger requests are spawned with fork instead
+#define ZYGOTE_MAX_MESSAGE (128 * 1024)
+
+/*
+* A struct representing the fixed size header of a spawn request sent to the zygote. It is followed by the
+* executable path, the working directory, argc arguments and envc environment strings, each null terminated
+*/
+struct zygoteRequest {
+	unsigned int flags;  // a combination of the ZYGOTE_ flags
+	unsigned int argc;  // the number of arguments that follow the path and working directory
+	unsigned int envc;  // the number of environment strings that follow the arguments
+	unsigned int numFDs;  // the number of file descriptors passed via SCM_RIGHTS for stdin, stdout and stderr
+	int fdTargets[3];  // the standard stream each passed file descriptor replaces, in order
+};
+
+/*
+* Forks the zygote. It should be called as early as possible so that the zygote has a minimal address space.
+* Returns true if the zygote is running, otherwise false
+*/
+bool startZygote(void);
+
+/*
+* Returns true if the zygote is running, otherwise false
+*/
+bool zygoteRunning(void);
+
+/*
+* Asks the zygote to spawn the executable at path with the provided argv and envp. Each of fds[0], fds[1]
+* and fds[2] that is not -1 replaces stdin, stdout or stderr respectively in the spawned process. The spawned
+* process is a child of the shell itself, so it is waited on with waitpid as usual. Returns the pid of the
+* spawned process or -1 if the zygote could not spawn it
+*/
+pid_t zygoteSpawn(char* path, char** argv, char** envp, int* fds, unsigned int flags);
+
+/*
+* Stops the zygote and waits for it to exit
+*/
+void stopZygote(void);
+
+/*
+* Forgets the zygote without stopping it. Called in a forked child of the shell that keeps executing commands,
+* which must fork them itself since the zygote spawns its processes as children of the shell
+*/
+void detachZygote(void);
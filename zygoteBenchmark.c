@@ -0,0 +1,100 @@
+/*
+* Author: Colin Francis
+* ONID: francico
+* Title: Smallsh
+* Description: Benchmark comparing the latency of spawning a process with fork and with the zygote as the
+*	memory used by the spawning process grows
+*
+* Usage: ./zygoteBenchmark [ITERATIONS] [MEGABYTES...]
+*	For each size in MEGABYTES (default 0 64 256 1024) that many megabytes are allocated and touched, then
+*	"/bin/true" is spawned and reaped ITERATIONS (default 200) times with each method
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "zygote.h"
+
+/*
+* Returns the current time of the monotonic clock in microseconds
+*/
+static double nowMicroseconds(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+/*
+* Spawns and reaps "/bin/true" iterations times, either with fork and execve or with the zygote, and returns
+* the average number of microseconds each spawn took
+*/
+static double timeSpawns(int iterations, bool useZygote, char** envp) {
+	char* argv[] = { "true", NULL };
+	int fds[3] = { -1, -1, -1 };
+	double start = nowMicroseconds();
+
+	for (int index = 0; index < iterations; index++) {
+		pid_t spawnPid;
+
+		if (useZygote) {
+			spawnPid = zygoteSpawn("/bin/true", argv, envp, fds, ZYGOTE_FOREGROUND);
+		}
+		else {
+			spawnPid = fork();
+			if (spawnPid == 0) {
+				execve("/bin/true", argv, envp);
+				_exit(127);
+			}
+		}
+
+		if (spawnPid == -1) {
+			perror("spawn failed");
+			exit(1);
+		}
+		waitpid(spawnPid, NULL, 0);
+	}
+
+	return (nowMicroseconds() - start) / iterations;
+}
+
+/*
+* Driver code for the benchmark
+*/
+int main(int argc, char* argv[]) {
+	extern char** environ;
+	int iterations = argc > 1 ? atoi(argv[1]) : 200;
+	int defaultSizes[] = { 0, 64, 256, 1024 };
+	int numSizes = argc > 2 ? argc - 2 : 4;
+
+	// start the zygote while this process is still small, just like smallsh does
+	if (!startZygote()) {
+		return 1;
+	}
+
+	printf("%10s %16s %16s\n", "RSS (MB)", "fork (us)", "zygote (us)");
+	for (int index = 0; index < numSizes; index++) {
+		int megabytes = argc > 2 ? atoi(argv[index + 2]) : defaultSizes[index];
+		size_t bytes = (size_t)megabytes * 1024 * 1024;
+
+		// grow the address space and touch every page so that fork has to copy the page tables
+		char* ballast = bytes ? (char*)malloc(bytes) : NULL;
+		if (ballast) {
+			memset(ballast, 1, bytes);
+		}
+
+		double forkTime = timeSpawns(iterations, false, environ);
+		double zygoteTime = timeSpawns(iterations, true, environ);
+		printf("%10d %16.1f %16.1f\n", megabytes, forkTime, zygoteTime);
+		fflush(stdout);
+
+		free(ballast);
+	}
+
+	stopZygote();
+	return 0;
+}